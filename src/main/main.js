@@ -1,10 +1,12 @@
-const { app, BrowserWindow, ipcMain, Menu, globalShortcut, screen, shell } = require('electron');
+const { app, BrowserWindow, ipcMain, Menu, globalShortcut, screen, shell, MessageChannelMain, webContents } = require('electron');
 const path = require('path');
 const Store = require('electron-store');
 
 // 尝试加载C++模块
 let highPriorityShortcut = null;
 let highPriorityTopmost = null;
+let resourceGovernor = null;
+let nativeTrace = null;
 try {
   highPriorityShortcut = require('../native/lib/binding.js');
   console.log('Successfully loaded high-priority shortcut module');
@@ -14,6 +16,7 @@ try {
   highPriorityShortcut = {
     installHook: () => { console.warn('C++ shortcuts not available, using fallback'); },
     registerShortcuts: () => { console.warn('C++ shortcuts not available'); },
+    updateShortcuts: () => false,
     uninstallHook: () => { console.warn('C++ shortcuts not available'); }
   };
 }
@@ -32,6 +35,30 @@ try {
   };
 }
 
+try {
+  resourceGovernor = require('../native/lib/governor.js');
+  console.log('Successfully loaded resource governor module');
+} catch (err) {
+  console.log('Failed to load resource governor module:', err);
+  resourceGovernor = {
+    start: () => false,
+    stop: () => {},
+    setProcesses: () => {},
+    setOverlayVisible: () => {},
+    isAvailable: () => false
+  };
+}
+
+try {
+  nativeTrace = require('../native/lib/trace.js');
+} catch (err) {
+  console.log('Failed to load native trace module:', err);
+  nativeTrace = {
+    setTraceEvents: () => {},
+    dumpTrace: () => false
+  };
+}
+
 // 防抖工具函数
 function debounce(func, wait) {
   let timeout;
@@ -62,8 +89,15 @@ const store = new Store({
       // mouseSide1Action: 'XButton1',  // 鼠标侧键1
       // mouseSide2Action: 'Shift+XButton2',  // Shift+鼠标侧键2
     },
+    // 按前台应用切换的键位方案：{ 名称: { process: [可执行文件名], windowClass: [窗口类名], shortcuts } }
+    // shortcuts在默认键位基础上覆盖，值为null表示该应用中不拦截此动作，例如让编辑器收到F1~F3：
+    //   editor: { process: ['Code.exe'], shortcuts: { playPause: null, rewind: null, forward: null } }
+    shortcutProfiles: {},
     browserOpacity: 0.8,
-    enableGpuAcceleration: false
+    enableGpuAcceleration: false,
+    // 拦截已绑定的鼠标侧键（低级鼠标钩子，每次鼠标移动都经过输入线程）；
+    // 关闭则只经Raw Input监听侧键，游戏和浏览器的前进/后退仍会收到
+    swallowMouseButtons: true
   }
 });
 
@@ -76,10 +110,71 @@ if (!store.get('enableGpuAcceleration')) {
 let mainWindow = null;
 let browserWindow = null;
 
+// 长按时native层对自动重复的处理：透明度按周期合并为一次调整，
+// 避免每次重复都写一次配置文件；切换类操作忽略重复
+const SHORTCUT_REPEAT_POLICIES = {
+  increaseOpacity: { mode: 'coalesce', rate: 10 },
+  decreaseOpacity: { mode: 'coalesce', rate: 10 },
+  playPause: 'drop',
+  toggleBrowser: 'drop'
+};
+
+// 按住快进/快退：按下先跳5秒，按住400毫秒后每150毫秒继续跳，步长逐渐加大
+// 计时由native定时器线程完成，JS只收到hold/repeat事件
+const SHORTCUT_TRIGGERS = {
+  rewind: { hold: 400, repeat: 150 },
+  forward: { hold: 400, repeat: 150 }
+};
+
+const SHORTCUT_OPTIONS = { repeat: SHORTCUT_REPEAT_POLICIES, triggers: SHORTCUT_TRIGGERS };
+
+// 键位方案随快捷键一起编译，前台应用切换时由native层直接换用，不经过JS
+function shortcutOptions() {
+  return {
+    ...SHORTCUT_OPTIONS,
+    profiles: store.get('shortcutProfiles'),
+    mouseHook: store.get('swallowMouseButtons')
+  };
+}
+
+// 播放器窗口隐藏且这些游戏在前台时，资源调控模块把本应用降为效率优先级并避开游戏占用的CPU核心
+const GAME_PROCESS_NAMES = ['YuanShen.exe', 'GenshinImpact.exe'];
+
+// 经MessagePort直达播放器窗口媒体控制器（media-preload.js）的动作及其编码，两边需保持一致
+const MEDIA_ACTION_CODES = {
+  playPause: 1,
+  rewind: 2,
+  forward: 3
+};
+
+// 按住期间第count次触发的跳转秒数：5、10、20，最多30
+function scrubStepSeconds(event) {
+  if (!event || event.trigger === 'press') {
+    return 5;
+  }
+  const tick = event.trigger === 'repeat' ? event.count : 0;
+  return Math.min(30, 5 * Math.pow(2, Math.floor(tick / 4) + 1));
+}
+
 // 快捷键处理函数
-function handleShortcut(action) {
-  console.log('Shortcut triggered:', action);
+// event为native层传来的事件信息，处理完成后回报以统计端到端延迟
+// event.count为合并后的按键次数
+function handleShortcut(action, event) {
+  const count = (event && event.count) || 1;
+  console.log('Shortcut triggered:', action, count > 1 ? `x${count}` : '');
   
+  const reportCompletion = () => {
+    if (event && highPriorityShortcut && highPriorityShortcut.reportCompletion) {
+      highPriorityShortcut.reportCompletion(event);
+    }
+  };
+  
+  // 松开事件只用于结束按住状态
+  if (event && event.trigger === 'release') {
+    reportCompletion();
+    return;
+  }
+
   switch (action) {
     case 'toggleBrowser':
       toggleBrowserVisibility();
@@ -87,21 +182,89 @@ function handleShortcut(action) {
     case 'playPause':
     case 'rewind':
     case 'forward':
-      executeMediaAction(action);
-      break;
+      // 已由native事件流经MessagePort直接送达播放器窗口，这里只负责让窗口可见；
+      // 完成回报由渲染进程确认后在binding.js中完成
+      if (event && event.routed) {
+        ensureBrowserWindowVisible();
+        return;
+      }
+      // 媒体控制器未就绪（页面加载中等）时退回注入脚本，在渲染进程执行完毕后才算完成
+      Promise.resolve(executeMediaAction(action, scrubStepSeconds(event))).finally(reportCompletion);
+      return;
     case 'increaseOpacity':
-      adjustBrowserOpacity(0.1);
+      adjustBrowserOpacity(0.1 * count);
       break;
     case 'decreaseOpacity':
-      adjustBrowserOpacity(-0.1);
+      adjustBrowserOpacity(-0.1 * count);
       break;
     default:
       console.log('Unknown shortcut action:', action);
   }
+  
+  reportCompletion();
+}
+
+// 确保播放器窗口可见（不抢焦点），窗口不可用时返回false
+function ensureBrowserWindowVisible() {
+  if (!browserWindow || browserWindow.isDestroyed()) {
+    return false;
+  }
+  try {
+    if (!browserWindow.isVisible()) {
+      browserWindow.show();
+    }
+    if (browserWindow.isMinimized()) {
+      browserWindow.restore();
+    }
+  } catch (err) {
+    console.error('Failed to manage browser window:', err);
+    return false;
+  }
+  return true;
+}
+
+// 把本应用当前的进程列表同步给资源调控模块
+function refreshGovernorProcesses() {
+  if (resourceGovernor.isAvailable()) {
+    resourceGovernor.setProcesses(app.getAppMetrics().map(metric => metric.pid));
+  }
 }
 
-// 执行媒体操作
-function executeMediaAction(action) {
+// 把本应用的进程列表和播放器窗口的可见状态同步给资源调控模块
+function updateResourceGovernor() {
+  if (!resourceGovernor.isAvailable()) {
+    return;
+  }
+  refreshGovernorProcesses();
+  const visible = !!browserWindow && !browserWindow.isDestroyed() &&
+    browserWindow.isVisible() && !browserWindow.isMinimized();
+  resourceGovernor.setOverlayVisible(visible);
+}
+
+function startResourceGovernor() {
+  if (!resourceGovernor.isAvailable() || !resourceGovernor.start({ games: GAME_PROCESS_NAMES })) {
+    return;
+  }
+  updateResourceGovernor();
+  // 渲染进程会随页面跳转增减，GPU/工具进程也可能重启：在进程出现或退出时刷新列表，不定时轮询。
+  // 新页面的渲染进程在导航提交后才存在，所以在did-navigate时刷新；已创建的页面（主窗口）同样跟踪
+  const trackContents = contents => contents.on('did-navigate', refreshGovernorProcesses);
+  webContents.getAllWebContents().forEach(trackContents);
+  app.on('web-contents-created', (event, contents) => {
+    refreshGovernorProcesses();
+    trackContents(contents);
+  });
+  app.on('render-process-gone', refreshGovernorProcesses);
+  app.on('child-process-gone', refreshGovernorProcesses);
+}
+
+// native运行时的时间线span：设置 TEYVAT_PERF_TRACE=文件路径 时启动即开启，退出时由nativeTrace.dumpTrace写成
+// 一个Chrome trace-event JSON，用Perfetto（ui.perfetto.dev）打开即可看到钩子匹配、TSFN派发、
+// 查找窗口、置顶尝试和置顶监控检查在同一条时间轴上。span缓冲区属于整个native运行时，只有这一份
+
+// 执行媒体操作（seconds为快进快退的秒数）
+// 仅在媒体控制器端口未连接时使用，正常情况下媒体按键经MessagePort直达media-preload.js
+function executeMediaAction(action, seconds = 5) {
   if (!browserWindow) {
     console.log('Browser window not available for media action:', action);
     return;
@@ -113,23 +276,15 @@ function executeMediaAction(action) {
     return;
   }
 
-  // 确保浏览器窗口可见并获得焦点
-  try {
-    if (!browserWindow.isVisible()) {
-      browserWindow.show();
-    }
-    if (browserWindow.isMinimized()) {
-      browserWindow.restore();
-    }
-  } catch (err) {
-    console.error('Failed to manage browser window:', err);
+  // 确保浏览器窗口可见
+  if (!ensureBrowserWindowVisible()) {
     return;
   }
 
   // 向浏览器窗口发送媒体控制指令
   switch (action) {
     case 'playPause':
-      executeMediaScript(`
+      return executeMediaScript(`
         (function() {
           try {
             // 尝试查找B站播放器的播放/暂停按钮
@@ -158,17 +313,16 @@ function executeMediaAction(action) {
           }
         })();
       `, action);
-      break;
 
     case 'rewind':
-      executeMediaScript(`
+      return executeMediaScript(`
         (function() {
           try {
             const videos = document.querySelectorAll('video');
             if (videos.length > 0) {
               const video = videos[0];
-              video.currentTime = Math.max(0, video.currentTime - 5);
-              return '视频后退5秒';
+              video.currentTime = Math.max(0, video.currentTime - ${seconds});
+              return '视频后退${seconds}秒';
             } else {
               return '未找到视频元素';
             }
@@ -177,17 +331,16 @@ function executeMediaAction(action) {
           }
         })();
       `, action);
-      break;
 
     case 'forward':
-      executeMediaScript(`
+      return executeMediaScript(`
         (function() {
           try {
             const videos = document.querySelectorAll('video');
             if (videos.length > 0) {
               const video = videos[0];
-              video.currentTime = Math.min(video.duration || video.currentTime + 5, video.currentTime + 5);
-              return '视频快进5秒';
+              video.currentTime = Math.min(video.duration || video.currentTime + ${seconds}, video.currentTime + ${seconds});
+              return '视频快进${seconds}秒';
             } else {
               return '未找到视频元素';
             }
@@ -196,7 +349,6 @@ function executeMediaAction(action) {
           }
         })();
       `, action);
-      break;
 
     default:
       console.log('Unknown media action:', action);
@@ -210,7 +362,7 @@ function executeMediaScript(script, action) {
     return;
   }
 
-  browserWindow.webContents.executeJavaScript(script)
+  return browserWindow.webContents.executeJavaScript(script)
     .then(result => {
       console.log('Media action result:', result);
     })
@@ -236,13 +388,26 @@ function initializeHighPriorityShortcuts() {
   
   try {
     // 安装钩子
-    highPriorityShortcut.installHook((action) => {
-      handleShortcut(action);
+    highPriorityShortcut.installHook((action, event) => {
+      handleShortcut(action, event);
     });
     
     // 注册快捷键
     const shortcuts = store.get('shortcuts');
-    highPriorityShortcut.registerShortcuts(shortcuts);
+    highPriorityShortcut.registerShortcuts(shortcuts, shortcutOptions());
+    
+    // 设置 TEYVAT_INPUT_TRACE=文件路径 时录制原始输入，用于复现"按了快捷键没反应"的问题
+    // 退出时自动结束录制，之后用 trace_replay 重放
+    if (process.env.TEYVAT_INPUT_TRACE && highPriorityShortcut.startTrace) {
+      try {
+        const trace = highPriorityShortcut.startTrace(process.env.TEYVAT_INPUT_TRACE);
+        if (trace) {
+          console.log('Recording input trace to', trace.path);
+        }
+      } catch (err) {
+        console.error('Failed to start input trace:', err);
+      }
+    }
     
     console.log('High-priority shortcuts initialized successfully');
     return true;
@@ -258,8 +423,13 @@ function updateShortcuts(newShortcuts) {
   
   if (highPriorityShortcut) {
     try {
-      highPriorityShortcut.registerShortcuts(newShortcuts);
-      console.log('Shortcuts updated successfully');
+      // 监听中直接原子替换键位表，钩子不卸载，更新期间不会丢失按键
+      if (highPriorityShortcut.updateShortcuts(newShortcuts, shortcutOptions())) {
+        console.log('Shortcuts hot-swapped successfully');
+      } else {
+        highPriorityShortcut.registerShortcuts(newShortcuts, shortcutOptions());
+        console.log('Shortcuts updated successfully');
+      }
     } catch (err) {
       console.error('Failed to update shortcuts:', err);
     }
@@ -357,6 +527,8 @@ function createBrowserWindow(url) {
     webPreferences: {
       nodeIntegration: false,
       contextIsolation: true,
+      // 常驻媒体控制器，运行在隔离环境，不向网页暴露API
+      preload: path.join(__dirname, 'media-preload.js')
     }
   });
 
@@ -378,12 +550,9 @@ function createBrowserWindow(url) {
     if (highPriorityTopmost && highPriorityTopmost.isAvailable()) {
       setTimeout(() => {
         console.log('Starting advanced topmost monitoring');
-        try {
-          const result = startAdvancedTopmost();
-          console.log('Advanced topmost result:', result);
-        } catch (err) {
-          console.error('Advanced topmost error:', err);
-        }
+        startAdvancedTopmost()
+          .then(result => console.log('Advanced topmost result:', result))
+          .catch(err => console.error('Advanced topmost error:', err));
       }, 2000);
     }
   });
@@ -412,7 +581,17 @@ function createBrowserWindow(url) {
   browserWindow.on('resize', debouncedSaveBounds);
   browserWindow.on('move', debouncedSaveBounds);
 
+  // 显示时立即恢复优先级，隐藏/最小化后交给资源调控模块降级
+  for (const event of ['show', 'hide', 'minimize', 'restore']) {
+    browserWindow.on(event, updateResourceGovernor);
+  }
+
   browserWindow.on('closed', () => {
+    // 断开媒体控制端口，媒体按键回到普通回调路径
+    if (highPriorityShortcut && highPriorityShortcut.setEventPort) {
+      highPriorityShortcut.setEventPort(null);
+    }
+    
     // 停止topmost监控
     if (highPriorityTopmost && highPriorityTopmost.isAvailable()) {
       try {
@@ -424,6 +603,7 @@ function createBrowserWindow(url) {
     }
     
     browserWindow = null;
+    updateResourceGovernor();
     if (mainWindow) {
       mainWindow.webContents.send('browser-window-closed');
     }
@@ -490,15 +670,32 @@ function adjustBrowserOpacity(delta) {
 }
 
 // 启动高级置顶功能（带重试机制）
-function startAdvancedTopmost(retryCount = 3) {
+async function startAdvancedTopmost(retryCount = 3) {
   if (!browserWindow || !highPriorityTopmost || !highPriorityTopmost.isAvailable()) {
     return false;
   }
   
-  // 获取所有可见窗口用于调试
   try {
-    const allWindows = highPriorityTopmost.getVisibleWindows();
-    console.log('Available windows:', allWindows.map(w => w.title).slice(0, 5)); // 只显示前5个
+    // 优先直接使用原生窗口句柄，不需要枚举任何窗口
+    // 置顶操作在原生工作线程执行，不阻塞主进程事件循环
+    try {
+      if (await highPriorityTopmost.startMonitoringAsync(browserWindow.getNativeWindowHandle())) {
+        console.log('Advanced topmost monitoring started with native window handle');
+        return true;
+      }
+    } catch (err) {
+      console.log('Failed to monitor native window handle:', err.message);
+    }
+    
+    // 句柄方式失败时退回标题匹配（原生模块会缓存标题对应的句柄）
+    // 获取所有可见窗口用于调试（快照在原生工作线程生成，只解码前5个标题）
+    highPriorityTopmost.getWindowSnapshot().then(snapshot => {
+      const titles = [];
+      for (let i = 0; i < Math.min(snapshot.length, 5); i++) {
+        titles.push(snapshot.title(i));
+      }
+      console.log('Available windows:', titles); // 只显示前5个
+    }).catch(err => console.error('Failed to get window snapshot:', err));
     
     // 尝试多种窗口标题匹配策略
     const actualTitle = browserWindow.getTitle();
@@ -511,18 +708,23 @@ function startAdvancedTopmost(retryCount = 3) {
       'Teyvat'                // 部分匹配
     ];
     
+    // 一次枚举同时匹配所有候选标题，按优先级取第一个命中的窗口句柄
+    const candidates = titleVariants.filter(title => title && title.trim());
+    const matches = highPriorityTopmost.findWindows(candidates);
+    
     let success = false;
-    for (const title of titleVariants) {
-      if (title && title.trim()) {
+    for (let i = 0; i < candidates.length; i++) {
+      if (matches[i] && matches[i].length > 0) {
+        const match = matches[i][0];
         try {
-          console.log(`Trying to monitor window with title: "${title}"`);
-          success = highPriorityTopmost.startMonitoring(title);
+          console.log(`Trying to monitor window "${match.title}" matched by "${candidates[i]}"`);
+          success = await highPriorityTopmost.startMonitoringAsync(match.handle);
           if (success) {
-            console.log(`Advanced topmost monitoring started successfully with title: "${title}"`);
+            console.log(`Advanced topmost monitoring started successfully with title: "${candidates[i]}"`);
             break;
           }
         } catch (err) {
-          console.log(`Failed to monitor "${title}":`, err.message);
+          console.log(`Failed to monitor "${candidates[i]}":`, err.message);
         }
       }
     }
@@ -578,12 +780,9 @@ function toggleAdvancedTopmost(enable = null) {
     
     // 尝试高级置顶（如果可用）
     if (highPriorityTopmost && highPriorityTopmost.isAvailable()) {
-      try {
-        const result = startAdvancedTopmost();
-        console.log('Advanced topmost result:', result);
-      } catch (err) {
-        console.error('Error with advanced topmost:', err);
-      }
+      startAdvancedTopmost()
+        .then(result => console.log('Advanced topmost result:', result))
+        .catch(err => console.error('Error with advanced topmost:', err));
     }
     return true;
   } else {
@@ -621,6 +820,20 @@ ipcMain.on('navigate-browser', (event, url) => {
   }
 });
 
+// 播放器窗口每次加载页面后，媒体控制器索取端口：新建一对MessagePort，
+// 一端交给渲染进程，另一端接到native事件流上（旧页面的端口随页面销毁自动关闭）
+ipcMain.on('media-controller-ready', (event) => {
+  if (!browserWindow || browserWindow.isDestroyed() || event.sender !== browserWindow.webContents) {
+    return;
+  }
+  if (!highPriorityShortcut || !highPriorityShortcut.setEventPort) {
+    return;
+  }
+  const { port1, port2 } = new MessageChannelMain();
+  event.sender.postMessage('media-port', null, [port2]);
+  highPriorityShortcut.setEventPort(port1, MEDIA_ACTION_CODES);
+});
+
 ipcMain.on('adjust-opacity', (_, newOpacity) => {
   if (browserWindow) {
     store.set('browserOpacity', newOpacity);
@@ -632,7 +845,8 @@ ipcMain.on('get-initial-settings', (event) => {
   event.reply('initial-settings', {
     shortcuts: store.get('shortcuts'),
     opacity: store.get('browserOpacity'),
-    enableGpu: store.get('enableGpuAcceleration')
+    enableGpu: store.get('enableGpuAcceleration'),
+    swallowMouseButtons: store.get('swallowMouseButtons')
   });
 });
 
@@ -644,6 +858,12 @@ ipcMain.on('set-gpu-acceleration', (event, enabled) => {
   store.set('enableGpuAcceleration', enabled);
 });
 
+// 立即生效：切换鼠标通道时native层会重启输入后端
+ipcMain.on('set-mouse-swallow', (event, enabled) => {
+  store.set('swallowMouseButtons', !!enabled);
+  updateShortcuts(store.get('shortcuts'));
+});
+
 ipcMain.on('toggle-advanced-topmost', (event, enabled) => {
   const success = toggleAdvancedTopmost(enabled);
   event.reply('advanced-topmost-result', {
@@ -662,8 +882,12 @@ ipcMain.on('get-topmost-status', (event) => {
 });
 
 app.whenReady().then(() => {
+  if (process.env.TEYVAT_PERF_TRACE) {
+    nativeTrace.setTraceEvents(true);
+  }
   createMainWindow();
   initializeHighPriorityShortcuts();
+  startResourceGovernor();
 });
 
 app.on('window-all-closed', () => {
@@ -673,6 +897,11 @@ app.on('window-all-closed', () => {
 });
 
 app.on('will-quit', () => {
+  if (process.env.TEYVAT_PERF_TRACE) {
+    nativeTrace.setTraceEvents(false);
+    nativeTrace.dumpTrace(process.env.TEYVAT_PERF_TRACE);
+  }
+  
   // 清理快捷键资源
   if (highPriorityShortcut) {
     try {
@@ -682,6 +911,9 @@ app.on('will-quit', () => {
     }
   }
   
+  // 恢复所有进程原有的优先级和CPU亲和性
+  resourceGovernor.stop();
+  
   // 清理topmost监控资源
   if (highPriorityTopmost && highPriorityTopmost.isAvailable()) {
     try {
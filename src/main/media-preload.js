@@ -0,0 +1,138 @@
+const { ipcRenderer } = require('electron');
+
+// 播放器窗口的常驻媒体控制器
+// 运行在预加载脚本的隔离环境中，不向网页暴露任何API；与网页共享同一个DOM
+// 主进程通过专用的MessagePort发来紧凑的动作编码，这里直接操作缓存好的视频元素和播放按钮，
+// 每次按键不再拼接、编译脚本，也不再重新querySelectorAll
+
+// 动作编码，与main.js中的MEDIA_ACTION_CODES保持一致
+const ACTION_PLAY_PAUSE = 1;
+const ACTION_REWIND = 2;
+const ACTION_FORWARD = 3;
+
+// 事件类型编码，与native/lib/binding.js中的PORT_TRIGGERS保持一致
+const TRIGGER_PRESS = 0;
+const TRIGGER_REPEAT = 2;
+
+const PLAY_BUTTON_SELECTOR = '.bpx-player-ctrl-play, .bilibili-player-video-btn-start';
+
+// 按住期间第count次触发的跳转秒数：5、10、20，最多30（同main.js的scrubStepSeconds）
+function scrubStepSeconds(trigger, count) {
+  if (trigger === TRIGGER_PRESS) {
+    return 5;
+  }
+  const tick = trigger === TRIGGER_REPEAT ? count : 0;
+  return Math.min(30, 5 * Math.pow(2, Math.floor(tick / 4) + 1));
+}
+
+// 视频元素与B站播放按钮的缓存
+// MutationObserver只在相关节点增删时标记失效，真正的重新查找推迟到下一次按键
+const cache = {
+  video: null,
+  playButton: null,
+  stale: true
+};
+
+function refreshCache() {
+  cache.video = document.querySelector('video');
+  cache.playButton = document.querySelector(PLAY_BUTTON_SELECTOR);
+  cache.stale = false;
+}
+
+function mediaElements() {
+  if (cache.stale ||
+      (cache.video && !cache.video.isConnected) ||
+      (cache.playButton && !cache.playButton.isConnected)) {
+    refreshCache();
+  }
+  return cache;
+}
+
+// 新增节点本身或其子树中出现视频/播放按钮时才需要重新查找；
+// 弹幕这类频繁插入的叶子节点只做一次标签比较
+function touchesMedia(node) {
+  if (node.nodeType !== Node.ELEMENT_NODE) {
+    return false;
+  }
+  if (node.tagName === 'VIDEO' || node.matches(PLAY_BUTTON_SELECTOR)) {
+    return true;
+  }
+  return node.firstElementChild !== null &&
+    (node.getElementsByTagName('video').length > 0 || node.querySelector(PLAY_BUTTON_SELECTOR) !== null);
+}
+
+const observer = new MutationObserver((mutations) => {
+  if (cache.stale) {
+    return;
+  }
+  for (const mutation of mutations) {
+    for (const node of mutation.addedNodes) {
+      if (touchesMedia(node)) {
+        cache.stale = true;
+        return;
+      }
+    }
+    // 移除由mediaElements()的isConnected检查处理
+  }
+});
+observer.observe(document, { childList: true, subtree: true });
+
+function runAction(code, trigger, count) {
+  const { video, playButton } = mediaElements();
+  switch (code) {
+    case ACTION_PLAY_PAUSE:
+      // 优先点击B站播放器按钮，保持其界面状态一致
+      if (playButton) {
+        playButton.click();
+      } else if (video) {
+        if (video.paused) {
+          video.play().catch(() => {});
+        } else {
+          video.pause();
+        }
+      }
+      break;
+    case ACTION_REWIND:
+      if (video) {
+        video.currentTime = Math.max(0, video.currentTime - scrubStepSeconds(trigger, count));
+      }
+      break;
+    case ACTION_FORWARD:
+      if (video) {
+        const target = video.currentTime + scrubStepSeconds(trigger, count);
+        video.currentTime = Math.min(video.duration || target, target);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+// 每条消息为 [code, trigger, count, sequence, ...]，处理完回发sequence列表用于端到端延迟统计
+function connectPort(port) {
+  port.onmessage = (message) => {
+    const data = message.data;
+    if (!Array.isArray(data)) {
+      return;
+    }
+    const handled = [];
+    for (let i = 0; i + 3 < data.length; i += 4) {
+      try {
+        runAction(data[i], data[i + 1], data[i + 2]);
+      } catch (err) {
+        console.error('[media] action failed:', err.message);
+      }
+      handled.push(data[i + 3]);
+    }
+    port.postMessage(handled);
+  };
+}
+
+ipcRenderer.on('media-port', (event) => {
+  if (event.ports && event.ports[0]) {
+    connectPort(event.ports[0]);
+  }
+});
+
+// 每次页面加载（含跳转）预加载脚本都会重新运行，向主进程索取新的端口
+ipcRenderer.send('media-controller-ready');
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Machine-readable benchmark results shared by the bench executables.
+//
+// Suites keep printing their human-readable lines and additionally report
+// headline numbers with BenchMetric(). Given --json=<file>, main() writes
+// them as one JSON document:
+//
+//   {"bench": "shortcut_bench", "label": "...", "failures": 0,
+//    "metrics": [{"suite": "match", "name": "flat_hit", "value": 2.1, "unit": "ns/event"}, ...]}
+//
+// label comes from $BENCH_LABEL (e.g. a commit hash). bench/compare.js
+// diffs two such files; units ending in "/s" or "x" are higher-is-better,
+// everything else lower-is-better.
+
+struct BenchMetricEntry {
+    std::string suite;
+    std::string name;
+    double value;
+    std::string unit;
+};
+
+inline std::vector<BenchMetricEntry>& BenchMetrics() {
+    static std::vector<BenchMetricEntry> metrics;
+    return metrics;
+}
+
+inline void BenchMetric(const char* suite, const std::string& name, double value, const char* unit) {
+    BenchMetrics().push_back(BenchMetricEntry{suite, name, value, unit});
+}
+
+inline double BenchElapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Removes a --json=<path> argument from argv; returns the path or ""
+inline std::string TakeJsonOption(int& argc, char** argv) {
+    std::string path;
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--json=", 7) == 0) {
+            path = argv[i] + 7;
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    return path;
+}
+
+inline void WriteJsonString(FILE* file, const std::string& text) {
+    fputc('"', file);
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            fputc('\\', file);
+            fputc(c, file);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            fprintf(file, "\\u%04x", c);
+        } else {
+            fputc(c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+inline bool WriteBenchJson(const std::string& path, const char* bench, int failures) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        fprintf(stderr, "cannot write %s\n", path.c_str());
+        return false;
+    }
+    const char* label = getenv("BENCH_LABEL");
+    fprintf(file, "{\"bench\": ");
+    WriteJsonString(file, bench);
+    fprintf(file, ", \"label\": ");
+    WriteJsonString(file, label ? label : "");
+    fprintf(file, ", \"failures\": %d, \"metrics\": [", failures);
+    const std::vector<BenchMetricEntry>& metrics = BenchMetrics();
+    for (size_t i = 0; i < metrics.size(); i++) {
+        fprintf(file, "%s\n  {\"suite\": ", i ? "," : "");
+        WriteJsonString(file, metrics[i].suite);
+        fprintf(file, ", \"name\": ");
+        WriteJsonString(file, metrics[i].name);
+        fprintf(file, ", \"value\": %.6g, \"unit\": ", metrics[i].value);
+        WriteJsonString(file, metrics[i].unit);
+        fprintf(file, "}");
+    }
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
@@ -0,0 +1,90 @@
+#!/usr/bin/env node
+'use strict';
+
+// Compares two benchmark result files written with --json=<file> by
+// shortcut_bench / topmost_bench (see bench_report.h).
+//
+//   node bench/compare.js <base.json> <head.json> [--threshold=10]
+//
+// Prints every metric present in both files with its relative change.
+// Units ending in "/s" or "x" are higher-is-better, everything else
+// lower-is-better. Exits 1 if any metric regressed by more than the
+// threshold (percent), or if the head run reported failures.
+
+const fs = require('fs');
+
+function usage() {
+  console.error('usage: node bench/compare.js <base.json> <head.json> [--threshold=percent]');
+  process.exit(2);
+}
+
+function load(path) {
+  let data;
+  try {
+    data = JSON.parse(fs.readFileSync(path, 'utf8'));
+  } catch (error) {
+    console.error(`cannot read ${path}: ${error.message}`);
+    process.exit(2);
+  }
+  const metrics = new Map();
+  for (const metric of data.metrics || []) {
+    metrics.set(`${metric.suite}/${metric.name}`, metric);
+  }
+  return { bench: data.bench, label: data.label || path, failures: data.failures || 0, metrics };
+}
+
+function higherIsBetter(unit) {
+  return unit.endsWith('/s') || unit === 'x';
+}
+
+function formatValue(value) {
+  return Math.abs(value) >= 1000 ? value.toExponential(3) : value.toFixed(2);
+}
+
+function main(argv) {
+  let threshold = 10;
+  const files = [];
+  for (const arg of argv) {
+    if (arg.startsWith('--threshold=')) {
+      threshold = Number(arg.slice('--threshold='.length));
+      if (!Number.isFinite(threshold) || threshold < 0) usage();
+    } else {
+      files.push(arg);
+    }
+  }
+  if (files.length !== 2) usage();
+
+  const base = load(files[0]);
+  const head = load(files[1]);
+  if (base.bench !== head.bench) {
+    console.error(`warning: comparing ${base.bench} against ${head.bench}`);
+  }
+
+  console.log(`${base.bench}: ${base.label} -> ${head.label} (threshold ${threshold}%)`);
+  const regressions = [];
+  for (const [key, after] of head.metrics) {
+    const before = base.metrics.get(key);
+    if (!before) {
+      console.log(`  ${key.padEnd(36)} ${''.padStart(10)} ${formatValue(after.value).padStart(10)} ${after.unit}  (new)`);
+      continue;
+    }
+    let change = 0;
+    if (before.value !== 0) change = ((after.value - before.value) / Math.abs(before.value)) * 100;
+    // Positive = worse, whichever direction the unit prefers
+    const worse = higherIsBetter(after.unit) ? -change : change;
+    const mark = worse > threshold ? '  REGRESSION' : worse < -threshold ? '  improved' : '';
+    if (worse > threshold) regressions.push(key);
+    const sign = change >= 0 ? '+' : '';
+    console.log(`  ${key.padEnd(36)} ${formatValue(before.value).padStart(10)} ${formatValue(after.value).padStart(10)} ` +
+      `${after.unit.padEnd(10)} ${(sign + change.toFixed(1) + '%').padStart(8)}${mark}`);
+  }
+  for (const key of base.metrics.keys()) {
+    if (!head.metrics.has(key)) console.log(`  ${key.padEnd(36)} (missing in head)`);
+  }
+
+  if (head.failures) console.log(`head run reported ${head.failures} failing suite(s)`);
+  if (regressions.length) console.log(`${regressions.length} metric(s) regressed by more than ${threshold}%`);
+  return regressions.length || head.failures ? 1 : 0;
+}
+
+process.exit(main(process.argv.slice(2)));
@@ -0,0 +1,1699 @@
+// Shortcut engine benchmarks.
+//
+// match: drives the hook-side matching logic with synthetic key events and
+//        compares the original std::map + std::string path against the flat
+//        ShortcutTable, then the cost of a hit and a miss through the table
+//        alone and through the whole engine.
+// ring:  stress-tests the hook -> JS EventQueue with a producer thread
+//        standing in for the hook and a consumer woken like the TSFN.
+// latency: cost of recording into the latency histograms and accuracy of
+//        the reported percentiles.
+// swap:  publishes rebuilt keymaps while a producer thread matches key
+//        presses; every press must match and publish must stay in the
+//        microsecond range.
+// seq:   chord sequences ("Ctrl+K, P", "Insert Insert") on synthetic event
+//        streams: checks completion, timeouts, broken sequences, autorepeat
+//        and pass-through of leading strokes, then the per-event cost with
+//        and without sequence bindings in the table.
+// repeat: autorepeat policies on a held key: drop delivers the first press
+//        only, rate caps deliveries per interval, coalesce sums repeats into
+//        events whose counts add up to every press; then the cost per repeat.
+// hold:  press / hold / repeat-while-held / release triggers served by the
+//        timer wheel thread: event order, tick spacing, nothing after the
+//        release, and the input-thread cost of a timed press + release.
+// keymap: key-name table and keymap compiler: canonical spelling, format ->
+//        parse round trip for every named key, error messages, duplicate
+//        and conflict reports, then parse, StringToVk and name lookup cost.
+// profile: per-application keymap profiles switched by focus changes: keys
+//        pass through where a profile unbinds them, sequences survive a
+//        switch, a republished table re-matches the focused app; then the
+//        cost of a switch and of a miss with and without profiles, and
+//        presses racing focus changes.
+// trace: records a synthetic input stream (sequences, autorepeat, injected
+//        events) into a mapped trace file, replays it into a fresh engine
+//        and checks the actions match the live run; then the input-thread
+//        cost of recording. See also trace_replay for real captures.
+// spans: timeline spans for the Chrome trace-event export: cost of a span
+//        with tracing off and on, ring overwrite accounting, and dumps taken
+//        while another thread keeps recording must only contain whole
+//        events, in order.
+// watchdog: the input watchdog against a backend whose hook can be killed:
+//        the dead hook must be reinstalled, and events left undrained
+//        must count one consumer stall and re-send the wakeup.
+// evdev: (Linux) the full engine behind the evdev backend, fed by a uinput
+//        loopback keyboard. Needs write access to /dev/uinput and read
+//        access to the created /dev/input node; skipped otherwise.
+// mouse: (Linux) side-button matching under a stream of pointer motion from
+//        a uinput loopback mouse, once through the full mouse stream
+//        (mouseHook, the default) and once through the opt-in
+//        event-masked button path: events the reader handled and reader CPU
+//        time per move, and every side-button press must match in both.
+//        Same requirements as evdev. The Windows counterpart, WH_MOUSE_LL
+//        against Raw Input, is not measured: it needs real pointer input on
+//        an interactive Windows desktop.
+// Runs anywhere; no Win32 headers are needed.
+//
+// --json=<file> also writes the headline numbers as JSON (see
+// bench_report.h); compare two runs with bench/compare.js.
+//
+// Usage: shortcut_bench [match|ring|latency|swap|seq|repeat|hold|keymap|profile|trace|spans|watchdog|evdev|mouse|all] [events=10000000] [hitPercent=2] [--json=file]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_report.h"
+#include "../src/shortcut_core.h"
+#include "../src/key_names.h"
+#include "../src/input_watchdog.h"
+#include "../src/keymap_compiler.h"
+#include "../src/keymap_profiles.h"
+#include "../src/trace_events.h"
+#include "../src/trace_replay.h"
+
+#ifdef SHORTCUT_BENCH_EVDEV
+#include <unistd.h>
+#include "../src/input_backend_evdev.h"
+#endif
+
+namespace {
+
+struct Binding {
+    const char* action;
+    uint32_t modifiers;
+    uint32_t vkCode;
+};
+
+const Binding kDefaultBindings[] = {
+    { "toggleBrowser", 0, VK_INSERT },
+    { "playPause", 0, VK_F1 },
+    { "rewind", 0, VK_F1 + 1 },
+    { "forward", 0, VK_F1 + 2 },
+    { "increaseOpacity", kModControl, VK_UP },
+    { "decreaseOpacity", kModControl, VK_DOWN },
+};
+
+struct SyntheticEvent {
+    uint32_t modifiers;
+    uint32_t vkCode;
+};
+
+std::vector<SyntheticEvent> MakeEvents(size_t count, int hitPercent) {
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::uniform_int_distribution<size_t> bindingPick(0, sizeof(kDefaultBindings) / sizeof(kDefaultBindings[0]) - 1);
+    // Misses are plain letter keys, some with Shift held
+    std::uniform_int_distribution<uint32_t> letter('A', 'Z');
+
+    std::vector<SyntheticEvent> events;
+    events.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        if (percent(rng) < hitPercent) {
+            const Binding& b = kDefaultBindings[bindingPick(rng)];
+            events.push_back({ b.modifiers, b.vkCode });
+        } else {
+            uint32_t modifiers = percent(rng) < 10 ? kModShift : 0;
+            events.push_back({ modifiers, letter(rng) });
+        }
+    }
+    return events;
+}
+
+// Stand-in for tsfn.NonBlockingCall: the queue takes ownership of a callable
+struct FakeQueue {
+    std::vector<std::function<void()>> pending;
+
+    void Drain() {
+        for (auto& fn : pending) fn();
+        pending.clear();
+    }
+};
+
+double RunMapPath(const std::vector<SyntheticEvent>& events, uint64_t& hits) {
+    std::map<std::pair<uint32_t, uint32_t>, std::string> keyboardHookMap;
+    for (const Binding& b : kDefaultBindings) {
+        keyboardHookMap[std::make_pair(b.modifiers, b.vkCode)] = b.action;
+    }
+
+    FakeQueue queue;
+    queue.pending.reserve(1024);
+    uint64_t delivered = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const SyntheticEvent& e : events) {
+        auto key = std::make_pair(e.modifiers, e.vkCode);
+        auto it = keyboardHookMap.find(key);
+        if (it != keyboardHookMap.end()) {
+            std::string action = it->second;
+            queue.pending.emplace_back([action, &delivered]() { delivered += action.size(); });
+            if (queue.pending.size() == 1024) queue.Drain();
+        }
+    }
+    queue.Drain();
+    auto end = std::chrono::steady_clock::now();
+
+    hits = delivered;
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+double RunTablePath(const std::vector<SyntheticEvent>& events, uint64_t& hits) {
+    ShortcutTable table;
+    for (const Binding& b : kDefaultBindings) {
+        table.BindKey(b.modifiers, b.vkCode, table.AddAction(b.action));
+    }
+
+    // Ids only; names are resolved once on the consumer side
+    std::vector<ActionId> queue;
+    queue.reserve(1024);
+    const std::vector<std::string>& names = table.ActionNames();
+    uint64_t delivered = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const SyntheticEvent& e : events) {
+        ActionId id = table.MatchKey(e.modifiers, e.vkCode);
+        if (id != kNoAction) {
+            queue.push_back(id);
+            if (queue.size() == 1024) {
+                for (ActionId q : queue) delivered += names[q].size();
+                queue.clear();
+            }
+        }
+    }
+    for (ActionId q : queue) delivered += names[q].size();
+    auto end = std::chrono::steady_clock::now();
+
+    hits = delivered;
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+int RunMatch(size_t count, int hitPercent) {
+    std::vector<SyntheticEvent> events = MakeEvents(count, hitPercent);
+
+    uint64_t mapHits = 0, tableHits = 0;
+    double mapNs = RunMapPath(events, mapHits);
+    double tableNs = RunTablePath(events, tableHits);
+
+    printf("[match] events=%zu hit%%=%d\n", count, hitPercent);
+    printf("map+string   %8.2f ns/event  (%.1f ms)\n", mapNs / count, mapNs / 1e6);
+    printf("flat table   %8.2f ns/event  (%.1f ms)\n", tableNs / count, tableNs / 1e6);
+    printf("speedup      %8.2fx\n", tableNs > 0 ? mapNs / tableNs : 0.0);
+    BenchMetric("match", "map_string", mapNs / count, "ns/event");
+    BenchMetric("match", "flat_table", tableNs / count, "ns/event");
+
+    // Both paths must deliver the same actions
+    if (mapHits != tableHits) {
+        fprintf(stderr, "mismatch: map=%llu table=%llu\n",
+                static_cast<unsigned long long>(mapHits), static_cast<unsigned long long>(tableHits));
+        return 1;
+    }
+
+    // Hits and misses apart: the table lookup alone, then the whole
+    // input-thread path (modifier tracking, table read lock, dispatch into
+    // the event queue) as a backend drives it
+    const size_t split = count > 2000000 ? 2000000 : count;
+    std::vector<SyntheticEvent> hits = MakeEvents(split, 100);
+    std::vector<SyntheticEvent> misses = MakeEvents(split, 0);
+    uint64_t ignored = 0;
+    double tableHitNs = RunTablePath(hits, ignored) / split;
+    double tableMissNs = RunTablePath(misses, ignored) / split;
+
+    ShortcutEngine engine;
+    for (const Binding& binding : kDefaultBindings) {
+        engine.AddBinding(binding.action, FormatKeyStroke(binding.modifiers, binding.vkCode, 0));
+    }
+    engine.PublishBindings();
+    ShortcutEvent batch[kEventRingCapacity];
+    auto engineNs = [&](const std::vector<SyntheticEvent>& events, uint64_t& matched) {
+        auto start = std::chrono::steady_clock::now();
+        for (const SyntheticEvent& e : events) {
+            if (e.modifiers & kModControl) engine.HandleKey(VK_LCONTROL, true, 0, 0);
+            if (e.modifiers & kModShift) engine.HandleKey(VK_LSHIFT, true, 0, 0);
+            if (engine.HandleKey(e.vkCode, true, 0, 0)) matched++;
+            engine.HandleKey(e.vkCode, false, 0, 0);
+            if (e.modifiers & kModShift) engine.HandleKey(VK_LSHIFT, false, 0, 0);
+            if (e.modifiers & kModControl) engine.HandleKey(VK_LCONTROL, false, 0, 0);
+            // Stand-in for the JS thread draining
+            if ((matched & 255) == 255) engine.DrainBatch(batch, kEventRingCapacity, 0);
+        }
+        return BenchElapsedNs(start) / events.size();
+    };
+    uint64_t engineHits = 0, engineMisses = 0;
+    double engineHitNs = engineNs(hits, engineHits);
+    double engineMissNs = engineNs(misses, engineMisses);
+
+    printf("table hit    %8.2f ns/event  miss %8.2f ns/event\n", tableHitNs, tableMissNs);
+    printf("engine hit   %8.2f ns/press  miss %8.2f ns/press (down+up, incl. modifiers)\n", engineHitNs, engineMissNs);
+    BenchMetric("match", "table_hit", tableHitNs, "ns/event");
+    BenchMetric("match", "table_miss", tableMissNs, "ns/event");
+    BenchMetric("match", "engine_hit", engineHitNs, "ns/press");
+    BenchMetric("match", "engine_miss", engineMissNs, "ns/press");
+    if (engineHits != split || engineMisses != 0) {
+        fprintf(stderr, "engine match check failed: hits=%llu of %zu, misses matched=%llu\n",
+                static_cast<unsigned long long>(engineHits), split, static_cast<unsigned long long>(engineMisses));
+        return 1;
+    }
+    return 0;
+}
+
+// Coalescing wakeup, like a libuv async handle behind the TSFN
+struct FakeWakeup {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool signaled = false;
+    bool done = false;
+    uint64_t signals = 0;
+
+    void Signal() {
+        std::lock_guard<std::mutex> lock(mutex);
+        signaled = true;
+        signals++;
+        cv.notify_one();
+    }
+};
+
+int RunRing(size_t count) {
+    EventQueue queue;
+    FakeWakeup wakeup;
+
+    uint64_t received = 0;
+    uint64_t callbacks = 0;
+    uint64_t lastSeq = 0;
+    bool ordered = true;
+
+    std::thread consumer([&]() {
+        ShortcutEvent batch[kEventRingCapacity];
+        for (;;) {
+            bool finished;
+            {
+                std::unique_lock<std::mutex> lock(wakeup.mutex);
+                wakeup.cv.wait(lock, [&]() { return wakeup.signaled || wakeup.done; });
+                wakeup.signaled = false;
+                finished = wakeup.done;
+            }
+            size_t n = queue.Drain(batch, kEventRingCapacity);
+            if (n > 0) callbacks++;
+            for (size_t i = 0; i < n; i++) {
+                if (batch[i].timestamp <= lastSeq) ordered = false;
+                lastSeq = batch[i].timestamp;
+            }
+            received += n;
+            if (finished && n == 0) break;
+        }
+    });
+
+    // Producer: key-mashing bursts with short idle gaps between them
+    uint64_t wakeups = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        ShortcutEvent event;
+        memset(&event, 0, sizeof(event));
+        event.actionId = static_cast<ActionId>(1 + (i & 3));
+        event.flags = kEventDown;
+        event.timestamp = i + 1;
+        if (queue.Publish(event)) {
+            wakeups++;
+            wakeup.Signal();
+        }
+        if ((i & 1023) == 1023) std::this_thread::yield();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(wakeup.mutex);
+        wakeup.done = true;
+        wakeup.cv.notify_one();
+    }
+    consumer.join();
+
+    EventQueueStats stats = queue.Stats();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    printf("[ring] events=%zu capacity=%zu\n", count, kEventRingCapacity);
+    printf("producer     %8.2f ns/publish (includes wakeups)\n", ns / count);
+    printf("delivered    %llu  dropped %llu\n",
+           static_cast<unsigned long long>(stats.delivered), static_cast<unsigned long long>(stats.dropped));
+    printf("wakeups      %llu  callbacks %llu  avg batch %.1f\n",
+           static_cast<unsigned long long>(wakeups), static_cast<unsigned long long>(callbacks),
+           callbacks ? static_cast<double>(received) / callbacks : 0.0);
+    BenchMetric("ring", "publish", ns / count, "ns/event");
+
+    if (received + stats.dropped != count || received != stats.delivered || !ordered) {
+        fprintf(stderr, "ring check failed: received=%llu dropped=%llu ordered=%d\n",
+                static_cast<unsigned long long>(received), static_cast<unsigned long long>(stats.dropped),
+                ordered ? 1 : 0);
+        return 1;
+    }
+    return 0;
+}
+
+int RunLatency(size_t count) {
+    // Log-normal spread centred around 60 us with a long tail, like real hotkey latency
+    std::mt19937_64 rng(777);
+    std::lognormal_distribution<double> dist(11.0, 1.2);
+    std::vector<uint64_t> samples(count);
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = static_cast<uint64_t>(dist(rng));
+    }
+
+    LatencyHistogram histogram;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t sample : samples) {
+        histogram.Record(sample);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+
+    std::vector<uint64_t> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+    LatencySummary summary = histogram.Summarize();
+
+    printf("[latency] samples=%zu buckets=%u\n", count, kLatencyBucketCount);
+    printf("record       %8.2f ns/sample\n", ns / count);
+    BenchMetric("latency", "record", ns / count, "ns/sample");
+
+    struct Check { const char* name; double quantile; uint64_t reported; };
+    const Check checks[] = {
+        { "p50", 0.50, summary.p50 }, { "p90", 0.90, summary.p90 },
+        { "p99", 0.99, summary.p99 }, { "p999", 0.999, summary.p999 },
+    };
+    int failures = 0;
+    for (const Check& check : checks) {
+        uint64_t exact = sorted[static_cast<size_t>(check.quantile * (count - 1))];
+        double error = exact ? std::abs(static_cast<double>(check.reported) - exact) / exact : 0.0;
+        printf("%-5s        exact %9llu ns  reported %9llu ns  error %.2f%%\n", check.name,
+               static_cast<unsigned long long>(exact), static_cast<unsigned long long>(check.reported), error * 100);
+        // One sub-bucket is 1/16 of its octave
+        if (count >= 1000 && error > 0.07) failures++;
+    }
+    if (summary.count != count || summary.min != sorted.front() || summary.max != sorted.back()) failures++;
+    if (failures) fprintf(stderr, "latency check failed\n");
+    return failures ? 1 : 0;
+}
+
+void PrintSummary(const char* name, const LatencySummary& summary) {
+    printf("%-15s n=%-8llu p50 %8.1f us  p99 %8.1f us  p999 %8.1f us  max %8.1f us\n", name,
+           static_cast<unsigned long long>(summary.count), summary.p50 / 1000.0, summary.p99 / 1000.0,
+           summary.p999 / 1000.0, summary.max / 1000.0);
+}
+
+int RunSwap(size_t count) {
+    // F1 stays bound in every table, so each press must match no matter how
+    // the swaps interleave with it
+    ShortcutEngine engine;
+    engine.AddBinding("playPause", "F1");
+    engine.PublishBindings();
+
+    std::atomic<bool> producing(true);
+    uint64_t matched = 0;
+    std::thread producer([&]() {
+        for (size_t i = 0; i < count; i++) {
+            if (engine.HandleKey(0x70, true, 0, 0)) matched++;
+            engine.HandleKey(0x70, false, 0, 0);
+            // Keep the queue from filling; drops do not affect matching
+            if ((i & 255) == 0) engine.ResetQueue();
+        }
+        producing.store(false, std::memory_order_release);
+    });
+
+    // Rebuild and publish alternating keymaps while the producer runs
+    LatencyHistogram compile, publish;
+    uint64_t swaps = 0;
+    while (producing.load(std::memory_order_acquire)) {
+        auto start = std::chrono::steady_clock::now();
+        engine.AddBinding("playPause", "F1");
+        engine.AddBinding((swaps & 1) ? "increaseOpacity" : "decreaseOpacity", "Control+Up");
+        engine.AddBinding("toggleBrowser", "Alt+Shift+B");
+        engine.PendingTable();
+        auto compiled = std::chrono::steady_clock::now();
+        engine.PublishBindings();
+        auto published = std::chrono::steady_clock::now();
+        compile.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(compiled - start).count()));
+        publish.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(published - compiled).count()));
+        swaps++;
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    producer.join();
+    engine.ReclaimTables();
+
+    printf("[swap] presses=%zu swaps=%llu matched=%llu\n", count,
+           static_cast<unsigned long long>(swaps), static_cast<unsigned long long>(matched));
+    LatencySummary compileSummary = compile.Summarize();
+    LatencySummary publishSummary = publish.Summarize();
+    PrintSummary("compile", compileSummary);
+    PrintSummary("publish", publishSummary);
+    BenchMetric("swap", "compile_p50", compileSummary.p50 / 1000.0, "us");
+    BenchMetric("swap", "publish_p50", publishSummary.p50 / 1000.0, "us");
+    BenchMetric("swap", "publish_p99", publishSummary.p99 / 1000.0, "us");
+
+    // Ids are inherited, so the action id of F1 never changes across swaps
+    ActionId playPause = engine.Table().MatchKey(0, 0x70);
+    if (matched != count || playPause != 1) {
+        fprintf(stderr, "swap check failed: matched=%llu of %zu, F1 id=%u\n",
+                static_cast<unsigned long long>(matched), count, static_cast<unsigned>(playPause));
+        return 1;
+    }
+    return 0;
+}
+
+// Down + up; returns whether the down stroke was consumed
+bool Tap(ShortcutEngine& engine, uint32_t vkCode) {
+    bool consumed = engine.HandleKey(vkCode, true, 0, 0);
+    engine.HandleKey(vkCode, false, 0, 0);
+    return consumed;
+}
+
+// Action names dispatched since the last call
+std::vector<std::string> Dispatched(ShortcutEngine& engine) {
+    ShortcutEvent batch[kEventRingCapacity];
+    size_t n = engine.DrainBatch(batch, kEventRingCapacity, SteadyNowNs());
+    std::vector<std::string> names;
+    for (size_t i = 0; i < n; i++) {
+        names.push_back(engine.Table().ActionNames()[batch[i].actionId]);
+    }
+    return names;
+}
+
+int RunSeq(size_t count) {
+    int failures = 0;
+    auto expect = [&](bool ok, const char* what) {
+        if (!ok) {
+            fprintf(stderr, "seq check failed: %s\n", what);
+            failures++;
+        }
+    };
+    auto fired = [](const std::vector<std::string>& names, const char* action) {
+        return names.size() == 1 && names[0] == action;
+    };
+
+    std::vector<KeyStroke> strokes;
+    uint32_t mouseButton = 0;
+    expect(ParseKeySequence("Ctrl + K", &strokes, mouseButton) && strokes.size() == 1 &&
+           strokes[0].modifiers == kModControl && strokes[0].vkCode == 'K', "parse Ctrl + K");
+    expect(ParseKeySequence("Ctrl+,", &strokes, mouseButton) && strokes.size() == 1 &&
+           strokes[0].vkCode == VK_OEM_COMMA, "parse Ctrl+,");
+    expect(ParseKeySequence("Ctrl+K, Ctrl+S", &strokes, mouseButton) && strokes.size() == 2 &&
+           strokes[1].modifiers == kModControl && strokes[1].vkCode == 'S', "parse Ctrl+K, Ctrl+S");
+    expect(!ParseKeySequence("F1 XButton1", &strokes, mouseButton), "mouse button inside a sequence");
+
+    ShortcutEngine engine;
+    expect(engine.AddBinding("quickNote", "Ctrl+K, P"), "bind Ctrl+K, P");
+    expect(engine.AddBinding("save", "Ctrl+K, Ctrl+S"), "bind Ctrl+K, Ctrl+S");
+    expect(engine.AddBinding("toggleBrowser", "Insert Insert", 300), "bind Insert Insert");
+    expect(engine.AddBinding("playPause", "F1"), "bind F1");
+    expect(engine.AddBinding("forward", "F5 F6", 20), "bind F5 F6");
+    expect(!engine.AddBinding("conflict", "Ctrl+K"), "prefix of a sequence rejected");
+    expect(!engine.AddBinding("conflict", "Ctrl+K, Ctrl+S, A"), "sequence through a sequence binding rejected");
+    expect(!engine.AddBinding("conflict", "F1, A"), "sequence through a binding rejected");
+    expect(!engine.AddBinding("conflict", "Insert Insert Insert"), "sequence extending a binding rejected");
+    engine.PublishBindings();
+
+    // Ctrl+K, P: the leading stroke passes through, the last one is consumed
+    engine.HandleKey(VK_LCONTROL, true, 0, 0);
+    expect(!Tap(engine, 'K'), "leading stroke passes through");
+    engine.HandleKey(VK_LCONTROL, false, 0, 0);
+    expect(Tap(engine, 'P'), "final stroke consumed");
+    expect(fired(Dispatched(engine), "quickNote"), "Ctrl+K, P fires");
+
+    // Ctrl held across both strokes
+    engine.HandleKey(VK_LCONTROL, true, 0, 0);
+    Tap(engine, 'K');
+    Tap(engine, 'S');
+    engine.HandleKey(VK_LCONTROL, false, 0, 0);
+    expect(fired(Dispatched(engine), "save"), "Ctrl+K, Ctrl+S fires");
+
+    // Double tap
+    Tap(engine, VK_INSERT);
+    Tap(engine, VK_INSERT);
+    expect(fired(Dispatched(engine), "toggleBrowser"), "Insert Insert fires");
+
+    // Holding the key is autorepeat, not a second tap
+    engine.HandleKey(VK_INSERT, true, 0, 0);
+    engine.HandleKey(VK_INSERT, true, 0, 0);
+    engine.HandleKey(VK_INSERT, true, 0, 0);
+    engine.HandleKey(VK_INSERT, false, 0, 0);
+    expect(Dispatched(engine).empty(), "autorepeat does not complete Insert Insert");
+    std::this_thread::sleep_for(std::chrono::milliseconds(350));
+
+    // Too slow
+    Tap(engine, VK_F1 + 4);
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    expect(!Tap(engine, VK_F1 + 5), "stroke after a timeout passes through");
+    expect(Dispatched(engine).empty(), "timeout cancels F5 F6");
+
+    // A broken sequence re-matches the breaking stroke from the root
+    engine.HandleKey(VK_LCONTROL, true, 0, 0);
+    Tap(engine, 'K');
+    engine.HandleKey(VK_LCONTROL, false, 0, 0);
+    expect(Tap(engine, VK_F1), "breaking stroke matched from the root");
+    expect(fired(Dispatched(engine), "playPause"), "F1 fires after a broken sequence");
+    expect(!Tap(engine, 'P'), "P alone passes through");
+    expect(Dispatched(engine).empty(), "P alone does not fire");
+
+    // Per-event cost on a stream of mostly unbound keys
+    std::mt19937 rng(7);
+    std::vector<uint32_t> keys(4096);
+    for (uint32_t& vk : keys) {
+        uint32_t roll = rng() % 100;
+        if (roll < 2) vk = VK_F1;
+        else if (roll < 3) vk = VK_INSERT;
+        else vk = 'A' + rng() % 20;
+    }
+    auto measure = [&](ShortcutEngine& target) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; i++) {
+            uint32_t vk = keys[i & (keys.size() - 1)];
+            target.HandleKey(vk, true, 0, 0);
+            target.HandleKey(vk, false, 0, 0);
+            if ((i & 255) == 0) target.ResetQueue();
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / (count * 2.0);
+    };
+    ShortcutEngine flat;
+    flat.AddBinding("playPause", "F1");
+    flat.AddBinding("toggleBrowser", "Insert");
+    flat.PublishBindings();
+
+    printf("[seq] events=%zu\n", count * 2);
+    double flatNs = measure(flat);
+    double dfaNs = measure(engine);
+    printf("flat table    %8.2f ns/event\n", flatNs);
+    printf("sequence DFA  %8.2f ns/event\n", dfaNs);
+    BenchMetric("seq", "flat_table", flatNs, "ns/event");
+    BenchMetric("seq", "dfa", dfaNs, "ns/event");
+    return failures ? 1 : 0;
+}
+
+int RunRepeat(size_t count) {
+    int failures = 0;
+    ShortcutEngine engine;
+    engine.AddBinding("toggleBrowser", "Insert");
+    engine.AddBinding("playPause", "F1");
+    engine.AddBinding("increaseOpacity", "Control+Up");
+    engine.AddBinding("decreaseOpacity", "Control+Down");
+    engine.SetRepeatPolicy("toggleBrowser", RepeatPolicy{kRepeatDrop, 0});
+    engine.SetRepeatPolicy("playPause", RepeatPolicy{kRepeatRate, 5});
+    engine.SetRepeatPolicy("increaseOpacity", RepeatPolicy{kRepeatCoalesce, 5});
+    engine.SetRepeatPolicy("decreaseOpacity", RepeatPolicy{kRepeatCoalesce, 60000});
+    engine.PublishBindings();
+
+    // Held for ~30 ms with a repeat every millisecond
+    // limit = most deliveries a 5 ms interval allows for the time actually held
+    uint32_t limit = 0;
+    auto hold = [&](uint32_t vkCode, int repeats, uint32_t* events, uint32_t* presses) {
+        auto start = std::chrono::steady_clock::now();
+        engine.HandleKey(vkCode, true, 0, 0);
+        for (int i = 0; i < repeats; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            if (!engine.HandleKey(vkCode, true, 0, 0)) failures++;
+        }
+        engine.HandleKey(vkCode, false, 0, 0);
+        auto held = std::chrono::steady_clock::now() - start;
+        limit = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(held).count() / 5 + 2);
+        ShortcutEvent batch[kEventRingCapacity];
+        size_t n = engine.DrainBatch(batch, kEventRingCapacity, SteadyNowNs());
+        *events = static_cast<uint32_t>(n);
+        *presses = 0;
+        for (size_t i = 0; i < n; i++) *presses += batch[i].count;
+    };
+
+    uint32_t events, presses;
+    hold(VK_INSERT, 30, &events, &presses);
+    printf("[repeat] drop      events=%u presses=%u\n", events, presses);
+    if (events != 1) failures++;
+
+    hold(VK_F1, 30, &events, &presses);
+    printf("[repeat] rate      events=%u presses=%u\n", events, presses);
+    if (events < 2 || events > limit) failures++;
+
+    engine.HandleKey(VK_LCONTROL, true, 0, 0);
+    hold(VK_UP, 30, &events, &presses);
+    printf("[repeat] coalesce  events=%u presses=%u\n", events, presses);
+    if (events < 2 || events > limit || presses != 31) failures++;
+
+    // Interval longer than the hold: everything arrives as one event on release
+    hold(VK_DOWN, 30, &events, &presses);
+    printf("[repeat] release   events=%u presses=%u\n", events, presses);
+    if (events != 2 || presses != 31) failures++;
+    engine.HandleKey(VK_LCONTROL, false, 0, 0);
+
+    // Cost of a filtered repeat on the input thread
+    engine.HandleKey(VK_LCONTROL, true, 0, 0);
+    engine.HandleKey(VK_DOWN, true, 0, 0);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        engine.HandleKey(VK_DOWN, true, 0, 0);
+    }
+    auto end = std::chrono::steady_clock::now();
+    engine.HandleKey(VK_DOWN, false, 0, 0);
+    double repeatNs = std::chrono::duration<double, std::nano>(end - start).count() / count;
+    printf("coalesced repeat %8.2f ns/event\n", repeatNs);
+    BenchMetric("repeat", "coalesce", repeatNs, "ns/event");
+
+    if (failures) fprintf(stderr, "repeat check failed\n");
+    return failures ? 1 : 0;
+}
+
+int RunHold(size_t count) {
+    int failures = 0;
+    ShortcutEngine engine;
+    FakeWakeup wakeup;
+    engine.SetDrainRequest([](void* context) {
+        static_cast<FakeWakeup*>(context)->Signal();
+        return true;
+    }, &wakeup);
+    engine.AddBinding("forward", "F3");
+    engine.AddBinding("playPause", "F1");
+    engine.SetTriggerPolicy("forward", TriggerPolicy{kTriggerPress | kTriggerHold | kTriggerRepeat, 30, 10});
+    engine.SetTriggerPolicy("playPause", TriggerPolicy{kTriggerRelease, 0, 0});
+    engine.PublishBindings();
+
+    auto drain = [&](std::vector<ShortcutEvent>* events) {
+        ShortcutEvent batch[kEventRingCapacity];
+        size_t n = engine.DrainBatch(batch, kEventRingCapacity, SteadyNowNs());
+        events->insert(events->end(), batch, batch + n);
+    };
+
+    // Held for 95 ms with OS autorepeat every 5 ms, which the timers replace
+    std::vector<ShortcutEvent> events;
+    engine.HandleKey(VK_F1 + 2, true, 0, 0);
+    auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(95)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        if (!engine.HandleKey(VK_F1 + 2, true, 0, 0)) failures++;
+        drain(&events);
+    }
+    engine.HandleKey(VK_F1 + 2, false, 0, 0);
+    drain(&events);
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    size_t beforeQuiet = events.size();
+    drain(&events);
+    if (events.size() != beforeQuiet) {
+        fprintf(stderr, "hold check failed: %zu events after release\n", events.size() - beforeQuiet);
+        failures++;
+    }
+
+    // press, hold, repeat x N (counts 1..N), release
+    size_t repeats = 0;
+    bool ordered = events.size() >= 3 && events.front().flags == kEventDown &&
+                   events[1].flags == kEventHold && events.back().flags == kEventUp;
+    for (size_t i = 2; ordered && i + 1 < events.size(); i++) {
+        ordered = events[i].flags == (kEventHold | kEventRepeat) && events[i].count == i - 1;
+        repeats++;
+    }
+    printf("[hold] events=%zu repeats=%zu\n", events.size(), repeats);
+    if (!ordered || repeats < 3 || repeats > 8) {
+        fprintf(stderr, "hold check failed: unexpected event stream\n");
+        failures++;
+    }
+    if (ordered && repeats > 0) {
+        double firstMs = (events[1].timestamp - events[0].timestamp) / 1e6;
+        double spacingMs = (events[events.size() - 2].timestamp - events[2].timestamp) / 1e6 /
+                           (repeats > 1 ? repeats - 1 : 1);
+        printf("hold after   %8.2f ms (30)\nrepeat every %8.2f ms (10)\n", firstMs, spacingMs);
+    }
+
+    // Release-only trigger: nothing on the press, one event on the release
+    events.clear();
+    engine.HandleKey(VK_F1, true, 0, 0);
+    drain(&events);
+    size_t onPress = events.size();
+    engine.HandleKey(VK_F1, false, 0, 0);
+    drain(&events);
+    if (onPress != 0 || events.size() != 1 || events[0].flags != kEventUp) {
+        fprintf(stderr, "hold check failed: release trigger\n");
+        failures++;
+    }
+
+    // Input-thread cost of arming and cancelling a hold
+    const size_t presses = count > 1000000 ? 1000000 : count;
+    auto costStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < presses; i++) {
+        engine.HandleKey(VK_F1 + 2, true, 0, 0);
+        engine.HandleKey(VK_F1 + 2, false, 0, 0);
+        if ((i & 63) == 0) engine.ResetQueue();
+    }
+    auto costEnd = std::chrono::steady_clock::now();
+    double pressNs = std::chrono::duration<double, std::nano>(costEnd - costStart).count() / presses;
+    printf("press+release %8.2f ns\n", pressNs);
+    BenchMetric("hold", "press_release", pressNs, "ns/press");
+
+    engine.StopTimers();
+    return failures ? 1 : 0;
+}
+
+int RunKeymap(size_t count) {
+    int failures = 0;
+    auto expect = [&](bool ok, const char* what) {
+        if (!ok) {
+            fprintf(stderr, "keymap check failed: %s\n", what);
+            failures++;
+        }
+    };
+
+    // Canonical spelling
+    std::vector<KeyStroke> strokes;
+    uint32_t mouseButton = 0;
+    std::string error;
+    expect(ParseKeySequence("shift+control+f1", &strokes, mouseButton) &&
+           FormatKeySequence(strokes, mouseButton) == "Ctrl+Shift+F1", "shift+control+f1 -> Ctrl+Shift+F1");
+    expect(ParseKeySequence("cmd + pgdn, ALT+x", &strokes, mouseButton) &&
+           FormatKeySequence(strokes, mouseButton) == "Win+PageDown, Alt+X", "aliases canonicalized");
+    expect(ParseKeySequence("Ctrl++", &strokes, mouseButton) && strokes[0].modifiers == kModControl &&
+           strokes[0].vkCode == VK_OEM_PLUS, "Ctrl++ is the plus key");
+    expect(ParseKeySequence("alt+mouseside2", &strokes, mouseButton) && mouseButton == kMouseXButton2 &&
+           FormatKeySequence(strokes, mouseButton) == "Alt+XButton2", "mouse button canonicalized");
+
+    // Every named key and modifier combination survives format -> parse
+    size_t named = 0;
+    for (uint32_t vkCode = 1; vkCode < kKeyCodeCount; vkCode++) {
+        if (!KeyNameForVk(vkCode)) continue;
+        named++;
+        for (uint32_t modifiers = 0; modifiers < kModifierCombinations; modifiers++) {
+            std::string text = FormatKeyStroke(modifiers, vkCode, 0);
+            KeyStroke stroke = {0, 0};
+            uint32_t button = 0;
+            if (!ParseKeyStroke(text.data(), text.size(), &stroke, button, nullptr) ||
+                stroke.modifiers != modifiers || stroke.vkCode != vkCode || button != 0) {
+                fprintf(stderr, "round trip failed: %s\n", text.c_str());
+                failures++;
+            }
+        }
+    }
+    printf("round trip    %zu named keys x %u modifier sets\n", named, kModifierCombinations);
+
+    // Errors name the offending token instead of binding something else
+    expect(!ParseKeySequence("Ctrl+Hyper+K", &strokes, mouseButton, &error) &&
+           error == "unknown key 'Hyper'", "unknown modifier reported");
+    expect(!ParseKeySequence("Ctrl+Escp", &strokes, mouseButton, &error) &&
+           error == "unknown key 'Escp'", "unknown key reported");
+    expect(!ParseKeySequence("A+B", &strokes, mouseButton, &error) &&
+           error == "'A' is not a modifier", "non-modifier prefix reported");
+    expect(!ParseKeySequence("Ctrl+Shift", &strokes, mouseButton, &error), "modifiers only rejected");
+    expect(!ParseKeySequence("Ctrl+", &strokes, mouseButton, &error), "missing key rejected");
+    expect(!ParseKeySequence("Ctrl++A", &strokes, mouseButton, &error), "empty token rejected");
+
+    // First binding wins; everything else is reported
+    std::vector<KeymapBinding> input = {
+        { "playPause", "F1", kDefaultSequenceTimeoutMs },
+        { "quickNote", "Ctrl+K, P", kDefaultSequenceTimeoutMs },
+        { "zoomIn", "control+shift+up", kDefaultSequenceTimeoutMs },
+        { "bad", "Ctrl+Nope", kDefaultSequenceTimeoutMs },
+        { "playPause", "f1", kDefaultSequenceTimeoutMs },
+        { "zoomOut", "Shift+Ctrl+Up", kDefaultSequenceTimeoutMs },
+        { "kill", "Ctrl+K", kDefaultSequenceTimeoutMs },
+        { "save", "Ctrl+K, P, S", kDefaultSequenceTimeoutMs },
+        { "side", "XButton1", kDefaultSequenceTimeoutMs },
+        { "side2", "x1", kDefaultSequenceTimeoutMs },
+    };
+    CompiledKeymap keymap;
+    expect(!CompileKeymap(input, &keymap), "issues reported");
+    expect(keymap.bindings.size() == 4, "four bindings accepted");
+    expect(keymap.issues.size() == 6, "six issues");
+    if (keymap.issues.size() == 6) {
+        expect(keymap.issues[0].kind == kKeymapInvalid && keymap.issues[0].action == "bad", "invalid entry");
+        expect(keymap.issues[1].kind == kKeymapDuplicate && keymap.issues[1].other == "playPause", "duplicate entry");
+        expect(keymap.issues[2].kind == kKeymapConflict && keymap.issues[2].other == "zoomIn", "same chord conflict");
+        expect(keymap.issues[3].kind == kKeymapConflict && keymap.issues[3].other == "quickNote", "prefix conflict");
+        expect(keymap.issues[4].kind == kKeymapConflict && keymap.issues[4].other == "quickNote", "extension conflict");
+        expect(keymap.issues[5].kind == kKeymapConflict && keymap.issues[5].other == "side", "mouse conflict");
+    }
+    for (const KeymapIssue& issue : keymap.issues) {
+        printf("  %-9s %-9s %-16s %s\n", KeymapIssueKindName(issue.kind), issue.action.c_str(),
+               issue.keys.c_str(), issue.message.c_str());
+    }
+
+    // Accepted bindings go into the engine unchanged
+    ShortcutEngine engine;
+    expect(ApplyKeymap(keymap, &engine) == keymap.bindings.size(), "every accepted binding applies");
+    engine.PublishBindings();
+    expect(engine.Table().MatchKey(kModControl | kModShift, VK_UP) != kNoAction, "canonical binding matches");
+
+    // Parse cost (JS thread, once per binding)
+    const char* samples[] = { "Ctrl+Shift+PageDown", "F12", "alt+numpad5", "Ctrl+K, Ctrl+S", "XButton2" };
+    const size_t parses = count > 1000000 ? 1000000 : count;
+    size_t parsed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < parses; i++) {
+        parsed += ParseKeySequence(samples[i % 5], &strokes, mouseButton) ? strokes.size() : 0;
+    }
+    auto end = std::chrono::steady_clock::now();
+    double parseNs = std::chrono::duration<double, std::nano>(end - start).count() / parses;
+    printf("parse         %8.2f ns/binding\n", parseNs);
+    BenchMetric("keymap", "parse", parseNs, "ns/binding");
+    expect(parsed > 0, "samples parse");
+
+    // StringToVk: the single-stroke entry point the glue and the legacy
+    // hook paths use
+    uint32_t modifiers = 0, vkCode = 0;
+    size_t converted = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < parses; i++) {
+        converted += StringToVk(samples[i % 5], vkCode, modifiers, mouseButton);
+    }
+    end = std::chrono::steady_clock::now();
+    double stringToVkNs = std::chrono::duration<double, std::nano>(end - start).count() / parses;
+    printf("StringToVk    %8.2f ns/key, %.1f M keys/s\n", stringToVkNs, stringToVkNs > 0 ? 1e3 / stringToVkNs : 0.0);
+    BenchMetric("keymap", "string_to_vk", stringToVkNs, "ns/key");
+    BenchMetric("keymap", "string_to_vk_rate", stringToVkNs > 0 ? 1e9 / stringToVkNs : 0.0, "keys/s");
+    // "Ctrl+K, Ctrl+S" is a sequence, not a single stroke
+    expect(converted == parses - (parses + 2) / 5, "StringToVk accepts single strokes only");
+
+    // Name lookup alone: one hash, one probe
+    const char* names[] = { "pagedown", "F12", "Numpad5", "escape", "hyper" };
+    size_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < parses; i++) {
+        const char* name = names[i % 5];
+        found += FindKeyName(name, strlen(name)) != nullptr;
+    }
+    end = std::chrono::steady_clock::now();
+    double lookupNs = std::chrono::duration<double, std::nano>(end - start).count() / parses;
+    printf("lookup        %8.2f ns/name\n", lookupNs);
+    BenchMetric("keymap", "lookup", lookupNs, "ns/name");
+    expect(found == parses - (parses + 1) / 5, "lookups resolve");
+
+    printf("hash seed     %u (first perfect seed %u)\n", key_names::kSeed, key_names::FindSeed());
+    return failures ? 1 : 0;
+}
+
+// Profiles are keyed like the app's: the default keymap everywhere, an
+// editor profile that gives F1/F2 back and moves playPause to Ctrl+Shift+P,
+// and a game profile with nothing but toggleBrowser
+KeymapProfileRule CompileProfile(ShortcutEngine& engine, const char* name,
+                                 const std::vector<KeymapBinding>& bindings,
+                                 std::vector<std::string> processes, std::vector<std::string> windowClasses) {
+    KeymapProfileRule rule;
+    rule.profile = engine.AddProfile(name);
+    rule.processes = processes;
+    rule.windowClasses = windowClasses;
+    CompiledKeymap keymap;
+    CompileKeymap(bindings, &keymap);
+    ApplyKeymap(keymap, &engine, rule.profile);
+    return rule;
+}
+
+int RunProfile(size_t count) {
+    int failures = 0;
+    auto expect = [&](bool ok, const char* what) {
+        if (!ok) {
+            fprintf(stderr, "profile check failed: %s\n", what);
+            failures++;
+        }
+    };
+    auto fired = [](const std::vector<std::string>& names, const char* action) {
+        return names.size() == 1 && names[0] == action;
+    };
+    auto ctrlShiftP = [](ShortcutEngine& engine) {
+        engine.HandleKey(VK_LCONTROL, true, 0, 0);
+        engine.HandleKey(VK_LSHIFT, true, 0, 0);
+        bool consumed = Tap(engine, 'P');
+        engine.HandleKey(VK_LSHIFT, false, 0, 0);
+        engine.HandleKey(VK_LCONTROL, false, 0, 0);
+        return consumed;
+    };
+
+    const std::vector<KeymapBinding> defaults = {
+        { "toggleBrowser", "Insert", kDefaultSequenceTimeoutMs },
+        { "playPause", "F1", kDefaultSequenceTimeoutMs },
+        { "rewind", "F2", kDefaultSequenceTimeoutMs },
+        { "quickNote", "Ctrl+K, N", kDefaultSequenceTimeoutMs },
+    };
+    ShortcutEngine engine;
+    CompiledKeymap keymap;
+    CompileKeymap(defaults, &keymap);
+    ApplyKeymap(keymap, &engine);
+    std::vector<KeymapProfileRule> rules;
+    rules.push_back(CompileProfile(engine, "editor", {
+        { "toggleBrowser", "Insert", kDefaultSequenceTimeoutMs },
+        { "quickNote", "Ctrl+K, N", kDefaultSequenceTimeoutMs },
+        { "playPause", "Ctrl+Shift+P", kDefaultSequenceTimeoutMs },
+    }, { "Code.exe", "code" }, {}));
+    rules.push_back(CompileProfile(engine, "game", {
+        { "toggleBrowser", "Insert", kDefaultSequenceTimeoutMs },
+    }, {}, { "UnityWndClass" }));
+    expect(engine.AddProfile("editor") == rules[0].profile, "profile names are unique");
+    engine.PublishBindings();
+
+    KeymapProfileSwitcher switcher;
+    switcher.SetRules(&engine, engine.Table().Generation(), rules);
+    const ShortcutTable& table = engine.Table();
+    expect(table.ProfileCount() == 3, "default + two profiles");
+
+    // Default profile: F1 is taken
+    expect(Tap(engine, VK_F1) && fired(Dispatched(engine), "playPause"), "F1 in the default profile");
+    expect(!ctrlShiftP(engine), "Ctrl+Shift+P passes through by default");
+
+    // Editor focused (process match, any case): F1 and F2 reach the editor
+    ForegroundApp editor;
+    editor.process = "CODE.EXE";
+    switcher.Select(editor);
+    expect(engine.ActiveProfile(engine.Table()) == rules[0].profile, "editor selected");
+    expect(!Tap(engine, VK_F1) && !Tap(engine, VK_F1 + 1), "F1 / F2 pass through in the editor");
+    expect(ctrlShiftP(engine) && fired(Dispatched(engine), "playPause"), "Ctrl+Shift+P in the editor");
+    expect(Tap(engine, VK_INSERT) && fired(Dispatched(engine), "toggleBrowser"), "Insert in the editor");
+
+    // A sequence started in the editor finishes after the focus moves
+    engine.HandleKey(VK_LCONTROL, true, 0, 0);
+    Tap(engine, 'K');
+    engine.HandleKey(VK_LCONTROL, false, 0, 0);
+    switcher.Select(ForegroundApp());
+    expect(Tap(engine, 'N') && fired(Dispatched(engine), "quickNote"), "sequence across a switch");
+
+    // Game focused (window class match): only Insert is consumed
+    ForegroundApp game;
+    game.process = "YuanShen.exe";
+    game.windowClass = "unitywndclass";
+    switcher.Select(game);
+    expect(!Tap(engine, VK_F1) && !ctrlShiftP(engine), "nothing but Insert in the game");
+    expect(Tap(engine, VK_INSERT) && fired(Dispatched(engine), "toggleBrowser"), "Insert in the game");
+
+    // A new table starts on the default profile until its rules arrive, then
+    // the focused application is matched again without a focus change
+    engine.AddBinding("playPause", "F1");
+    engine.AddBinding("toggleBrowser", "Insert");
+    uint32_t gameProfile = engine.AddProfile("game");
+    std::vector<KeyStroke> insert(1, KeyStroke{0, VK_INSERT});
+    engine.BindStrokes("toggleBrowser", insert, 0, kDefaultSequenceTimeoutMs, gameProfile);
+    engine.PublishBindings();
+    expect(engine.ActiveProfile(engine.Table()) == kDefaultProfile, "published table starts on the default");
+    std::vector<KeymapProfileRule> newRules(1);
+    newRules[0].profile = gameProfile;
+    newRules[0].windowClasses.push_back("UnityWndClass");
+    switcher.SetRules(&engine, engine.Table().Generation(), newRules);
+    expect(engine.ActiveProfile(engine.Table()) == gameProfile, "rules re-match the focused app");
+    expect(!Tap(engine, VK_F1), "F1 passes through in the game after the update");
+    engine.ReclaimTables();
+
+    KeymapProfileStats stats = switcher.Stats();
+    expect(stats.foregroundChanges == 3 && stats.switches == 3, "three focus changes, three switches");
+    expect(stats.app.windowClass == "unitywndclass", "last focused app kept");
+    printf("[profile] profiles=%u changes=%llu switches=%llu\n", engine.Table().ProfileCount(),
+           static_cast<unsigned long long>(stats.foregroundChanges), static_cast<unsigned long long>(stats.switches));
+
+    // Cost of a focus change on the monitor thread (match + one atomic
+    // store), alternating between two profiles so each one switches
+    const size_t switches = count > 1000000 ? 1000000 : count;
+    ForegroundApp apps[2] = { editor, game };
+    switcher.SetRules(&engine, engine.Table().Generation(), rules);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < switches; i++) {
+        switcher.Select(apps[i & 1]);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double switchNs = std::chrono::duration<double, std::nano>(end - start).count() / switches;
+    printf("switch        %8.2f ns/focus change\n", switchNs);
+    BenchMetric("profile", "switch", switchNs, "ns/change");
+
+    // Input thread: a miss with profiles bound costs what it did without
+    ShortcutEngine plain;
+    ApplyKeymap(keymap, &plain);
+    plain.PublishBindings();
+    ShortcutEngine* engines[2] = { &plain, &engine };
+    double missNs[2];
+    for (int e = 0; e < 2; e++) {
+        uint64_t consumed = 0;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; i++) {
+            uint32_t vkCode = 'A' + static_cast<uint32_t>(i % 26);
+            consumed += engines[e]->HandleKey(vkCode, true, 0, 0);
+            engines[e]->HandleKey(vkCode, false, 0, 0);
+        }
+        end = std::chrono::steady_clock::now();
+        missNs[e] = std::chrono::duration<double, std::nano>(end - start).count() / count;
+        expect(consumed == 0, "letters are never consumed");
+    }
+    printf("miss          %8.2f ns/key without profiles, %.2f ns/key with\n", missNs[0], missNs[1]);
+    BenchMetric("profile", "miss_plain", missNs[0], "ns/key");
+    BenchMetric("profile", "miss_profiles", missNs[1], "ns/key");
+
+    // Focus changes racing the input thread: Insert is bound in every
+    // profile, so each press must match whatever profile is active
+    engine.ResetQueue();
+    std::atomic<bool> producing(true);
+    uint64_t matched = 0;
+    std::thread producer([&]() {
+        for (size_t i = 0; i < count; i++) {
+            if (Tap(engine, VK_INSERT)) matched++;
+            if ((i & 255) == 0) engine.ResetQueue();
+        }
+        producing.store(false, std::memory_order_release);
+    });
+    uint64_t flips = 0;
+    while (producing.load(std::memory_order_acquire)) {
+        switcher.Select(apps[flips++ & 1]);
+    }
+    producer.join();
+    printf("race          %llu presses matched across %llu focus changes\n",
+           static_cast<unsigned long long>(matched), static_cast<unsigned long long>(flips));
+    expect(matched == count, "Insert matches in every profile");
+    return failures ? 1 : 0;
+}
+
+uint64_t fakeNowNs = 0;
+
+uint64_t FakeClock() {
+    return fakeNowNs;
+}
+
+int RunTrace(size_t count) {
+    int failures = 0;
+    auto expect = [&](bool ok, const char* what) {
+        if (!ok) {
+            fprintf(stderr, "trace check failed: %s\n", what);
+            failures++;
+        }
+    };
+
+    const std::string path = "/tmp/shortcut_bench_trace.bin";
+    const size_t events = count > 200000 ? 200000 : count;
+    std::vector<KeymapBinding> input = {
+        { "toggleBrowser", "Insert Insert", 300 },
+        { "playPause", "F1", kDefaultSequenceTimeoutMs },
+        { "quickNote", "Ctrl+K, P", kDefaultSequenceTimeoutMs },
+        { "increaseOpacity", "Ctrl+Up", kDefaultSequenceTimeoutMs },
+        { "side", "XButton1", kDefaultSequenceTimeoutMs },
+    };
+    CompiledKeymap keymap;
+    expect(CompileKeymap(input, &keymap), "keymap compiles");
+
+    // Live run on a fake clock: random keys with gaps around the sequence
+    // timeouts, autorepeat bursts and injected events
+    ShortcutEngine live;
+    live.SetClock(FakeClock);
+    ApplyKeymap(keymap, &live);
+    live.SetRepeatPolicy("increaseOpacity", RepeatPolicy{kRepeatCoalesce, 100});
+    live.PublishBindings();
+
+    InputTraceWriter* writer = new InputTraceWriter();
+    std::string error;
+    expect(writer->Open(path, events * 2 + 16, kTracePlatformSynthetic, &error), error.c_str());
+    live.SetInputTrace(writer);
+
+    const uint32_t keys[] = { VK_INSERT, VK_F1, 'K', 'P', VK_UP, 'A', VK_LCONTROL };
+    std::mt19937 rng(7);
+    std::vector<ReplayedAction> liveActions;
+    ShortcutEvent batch[kEventRingCapacity];
+    size_t recordIndex = 0;
+    uint64_t firstNs = 0;
+    auto feed = [&](uint8_t kind, uint32_t code, bool down, bool injected) {
+        uint8_t flags = (down ? kTraceDown : 0) | (injected ? kTraceInjected : 0);
+        InputTraceRecord* traced = live.BeginTrace(kind, code, flags, 0, 0, 0, 0);
+        bool consumed = false;
+        if (!injected) {
+            consumed = kind == kTraceMouse ? live.HandleMouseButton(code, down, 0, 0)
+                                           : live.HandleKey(code, down, 0, 0);
+        }
+        live.EndTrace(traced, consumed);
+        if (recordIndex == 0) firstNs = fakeNowNs;
+        size_t drained = live.DrainBatch(batch, kEventRingCapacity, fakeNowNs);
+        for (size_t j = 0; j < drained; j++) {
+            liveActions.push_back(ReplayedAction{recordIndex, batch[j].timestamp - firstNs, batch[j].actionId,
+                                                 batch[j].flags, batch[j].count});
+        }
+        recordIndex++;
+    };
+
+    fakeNowNs = 1000000000ull;
+    size_t fed = 0;
+    while (fed + 12 < events) {
+        // Gaps up to 1.5 s straddle both sequence timeouts
+        static const uint64_t gapsMs[] = { 1, 30, 120, 290, 310, 900, 1100, 1500 };
+        fakeNowNs += gapsMs[rng() % 8] * 1000000ull + rng() % 1000;
+        uint32_t r = rng() % 16;
+        if (r == 0) {
+            feed(kTraceMouse, kMouseXButton1, true, false);
+            feed(kTraceMouse, kMouseXButton1, false, false);
+            fed += 2;
+            continue;
+        }
+        uint32_t vk = keys[r % 7];
+        bool injected = r == 15;
+        bool ctrl = r % 3 == 0 && vk != VK_LCONTROL;
+        if (ctrl) feed(kTraceKey, VK_LCONTROL, true, false);
+        feed(kTraceKey, vk, true, injected);
+        uint32_t repeats = r == 4 ? 1 + rng() % 8 : 0;
+        for (uint32_t i = 0; i < repeats; i++) {
+            fakeNowNs += 33000000ull;
+            feed(kTraceKey, vk, true, false);
+        }
+        fakeNowNs += 40000000ull;
+        feed(kTraceKey, vk, false, injected);
+        if (ctrl) feed(kTraceKey, VK_LCONTROL, false, false);
+        fed += 2 + repeats + (ctrl ? 2 : 0);
+    }
+    expect(live.InputTrace() != nullptr && live.InputTrace()->Count() == recordIndex, "every event recorded");
+    expect(WriteReplayKeymap(path + ".keymap", keymap, live.Table(), &error), "keymap sidecar written");
+    live.SetInputTrace(nullptr);
+    live.SetClock(nullptr);
+
+    // Replay from the file into a fresh engine
+    InputTraceReader reader;
+    expect(reader.Open(path, &error), "trace reopens");
+    expect(reader.Count() == recordIndex, "record count survives close");
+    expect(reader.Header().finished == 1, "trace closed cleanly");
+    ShortcutEngine replay;
+    expect(LoadReplayKeymap(path + ".keymap", &replay, &error), "keymap sidecar loads");
+    replay.PublishBindings();
+
+    std::vector<ReplayedAction> replayed;
+    ReplayStats stats;
+    expect(ReplayInputTrace(reader.Records(), reader.Count(), &replay, ReplayOptions(), &replayed, &stats),
+           "consumed decisions match");
+    expect(stats.injected > 0, "injected events skipped");
+    bool same = replayed.size() == liveActions.size();
+    for (size_t i = 0; same && i < replayed.size(); i++) {
+        const ReplayedAction& a = replayed[i];
+        const ReplayedAction& b = liveActions[i];
+        same = a.record == b.record && a.offsetNs == b.offsetNs && a.id == b.id && a.flags == b.flags &&
+               a.count == b.count;
+    }
+    expect(same, "replay reproduces the live actions");
+    expect(!liveActions.empty(), "actions fired");
+    printf("trace         %zu records, %zu actions, %zu injected, file %zu bytes\n", reader.Count(),
+           replayed.size(), stats.injected, sizeof(InputTraceHeader) + reader.Count() * sizeof(InputTraceRecord));
+    printf("replay        %8.2f ns/event (p50 %llu, p99 %llu), %.1f M events/s\n",
+           stats.replayed ? static_cast<double>(stats.totalNs) / stats.replayed : 0.0,
+           static_cast<unsigned long long>(stats.p50Ns), static_cast<unsigned long long>(stats.p99Ns),
+           stats.totalNs ? stats.replayed * 1e3 / stats.totalNs : 0.0);
+    BenchMetric("trace", "replay", stats.replayed ? static_cast<double>(stats.totalNs) / stats.replayed : 0.0,
+                "ns/event");
+    reader.Close();
+
+    // Recording cost on the input thread: misses with and without a trace
+    ShortcutEngine engine;
+    for (const Binding& binding : kDefaultBindings) {
+        engine.AddBinding(binding.action, FormatKeyStroke(binding.modifiers, binding.vkCode, 0));
+    }
+    engine.PublishBindings();
+    const size_t presses = count > 1000000 ? 1000000 : count;
+    auto cost = [&]() {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < presses; i++) {
+            InputTraceRecord* traced = engine.BeginTrace(kTraceKey, 'A', kTraceDown, 0, 0, 0, 0);
+            bool consumed = engine.HandleKey('A', (i & 1) == 0, 0, 0);
+            engine.EndTrace(traced, consumed);
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / presses;
+    };
+    double untraced = cost();
+    writer = new InputTraceWriter();
+    expect(writer->Open(path, presses, kTracePlatformSynthetic, &error), "cost trace opens");
+    engine.SetInputTrace(writer);
+    double traced = cost();
+    expect(engine.InputTrace()->Count() == presses && engine.InputTrace()->Dropped() == 0, "cost trace complete");
+    engine.SetInputTrace(nullptr);
+    printf("record        %8.2f ns/event untraced, %8.2f ns/event traced\n", untraced, traced);
+    BenchMetric("trace", "record_untraced", untraced, "ns/event");
+    BenchMetric("trace", "record_traced", traced, "ns/event");
+
+    remove(path.c_str());
+    remove((path + ".keymap").c_str());
+    return failures ? 1 : 0;
+}
+
+// Backend whose hook can be removed behind its back, like Windows does to
+// a hook that overran LowLevelHooksTimeout
+class FlakyBackend : public InputBackend {
+public:
+    FlakyBackend() : alive_(true) {}
+
+    const char* Name() const override { return "flaky"; }
+    bool Start(ShortcutEngine*, const InputBackendOptions&) override { return true; }
+    void Stop() override {}
+    bool KeyboardActive() const override { return alive_; }
+    bool MouseActive() const override { return false; }
+
+    void CheckHealth(uint64_t) override {
+        counters_.probes.fetch_add(1, std::memory_order_relaxed);
+        if (alive_) return;
+        counters_.failures.fetch_add(1, std::memory_order_relaxed);
+        alive_ = true;
+        counters_.reinstalls.fetch_add(1, std::memory_order_relaxed);
+    }
+    InputBackendHealth Health() const override { return counters_.Snapshot(); }
+
+    void Kill() { alive_ = false; }
+
+private:
+    std::atomic<bool> alive_;
+    InputBackendCounters counters_;
+};
+
+// Polls until done() or the timeout; returns the wait in ms, or -1
+template <typename Done>
+double WaitFor(Done done, int timeoutMs) {
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(timeoutMs);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) return -1;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// One JSON object per line, as AppendTraceEventsJson() writes them
+std::vector<std::string> SplitTraceLines(const std::string& json) {
+    std::vector<std::string> lines;
+    size_t start = 0;
+    while (start < json.size()) {
+        size_t end = json.find(",\n", start);
+        if (end == std::string::npos) end = json.size();
+        lines.push_back(json.substr(start, end - start));
+        start = end + 2;
+    }
+    return lines;
+}
+
+int RunSpans(size_t count) {
+    int failures = 0;
+    auto expect = [&](bool ok, const char* what) {
+        if (!ok) {
+            fprintf(stderr, "spans check failed: %s\n", what);
+            failures++;
+        }
+    };
+
+    const size_t spans = count > 1000000 ? 1000000 : count;
+    volatile uint64_t sink = 0;
+    auto cost = [&]() {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < spans; i++) {
+            TraceSpan span("bench", "span");
+            sink = sink + i;
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / spans;
+    };
+
+    SetTraceEventsEnabled(false);
+    double disabled = cost();
+    SetTraceEventsEnabled(true);
+    double enabled = cost();
+    TraceEventStats stats = GetTraceEventStats();
+    uint64_t kept = spans < kTraceEventsPerThread - 1 ? spans : kTraceEventsPerThread - 1;
+    expect(stats.recorded == spans && stats.overwritten == spans - kept, "recorded / overwritten counts");
+    std::string json;
+    size_t dumped = AppendTraceEventsJson(&json);
+    expect(dumped == kept, "dump holds the ring");
+    printf("[spans] spans=%zu\nspan          %8.2f ns disabled, %8.2f ns enabled\n", spans, disabled, enabled);
+    BenchMetric("spans", "span_disabled", disabled, "ns");
+    BenchMetric("spans", "span_enabled", enabled, "ns");
+
+    // Re-enabling starts over; instants and thread names go into the dump
+    SetTraceEventsEnabled(false);
+    SetTraceEventsEnabled(true);
+    expect(GetTraceEventStats().recorded == 0, "enable clears");
+    SetTraceThreadName("bench main");
+    TraceEventInstant("bench", "instant", "value", 42);
+    json.clear();
+    expect(AppendTraceEventsJson(&json) == 1, "one instant");
+    expect(json.find("\"thread_name\"") != std::string::npos && json.find("\"bench main\"") != std::string::npos,
+           "thread name metadata");
+    expect(json.find("\"ph\":\"i\"") != std::string::npos && json.find("\"value\":42") != std::string::npos,
+           "instant with argument");
+
+    // A writer racing the dumps: every dumped writer span must be whole and
+    // the sequence numbers strictly increasing
+    ClearTraceEvents();
+    std::atomic<bool> stop(false);
+    std::thread writer([&]() {
+        SetTraceThreadName("bench writer");
+        for (int64_t sequence = 1; !stop.load(std::memory_order_relaxed); sequence++) {
+            TraceSpan span("bench", "racer");
+            span.SetArg("sequence", sequence);
+        }
+    });
+    size_t racedEvents = 0;
+    bool ordered = true;
+    bool whole = true;
+    for (int dump = 0; dump < 50; dump++) {
+        json.clear();
+        AppendTraceEventsJson(&json);
+        int64_t last = 0;
+        for (const std::string& line : SplitTraceLines(json)) {
+            if (line.find("\"racer\"") == std::string::npos) continue;
+            size_t at = line.find("\"sequence\":");
+            if (line.front() != '{' || line.back() != '}' || at == std::string::npos ||
+                line.find("\"dur\":") == std::string::npos) {
+                whole = false;
+                continue;
+            }
+            int64_t sequence = strtoll(line.c_str() + at + 11, nullptr, 10);
+            if (sequence <= last) ordered = false;
+            last = sequence;
+            racedEvents++;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    stop = true;
+    writer.join();
+    SetTraceEventsEnabled(false);
+    printf("raced dumps   %zu writer spans, %s, %s\n", racedEvents, whole ? "whole" : "TORN",
+           ordered ? "ordered" : "OUT OF ORDER");
+    expect(racedEvents > 0 && whole && ordered, "dumps during recording");
+
+    if (failures) fprintf(stderr, "spans check failed\n");
+    return failures ? 1 : 0;
+}
+
+int RunWatchdog(size_t) {
+    const uint32_t periodMs = 5;
+    const uint32_t stallMs = 50;
+    int failures = 0;
+
+    ShortcutEngine engine;
+    FakeWakeup wakeup;
+    engine.SetDrainRequest([](void* context) {
+        static_cast<FakeWakeup*>(context)->Signal();
+        return true;
+    }, &wakeup);
+    engine.AddBinding("playPause", "F1");
+    engine.PublishBindings();
+
+    FlakyBackend backend;
+    InputWatchdog watchdog;
+    watchdog.Start(&engine, &backend, periodMs, stallMs);
+
+    // Dead hook: found by the next probe and reinstalled
+    backend.Kill();
+    double reinstallMs = WaitFor([&] { return backend.Health().reinstalls == 1; }, 1000);
+    InputBackendHealth health = backend.Health();
+    printf("[watchdog] probes=%llu failures=%llu reinstalls=%llu\n",
+           static_cast<unsigned long long>(health.probes), static_cast<unsigned long long>(health.failures),
+           static_cast<unsigned long long>(health.reinstalls));
+    if (reinstallMs < 0 || health.failures != 1 || !backend.KeyboardActive()) {
+        fprintf(stderr, "watchdog check failed: dead hook not reinstalled\n");
+        failures++;
+    }
+
+    // Consumer that never drains: one stall, wakeups re-sent while it lasts
+    auto signals = [&] {
+        std::lock_guard<std::mutex> lock(wakeup.mutex);
+        return wakeup.signals;
+    };
+    uint64_t signalsBefore = signals();
+    engine.HandleKey(VK_F1, true, 0, 0);
+    engine.HandleKey(VK_F1, false, 0, 0);
+    double stallDelayMs = WaitFor([&] { return watchdog.Stats().consumerStalls == 1; }, 2000);
+    WaitFor([&] { return watchdog.Stats().drainKicks >= 3; }, 2000);
+    InputWatchdogStats stats = watchdog.Stats();
+    uint64_t wakeups = signals() - signalsBefore;
+    printf("[watchdog] consumerStalls=%llu drainKicks=%llu wakeups=%llu\n",
+           static_cast<unsigned long long>(stats.consumerStalls), static_cast<unsigned long long>(stats.drainKicks),
+           static_cast<unsigned long long>(wakeups));
+    // The publish itself woke the consumer once, every kick once more
+    if (stallDelayMs < 0 || stats.consumerStalls != 1 || !stats.consumerStalled || stats.drainKicks < 3 ||
+        wakeups < stats.drainKicks + 1) {
+        fprintf(stderr, "watchdog check failed: consumer stall\n");
+        failures++;
+    }
+
+    // Draining ends the stall; a consumer that keeps up never stalls
+    ShortcutEvent batch[kEventRingCapacity];
+    engine.DrainBatch(batch, kEventRingCapacity, SteadyNowNs());
+    if (WaitFor([&] { return !watchdog.Stats().consumerStalled; }, 1000) < 0) {
+        fprintf(stderr, "watchdog check failed: stall did not clear\n");
+        failures++;
+    }
+    for (int i = 0; i < 40; i++) {
+        engine.HandleKey(VK_F1, true, 0, 0);
+        engine.HandleKey(VK_F1, false, 0, 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        engine.DrainBatch(batch, kEventRingCapacity, SteadyNowNs());
+    }
+    if (watchdog.Stats().consumerStalls != 1) {
+        fprintf(stderr, "watchdog check failed: stall reported while draining\n");
+        failures++;
+    }
+
+    watchdog.Stop();
+    printf("reinstall after %6.2f ms (period %u)\nstall after     %6.2f ms (threshold %u)\n",
+           reinstallMs, periodMs, stallDelayMs, stallMs);
+    BenchMetric("watchdog", "reinstall_delay", reinstallMs, "ms");
+    BenchMetric("watchdog", "stall_delay", stallDelayMs, "ms");
+
+    if (failures) fprintf(stderr, "watchdog check failed\n");
+    return failures ? 1 : 0;
+}
+
+#ifdef SHORTCUT_BENCH_EVDEV
+int RunEvdev(size_t count) {
+    // Each press is a real trip through the kernel, keep the run short
+    const size_t presses = count > 20000 ? 20000 : count;
+
+    UinputDevice loopback;
+    if (!loopback.Create("teyvat-shortcut-loopback")) {
+        printf("[evdev] skipped: %s\n", loopback.Error().c_str());
+        return 0;
+    }
+
+    // Give udev a moment to create the node
+    std::string node;
+    for (int i = 0; i < 100; i++) {
+        node = loopback.EventNodePath();
+        if (!node.empty() && access(node.c_str(), R_OK) == 0) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ShortcutEngine engine;
+    engine.AddBinding("playPause", "F1");
+    engine.AddBinding("increaseOpacity", "Control+Up");
+    engine.PublishBindings();
+
+    FakeWakeup wakeup;
+    engine.SetDrainRequest([](void* context) {
+        static_cast<FakeWakeup*>(context)->Signal();
+        return true;
+    }, &wakeup);
+
+    EvdevInputBackend backend;
+    InputBackendOptions options;
+    options.devicePath = node;
+    if (node.empty() || !backend.Start(&engine, options)) {
+        printf("[evdev] skipped: %s\n", node.empty() ? "loopback node not found" : backend.Error().c_str());
+        return 0;
+    }
+
+    std::atomic<uint64_t> received(0);
+    std::thread consumer([&]() {
+        ShortcutEvent batch[kEventRingCapacity];
+        for (;;) {
+            bool finished;
+            {
+                std::unique_lock<std::mutex> lock(wakeup.mutex);
+                wakeup.cv.wait(lock, [&]() { return wakeup.signaled || wakeup.done; });
+                wakeup.signaled = false;
+                finished = wakeup.done;
+            }
+            size_t n = engine.DrainBatch(batch, kEventRingCapacity, SteadyNowNs());
+            received += n;
+            if (finished && n == 0) break;
+        }
+    });
+
+    // Every press is followed by a miss (plain 'A') the engine must ignore
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < presses; i++) {
+        bool hit = (i & 1) == 0;
+        if (hit) {
+            loopback.Key(KEY_F1, true);
+            loopback.Key(KEY_F1, false);
+        } else {
+            loopback.Key(KEY_A, true);
+            loopback.Key(KEY_A, false);
+        }
+        // Stay below the kernel's per-client buffer
+        if ((i & 63) == 63) {
+            uint64_t expected = (i + 2) / 2;
+            for (int spin = 0; spin < 1000 && received.load() < expected; spin++) {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    }
+    uint64_t expected = (presses + 1) / 2;
+    for (int spin = 0; spin < 2000 && received.load() < expected; spin++) {
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    backend.Stop();
+    {
+        std::lock_guard<std::mutex> lock(wakeup.mutex);
+        wakeup.done = true;
+        wakeup.cv.notify_one();
+    }
+    consumer.join();
+
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    printf("[evdev] presses=%zu device=%s\n", presses, node.c_str());
+    printf("throughput   %8.0f presses/s  matched %llu of %llu\n", presses / (ms / 1000.0),
+           static_cast<unsigned long long>(received.load()), static_cast<unsigned long long>(expected));
+    BenchMetric("evdev", "throughput", presses / (ms / 1000.0), "presses/s");
+    PrintSummary("kernelToReader", engine.Latency().Summarize(kStageOsToHook));
+    PrintSummary("readerToQueue", engine.Latency().Summarize(kStageHookToDispatch));
+    PrintSummary("queueToConsumer", engine.Latency().Summarize(kStageDispatchToJs));
+
+    if (received.load() != expected) {
+        fprintf(stderr, "evdev check failed: matched %llu, expected %llu\n",
+                static_cast<unsigned long long>(received.load()), static_cast<unsigned long long>(expected));
+        return 1;
+    }
+    return 0;
+}
+
+struct MouseRunResult {
+    bool started = false;
+    uint64_t matched = 0;
+    uint64_t events = 0;
+    uint64_t cpuNs = 0;
+};
+
+// One pass of moves with a side-button click every clickEvery moves
+MouseRunResult RunMousePass(UinputDevice& loopback, const std::string& node, bool mouseHook,
+                            size_t moves, size_t clickEvery, std::string* error) {
+    MouseRunResult result;
+    ShortcutEngine engine;
+    engine.AddBinding("back", "XButton1");
+    engine.PublishBindings();
+
+    EvdevInputBackend backend;
+    InputBackendOptions options;
+    options.devicePath = node;
+    options.mouseHook = mouseHook;
+    if (!backend.Start(&engine, options)) {
+        *error = backend.Error();
+        return result;
+    }
+    result.started = true;
+    InputBackendHealth before = backend.Health();
+
+    size_t clicks = 0;
+    for (size_t i = 0; i < moves; i++) {
+        input_event events[2];
+        memset(events, 0, sizeof(events));
+        events[0].type = EV_REL;
+        events[0].code = (i & 1) ? REL_Y : REL_X;
+        events[0].value = (i & 2) ? -1 : 1;
+        events[1].type = EV_SYN;
+        events[1].code = SYN_REPORT;
+        loopback.Write(events, 2);
+        if (i % clickEvery == clickEvery - 1) {
+            loopback.Key(BTN_SIDE, true);
+            loopback.Key(BTN_SIDE, false);
+            clicks++;
+        }
+        // Stay below the kernel's per-client buffer when every move is read
+        if ((i & 31) == 31) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    ShortcutEvent batch[kEventRingCapacity];
+    for (int spin = 0; spin < 2000 && result.matched < clicks; spin++) {
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+        result.matched += engine.DrainBatch(batch, kEventRingCapacity, SteadyNowNs());
+    }
+    InputBackendHealth after = backend.Health();
+    backend.Stop();
+
+    result.events = after.events - before.events;
+    result.cpuNs = after.cpuNs - before.cpuNs;
+    return result;
+}
+
+int RunMouse(size_t count) {
+    const size_t moves = count > 100000 ? 100000 : count;
+    const size_t clickEvery = 500;
+    const size_t clicks = moves / clickEvery;
+
+    UinputDevice loopback;
+    if (!loopback.Create("teyvat-shortcut-loopback")) {
+        printf("[mouse] skipped: %s\n", loopback.Error().c_str());
+        return 0;
+    }
+    std::string node;
+    for (int i = 0; i < 100; i++) {
+        node = loopback.EventNodePath();
+        if (!node.empty() && access(node.c_str(), R_OK) == 0) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (node.empty()) {
+        printf("[mouse] skipped: loopback node not found\n");
+        return 0;
+    }
+
+    printf("[mouse] moves=%zu clicks=%zu device=%s\n", moves, clicks, node.c_str());
+    int failures = 0;
+    struct Mode {
+        const char* name;
+        bool mouseHook;
+    };
+    const Mode modes[] = { { "hook", true }, { "buttons", false } };
+    for (const Mode& mode : modes) {
+        std::string error;
+        MouseRunResult result = RunMousePass(loopback, node, mode.mouseHook, moves, clickEvery, &error);
+        if (!result.started) {
+            printf("[mouse] skipped: %s\n", error.c_str());
+            return 0;
+        }
+        double cpuPerMove = static_cast<double>(result.cpuNs) / static_cast<double>(moves);
+        printf("%-8s events %8llu (%5.2f per move)  reader CPU %7.1f ns/move  matched %llu of %zu\n", mode.name,
+               static_cast<unsigned long long>(result.events),
+               static_cast<double>(result.events) / static_cast<double>(moves), cpuPerMove,
+               static_cast<unsigned long long>(result.matched), clicks);
+        BenchMetric("mouse", std::string(mode.name) + "_cpu_per_move", cpuPerMove, "ns");
+        BenchMetric("mouse", std::string(mode.name) + "_events", static_cast<double>(result.events), "events");
+        if (result.matched != clicks) {
+            fprintf(stderr, "mouse check failed (%s): matched %llu, expected %zu\n", mode.name,
+                    static_cast<unsigned long long>(result.matched), clicks);
+            failures++;
+        }
+    }
+    return failures;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string json = TakeJsonOption(argc, argv);
+    const char* suite = argc > 1 ? argv[1] : "all";
+    size_t count = argc > 2 ? static_cast<size_t>(strtoull(argv[2], nullptr, 10)) : 10000000;
+    int hitPercent = argc > 3 ? atoi(argv[3]) : 2;
+    if (count == 0) count = 1;
+
+    bool all = strcmp(suite, "all") == 0;
+    int failures = 0;
+    if (all || strcmp(suite, "match") == 0) failures += RunMatch(count, hitPercent);
+    if (all || strcmp(suite, "ring") == 0) failures += RunRing(count);
+    if (all || strcmp(suite, "latency") == 0) failures += RunLatency(count);
+    if (all || strcmp(suite, "swap") == 0) failures += RunSwap(count);
+    if (all || strcmp(suite, "seq") == 0) failures += RunSeq(count);
+    if (all || strcmp(suite, "repeat") == 0) failures += RunRepeat(count);
+    if (all || strcmp(suite, "hold") == 0) failures += RunHold(count);
+    if (all || strcmp(suite, "keymap") == 0) failures += RunKeymap(count);
+    if (all || strcmp(suite, "profile") == 0) failures += RunProfile(count);
+    if (all || strcmp(suite, "trace") == 0) failures += RunTrace(count);
+    if (all || strcmp(suite, "spans") == 0) failures += RunSpans(count);
+    if (all || strcmp(suite, "watchdog") == 0) failures += RunWatchdog(count);
+#ifdef SHORTCUT_BENCH_EVDEV
+    if (all || strcmp(suite, "evdev") == 0) failures += RunEvdev(count);
+    if (all || strcmp(suite, "mouse") == 0) failures += RunMouse(count);
+#endif
+    if (!json.empty() && !WriteBenchJson(json, "shortcut_bench", failures)) failures++;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,1036 @@
+// Topmost module benchmarks.
+//
+// match: the Aho-Corasick TitleMatcher over 10k synthetic titles as the
+//        number of patterns grows, against folding each title once and
+//        running one find() per pattern.
+// enum:  cost of GetVisibleWindows() / FindWindowByTitle(). On X11 the
+//        batched enumeration is compared with the previous one-request-per-
+//        window approach over the same synthetic windows; topmost_bench_mock
+//        enumerates `windows` in-memory windows.
+// raise: cost of SetWindowAlwaysOnTop() and of the IsWindowNearTop() check,
+//        and of raising a group per window vs with one SetWindowsAlwaysOnTop()
+//        the watcher runs on every notification.
+// watch: (X11) the event-driven watcher. The target is pushed to the bottom
+//        of the stack and the time until the watcher has raised it again is
+//        measured from outside; a second, lower priority window watched by
+//        the same thread is covered along with it and both must come back
+//        in order; then the target is unmapped and the other windows are
+//        restacked to verify the watcher gets no wakeups while the target
+//        is hidden.
+//
+// scale: (topmost_bench_mock) enumeration, snapshot, title lookup, title
+//        matching and re-raise cost at 100, 1k and 10k windows over the
+//        in-memory window system of window_platform_mock.cc.
+// policy: (topmost_bench_mock) per-window watcher policies: priority order
+//        of re-raised windows, re-raise budget and doubling backoff on a
+//        virtual clock, and the cost of one check as watched windows grow.
+// governor: (topmost_bench_mock) the resource governor's states as focus
+//        moves between the overlay, a game and another application, against
+//        a process control that only records what it was asked to do;
+//        showing the overlay must restore without waiting for a poll, and
+//        the thread must not wake while the overlay is visible or the
+//        state is background.
+//
+// The X11 suites create their own windows, so they run headless:
+//   xvfb-run -a ./topmost_bench all
+// Without a display they print "skipped". topmost_bench_mock needs no
+// display at all.
+//
+// --json=<file> also writes the headline numbers as JSON (see
+// bench_report.h); compare two runs with bench/compare.js.
+//
+// Usage: topmost_bench [match|enum|raise|watch|scale|policy|governor|all] [windows=200] [iterations=200] [--json=file]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_report.h"
+#include "../src/latency_histogram.h"
+#include "../src/title_matcher.h"
+#include "../src/topmost_watcher.h"
+#include "../src/window_platform.h"
+
+#ifdef TOPMOST_BENCH_X11
+#include <poll.h>
+#include "../src/x11_connection.h"
+#endif
+
+#ifdef TOPMOST_BENCH_MOCK
+#include "../src/resource_governor.h"
+#include "../src/window_platform_mock.h"
+#include "../src/window_snapshot.h"
+#include "../src/window_title_cache.h"
+#endif
+
+namespace {
+
+double ElapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+void PrintSummary(const char* name, const LatencySummary& summary) {
+    printf("%-15s n=%-8llu p50 %8.1f us  p99 %8.1f us  p999 %8.1f us  max %8.1f us\n", name,
+           static_cast<unsigned long long>(summary.count), summary.p50 / 1000.0, summary.p99 / 1000.0,
+           summary.p999 / 1000.0, summary.max / 1000.0);
+}
+
+const size_t kMatchTitles = 10000;
+const size_t kMatchRepeats = 20;
+
+const char* const kTitleWords[] = {
+    "Teyvat", "Browser", "Genshin", "Impact", "Visual", "Studio", "Code", "Chrome", "Firefox",
+    "Terminal", "Discord", "Steam", "Spotify", "Explorer", "Settings", "Document", "Untitled",
+    "Notepad", "Player", "Music", "Video", "Mail", "Calendar", "Photos", "Paint", "Game",
+    "\xE6\x8F\x90\xE7\x93\xA6\xE7\x89\xB9",   // 提瓦特
+    "\xE6\xB5\x8F\xE8\xA7\x88\xE5\x99\xA8",   // 浏览器
+    "\xE5\x8E\x9F\xE7\xA5\x9E",                 // 原神
+    "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82",   // Привет
+    "\xC3\x89" "cole",                              // École
+};
+const size_t kTitleWordCount = sizeof(kTitleWords) / sizeof(kTitleWords[0]);
+
+// Random casing of the ASCII letters, so matching has to fold
+std::string RandomCase(const char* word, std::mt19937& rng) {
+    std::string out(word);
+    for (char& c : out) {
+        if (c >= 'a' && c <= 'z' && (rng() & 3) == 0) c = static_cast<char>(c - 0x20);
+        else if (c >= 'A' && c <= 'Z' && (rng() & 3) == 0) c = static_cast<char>(c + 0x20);
+    }
+    return out;
+}
+
+int RunMatch() {
+    std::mt19937 rng(42);
+    std::vector<std::string> titles(kMatchTitles);
+    for (std::string& title : titles) {
+        size_t words = 2 + rng() % 5;
+        for (size_t w = 0; w < words; w++) {
+            if (w) title += (rng() & 1) ? " - " : " ";
+            title += RandomCase(kTitleWords[rng() % kTitleWordCount], rng);
+        }
+        title += " " + std::to_string(rng() % 1000);
+    }
+
+    printf("[match] titles=%zu repeats=%zu\n", kMatchTitles, kMatchRepeats);
+    printf("%-9s %8s %14s %14s %9s\n", "patterns", "states", "matcher ns", "fold+find ns", "speedup");
+
+    const size_t patternCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+    for (size_t patternCount : patternCounts) {
+        // Every fourth pattern is a prefix, the rest substrings; words are
+        // combined with numbers so most patterns are distinct
+        std::vector<std::string> patterns;
+        std::vector<TitleMatchMode> modes;
+        TitleMatcher matcher;
+        for (size_t p = 0; p < patternCount; p++) {
+            std::string pattern = kTitleWords[(p * 7) % kTitleWordCount];
+            if (p >= kTitleWordCount) pattern += " " + std::to_string(p % 10);
+            TitleMatchMode mode = (p % 4 == 3) ? kTitleMatchPrefix : kTitleMatchSubstring;
+            patterns.push_back(FoldCaseUtf8(pattern));
+            modes.push_back(mode);
+            matcher.AddPattern(pattern, mode);
+        }
+        matcher.Compile();
+
+        std::vector<uint32_t> matched;
+        uint64_t matcherHits = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < kMatchRepeats; r++) {
+            for (const std::string& title : titles) {
+                matched.clear();
+                matcher.Match(title, &matched);
+                matcherHits += matched.size();
+            }
+        }
+        double matcherNs = ElapsedNs(start);
+
+        std::string folded;
+        uint64_t naiveHits = 0;
+        start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < kMatchRepeats; r++) {
+            for (const std::string& title : titles) {
+                FoldCaseUtf8(title.data(), title.size(), &folded);
+                for (size_t p = 0; p < patterns.size(); p++) {
+                    bool hit = modes[p] == kTitleMatchPrefix
+                        ? folded.compare(0, patterns[p].size(), patterns[p]) == 0
+                        : folded.find(patterns[p]) != std::string::npos;
+                    if (hit) naiveHits++;
+                }
+            }
+        }
+        double naiveNs = ElapsedNs(start);
+
+        double titlesScanned = static_cast<double>(kMatchTitles * kMatchRepeats);
+        printf("%-9zu %8zu %14.1f %14.1f %8.2fx\n", patternCount, matcher.StateCount(),
+               matcherNs / titlesScanned, naiveNs / titlesScanned, matcherNs > 0 ? naiveNs / matcherNs : 0.0);
+        BenchMetric("match", "matcher_" + std::to_string(patternCount), matcherNs / titlesScanned, "ns/title");
+        BenchMetric("match", "fold_find_" + std::to_string(patternCount), naiveNs / titlesScanned, "ns/title");
+
+        if (matcherHits != naiveHits) {
+            fprintf(stderr, "match mismatch with %zu patterns: matcher=%llu fold+find=%llu\n", patternCount,
+                    static_cast<unsigned long long>(matcherHits), static_cast<unsigned long long>(naiveHits));
+            return 1;
+        }
+    }
+
+    // Regex-like mode sanity checks on folded Unicode titles
+    TitleMatcher regex;
+    regex.AddPattern("^teyvat*browser$", kTitleMatchRegex);
+    regex.AddPattern("\xD0\xBF\xD1\x80\xD0\xB8?\xD0\xB5\xD1\x82", kTitleMatchRegex);   // при?ет
+    regex.Compile();
+    struct { const char* title; size_t expected; } cases[] = {
+        { "TEYVAT - Browser", 1 },
+        { "My Teyvat Browser", 0 },
+        { "Teyvat Browser 2", 0 },
+        { "\xD0\x9F\xD0\xA0\xD0\x98\xD0\x92\xD0\x95\xD0\xA2 world", 1 },   // ПРИВЕТ world
+    };
+    for (const auto& test : cases) {
+        std::vector<uint32_t> matched;
+        regex.Match(test.title, &matched);
+        if (matched.size() != test.expected) {
+            fprintf(stderr, "regex check failed for \"%s\": %zu matches\n", test.title, matched.size());
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#ifdef TOPMOST_BENCH_X11
+
+// Plain top-level windows on a private connection, standing in for other
+// applications' windows
+class SyntheticWindows {
+public:
+    bool Open(size_t count) {
+        if (!connection_.Open()) return false;
+        xcb_connection_t* c = connection_.Get();
+        const X11Atoms& atoms = connection_.Atoms();
+
+        for (size_t i = 0; i < count; i++) {
+            xcb_window_t window = xcb_generate_id(c);
+            const uint32_t values[] = { XCB_EVENT_MASK_STRUCTURE_NOTIFY };
+            xcb_create_window(c, XCB_COPY_FROM_PARENT, window, connection_.Root(),
+                              static_cast<int16_t>(i % 64), static_cast<int16_t>(i % 48), 320, 240, 0,
+                              XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT,
+                              XCB_CW_EVENT_MASK, values);
+
+            std::string title = "bench window " + std::to_string(i);
+            xcb_change_property(c, XCB_PROP_MODE_REPLACE, window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8,
+                                static_cast<uint32_t>(title.size()), title.data());
+            xcb_change_property(c, XCB_PROP_MODE_REPLACE, window, atoms.netWmName, atoms.utf8String, 8,
+                                static_cast<uint32_t>(title.size()), title.data());
+            xcb_map_window(c, window);
+            windows_.push_back(window);
+        }
+        Sync();
+        return true;
+    }
+
+    // Waits until the server has processed everything sent so far
+    void Sync() {
+        xcb_connection_t* c = connection_.Get();
+        free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), nullptr));
+    }
+
+    void Restack(xcb_window_t window, uint32_t mode) {
+        xcb_configure_window(connection_.Get(), window, XCB_CONFIG_WINDOW_STACK_MODE, &mode);
+        xcb_flush(connection_.Get());
+    }
+
+    void Map(xcb_window_t window, bool mapped) {
+        if (mapped) {
+            xcb_map_window(connection_.Get(), window);
+        } else {
+            xcb_unmap_window(connection_.Get(), window);
+        }
+        Sync();
+    }
+
+    // Blocks until a ConfigureNotify for `window` that puts it above some
+    // sibling arrives; false on timeout
+    bool WaitForRaise(xcb_window_t window, int timeoutMs) {
+        xcb_connection_t* c = connection_.Get();
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        for (;;) {
+            xcb_generic_event_t* event;
+            while ((event = xcb_poll_for_event(c)) != nullptr) {
+                bool raised = false;
+                if ((event->response_type & ~0x80) == XCB_CONFIGURE_NOTIFY) {
+                    xcb_configure_notify_event_t* e = reinterpret_cast<xcb_configure_notify_event_t*>(event);
+                    raised = e->window == window && e->above_sibling != XCB_NONE;
+                }
+                free(event);
+                if (raised) return true;
+            }
+
+            int remaining = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count());
+            if (remaining <= 0) return false;
+            pollfd fd = { xcb_get_file_descriptor(c), POLLIN, 0 };
+            poll(&fd, 1, remaining);
+        }
+    }
+
+    void DiscardEvents() {
+        xcb_generic_event_t* event;
+        while ((event = xcb_poll_for_event(connection_.Get())) != nullptr) {
+            free(event);
+        }
+    }
+
+    const std::vector<xcb_window_t>& Windows() const { return windows_; }
+    X11Connection& Connection() { return connection_; }
+
+private:
+    X11Connection connection_;
+    std::vector<xcb_window_t> windows_;
+};
+
+// The enumeration as it was before batching: wait for each reply in turn
+std::vector<WindowInfo> EnumerateSequential(X11Connection& display) {
+    std::vector<WindowInfo> result;
+    xcb_connection_t* c = display.Get();
+
+    std::vector<xcb_window_t> windows;
+    xcb_get_property_reply_t* stacking = xcb_get_property_reply(c,
+        xcb_get_property(c, 0, display.Root(), display.Atoms().netClientListStacking, XCB_ATOM_WINDOW, 0, UINT32_MAX / 4),
+        nullptr);
+    if (stacking && stacking->format == 32 && xcb_get_property_value_length(stacking) > 0) {
+        const xcb_window_t* values = static_cast<const xcb_window_t*>(xcb_get_property_value(stacking));
+        windows.assign(values, values + xcb_get_property_value_length(stacking) / 4);
+    } else {
+        xcb_query_tree_reply_t* tree = xcb_query_tree_reply(c, xcb_query_tree(c, display.Root()), nullptr);
+        if (tree) {
+            windows.assign(xcb_query_tree_children(tree),
+                           xcb_query_tree_children(tree) + xcb_query_tree_children_length(tree));
+            free(tree);
+        }
+    }
+    free(stacking);
+
+    for (size_t n = windows.size(); n-- > 0;) {
+        xcb_get_window_attributes_reply_t* attributes = xcb_get_window_attributes_reply(c,
+            xcb_get_window_attributes(c, windows[n]), nullptr);
+        bool viewable = attributes && attributes->map_state == XCB_MAP_STATE_VIEWABLE;
+        free(attributes);
+        if (!viewable) continue;
+
+        xcb_get_property_reply_t* name = xcb_get_property_reply(c,
+            xcb_get_property(c, 0, windows[n], display.Atoms().netWmName, display.Atoms().utf8String, 0, 1024),
+            nullptr);
+        if (!name || xcb_get_property_value_length(name) == 0) {
+            free(name);
+            name = xcb_get_property_reply(c,
+                xcb_get_property(c, 0, windows[n], XCB_ATOM_WM_NAME, XCB_GET_PROPERTY_TYPE_ANY, 0, 1024),
+                nullptr);
+        }
+        if (name && xcb_get_property_value_length(name) > 0) {
+            WindowInfo info;
+            info.handle = windows[n];
+            info.title.assign(static_cast<const char*>(xcb_get_property_value(name)),
+                              xcb_get_property_value_length(name));
+            result.push_back(info);
+        }
+        free(name);
+    }
+    return result;
+}
+
+bool OpenSynthetic(SyntheticWindows& synthetic, size_t windows, const char* suite) {
+    if (!synthetic.Open(windows)) {
+        printf("[%s] skipped: cannot open X display (run under xvfb-run)\n", suite);
+        return false;
+    }
+    return true;
+}
+
+int RunEnum(size_t windows, size_t iterations) {
+    SyntheticWindows synthetic;
+    if (!OpenSynthetic(synthetic, windows, "enum")) return 0;
+
+    LatencyHistogram batched, sequential, find;
+    std::vector<WindowInfo> batchedResult, sequentialResult;
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        batchedResult = GetVisibleWindows();
+        batched.Record(static_cast<uint64_t>(ElapsedNs(start)));
+
+        start = std::chrono::steady_clock::now();
+        sequentialResult = EnumerateSequential(synthetic.Connection());
+        sequential.Record(static_cast<uint64_t>(ElapsedNs(start)));
+
+        // Worst case for a title lookup: the bottom-most window
+        start = std::chrono::steady_clock::now();
+        WindowHandle found = FindWindowByTitle("bench window 0");
+        find.Record(static_cast<uint64_t>(ElapsedNs(start)));
+        if (found != synthetic.Windows().front()) {
+            fprintf(stderr, "FindWindowByTitle returned %lu, expected %u\n",
+                    static_cast<unsigned long>(found), synthetic.Windows().front());
+            return 1;
+        }
+    }
+
+    LatencySummary batchedSummary = batched.Summarize();
+    LatencySummary sequentialSummary = sequential.Summarize();
+    printf("[enum] windows=%zu iterations=%zu visible=%zu\n", windows, iterations, batchedResult.size());
+    LatencySummary findSummary = find.Summarize();
+    PrintSummary("batched", batchedSummary);
+    PrintSummary("per-window", sequentialSummary);
+    PrintSummary("find(bottom)", findSummary);
+    BenchMetric("enum", "batched_p50", batchedSummary.p50 / 1000.0, "us");
+    BenchMetric("enum", "per_window_p50", sequentialSummary.p50 / 1000.0, "us");
+    BenchMetric("enum", "find_bottom_p50", findSummary.p50 / 1000.0, "us");
+    printf("speedup      %8.2fx (p50)\n",
+           batchedSummary.p50 ? static_cast<double>(sequentialSummary.p50) / batchedSummary.p50 : 0.0);
+
+    // Both paths must see the same windows in the same order
+    if (batchedResult.size() != sequentialResult.size() || batchedResult.size() < windows) {
+        fprintf(stderr, "enumeration mismatch: batched=%zu per-window=%zu created=%zu\n",
+                batchedResult.size(), sequentialResult.size(), windows);
+        return 1;
+    }
+    for (size_t i = 0; i < batchedResult.size(); i++) {
+        if (batchedResult[i].handle != sequentialResult[i].handle ||
+            batchedResult[i].title != sequentialResult[i].title) {
+            fprintf(stderr, "enumeration mismatch at %zu\n", i);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int RunRaise(size_t windows, size_t iterations) {
+    SyntheticWindows synthetic;
+    if (!OpenSynthetic(synthetic, windows, "raise")) return 0;
+    xcb_window_t target = synthetic.Windows().front();
+
+    LatencyHistogram raise, check;
+    for (size_t i = 0; i < iterations; i++) {
+        synthetic.Restack(target, XCB_STACK_MODE_BELOW);
+        synthetic.Sync();
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok = SetWindowAlwaysOnTop(target, true);
+        raise.Record(static_cast<uint64_t>(ElapsedNs(start)));
+
+        start = std::chrono::steady_clock::now();
+        bool onTop = IsWindowNearTop(target, 1);
+        check.Record(static_cast<uint64_t>(ElapsedNs(start)));
+
+        if (!ok || !onTop) {
+            fprintf(stderr, "raise failed at iteration %zu (ok=%d onTop=%d)\n", i, ok ? 1 : 0, onTop ? 1 : 0);
+            return 1;
+        }
+    }
+
+    // Several windows: one call each vs one batched z-order operation
+    const size_t groupSize = std::min<size_t>(8, synthetic.Windows().size());
+    std::vector<WindowHandle> group(synthetic.Windows().begin(), synthetic.Windows().begin() + groupSize);
+    LatencyHistogram single, batch;
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        for (WindowHandle window : group) {
+            SetWindowAlwaysOnTop(window, true);
+        }
+        single.Record(static_cast<uint64_t>(ElapsedNs(start)));
+
+        synthetic.Restack(target, XCB_STACK_MODE_BELOW);
+        synthetic.Sync();
+
+        start = std::chrono::steady_clock::now();
+        std::vector<bool> applied = SetWindowsAlwaysOnTop(group, true);
+        batch.Record(static_cast<uint64_t>(ElapsedNs(start)));
+
+        if (std::count(applied.begin(), applied.end(), true) != static_cast<long>(groupSize) ||
+            !IsWindowNearTop(group[0], 1)) {
+            fprintf(stderr, "batched raise failed at iteration %zu\n", i);
+            return 1;
+        }
+    }
+
+    LatencySummary raiseSummary = raise.Summarize();
+    LatencySummary checkSummary = check.Summarize();
+    LatencySummary singleSummary = single.Summarize();
+    LatencySummary batchSummary = batch.Summarize();
+    printf("[raise] windows=%zu iterations=%zu\n", windows, iterations);
+    PrintSummary("setTopmost", raiseSummary);
+    PrintSummary("nearTopCheck", checkSummary);
+    printf("group of %zu:\n", groupSize);
+    PrintSummary("perWindow", singleSummary);
+    PrintSummary("batched", batchSummary);
+    BenchMetric("raise", "set_topmost_p50", raiseSummary.p50 / 1000.0, "us");
+    BenchMetric("raise", "near_top_check_p50", checkSummary.p50 / 1000.0, "us");
+    BenchMetric("raise", "group_per_window_p50", singleSummary.p50 / 1000.0, "us");
+    BenchMetric("raise", "group_batched_p50", batchSummary.p50 / 1000.0, "us");
+    return 0;
+}
+
+int RunWatch(size_t windows, size_t iterations) {
+    // Fewer windows than the check depth would never count as "covered"
+    if (windows <= static_cast<size_t>(kTopmostCheckDepth)) windows = kTopmostCheckDepth + 1;
+
+    SyntheticWindows synthetic;
+    if (!OpenSynthetic(synthetic, windows, "watch")) return 0;
+    xcb_window_t target = synthetic.Windows().front();
+    SetWindowAlwaysOnTop(target, true);
+
+    // Every cover is answered here; budgets are the policy suite's business
+    TopmostPolicy unlimited;
+    unlimited.raiseBudget = 0;
+    std::unique_ptr<TopmostWatcher> watcher(CreateTopmostWatcher());
+    if (!watcher->Start() || !watcher->Watch(target, unlimited)) {
+        fprintf(stderr, "watcher failed to start\n");
+        return 1;
+    }
+
+    // Covered -> raised again, measured by another client
+    LatencyHistogram endToEnd;
+    for (size_t i = 0; i < iterations; i++) {
+        synthetic.DiscardEvents();
+        auto start = std::chrono::steady_clock::now();
+        synthetic.Restack(target, XCB_STACK_MODE_BELOW);
+        if (!synthetic.WaitForRaise(target, 1000)) {
+            fprintf(stderr, "watcher did not re-raise the target (iteration %zu)\n", i);
+            return 1;
+        }
+        endToEnd.Record(static_cast<uint64_t>(ElapsedNs(start)));
+    }
+    TopmostWatcherStats visible = watcher->Stats();
+
+    // A second, lower priority window on the same thread: covering both
+    // brings both back with the target on top
+    xcb_window_t second = synthetic.Windows()[1];
+    TopmostPolicy lower = unlimited;
+    lower.priority = -1;
+    SetWindowAlwaysOnTop(second, true);
+    bool both = watcher->Watch(second, lower);
+    synthetic.DiscardEvents();
+    synthetic.Restack(second, XCB_STACK_MODE_BELOW);
+    synthetic.Restack(target, XCB_STACK_MODE_BELOW);
+    both = both && synthetic.WaitForRaise(second, 1000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    both = both && IsWindowNearTop(target, 1) && IsWindowNearTop(second, 2);
+    both = both && watcher->Unwatch(second) && watcher->Stats().windows == 1;
+    SetWindowAlwaysOnTop(second, false);
+
+    // Hidden: restacking everything else must not wake the watcher
+    synthetic.Map(target, false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    TopmostWatcherStats beforeHidden = watcher->Stats();
+    for (size_t i = 1; i < synthetic.Windows().size(); i++) {
+        synthetic.Restack(synthetic.Windows()[i], XCB_STACK_MODE_ABOVE);
+    }
+    synthetic.Sync();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    TopmostWatcherStats afterHidden = watcher->Stats();
+    uint64_t hiddenWakeups = afterHidden.events - beforeHidden.events;
+
+    // Shown again: enforcement resumes
+    synthetic.Map(target, true);
+    synthetic.DiscardEvents();
+    synthetic.Restack(target, XCB_STACK_MODE_BELOW);
+    bool resumed = synthetic.WaitForRaise(target, 1000);
+    watcher->Stop();
+
+    LatencySummary endToEndSummary = endToEnd.Summarize();
+    printf("[watch] windows=%zu iterations=%zu\n", windows, iterations);
+    PrintSummary("cover->raise", endToEndSummary);
+    BenchMetric("watch", "cover_to_raise_p50", endToEndSummary.p50 / 1000.0, "us");
+    BenchMetric("watch", "reaction_p50", visible.reaction.p50 / 1000.0, "us");
+    PrintSummary("reaction", visible.reaction);
+    printf("events       %llu  checks %llu  reRaises %llu\n",
+           static_cast<unsigned long long>(visible.events), static_cast<unsigned long long>(visible.checks),
+           static_cast<unsigned long long>(visible.reRaises));
+    printf("hidden       restacks %zu  wakeups %llu  hides %llu\n", synthetic.Windows().size() - 1,
+           static_cast<unsigned long long>(hiddenWakeups), static_cast<unsigned long long>(afterHidden.hides));
+
+    printf("two windows  %s\n", both ? "raised in priority order" : "FAILED");
+
+    if (visible.reRaises < iterations || hiddenWakeups != 0 || !afterHidden.hidden || !resumed || !both) {
+        fprintf(stderr, "watch check failed: reRaises=%llu hiddenWakeups=%llu hidden=%d resumed=%d both=%d\n",
+                static_cast<unsigned long long>(visible.reRaises), static_cast<unsigned long long>(hiddenWakeups),
+                afterHidden.hidden ? 1 : 0, resumed ? 1 : 0, both ? 1 : 0);
+        return 1;
+    }
+    return 0;
+}
+
+#else
+
+// Without synthetic windows only the enumeration of the real desktop is
+// timed; the mock build fills its window system with `windows` windows first
+int RunEnum(size_t windows, size_t iterations) {
+#ifdef TOPMOST_BENCH_MOCK
+    MockWindowsReset();
+    for (size_t i = 0; i < windows; i++) {
+        std::string title = "Synthetic window " + std::to_string(i);
+        MockWindowCreate(title, static_cast<uint32_t>(1000 + i % 97));
+    }
+#else
+    (void)windows;
+#endif
+    LatencyHistogram enumerate;
+    size_t visible = 0;
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        visible = GetVisibleWindows().size();
+        enumerate.Record(static_cast<uint64_t>(ElapsedNs(start)));
+    }
+    LatencySummary summary = enumerate.Summarize();
+    printf("[enum] iterations=%zu visible=%zu\n", iterations, visible);
+    PrintSummary("enumerate", summary);
+    BenchMetric("enum", "enumerate_p50", summary.p50 / 1000.0, "us");
+#ifdef TOPMOST_BENCH_MOCK
+    MockWindowsReset();
+    if (visible != windows) {
+        fprintf(stderr, "enum check failed: %zu of %zu windows visible\n", visible, windows);
+        return 1;
+    }
+#endif
+    return 0;
+}
+
+#endif
+
+#ifdef TOPMOST_BENCH_MOCK
+
+// Everything the topmost module does per window, at desktop sizes no real
+// session reaches, over the in-memory window system so only our own code is
+// timed: enumeration and the packed snapshot, title lookup (uncached, worst
+// case at the bottom of the stack, and through the title cache), matching
+// every title against the configured patterns, and re-raising a covered
+// target alone and as part of a group.
+int RunScale(size_t iterations) {
+    static const size_t kScaleSizes[] = { 100, 1000, 10000 };
+    const size_t groupSize = 8;
+    int failures = 0;
+
+    printf("[scale] iterations<=%zu\n", iterations);
+    printf("%-7s %10s %10s %10s %10s %10s %10s %10s\n", "windows", "enum us", "snap us", "find us",
+           "cached us", "match us", "raise us", "group us");
+    for (size_t size : kScaleSizes) {
+        MockWindowsReset();
+        std::mt19937 rng(static_cast<uint32_t>(size));
+        std::vector<WindowHandle> handles;
+        for (size_t i = 0; i < size; i++) {
+            std::string title = RandomCase(kTitleWords[rng() % kTitleWordCount], rng);
+            title += " - " + RandomCase(kTitleWords[rng() % kTitleWordCount], rng);
+            title += " scale window " + std::to_string(i);
+            handles.push_back(MockWindowCreate(title, static_cast<uint32_t>(1000 + i % 97)));
+        }
+        // Created last-on-top, so the first window is at the bottom
+        WindowHandle bottom = handles.front();
+        std::vector<WindowHandle> group(handles.begin(), handles.begin() + groupSize);
+
+        TitleMatcher matcher;
+        for (size_t p = 0; p < 8; p++) {
+            matcher.AddPattern(kTitleWords[(p * 5) % kTitleWordCount],
+                               p % 4 == 3 ? kTitleMatchPrefix : kTitleMatchSubstring);
+        }
+        matcher.Compile();
+
+        // Keep the largest sizes to a few seconds
+        size_t runs = std::max<size_t>(5, std::min(iterations, iterations * 1000 / size));
+        LatencyHistogram enumerate, snapshot, find, cached, match, raise, reassert;
+        std::vector<uint8_t> packed;
+        std::vector<uint32_t> matched;
+        WindowTitleCache cache;
+        for (size_t r = 0; r < runs; r++) {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<WindowInfo> visible = GetVisibleWindows();
+            enumerate.Record(static_cast<uint64_t>(ElapsedNs(start)));
+
+            start = std::chrono::steady_clock::now();
+            PackWindowSnapshot(GetWindowSnapshot(), &packed);
+            snapshot.Record(static_cast<uint64_t>(ElapsedNs(start)));
+
+            start = std::chrono::steady_clock::now();
+            WindowHandle found = FindWindowByTitle("SCALE Window 0");
+            find.Record(static_cast<uint64_t>(ElapsedNs(start)));
+
+            start = std::chrono::steady_clock::now();
+            WindowHandle hit = cache.Find("scale window 0");
+            cached.Record(static_cast<uint64_t>(ElapsedNs(start)));
+
+            start = std::chrono::steady_clock::now();
+            size_t matches = 0;
+            for (const WindowInfo& window : visible) {
+                matched.clear();
+                matcher.Match(window.title, &matched);
+                matches += matched.size();
+            }
+            match.Record(static_cast<uint64_t>(ElapsedNs(start)));
+
+            // Covered target back on top
+            MockWindowLower(bottom);
+            start = std::chrono::steady_clock::now();
+            bool raised = SetWindowAlwaysOnTop(bottom, true);
+            raise.Record(static_cast<uint64_t>(ElapsedNs(start)));
+            bool onTop = IsWindowNearTop(bottom, 1);
+            MockWindowLower(bottom);
+
+            SetWindowsAlwaysOnTop(group, true);
+            MockWindowLower(group[3]);
+            SetWindowAlwaysOnTop(group[3], true);
+            start = std::chrono::steady_clock::now();
+            ReassertWindowsTopmost(group);
+            reassert.Record(static_cast<uint64_t>(ElapsedNs(start)));
+            bool groupOnTop = IsWindowNearTop(group[0], 1);
+            SetWindowsAlwaysOnTop(group, false);
+            MockWindowLower(bottom);
+
+            if (visible.size() != size || found != bottom || hit != bottom || matches == 0 || !raised ||
+                !onTop || !groupOnTop) {
+                fprintf(stderr, "scale check failed at %zu windows: visible=%zu found=%d cached=%d matches=%zu "
+                        "raised=%d onTop=%d groupOnTop=%d\n", size, visible.size(), found == bottom ? 1 : 0,
+                        hit == bottom ? 1 : 0, matches, raised ? 1 : 0, onTop ? 1 : 0, groupOnTop ? 1 : 0);
+                failures++;
+                break;
+            }
+        }
+
+        struct { const char* name; LatencyHistogram* histogram; } columns[] = {
+            { "enumerate", &enumerate }, { "snapshot", &snapshot }, { "find_bottom", &find },
+            { "find_cached", &cached }, { "match", &match }, { "raise", &raise }, { "reassert_group", &reassert },
+        };
+        printf("%-7zu", size);
+        for (const auto& column : columns) {
+            double us = column.histogram->Summarize().p50 / 1000.0;
+            printf(" %10.2f", us);
+            BenchMetric("scale", std::string(column.name) + "_" + std::to_string(size), us, "us");
+        }
+        printf("\n");
+    }
+
+    // Renaming the cached window must drop the cache entry
+    MockWindowsReset();
+    WindowHandle first = MockWindowCreate("Teyvat Browser", 1);
+    WindowTitleCache cache;
+    bool cachedOk = cache.Find("teyvat") == first && cache.Find("teyvat") == first &&
+                    cache.Stats().hits == 1;
+    MockWindowSetTitle(first, "Something Else");
+    cachedOk = cachedOk && cache.Stats().entries == 0 && cache.Find("teyvat") == 0;
+    if (!cachedOk) {
+        fprintf(stderr, "scale check failed: title cache not invalidated by rename\n");
+        failures++;
+    }
+    MockWindowsReset();
+    return failures ? 1 : 0;
+}
+
+// The watcher's per-window policies over the in-memory window system, on a
+// virtual clock: covered windows come back in priority order, a window that
+// keeps getting covered spends its budget and then backs off with a doubling
+// pause, and one check is a single z-order read however many windows are
+// watched. For reference the same test as one IsWindowNearTop() per window,
+// which is cheap here but one server round trip each on X11.
+int RunPolicy(size_t iterations) {
+    int failures = 0;
+    auto expect = [&](bool ok, const char* what) {
+        if (!ok) {
+            fprintf(stderr, "policy check failed: %s\n", what);
+            failures++;
+        }
+    };
+    const uint64_t ms = 1000000ull;
+
+    MockWindowsReset();
+    for (int i = 0; i < 20; i++) {
+        MockWindowCreate("Other window " + std::to_string(i), 200);
+    }
+    WindowHandle overlay = MockWindowCreate("Teyvat Browser", 100);
+    WindowHandle toolbar = MockWindowCreate("Teyvat Toolbar", 100);
+    WindowHandle notes = MockWindowCreate("Teyvat Notes", 100);
+
+    // Priority: the two lower windows are covered, the highest goes along
+    TopmostTargetSet targets;
+    TopmostPolicy low, mid, high;
+    low.priority = 0;
+    mid.priority = 1;
+    high.priority = 5;
+    targets.Add(notes, low, false);
+    targets.Add(overlay, high, false);
+    targets.Add(toolbar, mid, false);
+    SetWindowsAlwaysOnTop(std::vector<WindowHandle>{ overlay, toolbar, notes }, true);
+    MockWindowLower(notes);
+    MockWindowLower(toolbar);
+    uint64_t now = SteadyNowNs();
+    size_t raised = targets.Check(now, now);
+    std::vector<WindowInfo> visible = GetVisibleWindows();
+    expect(raised == 2, "covered windows not raised");
+    expect(visible.size() >= 3 && visible[0].handle == overlay && visible[1].handle == toolbar &&
+           visible[2].handle == notes, "raised out of priority order");
+    expect(targets.Check(now, now) == 0, "raised although on top");
+
+    // Budget and backoff: 3 raises per period, then 50 ms, then 100 ms
+    TopmostTargetSet fight;
+    TopmostPolicy fighting;
+    fighting.raiseBudget = 3;
+    fighting.backoffMs = 50;
+    fight.Add(overlay, fighting, false);
+    size_t raises = 0;
+    for (int i = 0; i < 4; i++) {
+        MockWindowLower(overlay);
+        raises += fight.Check(now + i * ms, now + i * ms);
+    }
+    uint64_t firstPause = fight.RetryDeadline();
+    expect(raises == 3 && firstPause == now + 3 * ms + 50 * ms, "budget not enforced");
+    expect(fight.Check(now + 20 * ms, now + 20 * ms) == 0, "raised while backing off");
+    expect(fight.Check(firstPause, firstPause) == 1 && fight.RetryDeadline() == 0, "not raised after the pause");
+    raises = 0;
+    for (int i = 1; i <= 3; i++) {
+        MockWindowLower(overlay);
+        raises += fight.Check(firstPause + i * ms, firstPause + i * ms);
+    }
+    uint64_t secondPause = fight.RetryDeadline();
+    expect(raises == 2 && secondPause == firstPause + 3 * ms + 100 * ms, "backoff did not double");
+    // A calm period later the fight starts over at the first pause
+    uint64_t calm = secondPause + 2000 * ms;
+    raises = 0;
+    for (int i = 0; i < 4; i++) {
+        MockWindowLower(overlay);
+        raises += fight.Check(calm + i * ms, calm + i * ms);
+    }
+    expect(raises == 3 && fight.RetryDeadline() == calm + 3 * ms + 50 * ms, "backoff not reset after calm");
+    TopmostWatcherStats fightStats = fight.Stats();
+    expect(fightStats.backoffs == 3 && fightStats.reRaises == 9, "fight counters");
+
+    // Hidden windows are not checked at all
+    fight.SetHidden(overlay, true);
+    expect(!fight.AnyVisible() && fight.RetryDeadline() == 0 && fight.Check(calm, calm) == 0,
+           "hidden window checked");
+    expect(fight.Stats().hidden && fight.Stats().hides == 1, "hide not counted");
+
+    printf("[policy] priority order ok, fight: reRaises=%llu throttled=%llu backoffs=%llu\n",
+           static_cast<unsigned long long>(fightStats.reRaises),
+           static_cast<unsigned long long>(fightStats.throttled),
+           static_cast<unsigned long long>(fightStats.backoffs));
+
+    // Cost of one notification as the number of watched windows grows (up
+    // to the check depth; more could never all count as on top)
+    static const size_t kWatchedCounts[] = { 1, 2, 4, 8 };
+    printf("%-8s %12s %12s\n", "watched", "check us", "perWindow us");
+    for (size_t watched : kWatchedCounts) {
+        MockWindowsReset();
+        for (int i = 0; i < 200; i++) {
+            MockWindowCreate("Other window " + std::to_string(i), 200);
+        }
+        TopmostTargetSet set;
+        std::vector<WindowHandle> handles;
+        for (size_t i = 0; i < watched; i++) {
+            handles.push_back(MockWindowCreate("Watched " + std::to_string(i), 100));
+            set.Add(handles.back(), TopmostPolicy(), false);
+        }
+        SetWindowsAlwaysOnTop(handles, true);
+
+        LatencyHistogram check, perWindow;
+        for (size_t i = 0; i < iterations; i++) {
+            auto start = std::chrono::steady_clock::now();
+            set.Check(SteadyNowNs(), 0);
+            check.Record(static_cast<uint64_t>(ElapsedNs(start)));
+
+            start = std::chrono::steady_clock::now();
+            size_t onTop = 0;
+            for (WindowHandle handle : handles) {
+                onTop += IsWindowNearTop(handle, kTopmostCheckDepth) ? 1 : 0;
+            }
+            perWindow.Record(static_cast<uint64_t>(ElapsedNs(start)));
+            if (onTop == 0) failures++;
+        }
+        double checkUs = check.Summarize().p50 / 1000.0;
+        double perWindowUs = perWindow.Summarize().p50 / 1000.0;
+        printf("%-8zu %12.2f %12.2f\n", watched, checkUs, perWindowUs);
+        BenchMetric("policy", "check_" + std::to_string(watched), checkUs, "us");
+        BenchMetric("policy", "per_window_" + std::to_string(watched), perWindowUs, "us");
+    }
+
+    MockWindowsReset();
+    return failures ? 1 : 0;
+}
+
+// Records what the governor asks for; only pid 500 runs a game
+class RecordingProcessControl : public ProcessControl {
+public:
+    bool Apply(const std::vector<uint32_t>& pids, ProcessPriorityLevel level, const CpuSet& cpus) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        applies_++;
+        pids_ = pids;
+        level_ = level;
+        cpus_ = cpus;
+        return true;
+    }
+    void RestoreAll() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        restores_++;
+        level_ = kProcessPriorityNormal;
+        cpus_.reset();
+    }
+    CpuSet OverlayCpus(uint32_t) override {
+        CpuSet cpus;
+        cpus.set(2);
+        cpus.set(3);
+        return cpus;
+    }
+    std::string ProcessName(uint32_t pid) override { return pid == 500 ? "GenshinImpact.exe" : "editor"; }
+    ProcessControlCaps Caps() const override { return ProcessControlCaps(); }
+
+    ProcessPriorityLevel Level() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return level_;
+    }
+    size_t Cpus() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cpus_.count();
+    }
+
+private:
+    mutable std::mutex mutex_;
+    uint64_t applies_ = 0;
+    uint64_t restores_ = 0;
+    std::vector<uint32_t> pids_;
+    ProcessPriorityLevel level_ = kProcessPriorityNormal;
+    CpuSet cpus_;
+};
+
+int RunGovernor() {
+    const uint32_t periodMs = 100;
+    int failures = 0;
+
+    MockWindowsReset();
+    WindowHandle overlay = MockWindowCreate("Teyvat Browser", 100);
+    WindowHandle game = MockWindowCreate("Genshin Impact", 500);
+    WindowHandle editor = MockWindowCreate("Notes", 600);
+
+    RecordingProcessControl control;
+    ResourceGovernor governor;
+    GovernorConfig config;
+    config.periodMs = periodMs;
+    config.foregroundEvents = true;
+    config.games.push_back("genshinimpact.EXE");
+    governor.SetProcesses(std::vector<uint32_t>{ 100, 101 });
+    governor.Start(&control, config);
+
+    auto waitState = [&](GovernorState state) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (governor.Stats().state != state) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    };
+    auto expect = [&](bool ok, const char* what) {
+        if (!ok) {
+            fprintf(stderr, "governor check failed: %s\n", what);
+            failures++;
+        }
+    };
+    // What a ForegroundMonitor would report for the focus change
+    auto focus = [&](WindowHandle window, uint32_t pid) {
+        BringWindowToForeground(window);
+        ForegroundApp app;
+        app.pid = pid;
+        ResourceGovernor::OnForegroundChanged(app, &governor);
+    };
+    // Governor thread wakeups over a few periods with nothing changing
+    auto idleSteps = [&]() {
+        uint64_t before = governor.Stats().steps;
+        std::this_thread::sleep_for(std::chrono::milliseconds(periodMs * 3));
+        return governor.Stats().steps - before;
+    };
+
+    // Visible overlay over the game: left alone, and the thread asleep once
+    // its first step is done
+    auto started = std::chrono::steady_clock::now();
+    while (governor.Stats().steps == 0 && std::chrono::steady_clock::now() - started < std::chrono::seconds(2)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    focus(game, 500);
+    expect(idleSteps() == 0, "woke while the overlay was visible");
+    expect(governor.Stats().state == kGovernorActive, "visible overlay lowered");
+
+    governor.SetOverlayVisible(false);
+    expect(waitState(kGovernorGame), "hidden overlay with the game focused");
+    expect(control.Level() == kProcessPriorityEfficiency && control.Cpus() == 2, "game state not applied");
+
+    uint64_t gameSteps = idleSteps();
+    expect(gameSteps >= 1, "game CPUs not re-sampled");
+
+    focus(editor, 600);
+    expect(waitState(kGovernorBackground), "another application focused");
+    expect(control.Level() == kProcessPriorityBackground && control.Cpus() == 0, "background state not applied");
+    expect(idleSteps() == 0, "woke in the background state");
+
+    focus(overlay, 100);
+    expect(waitState(kGovernorActive), "own window focused");
+    expect(control.Level() == kProcessPriorityNormal, "not restored on own focus");
+
+    // Showing the overlay restores at once, not at the next poll
+    focus(game, 500);
+    expect(waitState(kGovernorGame), "back to the game");
+    std::this_thread::sleep_for(std::chrono::milliseconds(periodMs / 2));
+    auto shown = std::chrono::steady_clock::now();
+    governor.SetOverlayVisible(true);
+    expect(waitState(kGovernorActive), "overlay shown");
+    double shownMs = ElapsedNs(shown) / 1e6;
+    GovernorStats stats = governor.Stats();
+    expect(stats.restore.count == 1 && shownMs < periodMs / 2.0, "restore waited for a poll");
+    expect(control.Level() == kProcessPriorityNormal && control.Cpus() == 0, "not restored on show");
+
+    governor.SetOverlayVisible(false);
+    expect(waitState(kGovernorGame), "hidden again");
+    governor.Stop();
+    stats = governor.Stats();
+    expect(stats.state == kGovernorActive && control.Level() == kProcessPriorityNormal, "not restored on stop");
+    expect(stats.stateNs[kGovernorGame] > 0 && stats.stateNs[kGovernorBackground] > 0 &&
+           stats.stateNs[kGovernorActive] > 0, "time in state missing");
+
+    printf("[governor] transitions=%llu applies=%llu steps=%llu\n", static_cast<unsigned long long>(stats.transitions),
+           static_cast<unsigned long long>(stats.applies), static_cast<unsigned long long>(stats.steps));
+    printf("game state re-samples %llu in %u ms (period %u ms)\n", static_cast<unsigned long long>(gameSteps),
+           periodMs * 3, periodMs);
+    printf("time in state ms: active %.1f, background %.1f, game %.1f\n", stats.stateNs[kGovernorActive] / 1e6,
+           stats.stateNs[kGovernorBackground] / 1e6, stats.stateNs[kGovernorGame] / 1e6);
+    printf("restore on show %8.2f us (period %u ms)\n", stats.restore.max / 1000.0, periodMs);
+    BenchMetric("governor", "restore", stats.restore.max / 1000.0, "us");
+
+    MockWindowsReset();
+    return failures ? 1 : 0;
+}
+
+#endif
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string json = TakeJsonOption(argc, argv);
+    const char* suite = argc > 1 ? argv[1] : "all";
+    size_t windows = argc > 2 ? static_cast<size_t>(strtoull(argv[2], nullptr, 10)) : 200;
+    size_t iterations = argc > 3 ? static_cast<size_t>(strtoull(argv[3], nullptr, 10)) : 200;
+    if (windows == 0) windows = 1;
+    if (iterations == 0) iterations = 1;
+
+    bool all = strcmp(suite, "all") == 0;
+    int failures = 0;
+    if (all || strcmp(suite, "match") == 0) failures += RunMatch();
+    if (all || strcmp(suite, "enum") == 0) failures += RunEnum(windows, iterations);
+#ifdef TOPMOST_BENCH_X11
+    if (all || strcmp(suite, "raise") == 0) failures += RunRaise(windows, iterations);
+    if (all || strcmp(suite, "watch") == 0) failures += RunWatch(windows, iterations);
+#endif
+#ifdef TOPMOST_BENCH_MOCK
+    if (all || strcmp(suite, "scale") == 0) failures += RunScale(iterations);
+    if (all || strcmp(suite, "policy") == 0) failures += RunPolicy(iterations);
+    if (all || strcmp(suite, "governor") == 0) failures += RunGovernor();
+#endif
+    if (!json.empty() && !WriteBenchJson(json, "topmost_bench", failures)) failures++;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+// Replays an input trace recorded with startTrace() through the shortcut
+// engine and prints the actions it produces, one per line:
+//
+//   <record> <ms since first record> <action> <press|release|repeat> <count>
+//
+// The output only depends on the trace and the keymap, so it can be kept as
+// a golden file (--expect) for regression tests. A summary with the
+// per-event engine cost goes to stderr as "# key value" lines.
+//
+// The keymap defaults to <trace>.keymap, written alongside the trace.
+// --realtime sleeps to the recorded spacing (--speed scales it); the output
+// is the same either way. Exits non-zero if an action differs from
+// --expect or the engine consumed a different set of events than it did
+// while recording.
+//
+// Usage: trace_replay <trace> [--keymap file] [--expect file] [--realtime] [--speed x] [--quiet]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../src/input_trace.h"
+#include "../src/shortcut_core.h"
+#include "../src/trace_replay.h"
+
+namespace {
+
+const char* TriggerName(uint8_t flags) {
+    if (flags & kEventHold) return (flags & kEventRepeat) ? "repeat" : "hold";
+    if (flags & kEventUp) return "release";
+    return (flags & kEventRepeat) ? "repeat" : "press";
+}
+
+std::string FormatAction(const ReplayedAction& action, const std::vector<std::string>& names) {
+    char line[256];
+    const char* name = action.id < names.size() ? names[action.id].c_str() : "?";
+    snprintf(line, sizeof(line), "%zu %.3f %s %s %u", action.record, action.offsetNs / 1e6, name,
+             TriggerName(action.flags), action.count);
+    return line;
+}
+
+bool ReadLines(const char* path, std::vector<std::string>* lines) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    char buffer[512];
+    while (fgets(buffer, sizeof(buffer), file)) {
+        std::string line(buffer);
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+        if (!line.empty()) lines->push_back(line);
+    }
+    fclose(file);
+    return true;
+}
+
+int Usage() {
+    fprintf(stderr, "usage: trace_replay <trace> [--keymap file] [--expect file] [--realtime] [--speed x] [--quiet]\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) return Usage();
+
+    std::string tracePath = argv[1];
+    std::string keymapPath = tracePath + ".keymap";
+    const char* expectPath = nullptr;
+    bool quiet = false;
+    ReplayOptions options;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--keymap") == 0 && i + 1 < argc) keymapPath = argv[++i];
+        else if (strcmp(argv[i], "--expect") == 0 && i + 1 < argc) expectPath = argv[++i];
+        else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) options.speed = atof(argv[++i]);
+        else if (strcmp(argv[i], "--realtime") == 0) options.realtime = true;
+        else if (strcmp(argv[i], "--quiet") == 0) quiet = true;
+        else return Usage();
+    }
+
+    std::string error;
+    InputTraceReader reader;
+    if (!reader.Open(tracePath, &error)) {
+        fprintf(stderr, "trace_replay: %s\n", error.c_str());
+        return 2;
+    }
+
+    ShortcutEngine engine;
+    if (!LoadReplayKeymap(keymapPath, &engine, &error)) {
+        fprintf(stderr, "trace_replay: %s\n", error.c_str());
+        return 2;
+    }
+    engine.PublishBindings();
+
+    std::vector<ReplayedAction> actions;
+    ReplayStats stats;
+    bool consistent = ReplayInputTrace(reader.Records(), reader.Count(), &engine, options, &actions, &stats);
+
+    const std::vector<std::string>& names = engine.Table().ActionNames();
+    std::vector<std::string> lines;
+    lines.reserve(actions.size());
+    for (const ReplayedAction& action : actions) {
+        lines.push_back(FormatAction(action, names));
+        if (!quiet) printf("%s\n", lines.back().c_str());
+    }
+
+    const InputTraceHeader& header = reader.Header();
+    fprintf(stderr, "# platform %s\n", InputTracePlatformName(header.platform));
+    fprintf(stderr, "# finished %u\n", header.finished);
+    fprintf(stderr, "# records %zu\n", stats.records);
+    fprintf(stderr, "# dropped %llu\n", static_cast<unsigned long long>(header.dropped.load()));
+    fprintf(stderr, "# injected %zu\n", stats.injected);
+    fprintf(stderr, "# actions %zu\n", actions.size());
+    fprintf(stderr, "# consumed_mismatches %zu\n", stats.consumedMismatches);
+    fprintf(stderr, "# ns_per_event_mean %.1f\n", stats.replayed ? static_cast<double>(stats.totalNs) / stats.replayed : 0.0);
+    fprintf(stderr, "# ns_per_event_p50 %llu\n", static_cast<unsigned long long>(stats.p50Ns));
+    fprintf(stderr, "# ns_per_event_p99 %llu\n", static_cast<unsigned long long>(stats.p99Ns));
+    fprintf(stderr, "# ns_per_event_max %llu\n", static_cast<unsigned long long>(stats.maxNs));
+    fprintf(stderr, "# events_per_sec %.0f\n", stats.totalNs ? stats.replayed * 1e9 / stats.totalNs : 0.0);
+
+    int result = 0;
+    if (!consistent) {
+        fprintf(stderr, "trace_replay: consumed/passed decision differs from the recording (first at record %zu)\n",
+                stats.firstMismatch);
+        result = 1;
+    }
+    if (expectPath) {
+        std::vector<std::string> expected;
+        if (!ReadLines(expectPath, &expected)) {
+            fprintf(stderr, "trace_replay: cannot read %s\n", expectPath);
+            return 2;
+        }
+        size_t common = expected.size() < lines.size() ? expected.size() : lines.size();
+        size_t first = common;
+        for (size_t i = 0; i < common; i++) {
+            if (expected[i] != lines[i]) {
+                first = i;
+                break;
+            }
+        }
+        if (first != common || expected.size() != lines.size()) {
+            fprintf(stderr, "trace_replay: action %zu differs from %s\n  expected: %s\n  replayed: %s\n", first,
+                    expectPath, first < expected.size() ? expected[first].c_str() : "(end)",
+                    first < lines.size() ? lines[first].c_str() : "(end)");
+            result = 1;
+        }
+    }
+    return result;
+}
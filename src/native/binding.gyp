@@ -1,8 +1,27 @@
 {
   "targets": [
     {
-      "target_name": "high_priority_shortcut",
-      "sources": [ "src/high_priority_shortcut.cc" ],
+      "target_name": "teyvat_native",
+      "sources": [
+        "src/native_runtime.cc",
+        "src/high_priority_shortcut.cc",
+        "src/shortcut_core.cc",
+        "src/keymap_compiler.cc",
+        "src/keymap_profiles.cc",
+        "src/timer_wheel.cc",
+        "src/input_watchdog.cc",
+        "src/input_trace.cc",
+        "src/trace_replay.cc",
+        "src/high_priority_topmost.cc",
+        "src/title_matcher.cc",
+        "src/topmost_targets.cc",
+        "src/topmost_worker.cc",
+        "src/window_snapshot.cc",
+        "src/window_title_cache.cc",
+        "src/high_priority_governor.cc",
+        "src/resource_governor.cc",
+        "src/trace_events.cc"
+      ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")"
       ],
@@ -13,26 +32,133 @@
       "libraries": [ ],
       "conditions": [
         ["OS=='win'", {
-          "libraries": [ "user32.lib" ]
+          "sources": [
+            "src/input_backend_win32.cc",
+            "src/foreground_monitor_win32.cc",
+            "src/mapped_file_win32.cc",
+            "src/window_platform_win32.cc",
+            "src/topmost_watcher_win32.cc",
+            "src/process_control_win32.cc"
+          ],
+          "libraries": [ "user32.lib", "wtsapi32.lib" ]
+        }],
+        ["OS=='linux'", {
+          "sources": [
+            "src/input_backend_evdev.cc",
+            "src/foreground_monitor_x11.cc",
+            "src/mapped_file_posix.cc",
+            "src/window_platform_x11.cc",
+            "src/topmost_watcher_x11.cc",
+            "src/process_control_linux.cc"
+          ],
+          "libraries": [ "-lxcb" ]
+        }],
+        ["OS!='win' and OS!='linux'", {
+          "sources": [
+            "src/input_backend_null.cc",
+            "src/foreground_monitor_null.cc",
+            "src/mapped_file_posix.cc",
+            "src/window_platform_null.cc",
+            "src/process_control_null.cc"
+          ]
         }]
       ]
     },
     {
-      "target_name": "high_priority_topmost",
-      "sources": [ "src/high_priority_topmost.cc" ],
-      "include_dirs": [
-        "<!@(node -p \"require('node-addon-api').include\")"
+      "target_name": "shortcut_bench",
+      "type": "executable",
+      "sources": [
+        "bench/shortcut_bench.cc",
+        "src/shortcut_core.cc",
+        "src/keymap_compiler.cc",
+        "src/keymap_profiles.cc",
+        "src/timer_wheel.cc",
+        "src/input_watchdog.cc",
+        "src/input_trace.cc",
+        "src/trace_replay.cc",
+        "src/trace_events.cc"
       ],
-      "dependencies": [
-        "<!(node -p \"require('node-addon-api').gyp\")"
+      "include_dirs": [ "src" ],
+      "conditions": [
+        ["OS=='win'", {
+          "sources": [ "src/mapped_file_win32.cc" ]
+        }],
+        ["OS=='linux'", {
+          "sources": [ "src/input_backend_evdev.cc", "src/mapped_file_posix.cc" ],
+          "defines": [ "SHORTCUT_BENCH_EVDEV" ]
+        }],
+        ["OS!='win' and OS!='linux'", {
+          "sources": [ "src/mapped_file_posix.cc" ]
+        }]
+      ]
+    },
+    {
+      "target_name": "trace_replay",
+      "type": "executable",
+      "sources": [
+        "bench/trace_replay.cc",
+        "src/shortcut_core.cc",
+        "src/keymap_compiler.cc",
+        "src/timer_wheel.cc",
+        "src/input_trace.cc",
+        "src/trace_replay.cc"
       ],
-      "defines": [ "NAPI_DISABLE_CPP_EXCEPTIONS" ],
-      "libraries": [ ],
+      "include_dirs": [ "src" ],
+      "conditions": [
+        ["OS=='win'", {
+          "sources": [ "src/mapped_file_win32.cc" ]
+        }],
+        ["OS!='win'", {
+          "sources": [ "src/mapped_file_posix.cc" ]
+        }]
+      ]
+    },
+    {
+      "target_name": "topmost_bench",
+      "type": "executable",
+      "sources": [
+        "bench/topmost_bench.cc",
+        "src/title_matcher.cc",
+        "src/topmost_targets.cc",
+        "src/trace_events.cc"
+      ],
+      "include_dirs": [ "src" ],
       "conditions": [
         ["OS=='win'", {
+          "sources": [
+            "src/window_platform_win32.cc",
+            "src/topmost_watcher_win32.cc"
+          ],
           "libraries": [ "user32.lib" ]
+        }],
+        ["OS=='linux'", {
+          "sources": [
+            "src/window_platform_x11.cc",
+            "src/topmost_watcher_x11.cc"
+          ],
+          "defines": [ "TOPMOST_BENCH_X11" ],
+          "libraries": [ "-lxcb" ]
+        }],
+        ["OS!='win' and OS!='linux'", {
+          "sources": [ "src/window_platform_null.cc" ]
         }]
       ]
+    },
+    {
+      "target_name": "topmost_bench_mock",
+      "type": "executable",
+      "sources": [
+        "bench/topmost_bench.cc",
+        "src/title_matcher.cc",
+        "src/topmost_targets.cc",
+        "src/window_snapshot.cc",
+        "src/window_title_cache.cc",
+        "src/window_platform_mock.cc",
+        "src/resource_governor.cc",
+        "src/trace_events.cc"
+      ],
+      "include_dirs": [ "src" ],
+      "defines": [ "TOPMOST_BENCH_MOCK" ]
     }
   ]
 }
@@ -1,13 +1,15 @@
 const path = require('path');
+const trace = require('./trace.js');
 
 let native = null;
 
 try {
-  // 尝试加载编译后的C++模块
-  native = require('../build/Release/high_priority_shortcut.node');
+  // 尝试加载编译后的C++模块：三个模块共用一个native运行时（teyvat_native.node），
+  // 读取.shortcut时才初始化本模块的状态；每个环境（主线程/worker_threads）各有一份
+  native = require('../build/Release/teyvat_native.node').shortcut;
 } catch (err) {
   // 如果加载失败，给出错误信息
-  console.error('Failed to load high_priority_shortcut module:', err);
+  console.error('Failed to load teyvat_native shortcut module:', err);
   // 提供回退实现
   native = {
     start: () => { console.warn('C++ module not available, shortcuts disabled'); },
@@ -15,6 +17,103 @@ try {
   };
 }
 
+// 与native层ShortcutEvent结构保持一致（32字节，小端）
+const EVENT_SIZE = 32;
+const EVENT_DOWN = 0x01;
+const EVENT_UP = 0x02;
+const EVENT_REPEAT = 0x04;
+const EVENT_HOLD = 0x08;
+
+// 事件类型：press按下 / release松开 / hold按住达到阈值 / repeat按住期间的周期触发
+function triggerOf(flags) {
+  if (flags & EVENT_HOLD) {
+    return (flags & EVENT_REPEAT) ? 'repeat' : 'hold';
+  }
+  return (flags & EVENT_UP) ? 'release' : 'press';
+}
+
+// 解码一批事件：每次唤醒只回调一次，这里逐条分发
+// timestamp/jsEntry为native稳定时钟纳秒值，仅用于回传reportCompletion()
+function decodeEvents(buffer, count, jsEntry) {
+  const view = new DataView(buffer);
+  const events = new Array(count);
+  for (let i = 0; i < count; i++) {
+    const offset = i * EVENT_SIZE;
+    events[i] = {
+      actionId: view.getUint16(offset, true),
+      flags: view.getUint8(offset + 2),
+      modifiers: view.getUint8(offset + 3),
+      osTime: view.getUint32(offset + 4, true),
+      timestamp: view.getUint32(offset + 8, true) + view.getUint32(offset + 12, true) * 0x100000000,
+      dispatchDelay: view.getUint32(offset + 16, true),
+      sequence: view.getUint32(offset + 20, true),
+      // 长按合并后一个事件代表的按键次数，未合并时为1
+      count: view.getUint32(offset + 24, true),
+      repeat: (view.getUint8(offset + 2) & EVENT_REPEAT) !== 0,
+      trigger: triggerOf(view.getUint8(offset + 2)),
+      jsEntry
+    };
+  }
+  return events;
+}
+
+// 直通端口消息中的事件类型编码（release不经端口转发）
+const PORT_TRIGGERS = { press: 0, hold: 1, repeat: 2 };
+// 等待渲染进程确认的事件上限，超出时丢弃最早的（只影响延迟统计）
+const MAX_PENDING_ACKS = 256;
+
+// 把一批事件中绑定了直通端口的动作打包成一条消息发出：[code, trigger, count, sequence, ...]
+// 在调用任何应用层回调之前执行，渲染进程不必等主进程处理完同批其它事件
+function routeEvents(api, events) {
+  if (!api.eventPort) {
+    return;
+  }
+  let message = null;
+  for (const event of events) {
+    if (event.flags & EVENT_UP) {
+      continue;
+    }
+    const code = api.eventRoutes.get(api.actionNames[event.actionId]);
+    if (code === undefined) {
+      continue;
+    }
+    if (!message) {
+      message = [];
+    }
+    message.push(code, PORT_TRIGGERS[event.trigger], event.count, event.sequence);
+    event.routed = true;
+    api.pendingAcks.set(event.sequence, event);
+    if (api.pendingAcks.size > MAX_PENDING_ACKS) {
+      api.pendingAcks.delete(api.pendingAcks.keys().next().value);
+    }
+  }
+  if (!message) {
+    return;
+  }
+  try {
+    api.eventPort.postMessage(message);
+  } catch (err) {
+    // 端口已关闭：退回普通回调路径
+    console.warn('[shortcut] event port closed:', err.message);
+    api.eventPort = null;
+    for (const event of events) {
+      event.routed = false;
+    }
+  }
+}
+
+// 键位表编译时被跳过的绑定（无法解析、重复、冲突）逐条打印出来
+function warnKeymapIssues() {
+  const report = native && native.getKeymapReport ? native.getKeymapReport() : null;
+  if (!report) {
+    return;
+  }
+  for (const issue of report.issues) {
+    const where = issue.profile ? `[${issue.profile}] ` : '';
+    console.warn(`[shortcut] ${where}${issue.type}: ${issue.action} = "${issue.keys}" 已忽略：${issue.message}`);
+  }
+}
+
 // 包装函数以提供更友好的API
 const api = {
   installHook: function(callback) {
@@ -24,7 +123,25 @@ const api = {
     this.callback = callback;
   },
   
-  registerShortcuts: function(shortcuts) {
+  // shortcuts: { 动作名: "Ctrl+K" }；支持多键序列 "Ctrl+K, P" / "Insert Insert"，
+  // 也可写成 { keys: "Ctrl+K, P", timeout: 毫秒 } 指定相邻两键的最大间隔（默认1000）
+  // 键名不区分大小写，修饰键顺序任意；按声明顺序先到先得，无法解析、重复或与已有绑定冲突
+  //   （包括一个是另一个序列的前缀）的条目会被跳过并打印警告，详见getKeymapReport()
+  // options: { grab } 仅Linux evdev后端使用，独占输入设备并转发未匹配的按键
+  // options.mouseHook: 默认true，鼠标侧键经由低级鼠标钩子/完整设备读取，已绑定的侧键会被拦截（游戏和浏览器的前进/后退都收不到）；
+  //   设为false则只经由按键专用通道读取（Windows Raw Input，Linux按事件码过滤的设备），鼠标移动不再逐条经过输入线程，
+  //   但侧键只能监听、不会被拦截；Windows下若本进程的其他窗口（如Chromium指针锁定）占用了Raw Input鼠标注册，
+  //   不会抢回，而是在getInputHealth().mouseTakenOver中报告
+  // options.repeat: { 动作名: 'pass' | 'drop' | 'rate' | 'coalesce' | { mode, rate } }
+  //   长按自动重复的处理方式：丢弃、限速为rate次/秒，或每1/rate秒合并为一个带count的事件（默认10）
+  // options.triggers: { 动作名: { press, release, hold: 毫秒, repeat: 毫秒 } }
+  //   按住hold毫秒后触发一次hold，之后每repeat毫秒触发一次repeat（event.count为第几次），
+  //   计时在native定时器线程完成；设置了hold/repeat时松开总会收到release
+  // options.profiles: { 方案名: { process: [可执行文件名], windowClass: [窗口类名], shortcuts, inherit } }
+  //   按前台应用启用的键位方案，进程名/窗口类名不区分大小写，按声明顺序取第一个匹配的方案
+  //   shortcuts覆盖默认键位：字符串改绑，null/false表示在该应用中不拦截此动作；inherit: false则不继承默认键位
+  //   前台窗口由native层订阅系统焦点事件跟踪，切换方案只是一次原子写，JS不参与；动作ID在各方案间共用
+  registerShortcuts: function(shortcuts, options) {
     if (!native || !native.start) {
       console.warn('C++ module not available, shortcuts registration skipped');
       return;
@@ -34,18 +151,208 @@ const api = {
       throw new Error('必须先调用installHook()设置回调函数');
     }
     
+    // 已在监听时优先热替换键位表，钩子和回调保持不变
+    if (this.updateShortcuts(shortcuts, options)) {
+      return;
+    }
+    
     // 停止之前的监听
     native.stop();
     
     // 启动新的快捷键监听
-    native.start(shortcuts, this.callback);
+    // native层只回传整数动作ID，这里按名称表映射回动作名；热替换后名称表会被更新，
+    // 已有动作的ID保持不变，所以替换前排队的事件仍能正确映射
+    // 定时器线程的hold/repeat与松开事件存在竞争，时间戳早于该动作最近一次松开的直接丢弃
+    const callback = this.callback;
+    const lastRelease = new Map();
+    this.actionNames = native.start(shortcuts, (buffer, count, jsEntry) => {
+      const events = decodeEvents(buffer, count, jsEntry).filter(event => {
+        if (event.flags & EVENT_UP) {
+          lastRelease.set(event.actionId, event.timestamp);
+          return true;
+        }
+        return !(event.flags & EVENT_HOLD) || event.timestamp >= (lastRelease.get(event.actionId) || 0);
+      });
+      routeEvents(this, events);
+      for (const event of events) {
+        callback(this.actionNames[event.actionId], event);
+      }
+    }, options || {}) || [];
+    this.listening = true;
+    warnKeymapIssues();
+  },
+  
+  // 原子替换正在使用的键位表，不卸载钩子；返回false表示需要完整重启（由registerShortcuts处理）
+  updateShortcuts: function(shortcuts, options) {
+    if (!this.listening || !native || !native.update) {
+      return false;
+    }
+    const actionNames = native.update(shortcuts, options || {});
+    if (!actionNames) {
+      return false;
+    }
+    this.actionNames = actionNames;
+    warnKeymapIssues();
+    return true;
+  },
+  
+  // 只检查不绑定：返回 { bindings: [{ action, keys }], issues: [{ type, action, keys, other, message }] }
+  // bindings中的keys为规范写法（如 "shift+control+f1" -> "Ctrl+Shift+F1"），type为invalid/duplicate/conflict
+  validateShortcuts: function(shortcuts) {
+    if (!native || !native.compileKeymap) {
+      return null;
+    }
+    return native.compileKeymap(shortcuts);
+  },
+  
+  // 最近一次registerShortcuts/updateShortcuts的编译结果，格式同validateShortcuts()
+  getKeymapReport: function() {
+    if (!native || !native.getKeymapReport) {
+      return null;
+    }
+    return native.getKeymapReport();
+  },
+  
+  // 事件直通端口：routes中列出的动作（{ 动作名: 非负整数编码 }）在每批事件到达时、
+  // 调用installHook回调之前，直接以 [code, trigger(0按下/1按住/2重复), count, sequence, ...]
+  // 的形式发往port（Electron MessagePortMain），省去主进程拼脚本和executeJavaScript
+  // 这些事件仍会交给回调，但带有event.routed = true，回调只需做窗口管理之类的附带工作
+  // 对端处理完后回发 [sequence, ...]，据此调用reportCompletion，延迟统计覆盖到渲染进程
+  // port为null时解除；对端关闭后自动解除，事件回到普通回调路径
+  setEventPort: function(port, routes) {
+    if (this.eventPort && this.eventPort !== port) {
+      this.eventPort.removeListener('message', this.onEventPortMessage);
+      this.eventPort.removeListener('close', this.onEventPortClose);
+      this.eventPort.close();
+    }
+    this.pendingAcks = new Map();
+    this.eventRoutes = new Map(Object.entries(routes || {}));
+    this.eventPort = port || null;
+    if (!port) {
+      return;
+    }
+    this.onEventPortMessage = (message) => {
+      if (!Array.isArray(message.data)) {
+        return;
+      }
+      for (const sequence of message.data) {
+        const event = this.pendingAcks.get(sequence);
+        if (event) {
+          this.pendingAcks.delete(sequence);
+          this.reportCompletion(event);
+        }
+      }
+    };
+    this.onEventPortClose = () => {
+      if (this.eventPort === port) {
+        this.eventPort = null;
+        this.pendingAcks.clear();
+      }
+    };
+    port.on('message', this.onEventPortMessage);
+    port.on('close', this.onEventPortClose);
+    port.start();
+  },
+  
+  // 处理完成后回报，用于统计端到端延迟（event为回调的第二个参数）
+  reportCompletion: function(event) {
+    if (!native || !native.reportCompletion || !event) {
+      return;
+    }
+    native.reportCompletion(event.timestamp || 0, event.jsEntry || 0);
   },
   
+  // 各阶段延迟统计（单位：微秒）：osToHook/hookToDispatch/dispatchToJs/jsToComplete/hookToComplete
+  getLatencyStats: function() {
+    if (!native || !native.getLatencyStats) {
+      return null;
+    }
+    return native.getLatencyStats();
+  },
+  
+  resetLatencyStats: function() {
+    if (native && native.resetLatencyStats) {
+      native.resetLatencyStats();
+    }
+  },
+  
+  // 当前输入后端信息（name/keyboard/mouse）
+  getBackendInfo: function() {
+    if (!native || !native.getBackendInfo) {
+      return null;
+    }
+    return native.getBackendInfo();
+  },
+  
+  // 输入线程优先级与钩子健康状况：是否提权成功、探测次数、钩子失效与重装次数，
+  // 以及JS侧消费停滞次数（consumerStalls）与重发唤醒次数（drainKicks）；
+  // events为输入线程处理的原始事件数（含未绑定的），cpuMs为输入线程累计CPU时间；
+  // mouseTakenOver为true表示Raw Input鼠标注册被本进程其他窗口占用，侧键暂时收不到
+  getInputHealth: function() {
+    if (!native || !native.getInputHealth) {
+      return null;
+    }
+    return native.getInputHealth();
+  },
+  
+  // 键位方案状态：{ monitor, profiles, active（null为默认键位）, foregroundChanges, switches, pid, process, windowClass }
+  getProfileStats: function() {
+    if (!native || !native.getProfileStats) {
+      return null;
+    }
+    return native.getProfileStats();
+  },
+  
+  // 事件投递统计（published/dropped/delivered/batches）
+  getEventStats: function() {
+    if (!native || !native.getEventStats) {
+      return null;
+    }
+    return native.getEventStats();
+  },
+  
+  // 将钩子看到的原始输入（含注入事件、是否被拦截）录制到二进制trace文件，供trace_replay离线重放
+  // 同时写出 path + '.keymap' 记录当前键位；options: { maxRecords } 默认约100万条（32MB），写满后计入dropped
+  // 录制跨越registerShortcuts的重启持续进行，直到stopTrace()；返回 { path, records, dropped, capacity }
+  startTrace: function(path, options) {
+    if (!native || !native.startTrace) {
+      return null;
+    }
+    return native.startTrace(path, options || {});
+  },
+  
+  // 结束录制并关闭文件，返回最终统计；未在录制时返回null
+  stopTrace: function() {
+    if (!native || !native.stopTrace) {
+      return null;
+    }
+    return native.stopTrace();
+  },
+  
+  getTraceInfo: function() {
+    if (!native || !native.getTraceInfo) {
+      return null;
+    }
+    return native.getTraceInfo();
+  },
+  
+  // 时间线span（钩子匹配keyboardHook/evdevKey等、TSFN派发tsfnDispatch、唤醒请求drainRequest）属于整个native运行时，
+  // 由trace.js统一开关、收集和写文件，这里只是转出，已包含topmost模块的span。与上面的输入trace相互独立
+  setTraceEvents: trace.setTraceEvents,
+  getTraceEventStats: trace.getTraceEventStats,
+  collectTraceEvents: trace.collectTraceEvents,
+  dumpTrace: trace.dumpTrace,
+  
   uninstallHook: function() {
+    this.setEventPort(null);
+    if (native && native.stopTrace) {
+      native.stopTrace();
+    }
     if (native && native.stop) {
       native.stop();
     }
     this.callback = null;
+    this.listening = false;
   }
 };
 
@@ -0,0 +1,117 @@
+let native = null;
+
+try {
+  // Try to load the compiled C++ module (the governor part of the shared
+  // native runtime, set up on first access)
+  native = require('../build/Release/teyvat_native.node').governor;
+} catch (err) {
+  console.error('Failed to load teyvat_native governor module:', err);
+  native = null;
+}
+
+// Wrapper API: lowers the app's CPU priority while the overlay is hidden
+const api = {
+  /**
+   * Start the governor thread. It follows the focus changes and moves the
+   * processes given to setProcesses() between 'active' (as found),
+   * 'background' (overlay hidden) and 'game' (overlay hidden, game focused:
+   * efficiency priority, kept off the game's CPUs). It sleeps while the
+   * overlay is visible.
+   * @param {Object} [options]
+   * @param {number} [options.periodMs=500] - How often the game state
+   *   re-samples the game's CPUs (and the foreground poll interval where
+   *   focus changes cannot be tracked)
+   * @param {boolean} [options.efficiency=true] - Efficiency rather than
+   *   background priority while a game is focused
+   * @param {boolean} [options.restrictAffinity=true] - Keep off the CPUs the
+   *   game is using
+   * @param {Array<string>} [options.games] - Executable names that count as
+   *   games (case-insensitive); empty or missing = any other application
+   * @returns {boolean} - Success status; false while a governor runs in
+   *   another environment (the process priorities are shared)
+   */
+  start: function(options = {}) {
+    if (!native || !native.startGovernor) {
+      return false;
+    }
+
+    try {
+      return native.startGovernor(options);
+    } catch (err) {
+      console.error('Failed to start resource governor:', err);
+      return false;
+    }
+  },
+
+  /**
+   * Stop the governor and restore every process to its original priority
+   * and affinity
+   */
+  stop: function() {
+    if (native && native.stopGovernor) {
+      native.stopGovernor();
+    }
+  },
+
+  /**
+   * Processes that belong to the app (e.g. app.getAppMetrics() pids)
+   * @param {Array<number>} pids
+   */
+  setProcesses: function(pids) {
+    if (native && native.setGovernorProcesses) {
+      native.setGovernorProcesses(pids);
+    }
+  },
+
+  /**
+   * Report whether the overlay is shown; showing it restores everything
+   * right away
+   * @param {boolean} visible - Visible and not minimized
+   */
+  setOverlayVisible: function(visible) {
+    if (native && native.setOverlayVisible) {
+      native.setOverlayVisible(!!visible);
+    }
+  },
+
+  /**
+   * Get governor state and counters
+   * @returns {Object|null} - { running, state, foregroundPid, transitions,
+   *   steps (governor thread wakeups), applies, applyFailures, overlayCpus,
+   *   timeInState: { active, background, game } (ms),
+   *   applied: { priority, efficiency, affinity, cgroup },
+   *   restore: { count, min, max, mean, p50, p99 } (microseconds) }, or null
+   *   if unavailable
+   */
+  getStats: function() {
+    if (!native || !native.getGovernorStats) {
+      return null;
+    }
+
+    try {
+      return native.getGovernorStats();
+    } catch (err) {
+      console.error('Failed to get governor stats:', err);
+      return null;
+    }
+  },
+
+  /**
+   * Reset the counters and time-in-state totals
+   */
+  resetStats: function() {
+    if (native && native.resetGovernorStats) {
+      native.resetGovernorStats();
+    }
+  },
+
+  /**
+   * Check if the native module is loaded
+   * @returns {boolean}
+   */
+  isAvailable: function() {
+    return !!(native && native.startGovernor);
+  }
+};
+
+module.exports = api;
@@ -1,12 +1,116 @@
 const path = require('path');
+const trace = require('./trace.js');
 
 let native = null;
 
+// Layout of the ArrayBuffer returned by native.getWindowSnapshot(); must match
+// src/window_snapshot.h
+const SNAPSHOT_VERSION = 1;
+const SNAPSHOT_HEADER_BYTES = 16;
+
+const WindowFlags = {
+  TOPMOST: 1 << 0,
+  MINIMIZED: 1 << 1,
+  FOREGROUND: 1 << 2
+};
+
+function align8(offset) {
+  return (offset + 7) & ~7;
+}
+
+let titleDecoder = null;
+
+// A packed snapshot with no windows
+function emptySnapshotBuffer() {
+  const buffer = new ArrayBuffer(align8(SNAPSHOT_HEADER_BYTES + 4));
+  new Uint32Array(buffer, 0, 4)[0] = SNAPSHOT_VERSION;
+  return buffer;
+}
+
+/**
+ * Read-only view over a packed window snapshot. The arrays are typed-array
+ * views on the buffer returned by the native module; titles are only decoded
+ * when asked for, and then cached.
+ */
+class WindowSnapshot {
+  /**
+   * @param {ArrayBuffer|null} buffer - Packed snapshot, or null for an empty one
+   */
+  constructor(buffer) {
+    if (!buffer) {
+      buffer = emptySnapshotBuffer();
+    }
+    const header = new Uint32Array(buffer, 0, 4);
+    if (header[0] !== SNAPSHOT_VERSION) {
+      throw new Error('Unsupported window snapshot version: ' + header[0]);
+    }
+    const count = header[1];
+
+    let offset = SNAPSHOT_HEADER_BYTES;
+    /** @type {number} */
+    this.length = count;
+    /** @type {Float64Array} */
+    this.handles = new Float64Array(buffer, offset, count);
+    offset = align8(offset + count * 8);
+    /** @type {Uint32Array} */
+    this.pids = new Uint32Array(buffer, offset, count);
+    offset = align8(offset + count * 4);
+    /** @type {Uint32Array} 0 = top of the z-order */
+    this.zOrder = new Uint32Array(buffer, offset, count);
+    offset = align8(offset + count * 4);
+    /** @type {Uint32Array} WindowFlags bits */
+    this.flags = new Uint32Array(buffer, offset, count);
+    offset = align8(offset + count * 4);
+    this._titleOffsets = new Uint32Array(buffer, offset, count + 1);
+    offset = align8(offset + (count + 1) * 4);
+    this._titleBytes = new Uint8Array(buffer, offset, header[2]);
+    this._titles = new Array(count);
+  }
+
+  /**
+   * Title of the i-th window (decoded on first access)
+   * @param {number} i - Index, 0 = top of the z-order
+   * @returns {string}
+   */
+  title(i) {
+    let title = this._titles[i];
+    if (title === undefined) {
+      titleDecoder = titleDecoder || new TextDecoder('utf-8');
+      title = titleDecoder.decode(this._titleBytes.subarray(this._titleOffsets[i], this._titleOffsets[i + 1]));
+      this._titles[i] = title;
+    }
+    return title;
+  }
+
+  /**
+   * The i-th window as a plain object
+   * @param {number} i - Index, 0 = top of the z-order
+   * @returns {{handle: number, pid: number, zOrder: number, flags: number, title: string}}
+   */
+  get(i) {
+    return {
+      handle: this.handles[i],
+      pid: this.pids[i],
+      zOrder: this.zOrder[i],
+      flags: this.flags[i],
+      title: this.title(i)
+    };
+  }
+
+  *[Symbol.iterator]() {
+    for (let i = 0; i < this.length; i++) {
+      yield this.get(i);
+    }
+  }
+}
+
 try {
-  // Try to load the compiled C++ module
-  native = require('../build/Release/high_priority_topmost.node');
+  // Try to load the compiled C++ module. All three modules share one native
+  // runtime (teyvat_native.node); reading .topmost sets up this module's
+  // state, once per environment (main thread or worker_thread).
+  native = require('../build/Release/teyvat_native.node').topmost;
 } catch (err) {
-  console.error('Failed to load high_priority_topmost module:', err);
+  console.error('Failed to load teyvat_native topmost module:', err);
   // Provide fallback implementation
   native = {
     startWindowMonitoring: () => { 
@@ -28,15 +132,26 @@ try {
     bringWindowToForeground: () => { 
       console.warn('C++ topmost module not available'); 
       return false;
-    }
+    },
+    startWindowMonitoringAsync: () => Promise.resolve(false),
+    setWindowTopmostAsync: () => Promise.resolve(false),
+    watchWindow: () => false,
+    watchWindowAsync: () => Promise.resolve(false),
+    unwatchWindow: () => false,
+    getWindowSnapshot: () => Promise.resolve(null),
+    findWindows: (patterns) => patterns.map(() => []),
+    getMonitorStats: () => null,
+    resetMonitorStats: () => {}
   };
 }
 
 // Wrapper API to provide a more friendly interface
 const api = {
   /**
-   * Start monitoring a window to keep it always on top
-   * @param {string} windowTitle - Part of the window title to search for
+   * Start monitoring a window to keep it always on top, in place of any
+   * windows watched so far
+   * @param {string|number|Buffer} windowTitle - Native handle (e.g. from
+   *   BrowserWindow.getNativeWindowHandle()) or part of the window title
    * @returns {boolean} - Success status
    */
   startMonitoring: function(windowTitle) {
@@ -54,7 +169,7 @@ const api = {
   
   /**
    * Stop monitoring windows and optionally remove topmost status
-   * @param {string} [windowTitle] - Optional window title to remove topmost from
+   * @param {string|number|Buffer} [windowTitle] - Optional handle or title to remove topmost from
    * @returns {boolean} - Success status
    */
   stopMonitoring: function(windowTitle) {
@@ -73,7 +188,7 @@ const api = {
   
   /**
    * Set a specific window to topmost or not topmost
-   * @param {string} windowTitle - Part of the window title to search for
+   * @param {string|number|Buffer} windowTitle - Native handle or part of the window title
    * @param {boolean} topmost - Whether to set window topmost
    * @returns {boolean} - Success status
    */
@@ -91,6 +206,109 @@ const api = {
     }
   },
   
+  /**
+   * Start monitoring without blocking the JS thread: the lookup and raise run
+   * on the native topmost worker, the watcher starts once they succeed
+   * @param {string|number|Buffer} windowTitle - Native handle or part of the window title
+   * @returns {Promise<boolean>} - Success status
+   */
+  startMonitoringAsync: function(windowTitle) {
+    if (!native || !native.startWindowMonitoringAsync) {
+      return Promise.resolve(false);
+    }
+    
+    try {
+      return native.startWindowMonitoringAsync(windowTitle);
+    } catch (err) {
+      console.error('Failed to start window monitoring:', err);
+      return Promise.resolve(false);
+    }
+  },
+  
+  /**
+   * Set one or more windows topmost (or not) on the native topmost worker.
+   * An array is applied as a single z-order batch, first window on top.
+   * @param {string|number|Buffer|Array<string|number|Buffer>} windows - Handle(s) or title part(s)
+   * @param {boolean} topmost - Whether to set the windows topmost
+   * @returns {Promise<boolean>} - True if every window was found and changed
+   */
+  setTopmostAsync: function(windows, topmost = true) {
+    if (!native || !native.setWindowTopmostAsync) {
+      return Promise.resolve(false);
+    }
+    
+    try {
+      return native.setWindowTopmostAsync(windows, topmost);
+    } catch (err) {
+      console.error('Failed to set window topmost:', err);
+      return Promise.resolve(false);
+    }
+  },
+  
+  /**
+   * Keep one more window on top, next to those already watched. All watched
+   * windows share one native watcher thread; calling this again for a
+   * watched window only changes its policy. The watcher belongs to one
+   * environment at a time: false while another one (a worker_thread) runs it.
+   * @param {string|number|Buffer} windowTitle - Native handle or part of the window title
+   * @param {{priority?: number, raiseBudget?: number, backoffMs?: number}} [policy] -
+   *   priority: higher stays above lower (default 0); raiseBudget: re-raises
+   *   per second before backing off, 0 = unlimited (default 20); backoffMs:
+   *   first pause once the budget is spent, doubled while the window keeps
+   *   getting covered (default 250)
+   * @returns {boolean} - Success status
+   */
+  watchWindow: function(windowTitle, policy) {
+    if (!native || !native.watchWindow) {
+      return false;
+    }
+    
+    try {
+      return native.watchWindow(windowTitle, policy);
+    } catch (err) {
+      console.error('Failed to watch window:', err);
+      return false;
+    }
+  },
+  
+  /**
+   * watchWindow() with the lookup and raise on the native topmost worker
+   * @param {string|number|Buffer} windowTitle - Native handle or part of the window title
+   * @param {{priority?: number, raiseBudget?: number, backoffMs?: number}} [policy]
+   * @returns {Promise<boolean>} - Success status
+   */
+  watchWindowAsync: function(windowTitle, policy) {
+    if (!native || !native.watchWindowAsync) {
+      return Promise.resolve(false);
+    }
+    
+    try {
+      return native.watchWindowAsync(windowTitle, policy);
+    } catch (err) {
+      console.error('Failed to watch window:', err);
+      return Promise.resolve(false);
+    }
+  },
+  
+  /**
+   * Stop keeping one window on top; the other watched windows stay
+   * @param {string|number|Buffer} windowTitle - Native handle or part of the window title
+   * @param {boolean} [lower=false] - Also remove its topmost status
+   * @returns {boolean} - Whether the window was being watched
+   */
+  unwatchWindow: function(windowTitle, lower = false) {
+    if (!native || !native.unwatchWindow) {
+      return false;
+    }
+    
+    try {
+      return native.unwatchWindow(windowTitle, lower);
+    } catch (err) {
+      console.error('Failed to unwatch window:', err);
+      return false;
+    }
+  },
+  
   /**
    * Get list of all visible windows (for debugging)
    * @returns {Array} - Array of window objects with title and handle
@@ -109,9 +327,49 @@ const api = {
     }
   },
   
+  /**
+   * Snapshot of all visible windows, enumerated off the JS thread
+   * @returns {Promise<WindowSnapshot>} - Packed handles, pids, z-order, flags
+   *   and lazily decoded titles; empty if the module is unavailable
+   */
+  getWindowSnapshot: function() {
+    if (!native || !native.getWindowSnapshot) {
+      return Promise.resolve(new WindowSnapshot(null));
+    }
+    
+    return native.getWindowSnapshot()
+      .then(buffer => new WindowSnapshot(buffer))
+      .catch(err => {
+        console.error('Failed to get window snapshot:', err);
+        return new WindowSnapshot(null);
+      });
+  },
+  
+  /**
+   * Match several title patterns against one window enumeration
+   * @param {Array<string|{pattern: string, mode: string}>} patterns - Title
+   *   patterns; mode is 'substring' (default), 'prefix' or 'regex' (`*`, `?`,
+   *   `^`, `$`). Matching is case-insensitive.
+   * @returns {Array<Array<{handle: number, title: string}>>} - Matching windows
+   *   per pattern, topmost first
+   */
+  findWindows: function(patterns) {
+    if (!native || !native.findWindows) {
+      console.warn('C++ topmost module not available');
+      return patterns.map(() => []);
+    }
+    
+    try {
+      return native.findWindows(patterns);
+    } catch (err) {
+      console.error('Failed to find windows:', err);
+      return patterns.map(() => []);
+    }
+  },
+  
   /**
    * Bring a window to foreground
-   * @param {string} windowTitle - Part of the window title to search for
+   * @param {string|number|Buffer} windowTitle - Native handle or part of the window title
    * @returns {boolean} - Success status
    */
   bringToForeground: function(windowTitle) {
@@ -128,6 +386,48 @@ const api = {
     }
   },
   
+  /**
+   * Get counters of the event-driven topmost watcher, summed over every
+   * watched window and per window
+   * @returns {Object|null} - { running, hidden, windows, events, checks,
+   *   reRaises, throttled, backoffs, hides,
+   *   targets: [{ handle, priority, raiseBudget, backoffMs, reRaises,
+   *     throttled, backoffs, hides, hidden, backingOff }],
+   *   reaction: { count, min, max, mean, p50, p90, p99, p999 },
+   *   titleCache: { hits, misses, invalidations, entries },
+   *   worker: { jobs, batches, retries } } with latencies in microseconds, or
+   *   null if unavailable
+   */
+  getMonitorStats: function() {
+    if (!native || !native.getMonitorStats) {
+      return null;
+    }
+    
+    try {
+      return native.getMonitorStats();
+    } catch (err) {
+      console.error('Failed to get monitor stats:', err);
+      return null;
+    }
+  },
+  
+  /**
+   * Reset the watcher counters and reaction latency histogram
+   */
+  resetMonitorStats: function() {
+    if (native && native.resetMonitorStats) {
+      native.resetMonitorStats();
+    }
+  },
+  
+  // Timeline spans (FindWindowByTitle, SetWindowAlwaysOnTop attempts,
+  // watcher checks, worker batches) belong to the whole native runtime; see
+  // trace.js
+  setTraceEvents: trace.setTraceEvents,
+  getTraceEventStats: trace.getTraceEventStats,
+  collectTraceEvents: trace.collectTraceEvents,
+  dumpTrace: trace.dumpTrace,
+  
   /**
    * Check if the native module is available
    * @returns {boolean} - Whether the native module is loaded
@@ -142,4 +442,7 @@ const api = {
   }
 };
 
+api.WindowSnapshot = WindowSnapshot;
+api.WindowFlags = WindowFlags;
+
 module.exports = api;
\ No newline at end of file
@@ -0,0 +1,81 @@
+let native = null;
+
+try {
+  // Timeline spans belong to the native runtime itself, not to one of its
+  // sub-modules: reading these does not set up the shortcut or topmost part
+  native = require('../build/Release/teyvat_native.node');
+} catch (err) {
+  console.error('Failed to load teyvat_native runtime:', err);
+  native = null;
+}
+
+// Wrapper API for the native timeline spans (hook matching, TSFN dispatch,
+// window lookups, topmost attempts, watcher checks, governor steps). One
+// buffer set per process, so every caller sees the spans of every module;
+// binding.js and topmost.js re-export these functions.
+const api = {
+  /**
+   * Turn the spans on or off. Off costs one flag test per span; turning on
+   * discards spans from an earlier session.
+   * @param {boolean} enabled
+   */
+  setTraceEvents: function(enabled) {
+    if (native && native.setTraceEvents) {
+      native.setTraceEvents(!!enabled);
+    }
+  },
+
+  /**
+   * @returns {Object|null} - { enabled, recorded, overwritten, threads };
+   *   a full per-thread ring overwrites its oldest spans (counted in
+   *   overwritten)
+   */
+  getTraceEventStats: function() {
+    if (!native || !native.getTraceEventStats) {
+      return null;
+    }
+    return native.getTraceEventStats();
+  },
+
+  /**
+   * Buffered spans as comma-separated Chrome trace-event objects, without
+   * the enclosing array
+   * @returns {string}
+   */
+  collectTraceEvents: function() {
+    if (!native || !native.collectTraceEvents) {
+      return '';
+    }
+    return native.collectTraceEvents();
+  },
+
+  /**
+   * Write the spans as Chrome trace-event JSON (opens in Perfetto or
+   * chrome://tracing)
+   * @param {string} file - Output path
+   * @returns {boolean} - Whether the file was written
+   */
+  dumpTrace: function(file) {
+    if (!native || !native.dumpTrace) {
+      return false;
+    }
+    try {
+      const count = native.dumpTrace(file);
+      console.log('Native trace written to', file, '(' + count + ' events)');
+      return true;
+    } catch (err) {
+      console.error('Failed to write native trace:', err);
+      return false;
+    }
+  },
+
+  /**
+   * Check if the native runtime is loaded
+   * @returns {boolean}
+   */
+  isAvailable: function() {
+    return !!(native && native.dumpTrace);
+  }
+};
+
+module.exports = api;
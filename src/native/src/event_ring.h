@@ -0,0 +1,167 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "shortcut_table.h"
+
+// Lock-free hand-off from the hook thread to the JS thread.
+//
+// The hook thread is the only producer and the JS thread (TSFN callback) the
+// only consumer. Producers never block or allocate: when the ring is full the
+// event is counted as dropped. At most one drain is scheduled at a time, so a
+// burst of key presses costs one libuv wakeup and one JS call.
+
+const uint8_t kEventDown = 0x01;
+const uint8_t kEventUp = 0x02;
+const uint8_t kEventRepeat = 0x04; // autorepeat, or a repeat-while-held tick with kEventHold
+const uint8_t kEventHold = 0x08;   // produced by the hold timer, not by an input event
+
+// Compact record shared with lib/binding.js (32 bytes, little endian)
+struct ShortcutEvent {
+    ActionId actionId;      // offset 0
+    uint8_t flags;          // offset 2, kEvent* bits
+    uint8_t modifiers;      // offset 3, kMod* bits
+    uint32_t osTime;        // offset 4, OS event time in ms
+    uint64_t timestamp;     // offset 8, steady clock ns at hook entry
+    uint32_t dispatchDelay; // offset 16, ns from hook entry until queued
+    uint32_t sequence;      // offset 20, per-process event counter
+    uint32_t count;         // offset 24, key presses this event stands for (>1 when coalesced);
+                            //            tick number for repeat-while-held
+    uint32_t reserved;      // offset 28
+};
+
+static_assert(sizeof(ShortcutEvent) == 32, "ShortcutEvent layout is shared with JS");
+
+inline uint64_t SteadyNowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscRing() : head_(0), cachedTail_(0), tail_(0), cachedHead_(0) {}
+
+    // Producer only
+    bool TryPush(const T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - cachedTail_ == Capacity) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head - cachedTail_ == Capacity) return false;
+        }
+        slots_[head & (Capacity - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only; returns the number of items copied into out
+    size_t PopBatch(T* out, size_t maxItems) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (cachedHead_ == tail) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+        }
+        size_t count = cachedHead_ - tail;
+        if (count > maxItems) count = maxItems;
+        for (size_t i = 0; i < count; i++) {
+            out[i] = slots_[(tail + i) & (Capacity - 1)];
+        }
+        tail_.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer only
+    void Reset() {
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+        cachedTail_ = 0;
+        cachedHead_ = 0;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    // Producer and consumer indices live on separate cache lines
+    alignas(64) std::atomic<size_t> head_;
+    size_t cachedTail_;
+    alignas(64) std::atomic<size_t> tail_;
+    size_t cachedHead_;
+    alignas(64) T slots_[Capacity];
+};
+
+const size_t kEventRingCapacity = 256;
+
+struct EventQueueStats {
+    uint64_t published;
+    uint64_t dropped;
+    uint64_t delivered;
+    uint64_t batches;
+};
+
+class EventQueue {
+public:
+    EventQueue() : drainPending_(false), published_(0), dropped_(0), delivered_(0), batches_(0) {}
+
+    // Producer side. Returns true when the caller must schedule a drain
+    // (i.e. wake the JS thread); false if one is already pending or the
+    // event was dropped.
+    bool Publish(const ShortcutEvent& event) {
+        if (!ring_.TryPush(event)) {
+            Bump(dropped_, 1);
+            return false;
+        }
+        Bump(published_, 1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return !drainPending_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    // Producer side: the wakeup could not be scheduled, let the next event retry
+    void CancelDrain() {
+        drainPending_.store(false, std::memory_order_release);
+    }
+
+    // Consumer side. Clears the pending flag before reading so any event
+    // published after this point schedules a fresh drain.
+    size_t Drain(ShortcutEvent* out, size_t maxItems) {
+        drainPending_.store(false, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        size_t count = ring_.PopBatch(out, maxItems);
+        if (count > 0) {
+            Bump(delivered_, count);
+            Bump(batches_, 1);
+        }
+        return count;
+    }
+
+    // Only safe while no producer is running
+    void Reset() {
+        ring_.Reset();
+        drainPending_.store(false, std::memory_order_relaxed);
+    }
+
+    EventQueueStats Stats() const {
+        EventQueueStats stats;
+        stats.published = published_.load(std::memory_order_relaxed);
+        stats.dropped = dropped_.load(std::memory_order_relaxed);
+        stats.delivered = delivered_.load(std::memory_order_relaxed);
+        stats.batches = batches_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    // Each counter has a single writer, so a plain load/store avoids a locked RMW
+    static void Bump(std::atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    SpscRing<ShortcutEvent, kEventRingCapacity> ring_;
+    alignas(64) std::atomic<bool> drainPending_;
+    std::atomic<uint64_t> published_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<uint64_t> delivered_;
+    std::atomic<uint64_t> batches_;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Foreground application tracking for the shortcut module's keymap profiles
+// and the resource governor, which share one monitor (native_runtime.h).
+//
+// A monitor thread subscribes to the window system's focus notifications
+// (EVENT_SYSTEM_FOREGROUND on Windows, _NET_ACTIVE_WINDOW changes on X11)
+// and reports the owner of every newly focused window. It never polls: with
+// the focus unchanged the thread stays blocked.
+
+struct ForegroundApp {
+    uint32_t pid = 0;           // 0 if unknown
+    std::string process;        // executable file name ("Code.exe", "code"), empty if unknown
+    std::string windowClass;    // Win32 class name / X11 WM_CLASS class, empty if unknown
+};
+
+// Runs on the monitor thread
+typedef void (*ForegroundChangedFn)(const ForegroundApp& app, void* context);
+
+class ForegroundMonitor {
+public:
+    virtual ~ForegroundMonitor() {}
+
+    // Starts the monitor thread. The callback runs once for the window that
+    // is focused now, then on every change; false if nothing can be tracked.
+    virtual bool Start(ForegroundChangedFn callback, void* context) = 0;
+    // Blocks until the monitor thread has exited
+    virtual void Stop() = 0;
+    virtual bool IsRunning() const = 0;
+};
+
+// Implemented once per platform (foreground_monitor_win32.cc,
+// foreground_monitor_x11.cc, foreground_monitor_null.cc)
+ForegroundMonitor* CreateForegroundMonitor();
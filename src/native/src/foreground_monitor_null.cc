@@ -0,0 +1,19 @@
+#include "foreground_monitor.h"
+
+// Fallback for platforms without focus notifications: keymap profiles are
+// accepted, but only the default keymap is ever active.
+
+namespace {
+
+class NullForegroundMonitor : public ForegroundMonitor {
+public:
+    bool Start(ForegroundChangedFn, void*) override { return false; }
+    void Stop() override {}
+    bool IsRunning() const override { return false; }
+};
+
+} // namespace
+
+ForegroundMonitor* CreateForegroundMonitor() {
+    return new NullForegroundMonitor();
+}
@@ -0,0 +1,156 @@
+#include <windows.h>
+
+#include <thread>
+
+#include "foreground_monitor.h"
+
+// WinEvent based foreground monitor. The out-of-context EVENT_SYSTEM_FOREGROUND
+// hook is delivered through the message queue of the thread that installed
+// it, so the monitor thread sits in GetMessage until the focus changes. Our
+// own process is included: focusing the overlay selects its profile too.
+
+namespace {
+
+class Win32ForegroundMonitor;
+
+// WinEvent procs carry no context, so the running monitor is kept here
+Win32ForegroundMonitor* activeMonitor = nullptr;
+
+void CALLBACK ForegroundEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd, LONG idObject,
+                                  LONG idChild, DWORD eventThread, DWORD eventTime);
+
+std::string ToUtf8(const wchar_t* text, int length) {
+    std::string out;
+    int utf8Length = WideCharToMultiByte(CP_UTF8, 0, text, length, NULL, 0, NULL, NULL);
+    if (utf8Length > 0) {
+        out.resize(utf8Length);
+        WideCharToMultiByte(CP_UTF8, 0, text, length, &out[0], utf8Length, NULL, NULL);
+    }
+    return out;
+}
+
+// Executable file name of a process, e.g. "Code.exe"
+std::string ProcessImageName(DWORD pid) {
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (!process) return std::string();
+    wchar_t path[MAX_PATH];
+    DWORD length = MAX_PATH;
+    std::string name;
+    if (QueryFullProcessImageNameW(process, 0, path, &length)) {
+        const wchar_t* base = path;
+        for (DWORD i = 0; i < length; i++) {
+            if (path[i] == L'\\' || path[i] == L'/') base = path + i + 1;
+        }
+        name = ToUtf8(base, static_cast<int>(path + length - base));
+    }
+    CloseHandle(process);
+    return name;
+}
+
+class Win32ForegroundMonitor : public ForegroundMonitor {
+public:
+    Win32ForegroundMonitor()
+        : callback_(nullptr), context_(nullptr), threadId_(0), hook_(NULL), lastPid_(0), running_(false) {}
+
+    ~Win32ForegroundMonitor() override { Stop(); }
+
+    bool Start(ForegroundChangedFn callback, void* context) override {
+        Stop();
+        callback_ = callback;
+        context_ = context;
+        activeMonitor = this;
+
+        HANDLE readyEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+        monitorThread_ = std::thread([this, readyEvent]() {
+            threadId_ = GetCurrentThreadId();
+
+            // Message queue first, so an early WM_QUIT from Stop() is not lost
+            MSG msg;
+            PeekMessage(&msg, NULL, WM_USER, WM_USER, PM_NOREMOVE);
+
+            hook_ = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND,
+                                    NULL, ForegroundEventProc, 0, 0, WINEVENT_OUTOFCONTEXT);
+            running_ = hook_ != NULL;
+            SetEvent(readyEvent);
+            if (!hook_) {
+                return;
+            }
+
+            Report(GetForegroundWindow());
+            while (GetMessage(&msg, NULL, 0, 0) > 0) {
+                TranslateMessage(&msg);
+                DispatchMessage(&msg);
+            }
+
+            UnhookWinEvent(hook_);
+            hook_ = NULL;
+        });
+
+        WaitForSingleObject(readyEvent, INFINITE);
+        CloseHandle(readyEvent);
+        if (!running_) {
+            Stop();
+            return false;
+        }
+        return true;
+    }
+
+    void Stop() override {
+        if (monitorThread_.joinable()) {
+            PostThreadMessage(threadId_, WM_QUIT, 0, 0);
+            monitorThread_.join();
+        }
+        threadId_ = 0;
+        running_ = false;
+        if (activeMonitor == this) {
+            activeMonitor = nullptr;
+        }
+    }
+
+    bool IsRunning() const override { return running_; }
+
+    // Monitor thread
+    void Report(HWND hwnd) {
+        if (!hwnd) return;
+        ForegroundApp app;
+        DWORD pid = 0;
+        GetWindowThreadProcessId(hwnd, &pid);
+        app.pid = pid;
+
+        wchar_t className[256];
+        int classLength = GetClassNameW(hwnd, className, 256);
+        if (classLength > 0) {
+            app.windowClass = ToUtf8(className, classLength);
+        }
+        // Focus moving between windows of one process keeps the image name
+        if (pid != lastPid_) {
+            lastPid_ = pid;
+            lastProcess_ = ProcessImageName(pid);
+        }
+        app.process = lastProcess_;
+        callback_(app, context_);
+    }
+
+private:
+    ForegroundChangedFn callback_;
+    void* context_;
+    DWORD threadId_;
+    HWINEVENTHOOK hook_;
+    DWORD lastPid_;            // monitor thread only
+    std::string lastProcess_;
+    std::thread monitorThread_;
+    volatile bool running_;
+};
+
+void CALLBACK ForegroundEventProc(HWINEVENTHOOK, DWORD, HWND hwnd, LONG idObject,
+                                  LONG idChild, DWORD, DWORD) {
+    if (activeMonitor && hwnd && idObject == OBJID_WINDOW && idChild == CHILDID_SELF) {
+        activeMonitor->Report(hwnd);
+    }
+}
+
+} // namespace
+
+ForegroundMonitor* CreateForegroundMonitor() {
+    return new Win32ForegroundMonitor();
+}
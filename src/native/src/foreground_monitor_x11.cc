@@ -0,0 +1,188 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <thread>
+
+#include "foreground_monitor.h"
+#include "x11_connection.h"
+
+// X11 foreground monitor. It runs on its own XCB connection with only
+// PropertyChange selected on the root window, and blocks in poll() on the
+// connection fd plus an eventfd used to stop it. A _NET_ACTIVE_WINDOW change
+// costs three pipelined requests: the property itself, then WM_CLASS and
+// _NET_WM_PID of the new window.
+
+namespace {
+
+// argv[0] base name, like ProcessControl::ProcessName(); Wine games keep
+// their Windows path there ("C:\...\YuanShen.exe")
+std::string ProcessImageName(uint32_t pid) {
+    std::string path = "/proc/" + std::to_string(pid) + "/cmdline";
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return std::string();
+    char buffer[4096];
+    ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (length <= 0) return std::string();
+    buffer[length] = '\0';
+    std::string argv0(buffer);
+    size_t slash = argv0.find_last_of("/\\");
+    return slash == std::string::npos ? argv0 : argv0.substr(slash + 1);
+}
+
+class X11ForegroundMonitor : public ForegroundMonitor {
+public:
+    X11ForegroundMonitor()
+        : callback_(nullptr), context_(nullptr), stopFd_(-1), active_(XCB_NONE), running_(false) {}
+
+    ~X11ForegroundMonitor() override { Stop(); }
+
+    bool Start(ForegroundChangedFn callback, void* context) override {
+        Stop();
+        callback_ = callback;
+        context_ = context;
+        if (!connection_.Open() || connection_.Atoms().netActiveWindow == XCB_ATOM_NONE) {
+            Stop();
+            return false;
+        }
+        stopFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (stopFd_ < 0) {
+            Stop();
+            return false;
+        }
+
+        const uint32_t rootMask = XCB_EVENT_MASK_PROPERTY_CHANGE;
+        xcb_change_window_attributes(connection_.Get(), connection_.Root(), XCB_CW_EVENT_MASK, &rootMask);
+        xcb_flush(connection_.Get());
+
+        active_ = XCB_NONE;
+        running_ = true;
+        monitorThread_ = std::thread(&X11ForegroundMonitor::MonitorLoop, this);
+        return true;
+    }
+
+    void Stop() override {
+        if (monitorThread_.joinable()) {
+            uint64_t one = 1;
+            ssize_t ignored = write(stopFd_, &one, sizeof(one));
+            (void)ignored;
+            monitorThread_.join();
+        }
+        if (stopFd_ >= 0) {
+            close(stopFd_);
+            stopFd_ = -1;
+        }
+        connection_.Close();
+        running_ = false;
+    }
+
+    bool IsRunning() const override { return running_; }
+
+private:
+    // Reports the active window if it changed
+    void CheckActiveWindow() {
+        xcb_connection_t* c = connection_.Get();
+        const X11Atoms& atoms = connection_.Atoms();
+        xcb_get_property_reply_t* reply = xcb_get_property_reply(c,
+            xcb_get_property(c, 0, connection_.Root(), atoms.netActiveWindow, XCB_ATOM_WINDOW, 0, 1), nullptr);
+        xcb_window_t window = XCB_NONE;
+        if (reply && reply->format == 32 && xcb_get_property_value_length(reply) >= 4) {
+            window = *static_cast<xcb_window_t*>(xcb_get_property_value(reply));
+        }
+        free(reply);
+        if (window == active_) return;
+        active_ = window;
+
+        ForegroundApp app;
+        if (window != XCB_NONE) {
+            xcb_get_property_cookie_t classCookie = xcb_get_property(c, 0, window, XCB_ATOM_WM_CLASS,
+                                                                     XCB_ATOM_STRING, 0, 256);
+            xcb_get_property_cookie_t pidCookie = xcb_get_property(c, 0, window, atoms.netWmPid,
+                                                                   XCB_ATOM_CARDINAL, 0, 1);
+            // WM_CLASS is "instance\0class\0"; profiles match the class
+            xcb_get_property_reply_t* wmClass = xcb_get_property_reply(c, classCookie, nullptr);
+            if (wmClass && wmClass->format == 8) {
+                const char* value = static_cast<const char*>(xcb_get_property_value(wmClass));
+                int length = xcb_get_property_value_length(wmClass);
+                std::string both(value, static_cast<size_t>(length));
+                size_t split = both.find('\0');
+                if (split != std::string::npos) {
+                    app.windowClass = both.substr(split + 1);
+                    size_t end = app.windowClass.find('\0');
+                    if (end != std::string::npos) app.windowClass.resize(end);
+                }
+            }
+            free(wmClass);
+            xcb_get_property_reply_t* pid = xcb_get_property_reply(c, pidCookie, nullptr);
+            if (pid && pid->format == 32 && xcb_get_property_value_length(pid) >= 4) {
+                app.pid = *static_cast<uint32_t*>(xcb_get_property_value(pid));
+            }
+            free(pid);
+        }
+        if (app.pid != 0) {
+            app.process = ProcessImageName(app.pid);
+        }
+        callback_(app, context_);
+    }
+
+    void MonitorLoop() {
+        xcb_connection_t* c = connection_.Get();
+        const xcb_atom_t netActiveWindow = connection_.Atoms().netActiveWindow;
+        pollfd fds[2];
+        fds[0].fd = xcb_get_file_descriptor(c);
+        fds[0].events = POLLIN;
+        fds[1].fd = stopFd_;
+        fds[1].events = POLLIN;
+
+        // The window focused at start is reported before any event arrives
+        bool needCheck = true;
+        while (true) {
+            xcb_generic_event_t* event;
+            while ((event = xcb_poll_for_event(c)) != nullptr) {
+                if ((event->response_type & ~0x80) == XCB_PROPERTY_NOTIFY) {
+                    const xcb_property_notify_event_t* e = reinterpret_cast<const xcb_property_notify_event_t*>(event);
+                    if (e->window == connection_.Root() && e->atom == netActiveWindow) needCheck = true;
+                }
+                free(event);
+            }
+            if (xcb_connection_has_error(c)) {
+                break;
+            }
+            if (needCheck) {
+                needCheck = false;
+                CheckActiveWindow();
+                // Replies may have pulled more events into XCB's queue
+                continue;
+            }
+
+            fds[0].revents = 0;
+            fds[1].revents = 0;
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (fds[1].revents) {
+                break;
+            }
+        }
+
+        running_ = false;
+    }
+
+    ForegroundChangedFn callback_;
+    void* context_;
+    X11Connection connection_;
+    int stopFd_;
+    xcb_window_t active_;     // monitor thread only
+    std::thread monitorThread_;
+    volatile bool running_;
+};
+
+} // namespace
+
+ForegroundMonitor* CreateForegroundMonitor() {
+    return new X11ForegroundMonitor();
+}
@@ -0,0 +1,181 @@
+#include <napi.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "native_runtime.h"
+#include "process_control.h"
+#include "resource_governor.h"
+
+// N-API glue for the resource governor, the `governor` sub-module of the
+// native runtime (native_runtime.h). State tracking lives in
+// resource_governor.cc and the priority / affinity changes in the
+// process_control_* files; this file only converts arguments and results.
+
+namespace {
+
+// State of one environment's governor sub-module. The processes it manages
+// belong to the whole app, so only one environment runs a governor at a time.
+struct GovernorModule : public RuntimeModule {
+    std::unique_ptr<ProcessControl> processControl;
+    ResourceGovernor governor;
+    bool followsForeground = false;   // fed by the shared foreground monitor
+
+    ~GovernorModule() override { Shutdown(); }
+    void Shutdown() override {
+        if (followsForeground) {
+            UnsubscribeForeground(ResourceGovernor::OnForegroundChanged, &governor);
+            followsForeground = false;
+        }
+        governor.Stop();
+        ReleaseProcessResource(kResourceGovernor, this);
+    }
+};
+
+GovernorModule& State(const Napi::CallbackInfo& info) {
+    return *static_cast<GovernorModule*>(info.Data());
+}
+
+// Args: options { periodMs, efficiency, restrictAffinity, games: [name, ...] }
+// Returns false if a governor already runs in another environment
+Napi::Value StartGovernor(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    GovernorModule& state = State(info);
+    GovernorConfig config;
+
+    if (info.Length() > 0 && info[0].IsObject()) {
+        Napi::Object options = info[0].As<Napi::Object>();
+        Napi::Value periodMs = options.Get("periodMs");
+        if (periodMs.IsNumber()) {
+            config.periodMs = periodMs.As<Napi::Number>().Uint32Value();
+        }
+        Napi::Value efficiency = options.Get("efficiency");
+        if (efficiency.IsBoolean()) {
+            config.efficiency = efficiency.As<Napi::Boolean>().Value();
+        }
+        Napi::Value restrictAffinity = options.Get("restrictAffinity");
+        if (restrictAffinity.IsBoolean()) {
+            config.restrictAffinity = restrictAffinity.As<Napi::Boolean>().Value();
+        }
+        Napi::Value games = options.Get("games");
+        if (games.IsArray()) {
+            Napi::Array list = games.As<Napi::Array>();
+            for (uint32_t i = 0; i < list.Length(); i++) {
+                Napi::Value name = list.Get(i);
+                if (name.IsString()) config.games.push_back(name.As<Napi::String>().Utf8Value());
+            }
+        }
+    }
+
+    if (!ClaimProcessResource(kResourceGovernor, &state)) {
+        return Napi::Boolean::New(env, false);
+    }
+    if (!state.processControl) {
+        state.processControl.reset(CreateProcessControl());
+    }
+    // Focus changes drive the governor where they can be tracked; it only
+    // polls the foreground window where they cannot
+    if (!state.followsForeground) {
+        state.followsForeground = SubscribeForeground(ResourceGovernor::OnForegroundChanged, &state.governor);
+    }
+    config.foregroundEvents = state.followsForeground;
+    state.governor.Start(state.processControl.get(), config);
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value StopGovernor(const Napi::CallbackInfo& info) {
+    State(info).Shutdown();
+    return info.Env().Undefined();
+}
+
+// Args: array of pids (the app's main, renderer and GPU processes)
+Napi::Value SetGovernorProcesses(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    GovernorModule& state = State(info);
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Array of process ids required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Array list = info[0].As<Napi::Array>();
+    std::vector<uint32_t> pids;
+    pids.reserve(list.Length());
+    for (uint32_t i = 0; i < list.Length(); i++) {
+        Napi::Value pid = list.Get(i);
+        if (pid.IsNumber()) pids.push_back(pid.As<Napi::Number>().Uint32Value());
+    }
+    state.governor.SetProcesses(pids);
+    return env.Undefined();
+}
+
+// Args: whether the overlay window is shown (visible and not minimized)
+Napi::Value SetOverlayVisible(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    GovernorModule& state = State(info);
+    if (info.Length() < 1 || !info[0].IsBoolean()) {
+        Napi::TypeError::New(env, "Visibility boolean required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    state.governor.SetOverlayVisible(info[0].As<Napi::Boolean>().Value());
+    return env.Undefined();
+}
+
+// Current state, time per state in ms and restore latency in microseconds
+Napi::Value GetGovernorStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    GovernorModule& state = State(info);
+    GovernorStats stats = state.governor.Stats();
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("running", Napi::Boolean::New(env, state.governor.Running()));
+    result.Set("state", Napi::String::New(env, GovernorStateName(stats.state)));
+    result.Set("foregroundPid", Napi::Number::New(env, stats.foregroundPid));
+    result.Set("transitions", Napi::Number::New(env, static_cast<double>(stats.transitions)));
+    result.Set("steps", Napi::Number::New(env, static_cast<double>(stats.steps)));
+    result.Set("applies", Napi::Number::New(env, static_cast<double>(stats.applies)));
+    result.Set("applyFailures", Napi::Number::New(env, static_cast<double>(stats.applyFailures)));
+    result.Set("overlayCpus", Napi::Number::New(env, static_cast<double>(stats.overlayCpus)));
+
+    Napi::Object timeInState = Napi::Object::New(env);
+    for (int state = 0; state < kGovernorStateCount; state++) {
+        timeInState.Set(GovernorStateName(state), Napi::Number::New(env, stats.stateNs[state] / 1e6));
+    }
+    result.Set("timeInState", timeInState);
+
+    Napi::Object applied = Napi::Object::New(env);
+    applied.Set("priority", Napi::Boolean::New(env, stats.caps.priority));
+    applied.Set("efficiency", Napi::Boolean::New(env, stats.caps.efficiency));
+    applied.Set("affinity", Napi::Boolean::New(env, stats.caps.affinity));
+    applied.Set("cgroup", Napi::Boolean::New(env, stats.caps.cgroup));
+    result.Set("applied", applied);
+
+    Napi::Object restore = Napi::Object::New(env);
+    restore.Set("count", Napi::Number::New(env, static_cast<double>(stats.restore.count)));
+    restore.Set("min", Napi::Number::New(env, stats.restore.min / 1000.0));
+    restore.Set("max", Napi::Number::New(env, stats.restore.max / 1000.0));
+    restore.Set("mean", Napi::Number::New(env, stats.restore.mean / 1000.0));
+    restore.Set("p50", Napi::Number::New(env, stats.restore.p50 / 1000.0));
+    restore.Set("p99", Napi::Number::New(env, stats.restore.p99 / 1000.0));
+    result.Set("restore", restore);
+
+    return result;
+}
+
+Napi::Value ResetGovernorStats(const Napi::CallbackInfo& info) {
+    State(info).governor.ResetStats();
+    return info.Env().Undefined();
+}
+
+} // namespace
+
+RuntimeModule* CreateGovernorModule(Napi::Env env, Napi::Object exports) {
+    GovernorModule* state = new GovernorModule();
+    exports.Set("startGovernor", Napi::Function::New(env, StartGovernor, "startGovernor", state));
+    exports.Set("stopGovernor", Napi::Function::New(env, StopGovernor, "stopGovernor", state));
+    exports.Set("setGovernorProcesses", Napi::Function::New(env, SetGovernorProcesses, "setGovernorProcesses", state));
+    exports.Set("setOverlayVisible", Napi::Function::New(env, SetOverlayVisible, "setOverlayVisible", state));
+    exports.Set("getGovernorStats", Napi::Function::New(env, GetGovernorStats, "getGovernorStats", state));
+    exports.Set("resetGovernorStats", Napi::Function::New(env, ResetGovernorStats, "resetGovernorStats", state));
+    return state;
+}
@@ -1,311 +1,365 @@
 #include <napi.h>
-#include <windows.h>
-#include <thread>
-#include <map>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
 #include <vector>
-#include <algorithm>
-#include <cctype>
-#include <sstream>
-
-// Global state variables
-std::thread hotkeyThread;
-std::thread mouseHookThread;
-DWORD hotkeyThreadId = 0;
-bool isRunning = false;
-bool mouseHookRunning = false;
-bool keyboardHookRunning = false;
-Napi::ThreadSafeFunction tsfn;
-std::map<int, std::string> idToActionMap;
-std::map<std::pair<UINT, UINT>, std::string> mouseKeyMap; // (modifiers, mouseButton) -> action
-std::map<std::pair<UINT, UINT>, std::string> keyboardHookMap; // (modifiers, vkCode) -> action
-HHOOK mouseHook = NULL;
-HHOOK keyboardHook = NULL;
-
-// Track modifier key states
-bool isShiftPressed = false;
-bool isCtrlPressed = false;
-bool isAltPressed = false;
-bool isWinPressed = false;
-
-// GAME-COMPATIBLE KEYBOARD HOOK - BASED ON CSDN RESEARCH!
-LRESULT CALLBACK KeyboardHookProc(int nCode, WPARAM wParam, LPARAM lParam) {
-    // CRITICAL: Always process HC_ACTION, ignore nCode < 0 (as per CSDN article)
-    if (nCode == HC_ACTION && keyboardHookRunning) {
-        KBDLLHOOKSTRUCT* pKeyboard = (KBDLLHOOKSTRUCT*)lParam;
-        DWORD vkCode = pKeyboard->vkCode;
-        bool isKeyDown = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
-        bool isKeyUp = (wParam == WM_KEYUP || wParam == WM_SYSKEYUP);
-        
-        // GAME COMPATIBILITY: Ignore injected events to prevent infinite loops
-        if (pKeyboard->flags & LLKHF_INJECTED) {
-            return CallNextHookEx(keyboardHook, nCode, wParam, lParam);
-        }
-        
-        // Track modifier key states with ULTRA precision
-        if (isKeyDown || isKeyUp) {
-            bool pressed = isKeyDown;
-            switch (vkCode) {
-                case VK_LSHIFT:
-                case VK_RSHIFT:
-                    isShiftPressed = pressed;
-                    break;
-                case VK_LCONTROL:
-                case VK_RCONTROL:
-                    isCtrlPressed = pressed;
-                    break;
-                case VK_LMENU:
-                case VK_RMENU:
-                    isAltPressed = pressed;
-                    break;
-                case VK_LWIN:
-                case VK_RWIN:
-                    isWinPressed = pressed;
-                    break;
-            }
-        }
-        
-        // GAME MODE: Only process key down events for shortcuts
-        if (isKeyDown) {
-            // Build current modifier mask with HIGH precision
-            UINT modifiers = 0;
-            if (isShiftPressed) modifiers |= MOD_SHIFT;
-            if (isCtrlPressed) modifiers |= MOD_CONTROL;
-            if (isAltPressed) modifiers |= MOD_ALT;
-            if (isWinPressed) modifiers |= MOD_WIN;
-            
-            // Check if this key combination is registered
-            auto key = std::make_pair(modifiers, vkCode);
-            auto it = keyboardHookMap.find(key);
-            if (it != keyboardHookMap.end()) {
-                std::string action = it->second;
-                
-                // ULTRA-FAST callback execution for games
-                if (tsfn) {
-                    tsfn.NonBlockingCall([action](Napi::Env env, Napi::Function jsCallback) {
-                        jsCallback.Call({Napi::String::New(env, action)});
-                    });
-                }
-                
-                // GAME COMPATIBILITY: Always consume registered shortcuts
-                // This prevents games from receiving our hotkeys
-                return 1;
-            }
-        }
+
+#include "shortcut_core.h"
+#include "input_backend.h"
+#include "foreground_monitor.h"
+#include "input_watchdog.h"
+#include "keymap_compiler.h"
+#include "keymap_profiles.h"
+#include "native_runtime.h"
+#include "trace_events.h"
+#include "trace_replay.h"
+
+// N-API glue for the shortcut engine, the `shortcut` sub-module of the native
+// runtime (native_runtime.h). Parsing, matching and dispatch live in
+// shortcut_core.cc; the platform input source lives behind InputBackend.
+
+namespace {
+
+struct ShortcutModule;
+
+// Matched events go through a fixed SPSC ring; the TSFN only carries the
+// wakeup, so at most one call is queued and the input thread never allocates
+void CallJsDrain(Napi::Env env, Napi::Function jsCallback, ShortcutModule* context, void* data);
+typedef Napi::TypedThreadSafeFunction<ShortcutModule, void, CallJsDrain> DrainTsfn;
+
+void StopHotkeyListener(ShortcutModule& state);
+
+// State of one environment's shortcut sub-module
+struct ShortcutModule : public RuntimeModule {
+    ShortcutEngine engine;
+    std::unique_ptr<InputBackend> backend;
+    InputWatchdog watchdog;     // checks the backend and the JS consumer while running
+    DrainTsfn tsfn;
+    CompiledKeymap lastKeymap;  // result of the last start() / update() compile
+    KeymapProfileSwitcher profileSwitcher;
+    bool followsForeground = false;                        // subscribed only while profiles are bound
+    std::vector<KeymapProfileRule> pendingProfileRules;    // for the pending table
+
+    ~ShortcutModule() override { Shutdown(); }
+    void Shutdown() override { StopHotkeyListener(*this); }
+};
+
+ShortcutModule& State(const Napi::CallbackInfo& info) {
+    return *static_cast<ShortcutModule*>(info.Data());
+}
+
+// Runs on the JS thread: hand everything queued so far to JS in one call
+void CallJsDrain(Napi::Env env, Napi::Function jsCallback, ShortcutModule* context, void* data) {
+    if (env == nullptr || jsCallback == nullptr) {
+        return;
+    }
+    ShortcutModule& state = *context;
+
+    // Tables replaced by update() are freed here once the input thread is done with them
+    state.engine.ReclaimTables();
+
+    TraceSpan span("shortcut", "tsfnDispatch");
+    ShortcutEvent batch[kEventRingCapacity];
+    uint64_t jsEntry = SteadyNowNs();
+    size_t count = state.engine.DrainBatch(batch, kEventRingCapacity, jsEntry);
+    span.SetArg("events", static_cast<int64_t>(count));
+    if (count == 0) {
+        return;
+    }
+
+    Napi::ArrayBuffer buffer = Napi::ArrayBuffer::New(env, count * sizeof(ShortcutEvent));
+    memcpy(buffer.Data(), batch, count * sizeof(ShortcutEvent));
+    jsCallback.Call({
+        buffer,
+        Napi::Number::New(env, static_cast<double>(count)),
+        Napi::Number::New(env, static_cast<double>(jsEntry))
+    });
+}
+
+// Input thread: wake the JS thread for a drain
+bool RequestDrain(void* context) {
+    TraceEventInstant("shortcut", "drainRequest");
+    ShortcutModule& state = *static_cast<ShortcutModule*>(context);
+    return state.tsfn && state.tsfn.NonBlockingCall() == napi_ok;
+}
+
+// Stop hotkey listener
+void StopHotkeyListener(ShortcutModule& state) {
+    // First: it calls into the backend and re-sends drains through the TSFN
+    state.watchdog.Stop();
+    if (state.followsForeground) {
+        UnsubscribeForeground(KeymapProfileSwitcher::OnForegroundChanged, &state.profileSwitcher);
+        state.followsForeground = false;
+    }
+    if (state.backend) {
+        state.backend->Stop();
     }
+    // The hold timer thread also requests drains
+    state.engine.StopTimers();
     
-    // CRITICAL: Always call next hook for system stability
-    return CallNextHookEx(keyboardHook, nCode, wParam, lParam);
+    // Clean up resources
+    if (state.tsfn) {
+        state.tsfn.Release();
+        state.tsfn = nullptr;
+    }
+    
+    state.engine.Clear();
+    ReleaseProcessResource(kResourceInputListener, &state);
 }
 
-// Mouse hook procedure
-LRESULT CALLBACK MouseHookProc(int nCode, WPARAM wParam, LPARAM lParam) {
-    if (nCode >= 0 && mouseHookRunning) {
-        UINT mouseButton = 0;
-        if (wParam == WM_XBUTTONDOWN) {
-            MSLLHOOKSTRUCT* pMouseStruct = (MSLLHOOKSTRUCT*)lParam;
-            WORD xButton = HIWORD(pMouseStruct->mouseData);
-            if (xButton == XBUTTON1) mouseButton = 1; // Mouse side button 1
-            else if (xButton == XBUTTON2) mouseButton = 2; // Mouse side button 2
-            
-            // Get current modifier key states from our tracking
-            UINT modifiers = 0;
-            if (isShiftPressed) modifiers |= MOD_SHIFT;
-            if (isCtrlPressed) modifiers |= MOD_CONTROL;
-            if (isAltPressed) modifiers |= MOD_ALT;
-            if (isWinPressed) modifiers |= MOD_WIN;
-            
-            auto key = std::make_pair(modifiers, mouseButton);
-            auto it = mouseKeyMap.find(key);
-            if (it != mouseKeyMap.end()) {
-                std::string action = it->second;
-                if (tsfn) {
-                    tsfn.NonBlockingCall([action](Napi::Env env, Napi::Function jsCallback) {
-                        jsCallback.Call({Napi::String::New(env, action)});
-                    });
-                }
-                return 1; // Consume this event
+InputBackendOptions ParseBackendOptions(const Napi::CallbackInfo& info, size_t index) {
+    InputBackendOptions options;
+    if (info.Length() > index && info[index].IsObject()) {
+        Napi::Object opts = info[index].As<Napi::Object>();
+        Napi::Value grab = opts.Get("grab");
+        options.grab = grab.IsBoolean() && grab.As<Napi::Boolean>().Value();
+        Napi::Value mouseHook = opts.Get("mouseHook");
+        options.mouseHook = !mouseHook.IsBoolean() || mouseHook.As<Napi::Boolean>().Value();
+    }
+    return options;
+}
+
+// Reads a { action: "Ctrl+K" } object in property order. A value may also
+// be { keys: "Ctrl+K, P", timeout: ms } for sequences.
+std::vector<KeymapBinding> ReadKeymap(const Napi::Object& shortcuts) {
+    std::vector<KeymapBinding> keymap;
+    Napi::Array shortcutNames = shortcuts.GetPropertyNames();
+    for (uint32_t i = 0; i < shortcutNames.Length(); i++) {
+        Napi::Value key = shortcutNames.Get(i);
+        std::string actionName = key.As<Napi::String>().Utf8Value();
+        Napi::Value value = shortcuts.Get(key);
+        uint32_t timeoutMs = kDefaultSequenceTimeoutMs;
+        if (value.IsObject()) {
+            Napi::Object binding = value.As<Napi::Object>();
+            Napi::Value timeout = binding.Get("timeout");
+            if (timeout.IsNumber() && timeout.As<Napi::Number>().Int64Value() > 0) {
+                timeoutMs = timeout.As<Napi::Number>().Uint32Value();
             }
+            value = binding.Get("keys");
         }
+        if (!value.IsString()) continue;
+        keymap.push_back({actionName, value.As<Napi::String>().Utf8Value(), timeoutMs});
     }
-    return CallNextHookEx(mouseHook, nCode, wParam, lParam);
+    return keymap;
 }
 
-// Stop hotkey listener
-void StopHotkeyListener() {
-    // Stop keyboard hook - THE ULTIMATE STOPPER!
-    if (keyboardHook) {
-        UnhookWindowsHookEx(keyboardHook);
-        keyboardHook = NULL;
-        keyboardHookRunning = false;
+// Reads a profile's process / windowClass: a string or an array of strings
+std::vector<std::string> ReadNameList(const Napi::Value& value) {
+    std::vector<std::string> names;
+    if (value.IsString()) {
+        names.push_back(value.As<Napi::String>().Utf8Value());
+    } else if (value.IsArray()) {
+        Napi::Array list = value.As<Napi::Array>();
+        for (uint32_t i = 0; i < list.Length(); i++) {
+            Napi::Value name = list.Get(i);
+            if (name.IsString()) names.push_back(name.As<Napi::String>().Utf8Value());
+        }
     }
-    
-    // Stop mouse hook
-    if (mouseHook) {
-        UnhookWindowsHookEx(mouseHook);
-        mouseHook = NULL;
-        mouseHookRunning = false;
+    return names;
+}
+
+// A profile's keymap: the default keymap with the profile's entries laid
+// over it (inherit: false starts empty). A string replaces the action's keys,
+// null or false unbinds the action in this profile, new actions are appended.
+std::vector<KeymapBinding> ReadProfileKeymap(const std::vector<KeymapBinding>& defaults,
+                                             const Napi::Object& profile) {
+    Napi::Value value = profile.Get("shortcuts");
+    Napi::Object shortcuts = value.IsObject() ? value.As<Napi::Object>() : Napi::Object::New(profile.Env());
+    std::vector<KeymapBinding> overrides = ReadKeymap(shortcuts);
+    Napi::Value inherit = profile.Get("inherit");
+
+    std::vector<KeymapBinding> keymap;
+    if (!inherit.IsBoolean() || inherit.As<Napi::Boolean>().Value()) {
+        for (const KeymapBinding& binding : defaults) {
+            if (!shortcuts.Has(binding.action)) keymap.push_back(binding);
+        }
     }
-    
-    // Stop legacy hotkey listening (kept as backup)
-    if (isRunning && hotkeyThreadId != 0) {
-        PostThreadMessage(hotkeyThreadId, WM_QUIT, 0, 0);
-        if (hotkeyThread.joinable()) {
-            hotkeyThread.join();
+    keymap.insert(keymap.end(), overrides.begin(), overrides.end());
+    return keymap;
+}
+
+// Fills the engine's pending table with the conflict-free part of the keymap
+// and of every profile in options.profiles = { name: { process, windowClass,
+// shortcuts, inherit } }; what was left out stays in lastKeymap for
+// getKeymapReport(). The profile rules wait in pendingProfileRules for the publish.
+void CompileBindings(ShortcutModule& state, const Napi::Object& shortcuts, const Napi::CallbackInfo& info, size_t index) {
+    std::vector<KeymapBinding> defaults = ReadKeymap(shortcuts);
+    CompileKeymap(defaults, &state.lastKeymap);
+    ApplyKeymap(state.lastKeymap, &state.engine);
+
+    state.pendingProfileRules.clear();
+    if (info.Length() <= index || !info[index].IsObject()) return;
+    Napi::Value profiles = info[index].As<Napi::Object>().Get("profiles");
+    if (!profiles.IsObject()) return;
+
+    Napi::Object profileMap = profiles.As<Napi::Object>();
+    Napi::Array profileNames = profileMap.GetPropertyNames();
+    for (uint32_t i = 0; i < profileNames.Length(); i++) {
+        Napi::Value key = profileNames.Get(i);
+        Napi::Value value = profileMap.Get(key);
+        if (!value.IsObject()) continue;
+        std::string name = key.As<Napi::String>().Utf8Value();
+        Napi::Object profile = value.As<Napi::Object>();
+
+        KeymapProfileRule rule;
+        rule.processes = ReadNameList(profile.Get("process"));
+        rule.windowClasses = ReadNameList(profile.Get("windowClass"));
+        rule.profile = state.engine.AddProfile(name);
+        if (rule.profile == kNoProfile) {
+            state.lastKeymap.issues.push_back({kKeymapInvalid, std::string(), std::string(), std::string(),
+                                         "too many keymap profiles", name});
+            continue;
+        }
+
+        CompiledKeymap keymap;
+        CompileKeymap(ReadProfileKeymap(defaults, profile), &keymap);
+        ApplyKeymap(keymap, &state.engine, rule.profile);
+        for (KeymapIssue& issue : keymap.issues) {
+            issue.profile = name;
+            state.lastKeymap.issues.push_back(issue);
+        }
+        if (!rule.processes.empty() || !rule.windowClasses.empty()) {
+            state.pendingProfileRules.push_back(rule);
         }
-        hotkeyThreadId = 0;
-        isRunning = false;
     }
-    
-    // Reset modifier key states
-    isShiftPressed = false;
-    isCtrlPressed = false;
-    isAltPressed = false;
-    isWinPressed = false;
-    
-    // Clean up resources
-    if (tsfn) {
-        tsfn.Release();
-        tsfn = nullptr;
+}
+
+// After PublishBindings(): hands the profile rules to the switcher and
+// follows the foreground window only while some profile can be selected
+void PublishProfileRules(ShortcutModule& state) {
+    state.profileSwitcher.SetRules(&state.engine, state.engine.Table().Generation(), state.pendingProfileRules);
+    if (state.pendingProfileRules.empty()) {
+        if (state.followsForeground) {
+            UnsubscribeForeground(KeymapProfileSwitcher::OnForegroundChanged, &state.profileSwitcher);
+            state.followsForeground = false;
+        }
+        return;
+    }
+    if (!state.followsForeground) {
+        state.followsForeground =
+            SubscribeForeground(KeymapProfileSwitcher::OnForegroundChanged, &state.profileSwitcher);
     }
-    
-    mouseKeyMap.clear();
-    keyboardHookMap.clear();
 }
 
-// Enhanced function to convert string to virtual key code and modifiers
-bool StringToVk(const std::string& keyString, UINT& vkCode, UINT& modifiers, UINT& mouseButton) {
-    vkCode = 0;
-    modifiers = 0;
-    mouseButton = 0;
-    
-    // Split key string
-    std::vector<std::string> parts;
-    std::stringstream ss(keyString);
-    std::string part;
-    while (std::getline(ss, part, '+')) {
-        // Remove spaces
-        part.erase(std::remove_if(part.begin(), part.end(), ::isspace), part.end());
-        if (!part.empty()) {
-            parts.push_back(part);
+// { bindings: [{ action, keys }], issues: [{ type, action, keys, other, message }] }
+// with keys in canonical spelling
+Napi::Object KeymapReport(Napi::Env env, const CompiledKeymap& keymap) {
+    Napi::Array bindings = Napi::Array::New(env, keymap.bindings.size());
+    for (size_t i = 0; i < keymap.bindings.size(); i++) {
+        Napi::Object binding = Napi::Object::New(env);
+        binding.Set("action", Napi::String::New(env, keymap.bindings[i].action));
+        binding.Set("keys", Napi::String::New(env, keymap.bindings[i].canonical));
+        bindings.Set(static_cast<uint32_t>(i), binding);
+    }
+
+    Napi::Array issues = Napi::Array::New(env, keymap.issues.size());
+    for (size_t i = 0; i < keymap.issues.size(); i++) {
+        const KeymapIssue& issue = keymap.issues[i];
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("type", Napi::String::New(env, KeymapIssueKindName(issue.kind)));
+        entry.Set("action", Napi::String::New(env, issue.action));
+        entry.Set("keys", Napi::String::New(env, issue.keys));
+        if (!issue.other.empty()) {
+            entry.Set("other", Napi::String::New(env, issue.other));
+        }
+        if (!issue.profile.empty()) {
+            entry.Set("profile", Napi::String::New(env, issue.profile));
         }
+        entry.Set("message", Napi::String::New(env, issue.message));
+        issues.Set(static_cast<uint32_t>(i), entry);
     }
-    
-    if (parts.empty()) return false;
-
-    // Process modifier keys
-    for (size_t i = 0; i < parts.size() - 1; ++i) {
-        std::string modifier = parts[i];
-        std::transform(modifier.begin(), modifier.end(), modifier.begin(), ::toupper);
-        
-        if (modifier == "SHIFT") modifiers |= MOD_SHIFT;
-        else if (modifier == "CONTROL" || modifier == "CTRL") modifiers |= MOD_CONTROL;
-        else if (modifier == "ALT") modifiers |= MOD_ALT;
-        else if (modifier == "WIN" || modifier == "WINDOWS" || modifier == "CMD") modifiers |= MOD_WIN;
-    }
-
-    // Process the main key
-    std::string key = parts.back();
-    std::transform(key.begin(), key.end(), key.begin(), ::toupper);
-
-    // Check if it's a mouse side button
-    if (key == "XBUTTON1" || key == "X1" || key == "MOUSESIDE1") {
-        mouseButton = 1;
-        return true;
-    } else if (key == "XBUTTON2" || key == "X2" || key == "MOUSESIDE2") {
-        mouseButton = 2;
-        return true;
-    }
-
-    // Process single character keys
-    if (key.length() == 1) {
-        char c = key[0];
-        if (c >= 'A' && c <= 'Z') vkCode = c;
-        else if (c >= '0' && c <= '9') vkCode = c;
-        else {
-            // Special symbol keys
-            switch (c) {
-                case '`': case '~': vkCode = VK_OEM_3; break;  // `~
-                case '-': case '_': vkCode = VK_OEM_MINUS; break; // -_
-                case '=': case '+': vkCode = VK_OEM_PLUS; break;  // =+
-                case '[': case '{': vkCode = VK_OEM_4; break;     // [{
-                case ']': case '}': vkCode = VK_OEM_6; break;     // ]}
-                case '\\': case '|': vkCode = VK_OEM_5; break;    // \|
-                case ';': case ':': vkCode = VK_OEM_1; break;     // ;:
-                case '\'': case '"': vkCode = VK_OEM_7; break;    // '"
-                case ',': case '<': vkCode = VK_OEM_COMMA; break; // ,<
-                case '.': case '>': vkCode = VK_OEM_PERIOD; break;// .>
-                case '/': case '?': vkCode = VK_OEM_2; break;     // /?
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("bindings", bindings);
+    result.Set("issues", issues);
+    return result;
+}
+
+// Applies options.repeat = { action: "drop" | "rate" | "coalesce" | { mode, rate } }
+// to the pending table; rate is in Hz (default 10) for "rate" and "coalesce"
+void CompileRepeatPolicies(ShortcutModule& state, const Napi::CallbackInfo& info, size_t index) {
+    if (info.Length() <= index || !info[index].IsObject()) return;
+    Napi::Value repeat = info[index].As<Napi::Object>().Get("repeat");
+    if (!repeat.IsObject()) return;
+
+    Napi::Object policies = repeat.As<Napi::Object>();
+    Napi::Array actionNames = policies.GetPropertyNames();
+    for (uint32_t i = 0; i < actionNames.Length(); i++) {
+        Napi::Value key = actionNames.Get(i);
+        Napi::Value value = policies.Get(key);
+        double rate = 10;
+        if (value.IsObject()) {
+            Napi::Value rateValue = value.As<Napi::Object>().Get("rate");
+            if (rateValue.IsNumber() && rateValue.As<Napi::Number>().DoubleValue() > 0) {
+                rate = rateValue.As<Napi::Number>().DoubleValue();
             }
+            value = value.As<Napi::Object>().Get("mode");
         }
+        if (!value.IsString()) continue;
+
+        std::string mode = value.As<Napi::String>().Utf8Value();
+        RepeatPolicy policy = { kRepeatPass, static_cast<uint32_t>(1000.0 / rate) };
+        if (mode == "drop") policy.mode = kRepeatDrop;
+        else if (mode == "rate") policy.mode = kRepeatRate;
+        else if (mode == "coalesce") policy.mode = kRepeatCoalesce;
+        else if (mode != "pass") continue;
+        state.engine.SetRepeatPolicy(key.As<Napi::String>().Utf8Value(), policy);
+    }
+}
+
+// Applies options.triggers = { action: { press, release, hold: ms, repeat: ms } };
+// press defaults to true, hold / repeat are enabled by a positive interval
+void CompileTriggerPolicies(ShortcutModule& state, const Napi::CallbackInfo& info, size_t index) {
+    if (info.Length() <= index || !info[index].IsObject()) return;
+    Napi::Value triggers = info[index].As<Napi::Object>().Get("triggers");
+    if (!triggers.IsObject()) return;
+
+    Napi::Object policies = triggers.As<Napi::Object>();
+    Napi::Array actionNames = policies.GetPropertyNames();
+    for (uint32_t i = 0; i < actionNames.Length(); i++) {
+        Napi::Value key = actionNames.Get(i);
+        Napi::Value value = policies.Get(key);
+        if (!value.IsObject()) continue;
+
+        Napi::Object spec = value.As<Napi::Object>();
+        TriggerPolicy policy = { 0, 0, 0 };
+        Napi::Value press = spec.Get("press");
+        if (!press.IsBoolean() || press.As<Napi::Boolean>().Value()) policy.triggers |= kTriggerPress;
+        Napi::Value release = spec.Get("release");
+        if (release.IsBoolean() && release.As<Napi::Boolean>().Value()) policy.triggers |= kTriggerRelease;
+        Napi::Value hold = spec.Get("hold");
+        if (hold.IsNumber() && hold.As<Napi::Number>().Int64Value() > 0) {
+            policy.triggers |= kTriggerHold;
+            policy.holdMs = hold.As<Napi::Number>().Uint32Value();
+        }
+        Napi::Value repeat = spec.Get("repeat");
+        if (repeat.IsNumber() && repeat.As<Napi::Number>().Int64Value() > 0) {
+            policy.triggers |= kTriggerRepeat;
+            policy.repeatMs = repeat.As<Napi::Number>().Uint32Value();
+        }
+        state.engine.SetTriggerPolicy(key.As<Napi::String>().Utf8Value(), policy);
     }
-    // Function keys
-    else if (key.rfind("F", 0) == 0 && key.length() > 1) {
-        try {
-            int fkey = std::stoi(key.substr(1));
-            if (fkey >= 1 && fkey <= 24) {
-                vkCode = VK_F1 + (fkey - 1);
-            }
-        } catch (...) {}
-    }
-    // Special keys
-    else {
-        if (key == "INSERT") vkCode = VK_INSERT;
-        else if (key == "DELETE" || key == "DEL") vkCode = VK_DELETE;
-        else if (key == "HOME") vkCode = VK_HOME;
-        else if (key == "END") vkCode = VK_END;
-        else if (key == "PAGEUP" || key == "PGUP") vkCode = VK_PRIOR;
-        else if (key == "PAGEDOWN" || key == "PGDN") vkCode = VK_NEXT;
-        else if (key == "UP" || key == "UPARROW") vkCode = VK_UP;
-        else if (key == "DOWN" || key == "DOWNARROW") vkCode = VK_DOWN;
-        else if (key == "LEFT" || key == "LEFTARROW") vkCode = VK_LEFT;
-        else if (key == "RIGHT" || key == "RIGHTARROW") vkCode = VK_RIGHT;
-        else if (key == "SPACE" || key == "SPACEBAR") vkCode = VK_SPACE;
-        else if (key == "TAB") vkCode = VK_TAB;
-        else if (key == "ENTER" || key == "RETURN") vkCode = VK_RETURN;
-        else if (key == "ESCAPE" || key == "ESC") vkCode = VK_ESCAPE;
-        else if (key == "BACKSPACE" || key == "BACK") vkCode = VK_BACK;
-        else if (key == "CAPSLOCK" || key == "CAPS") vkCode = VK_CAPITAL;
-        else if (key == "NUMLOCK") vkCode = VK_NUMLOCK;
-        else if (key == "SCROLLLOCK") vkCode = VK_SCROLL;
-        else if (key == "PRINTSCREEN" || key == "PRTSC") vkCode = VK_SNAPSHOT;
-        else if (key == "PAUSE") vkCode = VK_PAUSE;
-        else if (key == "APPS" || key == "MENU") vkCode = VK_APPS;
-        // Numpad keys
-        else if (key == "NUMPAD0") vkCode = VK_NUMPAD0;
-        else if (key == "NUMPAD1") vkCode = VK_NUMPAD1;
-        else if (key == "NUMPAD2") vkCode = VK_NUMPAD2;
-        else if (key == "NUMPAD3") vkCode = VK_NUMPAD3;
-        else if (key == "NUMPAD4") vkCode = VK_NUMPAD4;
-        else if (key == "NUMPAD5") vkCode = VK_NUMPAD5;
-        else if (key == "NUMPAD6") vkCode = VK_NUMPAD6;
-        else if (key == "NUMPAD7") vkCode = VK_NUMPAD7;
-        else if (key == "NUMPAD8") vkCode = VK_NUMPAD8;
-        else if (key == "NUMPAD9") vkCode = VK_NUMPAD9;
-        else if (key == "MULTIPLY" || key == "NUMPADMULTIPLY") vkCode = VK_MULTIPLY;
-        else if (key == "ADD" || key == "NUMPADADD") vkCode = VK_ADD;
-        else if (key == "SUBTRACT" || key == "NUMPADSUBTRACT") vkCode = VK_SUBTRACT;
-        else if (key == "DECIMAL" || key == "NUMPADDECIMAL") vkCode = VK_DECIMAL;
-        else if (key == "DIVIDE" || key == "NUMPADDIVIDE") vkCode = VK_DIVIDE;
-        // Media keys
-        else if (key == "VOLUMEUP") vkCode = VK_VOLUME_UP;
-        else if (key == "VOLUMEDOWN") vkCode = VK_VOLUME_DOWN;
-        else if (key == "VOLUMEMUTE") vkCode = VK_VOLUME_MUTE;
-        else if (key == "MEDIANEXT") vkCode = VK_MEDIA_NEXT_TRACK;
-        else if (key == "MEDIAPREV") vkCode = VK_MEDIA_PREV_TRACK;
-        else if (key == "MEDIAPLAYPAUSE") vkCode = VK_MEDIA_PLAY_PAUSE;
-        else if (key == "MEDIASTOP") vkCode = VK_MEDIA_STOP;
-    }
-
-    return vkCode != 0 || mouseButton != 0;
+}
+
+// Action names indexed by action id so JS can map ids back once
+Napi::Array ActionNameArray(Napi::Env env, const ShortcutModule& state) {
+    const std::vector<std::string>& names = state.engine.Table().ActionNames();
+    Napi::Array actionNames = Napi::Array::New(env, names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        actionNames.Set(static_cast<uint32_t>(i), Napi::String::New(env, names[i]));
+    }
+    return actionNames;
 }
 
 // Start/register hotkeys
+// Args: shortcuts object, callback, optional { grab, mouseHook, repeat, triggers, profiles } options
+// Returns the action names indexed by action id so JS can map ids back once
 Napi::Value Start(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    StopHotkeyListener();
-    idToActionMap.clear();
-    mouseKeyMap.clear();
+    ShortcutModule& state = State(info);
+    StopHotkeyListener(state);
 
     if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsFunction()) {
         Napi::TypeError::New(env, "Shortcut object and callback function required").ThrowAsJavaScriptException();
@@ -314,107 +368,301 @@ Napi::Value Start(const Napi::CallbackInfo& info) {
 
     Napi::Object shortcuts = info[0].As<Napi::Object>();
     Napi::Function callback = info[1].As<Napi::Function>();
+    InputBackendOptions options = ParseBackendOptions(info, 2);
+
+    // The hooks are per process: a listener in one environment at a time
+    if (!ClaimProcessResource(kResourceInputListener, &state)) {
+        Napi::Error::New(env, "Shortcut listener is already running in another environment").ThrowAsJavaScriptException();
+        return env.Null();
+    }
 
-    tsfn = Napi::ThreadSafeFunction::New(env, callback, "HotkeyCallback", 0, 1, [](Napi::Env) {});
+    // Queue size 1: EventQueue keeps at most one drain pending
+    state.tsfn = DrainTsfn::New(env, callback, "HotkeyCallback", 1, 1, &state);
+    state.ArmShutdownHook(env);
+    state.engine.SetDrainRequest(RequestDrain, &state);
+    
+    // Compile shortcut configuration into the dispatch table
+    CompileBindings(state, shortcuts, info, 2);
+    CompileRepeatPolicies(state, info, 2);
+    CompileTriggerPolicies(state, info, 2);
+    state.engine.PublishBindings();
+    PublishProfileRules(state);
 
-    struct HotkeyInfo {
-        std::string actionName;
-        UINT modifiers;
-        UINT vkCode;
-    };
-    std::vector<HotkeyInfo> hotkeysToRegister;
+    if (!state.backend) {
+        state.backend.reset(CreatePlatformInputBackend());
+    }
+    if (state.backend->Start(&state.engine, options)) {
+        state.watchdog.Start(&state.engine, state.backend.get());
+    }
     
-    // Parse shortcut configuration
-    Napi::Array shortcutNames = shortcuts.GetPropertyNames();
-    for (uint32_t i = 0; i < shortcutNames.Length(); i++) {
-        Napi::Value key = shortcutNames.Get(i);
-        std::string actionName = key.As<Napi::String>().Utf8Value();
-        std::string keyString = shortcuts.Get(key).As<Napi::String>().Utf8Value();
-        
-        UINT vkCode = 0, modifiers = 0, mouseButton = 0;
-        if (StringToVk(keyString, vkCode, modifiers, mouseButton)) {
-            if (mouseButton != 0) {
-                // Mouse side button mapping
-                mouseKeyMap[std::make_pair(modifiers, mouseButton)] = actionName;
-            } else if (vkCode != 0) {
-                // Use THE ULTIMATE KEYBOARD HOOK instead of RegisterHotKey
-                keyboardHookMap[std::make_pair(modifiers, vkCode)] = actionName;
-                // Keep legacy method as backup
-                hotkeysToRegister.push_back({actionName, modifiers, vkCode});
-            }
-        }
+    return ActionNameArray(env, state);
+}
+
+// Replace the bindings of a running listener without touching the hooks,
+// the TSFN or events already queued: the new table is compiled on the JS
+// thread and swapped in with one atomic pointer exchange. Returns the action names like
+// start(), or null if the backend cannot serve the new bindings as installed
+// (e.g. first mouse binding while only the keyboard hook runs); the caller
+// then restarts.
+Napi::Value Update(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    ShortcutModule& state = State(info);
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Shortcut object required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (!state.tsfn || !state.backend) {
+        return env.Null();
     }
 
-    // Install THE ULTIMATE KEYBOARD HOOK - Works in fullscreen games!
-    if (!keyboardHookMap.empty()) {
-        keyboardHook = SetWindowsHookEx(WH_KEYBOARD_LL, KeyboardHookProc, GetModuleHandle(NULL), 0);
-        if (keyboardHook) {
-            keyboardHookRunning = true;
-        }
+    CompileBindings(state, info[0].As<Napi::Object>(), info, 1);
+    CompileRepeatPolicies(state, info, 1);
+    CompileTriggerPolicies(state, info, 1);
+    if (!state.backend->CanSwapBindings(state.engine.PendingTable(), ParseBackendOptions(info, 1))) {
+        state.engine.DiscardBindings();
+        return env.Null();
     }
+    state.engine.PublishBindings();
+    PublishProfileRules(state);
+    return ActionNameArray(env, state);
+}
 
-    // Install mouse hook (if there are mouse shortcuts)
-    if (!mouseKeyMap.empty()) {
-        mouseHook = SetWindowsHookEx(WH_MOUSE_LL, MouseHookProc, GetModuleHandle(NULL), 0);
-        if (mouseHook) {
-            mouseHookRunning = true;
-        }
+// Dry run: canonicalize and check a shortcuts object without binding it
+Napi::Value CompileKeymapReport(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Shortcut object required").ThrowAsJavaScriptException();
+        return env.Null();
     }
+    CompiledKeymap keymap;
+    CompileKeymap(ReadKeymap(info[0].As<Napi::Object>()), &keymap);
+    return KeymapReport(env, keymap);
+}
 
-    // Keep legacy RegisterHotKey as backup (in case hooks fail in some scenarios)
-    if (!hotkeysToRegister.empty() && !keyboardHookRunning) {
-        isRunning = true;
-        hotkeyThread = std::thread([hotkeysToRegister]() {
-            hotkeyThreadId = GetCurrentThreadId();
-            int nextHotkeyId = 1;
-            
-            // Register hotkeys
-            for (const auto& hotkey : hotkeysToRegister) {
-                int id = nextHotkeyId++;
-                if (RegisterHotKey(NULL, id, hotkey.modifiers, hotkey.vkCode)) {
-                    idToActionMap[id] = hotkey.actionName;
-                }
-            }
+// Report for the bindings passed to the last start() / update()
+Napi::Value GetKeymapReport(const Napi::CallbackInfo& info) {
+    ShortcutModule& state = State(info);
+    return KeymapReport(info.Env(), state.lastKeymap);
+}
 
-            // Message loop
-            MSG msg = {0};
-            while (GetMessage(&msg, NULL, 0, 0) != 0) {
-                if (msg.message == WM_HOTKEY) {
-                    int id = static_cast<int>(msg.wParam);
-                    auto it = idToActionMap.find(id);
-                    if (it != idToActionMap.end()) {
-                        std::string action = it->second;
-                        if (tsfn) {
-                            tsfn.NonBlockingCall([action](Napi::Env env, Napi::Function jsCallback) {
-                                jsCallback.Call({Napi::String::New(env, action)});
-                            });
-                        }
-                    }
-                }
-            }
+// { path, records, dropped, capacity } of the running trace, or null
+Napi::Value TraceInfo(Napi::Env env, const ShortcutModule& state) {
+    const InputTraceWriter* trace = state.engine.InputTrace();
+    if (!trace) {
+        return env.Null();
+    }
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("path", Napi::String::New(env, trace->Path()));
+    result.Set("records", Napi::Number::New(env, static_cast<double>(trace->Count())));
+    result.Set("dropped", Napi::Number::New(env, static_cast<double>(trace->Dropped())));
+    result.Set("capacity", Napi::Number::New(env, static_cast<double>(trace->Capacity())));
+    return result;
+}
 
-            // Clean up registered hotkeys
-            for (const auto& pair : idToActionMap) {
-                UnregisterHotKey(NULL, pair.first);
-            }
-        });
-        hotkeyThread.detach();
+// Record the raw input stream into a binary trace for trace_replay
+// Args: file path, optional { maxRecords } (default 1M records, 32 MiB)
+// The current bindings are written next to it as <path>.keymap. Recording
+// keeps running across start()/stop() until stopTrace().
+Napi::Value StartTrace(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    ShortcutModule& state = State(info);
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Trace file path required").ThrowAsJavaScriptException();
+        return env.Null();
     }
-    
-    return env.Undefined();
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    uint64_t maxRecords = kDefaultTraceRecords;
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Value limit = info[1].As<Napi::Object>().Get("maxRecords");
+        if (limit.IsNumber() && limit.As<Napi::Number>().Int64Value() > 0) {
+            maxRecords = static_cast<uint64_t>(limit.As<Napi::Number>().Int64Value());
+        }
+    }
+
+    if (!state.backend) {
+        state.backend.reset(CreatePlatformInputBackend());
+    }
+    std::string error;
+    std::unique_ptr<InputTraceWriter> trace(new InputTraceWriter());
+    if (!trace->Open(path, maxRecords, state.backend->TracePlatform(), &error) ||
+        !WriteReplayKeymap(path + ".keymap", state.lastKeymap, state.engine.Table(), &error)) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    state.engine.SetInputTrace(trace.release());
+    return TraceInfo(env, state);
+}
+
+// Stops recording and closes the file; returns the final trace info (null if none was running)
+Napi::Value StopTrace(const Napi::CallbackInfo& info) {
+    ShortcutModule& state = State(info);
+    Napi::Value result = TraceInfo(info.Env(), state);
+    state.engine.SetInputTrace(nullptr);
+    return result;
+}
+
+Napi::Value GetTraceInfo(const Napi::CallbackInfo& info) {
+    ShortcutModule& state = State(info);
+    return TraceInfo(info.Env(), state);
 }
 
 // Stop hotkey listener
 Napi::Value Stop(const Napi::CallbackInfo& info) {
-    StopHotkeyListener();
+    ShortcutModule& state = State(info);
+    StopHotkeyListener(state);
     return info.Env().Undefined();
 }
 
-// Module initialization
-Napi::Object Init(Napi::Env env, Napi::Object exports) {
-    exports.Set("start", Napi::Function::New(env, Start));
-    exports.Set("stop", Napi::Function::New(env, Stop));
-    return exports;
+// Which input backend is in use and what it managed to attach to
+Napi::Value GetBackendInfo(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    ShortcutModule& state = State(info);
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("name", Napi::String::New(env, state.backend ? state.backend->Name() : "none"));
+    result.Set("keyboard", Napi::Boolean::New(env, state.backend && state.backend->KeyboardActive()));
+    result.Set("mouse", Napi::Boolean::New(env, state.backend && state.backend->MouseActive()));
+    return result;
 }
 
-NODE_API_MODULE(high_priority_shortcut, Init)
\ No newline at end of file
+// Input thread priority, hook/device health and consumer stalls
+Napi::Value GetInputHealth(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    ShortcutModule& state = State(info);
+    InputBackendHealth health = state.backend ? state.backend->Health() : InputBackendCounters().Snapshot();
+    InputWatchdogStats stats = state.watchdog.Stats();
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("backend", Napi::String::New(env, state.backend ? state.backend->Name() : "none"));
+    result.Set("watchdog", Napi::Boolean::New(env, state.watchdog.Running()));
+    result.Set("elevatedPriority", Napi::Boolean::New(env, health.elevatedPriority));
+    result.Set("realtimePriority", Napi::Boolean::New(env, health.realtimePriority));
+    result.Set("probes", Napi::Number::New(env, static_cast<double>(health.probes)));
+    result.Set("hookFailures", Napi::Number::New(env, static_cast<double>(health.failures)));
+    result.Set("reinstalls", Napi::Number::New(env, static_cast<double>(health.reinstalls)));
+    result.Set("events", Napi::Number::New(env, static_cast<double>(health.events)));
+    result.Set("mouseTakenOver", Napi::Boolean::New(env, health.mouseTakenOver));
+    result.Set("cpuMs", Napi::Number::New(env, static_cast<double>(health.cpuNs) / 1e6));
+    result.Set("checks", Napi::Number::New(env, static_cast<double>(stats.checks)));
+    result.Set("consumerStalls", Napi::Number::New(env, static_cast<double>(stats.consumerStalls)));
+    result.Set("drainKicks", Napi::Number::New(env, static_cast<double>(stats.drainKicks)));
+    result.Set("consumerStalled", Napi::Boolean::New(env, stats.consumerStalled));
+    return result;
+}
+
+// Keymap profile in use and what the foreground monitor last reported
+Napi::Value GetProfileStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    ShortcutModule& state = State(info);
+    KeymapProfileStats stats = state.profileSwitcher.Stats();
+    const std::vector<std::string>& names = state.engine.Table().ProfileNames();
+
+    Napi::Array profiles = Napi::Array::New(env, names.size() - 1);
+    for (size_t i = 1; i < names.size(); i++) {
+        profiles.Set(static_cast<uint32_t>(i - 1), Napi::String::New(env, names[i]));
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("monitor", Napi::Boolean::New(env, state.followsForeground));
+    result.Set("profiles", profiles);
+    if (stats.profile != kDefaultProfile && stats.profile < names.size()) {
+        result.Set("active", Napi::String::New(env, names[stats.profile]));
+    } else {
+        result.Set("active", env.Null());
+    }
+    result.Set("foregroundChanges", Napi::Number::New(env, static_cast<double>(stats.foregroundChanges)));
+    result.Set("switches", Napi::Number::New(env, static_cast<double>(stats.switches)));
+    result.Set("pid", Napi::Number::New(env, stats.app.pid));
+    result.Set("process", Napi::String::New(env, stats.app.process));
+    result.Set("windowClass", Napi::String::New(env, stats.app.windowClass));
+    return result;
+}
+
+// Event delivery counters
+Napi::Value GetEventStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    ShortcutModule& state = State(info);
+    EventQueueStats stats = state.engine.QueueStats();
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("published", Napi::Number::New(env, static_cast<double>(stats.published)));
+    result.Set("dropped", Napi::Number::New(env, static_cast<double>(stats.dropped)));
+    result.Set("delivered", Napi::Number::New(env, static_cast<double>(stats.delivered)));
+    result.Set("batches", Napi::Number::New(env, static_cast<double>(stats.batches)));
+    result.Set("capacity", Napi::Number::New(env, static_cast<double>(kEventRingCapacity)));
+    return result;
+}
+
+// Called by JS once a handler has finished acting on an event
+// Args: hook timestamp (ns), JS callback entry timestamp (ns)
+Napi::Value ReportCompletion(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    ShortcutModule& state = State(info);
+    
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Event timestamp and JS entry timestamp required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    uint64_t hookEntry = static_cast<uint64_t>(info[0].As<Napi::Number>().DoubleValue());
+    uint64_t jsEntry = static_cast<uint64_t>(info[1].As<Napi::Number>().DoubleValue());
+    uint64_t now = SteadyNowNs();
+    
+    if (jsEntry != 0 && now > jsEntry) {
+        state.engine.Latency().Record(kStageJsToComplete, now - jsEntry);
+    }
+    if (hookEntry != 0 && now > hookEntry) {
+        state.engine.Latency().Record(kStageHookToComplete, now - hookEntry);
+    }
+    return env.Undefined();
+}
+
+// Per-stage latency percentiles, in microseconds
+Napi::Value GetLatencyStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    ShortcutModule& state = State(info);
+    Napi::Object result = Napi::Object::New(env);
+    
+    for (int stage = 0; stage < kLatencyStageCount; stage++) {
+        LatencySummary summary = state.engine.Latency().Summarize(static_cast<LatencyStage>(stage));
+        Napi::Object stats = Napi::Object::New(env);
+        stats.Set("count", Napi::Number::New(env, static_cast<double>(summary.count)));
+        stats.Set("min", Napi::Number::New(env, summary.min / 1000.0));
+        stats.Set("max", Napi::Number::New(env, summary.max / 1000.0));
+        stats.Set("mean", Napi::Number::New(env, summary.mean / 1000.0));
+        stats.Set("p50", Napi::Number::New(env, summary.p50 / 1000.0));
+        stats.Set("p90", Napi::Number::New(env, summary.p90 / 1000.0));
+        stats.Set("p99", Napi::Number::New(env, summary.p99 / 1000.0));
+        stats.Set("p999", Napi::Number::New(env, summary.p999 / 1000.0));
+        result.Set(LatencyStageName(stage), stats);
+    }
+    return result;
+}
+
+Napi::Value ResetLatencyStats(const Napi::CallbackInfo& info) {
+    ShortcutModule& state = State(info);
+    state.engine.Latency().Reset();
+    return info.Env().Undefined();
+}
+
+} // namespace
+
+RuntimeModule* CreateShortcutModule(Napi::Env env, Napi::Object exports) {
+    ShortcutModule* state = new ShortcutModule();
+    exports.Set("start", Napi::Function::New(env, Start, "start", state));
+    exports.Set("stop", Napi::Function::New(env, Stop, "stop", state));
+    exports.Set("update", Napi::Function::New(env, Update, "update", state));
+    exports.Set("getEventStats", Napi::Function::New(env, GetEventStats, "getEventStats", state));
+    exports.Set("getBackendInfo", Napi::Function::New(env, GetBackendInfo, "getBackendInfo", state));
+    exports.Set("getInputHealth", Napi::Function::New(env, GetInputHealth, "getInputHealth", state));
+    exports.Set("getProfileStats", Napi::Function::New(env, GetProfileStats, "getProfileStats", state));
+    exports.Set("reportCompletion", Napi::Function::New(env, ReportCompletion, "reportCompletion", state));
+    exports.Set("getLatencyStats", Napi::Function::New(env, GetLatencyStats, "getLatencyStats", state));
+    exports.Set("resetLatencyStats", Napi::Function::New(env, ResetLatencyStats, "resetLatencyStats", state));
+    exports.Set("compileKeymap", Napi::Function::New(env, CompileKeymapReport, "compileKeymap", state));
+    exports.Set("getKeymapReport", Napi::Function::New(env, GetKeymapReport, "getKeymapReport", state));
+    exports.Set("startTrace", Napi::Function::New(env, StartTrace, "startTrace", state));
+    exports.Set("stopTrace", Napi::Function::New(env, StopTrace, "stopTrace", state));
+    exports.Set("getTraceInfo", Napi::Function::New(env, GetTraceInfo, "getTraceInfo", state));
+    return state;
+}
@@ -1,316 +1,659 @@
 #include <napi.h>
-#include <windows.h>
-#include <map>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <thread>
-#include <chrono>
-
-// Global state for window management
-std::map<std::string, HWND> trackedWindows;
-bool monitoringActive = false;
-std::thread monitorThread;
-
-// Enhanced window enumeration callback for finding target windows
-BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam) {
-    DWORD processId;
-    GetWindowThreadProcessId(hwnd, &processId);
-    
-    // Try both ANSI and Unicode window text
-    char windowTextA[512];
-    wchar_t windowTextW[512];
-    GetWindowTextA(hwnd, windowTextA, sizeof(windowTextA));
-    GetWindowTextW(hwnd, windowTextW, sizeof(windowTextW)/sizeof(wchar_t));
-    
-    char className[256];
-    GetClassNameA(hwnd, className, sizeof(className));
-    
-    // Check if window is visible and has a title
-    if (IsWindowVisible(hwnd) && (strlen(windowTextA) > 0 || wcslen(windowTextW) > 0)) {
-        std::string* targetTitle = reinterpret_cast<std::string*>(lParam);
-        std::string currentTitleA(windowTextA);
-        
-        // Convert Unicode to UTF-8 for comparison
-        std::string currentTitleW;
-        if (wcslen(windowTextW) > 0) {
-            int utf8Length = WideCharToMultiByte(CP_UTF8, 0, windowTextW, -1, NULL, 0, NULL, NULL);
-            if (utf8Length > 0) {
-                std::vector<char> utf8Buffer(utf8Length);
-                WideCharToMultiByte(CP_UTF8, 0, windowTextW, -1, utf8Buffer.data(), utf8Length, NULL, NULL);
-                currentTitleW = std::string(utf8Buffer.data());
-            }
-        }
-        
-        // Case-insensitive search for window title (try both ANSI and UTF-8)
-        bool foundA = currentTitleA.find(*targetTitle) != std::string::npos;
-        bool foundW = !currentTitleW.empty() && currentTitleW.find(*targetTitle) != std::string::npos;
-        
-        if (foundA || foundW) {
-            trackedWindows[*targetTitle] = hwnd;
-            return FALSE; // Stop enumeration when found
+#include <unordered_map>
+#include <vector>
+
+#include "native_runtime.h"
+#include "title_matcher.h"
+#include "topmost_watcher.h"
+#include "topmost_worker.h"
+#include "window_platform.h"
+#include "window_snapshot.h"
+#include "window_title_cache.h"
+
+// N-API glue for the topmost module, the `topmost` sub-module of the native
+// runtime (native_runtime.h). Window operations live in the
+// window_platform_* files and the event-driven enforcement in the
+// topmost_watcher_* files; this file only converts arguments and results.
+
+namespace {
+
+struct TopmostModule;
+
+// Async operations: the worker reports finished jobs into completedJobs and
+// wakes the JS thread through a function-less TSFN (queue unbounded, one
+// wakeup per non-empty transition); deferreds never leave the JS thread.
+void CallJsCompleteTopmost(Napi::Env env, Napi::Function jsCallback, TopmostModule* context, void* data);
+typedef Napi::TypedThreadSafeFunction<TopmostModule, void, CallJsCompleteTopmost> CompletionTsfn;
+
+// What to do with the watcher once a job's raise succeeded
+enum WatchMode {
+    kWatchNone,
+    kWatchReplace,   // startWindowMonitoringAsync: the job's window becomes the only target
+    kWatchAdd        // watchWindowAsync: one more target
+};
+
+struct PendingTopmostOp {
+    Napi::Promise::Deferred deferred;
+    WatchMode watch;
+    TopmostPolicy policy;
+};
+
+void StopWatcher(TopmostModule& state);
+
+// State of one environment's topmost sub-module
+struct TopmostModule : public RuntimeModule {
+    std::unique_ptr<TopmostWatcher> watcher;
+    TopmostWorker topmostWorker;
+
+    CompletionTsfn completionTsfn;
+    std::mutex completedMutex;
+    std::vector<TopmostJobResult> completedJobs;
+    std::unordered_map<uint32_t, PendingTopmostOp> pendingOps;   // JS thread only
+    uint32_t nextJobId = 1;
+
+    ~TopmostModule() override { Shutdown(); }
+    void Shutdown() override {
+        StopWatcher(*this);
+        topmostWorker.Stop();
+    }
+};
+
+TopmostModule& State(const Napi::CallbackInfo& info) {
+    return *static_cast<TopmostModule*>(info.Data());
+}
+
+// Title lookups are shared by every environment: one cache, and one window
+// change monitor per process behind it
+WindowTitleCache titleCache;
+
+// A window can be given as a native handle (number, or the Buffer returned by
+// BrowserWindow.getNativeWindowHandle()) or as a title substring. Handles are
+// used as-is after a validity check; titles go through the cache.
+bool IsWindowArgument(const Napi::Value& value) {
+    return value.IsString() || value.IsNumber() || value.IsBuffer();
+}
+
+// Handle carried by a number or Buffer argument (not validated); 0 otherwise
+WindowHandle HandleFromValue(const Napi::Value& value) {
+    WindowHandle window = 0;
+    if (value.IsNumber()) {
+        window = static_cast<WindowHandle>(value.As<Napi::Number>().Int64Value());
+    } else if (value.IsBuffer()) {
+        Napi::Buffer<uint8_t> buffer = value.As<Napi::Buffer<uint8_t>>();
+        if (buffer.Length() >= sizeof(uint64_t)) {
+            uint64_t raw;
+            memcpy(&raw, buffer.Data(), sizeof(raw));
+            window = static_cast<WindowHandle>(raw);
+        } else if (buffer.Length() >= sizeof(uint32_t)) {
+            uint32_t raw;
+            memcpy(&raw, buffer.Data(), sizeof(raw));
+            window = static_cast<WindowHandle>(raw);
         }
     }
-    
-    return TRUE; // Continue enumeration
+    return window;
+}
+
+WindowHandle ResolveWindow(const Napi::Value& value) {
+    if (value.IsString()) {
+        return titleCache.Find(value.As<Napi::String>().Utf8Value());
+    }
+    WindowHandle window = HandleFromValue(value);
+    return (window && IsWindowValid(window)) ? window : 0;
 }
 
-// Function to find window by title (partial match)
-HWND FindWindowByTitle(const std::string& titleSubstring) {
-    trackedWindows.clear();
-    EnumWindows(EnumWindowsProc, reinterpret_cast<LPARAM>(&titleSubstring));
-    
-    auto it = trackedWindows.find(titleSubstring);
-    return (it != trackedWindows.end()) ? it->second : NULL;
+std::string DescribeWindow(const Napi::Value& value) {
+    return value.IsString() ? value.As<Napi::String>().Utf8Value() : std::string("<handle>");
 }
 
-// Advanced window topmost setting with UIAccess-like behavior
-bool SetWindowAlwaysOnTop(HWND hwnd, bool topmost) {
-    if (!IsWindow(hwnd)) {
+void StopWatcher(TopmostModule& state) {
+    if (state.watcher) {
+        state.watcher->Stop();
+    }
+    ReleaseProcessResource(kResourceTopmostWatcher, &state);
+}
+
+// Adds a window to the one watcher thread, starting it on first use. False
+// if the watcher already runs in another environment (the WinEvent hooks are
+// per process).
+bool WatchWindow(TopmostModule& state, WindowHandle window, const TopmostPolicy& policy, WatchMode mode) {
+    if (mode == kWatchReplace) {
+        StopWatcher(state);
+    }
+    if (!ClaimProcessResource(kResourceTopmostWatcher, &state)) {
         return false;
     }
-    
-    HWND insertAfter = topmost ? HWND_TOPMOST : HWND_NOTOPMOST;
-    UINT flags = SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE;
-    
-    // First attempt: Standard topmost setting
-    bool result = SetWindowPos(hwnd, insertAfter, 0, 0, 0, 0, flags);
-    
-    if (topmost && result) {
-        // Enhanced approach: Force window to stay on top
-        // This mimics UIAccess behavior for better fullscreen game compatibility
-        
-        // Get current window style
-        LONG_PTR exStyle = GetWindowLongPtr(hwnd, GWL_EXSTYLE);
-        
-        // Add WS_EX_TOPMOST and WS_EX_NOACTIVATE for better compatibility
-        exStyle |= WS_EX_TOPMOST | WS_EX_NOACTIVATE;
-        SetWindowLongPtr(hwnd, GWL_EXSTYLE, exStyle);
-        
-        // Force update with multiple attempts for stubborn fullscreen applications
-        for (int i = 0; i < 3; i++) {
-            SetWindowPos(hwnd, HWND_TOPMOST, 0, 0, 0, 0, flags);
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        }
-        
-        // Additional technique: Set window to system-level priority
-        // This helps when dealing with fullscreen games that try to override topmost
-        SetWindowPos(hwnd, reinterpret_cast<HWND>(-1), 0, 0, 0, 0, flags);
+    if (!state.watcher) {
+        state.watcher.reset(CreateTopmostWatcher());
     }
-    
-    return result;
+    if (!state.watcher->IsRunning() && !state.watcher->Start()) {
+        return false;
+    }
+    return state.watcher->Watch(window, policy);
 }
 
-// Monitor thread function to maintain topmost status against fullscreen applications
-void MonitorWindowTopmost(HWND targetWindow) {
-    while (monitoringActive && IsWindow(targetWindow)) {
-        // Check if window is still topmost
-        HWND topWindow = GetTopWindow(GetDesktopWindow());
-        bool isOnTop = false;
-        
-        // Walk through top-level windows to check if our window is among the topmost
-        HWND currentWindow = topWindow;
-        for (int i = 0; i < 10 && currentWindow; i++) { // Check top 10 windows
-            if (currentWindow == targetWindow) {
-                isOnTop = true;
-                break;
-            }
-            currentWindow = GetNextWindow(currentWindow, GW_HWNDNEXT);
-        }
-        
-        // If not on top, force it back to top
-        if (!isOnTop) {
-            SetWindowAlwaysOnTop(targetWindow, true);
-        }
-        
-        // Sleep to prevent excessive CPU usage
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+// { priority, raiseBudget, backoffMs }, every field optional; false (with a
+// pending TypeError) if malformed
+bool ParsePolicy(Napi::Env env, const Napi::Value& value, TopmostPolicy* policy) {
+    if (value.IsUndefined() || value.IsNull()) {
+        return true;
     }
+    if (!value.IsObject()) {
+        Napi::TypeError::New(env, "Policy must be an object").ThrowAsJavaScriptException();
+        return false;
+    }
+    Napi::Object object = value.As<Napi::Object>();
+    Napi::Value priority = object.Get("priority");
+    Napi::Value raiseBudget = object.Get("raiseBudget");
+    Napi::Value backoffMs = object.Get("backoffMs");
+    if ((!priority.IsUndefined() && !priority.IsNumber()) ||
+        (!raiseBudget.IsUndefined() && (!raiseBudget.IsNumber() || raiseBudget.As<Napi::Number>().DoubleValue() < 0)) ||
+        (!backoffMs.IsUndefined() && (!backoffMs.IsNumber() || backoffMs.As<Napi::Number>().DoubleValue() < 0))) {
+        Napi::TypeError::New(env, "Policy fields must be numbers (raiseBudget and backoffMs not negative)").ThrowAsJavaScriptException();
+        return false;
+    }
+    if (priority.IsNumber()) policy->priority = priority.As<Napi::Number>().Int32Value();
+    if (raiseBudget.IsNumber()) policy->raiseBudget = raiseBudget.As<Napi::Number>().Uint32Value();
+    if (backoffMs.IsNumber()) policy->backoffMs = backoffMs.As<Napi::Number>().Uint32Value();
+    return true;
 }
 
 // Start monitoring a window to keep it always on top
 Napi::Value StartWindowMonitoring(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    
-    if (info.Length() < 1 || !info[0].IsString()) {
-        Napi::TypeError::New(env, "Window title string required").ThrowAsJavaScriptException();
+    TopmostModule& state = State(info);
+
+    if (info.Length() < 1 || !IsWindowArgument(info[0])) {
+        Napi::TypeError::New(env, "Window handle or title string required").ThrowAsJavaScriptException();
         return env.Null();
     }
-    
-    std::string windowTitle = info[0].As<Napi::String>().Utf8Value();
-    
+
     // Find the target window
-    HWND targetWindow = FindWindowByTitle(windowTitle);
+    WindowHandle targetWindow = ResolveWindow(info[0]);
     if (!targetWindow) {
-        Napi::Error::New(env, "Window not found: " + windowTitle).ThrowAsJavaScriptException();
+        Napi::Error::New(env, "Window not found: " + DescribeWindow(info[0])).ThrowAsJavaScriptException();
         return env.Null();
     }
-    
-    // Set window to always on top
-    bool success = SetWindowAlwaysOnTop(targetWindow, true);
-    
+
+    // Set window to always on top; the follow-up retries run on the worker's timers
+    bool success = TracedSetWindowAlwaysOnTop(targetWindow, true);
+
     if (success) {
-        // Stop any existing monitoring
-        monitoringActive = false;
-        if (monitorThread.joinable()) {
-            monitorThread.join();
-        }
-        
-        // Start new monitoring thread
-        monitoringActive = true;
-        monitorThread = std::thread(MonitorWindowTopmost, targetWindow);
-        monitorThread.detach();
-        
-        return Napi::Boolean::New(env, true);
-    }
-    
+        state.topmostWorker.ScheduleRetries(std::vector<WindowHandle>(1, targetWindow));
+        // Stop any existing monitoring, then watch z-order events for the new target
+        return Napi::Boolean::New(env, WatchWindow(state, targetWindow, TopmostPolicy(), kWatchReplace));
+    }
+
     return Napi::Boolean::New(env, false);
 }
 
+// watchWindow(window, policy?) -> boolean
+// Keeps one more window on top, next to those already watched; calling it
+// again for a watched window only changes its policy.
+Napi::Value WatchWindowSync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    TopmostModule& state = State(info);
+
+    if (info.Length() < 1 || !IsWindowArgument(info[0])) {
+        Napi::TypeError::New(env, "Window handle or title string required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    TopmostPolicy policy;
+    if (!ParsePolicy(env, info.Length() > 1 ? info[1] : env.Undefined(), &policy)) {
+        return env.Null();
+    }
+
+    WindowHandle targetWindow = ResolveWindow(info[0]);
+    if (!targetWindow || !TracedSetWindowAlwaysOnTop(targetWindow, true)) {
+        return Napi::Boolean::New(env, false);
+    }
+    state.topmostWorker.ScheduleRetries(std::vector<WindowHandle>(1, targetWindow));
+    return Napi::Boolean::New(env, WatchWindow(state, targetWindow, policy, kWatchAdd));
+}
+
+// unwatchWindow(window, lower?) -> boolean
+// Stops keeping one window on top; the others stay watched
+Napi::Value UnwatchWindow(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    TopmostModule& state = State(info);
+
+    if (info.Length() < 1 || !IsWindowArgument(info[0])) {
+        Napi::TypeError::New(env, "Window handle or title string required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    WindowHandle targetWindow = ResolveWindow(info[0]);
+    if (!targetWindow) {
+        return Napi::Boolean::New(env, false);
+    }
+    bool removed = state.watcher && state.watcher->Unwatch(targetWindow);
+    if (info.Length() > 1 && info[1].IsBoolean() && info[1].As<Napi::Boolean>().Value()) {
+        TracedSetWindowAlwaysOnTop(targetWindow, false);
+    }
+    return Napi::Boolean::New(env, removed);
+}
+
 // Stop monitoring and remove topmost status
 Napi::Value StopWindowMonitoring(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    
-    monitoringActive = false;
-    
-    if (monitorThread.joinable()) {
-        monitorThread.join();
-    }
-    
+    TopmostModule& state = State(info);
+
+    StopWatcher(state);
+
     // Optional: Remove topmost from all tracked windows
-    if (info.Length() > 0 && info[0].IsString()) {
-        std::string windowTitle = info[0].As<Napi::String>().Utf8Value();
-        HWND targetWindow = FindWindowByTitle(windowTitle);
+    if (info.Length() > 0 && IsWindowArgument(info[0])) {
+        WindowHandle targetWindow = ResolveWindow(info[0]);
         if (targetWindow) {
-            SetWindowAlwaysOnTop(targetWindow, false);
+            TracedSetWindowAlwaysOnTop(targetWindow, false);
         }
     }
-    
+
     return Napi::Boolean::New(env, true);
 }
 
 // Set specific window topmost without monitoring
 Napi::Value SetWindowTopmost(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    
-    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsBoolean()) {
-        Napi::TypeError::New(env, "Window title string and boolean topmost flag required").ThrowAsJavaScriptException();
+    TopmostModule& state = State(info);
+
+    if (info.Length() < 2 || !IsWindowArgument(info[0]) || !info[1].IsBoolean()) {
+        Napi::TypeError::New(env, "Window handle or title string and boolean topmost flag required").ThrowAsJavaScriptException();
         return env.Null();
     }
-    
-    std::string windowTitle = info[0].As<Napi::String>().Utf8Value();
+
     bool topmost = info[1].As<Napi::Boolean>().Value();
-    
-    HWND targetWindow = FindWindowByTitle(windowTitle);
+
+    WindowHandle targetWindow = ResolveWindow(info[0]);
     if (!targetWindow) {
         return Napi::Boolean::New(env, false);
     }
-    
-    bool success = SetWindowAlwaysOnTop(targetWindow, topmost);
+
+    bool success = TracedSetWindowAlwaysOnTop(targetWindow, topmost);
+    if (success && topmost) {
+        state.topmostWorker.ScheduleRetries(std::vector<WindowHandle>(1, targetWindow));
+    }
     return Napi::Boolean::New(env, success);
 }
 
-// Get list of all visible windows (for debugging)
-Napi::Value GetVisibleWindows(const Napi::CallbackInfo& info) {
+// Worker thread: title lookups for async jobs go through the shared cache
+WindowHandle ResolveTitleOnWorker(const std::string& title, void* context) {
+    return titleCache.Find(title);
+}
+
+// Worker thread
+void OnTopmostJobDone(const TopmostJobResult& result, void* context) {
+    TopmostModule& state = *static_cast<TopmostModule*>(context);
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(state.completedMutex);
+        state.completedJobs.push_back(result);
+        wake = state.completedJobs.size() == 1;
+    }
+    if (wake) {
+        state.completionTsfn.NonBlockingCall();
+    }
+}
+
+// Runs on the JS thread: settle the promises of every finished job
+void CallJsCompleteTopmost(Napi::Env env, Napi::Function jsCallback, TopmostModule* context, void* data) {
+    if (env == nullptr) {
+        return;
+    }
+    TopmostModule& state = *context;
+
+    std::vector<TopmostJobResult> results;
+    {
+        std::lock_guard<std::mutex> lock(state.completedMutex);
+        results.swap(state.completedJobs);
+    }
+
+    for (const TopmostJobResult& result : results) {
+        auto it = state.pendingOps.find(result.id);
+        if (it == state.pendingOps.end()) continue;
+
+        bool success = result.success;
+        if (success && it->second.watch != kWatchNone) {
+            success = WatchWindow(state, result.windows[0], it->second.policy, it->second.watch);
+        }
+        it->second.deferred.Resolve(Napi::Boolean::New(env, success));
+        state.pendingOps.erase(it);
+    }
+
+    // Let the process exit while nothing is outstanding
+    if (state.pendingOps.empty()) {
+        state.completionTsfn.Unref(env);
+    }
+}
+
+// Adds one window argument to a job; false if it is not a window argument
+bool AddJobTarget(const Napi::Value& value, TopmostJob* job) {
+    if (!IsWindowArgument(value)) {
+        return false;
+    }
+    job->windows.push_back(value.IsString() ? 0 : HandleFromValue(value));
+    job->titles.push_back(value.IsString() ? value.As<Napi::String>().Utf8Value() : std::string());
+    return true;
+}
+
+Napi::Value SubmitTopmostJob(TopmostModule& state, Napi::Env env, TopmostJob job, WatchMode watch,
+                             const TopmostPolicy& policy = TopmostPolicy()) {
+    if (!state.completionTsfn) {
+        state.completionTsfn = CompletionTsfn::New(env, "TopmostCompletion", 0, 1, &state);
+        state.ArmShutdownHook(env);
+        state.topmostWorker.SetCallbacks(ResolveTitleOnWorker, OnTopmostJobDone, &state);
+    }
+    if (state.pendingOps.empty()) {
+        state.completionTsfn.Ref(env);
+    }
+
+    job.id = state.nextJobId++;
+    PendingTopmostOp op = { Napi::Promise::Deferred::New(env), watch, policy };
+    Napi::Promise promise = op.deferred.Promise();
+    state.pendingOps.emplace(job.id, op);
+    state.topmostWorker.Submit(std::move(job));
+    return promise;
+}
+
+// setWindowTopmostAsync(window | [window, ...], topmost) -> Promise<boolean>
+// Resolves true if every window was found and changed. An array is applied as
+// one z-order batch (windows[0] ends up on top), and so are calls that queue
+// up while the worker is busy.
+Napi::Value SetWindowTopmostAsync(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    Napi::Array windowList = Napi::Array::New(env);
-    
-    struct EnumData {
-        Napi::Env env;
-        Napi::Array* array;
-        uint32_t index;
-    };
-    
-    EnumData enumData = { env, &windowList, 0 };
-    
-    EnumWindows([](HWND hwnd, LPARAM lParam) -> BOOL {
-        EnumData* data = reinterpret_cast<EnumData*>(lParam);
-        
-        if (IsWindowVisible(hwnd)) {
-            // Try both ANSI and Unicode
-            char windowTextA[512];
-            wchar_t windowTextW[512];
-            GetWindowTextA(hwnd, windowTextA, sizeof(windowTextA));
-            GetWindowTextW(hwnd, windowTextW, sizeof(windowTextW)/sizeof(wchar_t));
-            
-            std::string title;
-            
-            // Prefer Unicode title with UTF-8 conversion
-            if (wcslen(windowTextW) > 0) {
-                int utf8Length = WideCharToMultiByte(CP_UTF8, 0, windowTextW, -1, NULL, 0, NULL, NULL);
-                if (utf8Length > 0) {
-                    std::vector<char> utf8Buffer(utf8Length);
-                    WideCharToMultiByte(CP_UTF8, 0, windowTextW, -1, utf8Buffer.data(), utf8Length, NULL, NULL);
-                    title = std::string(utf8Buffer.data());
-                }
-            } else if (strlen(windowTextA) > 0) {
-                title = std::string(windowTextA);
-            }
-            
-            if (!title.empty()) {
-                Napi::Object windowInfo = Napi::Object::New(data->env);
-                windowInfo.Set("title", Napi::String::New(data->env, title));
-                windowInfo.Set("handle", Napi::Number::New(data->env, reinterpret_cast<uintptr_t>(hwnd)));
-                
-                data->array->Set(data->index++, windowInfo);
+
+    if (info.Length() < 2 || !info[1].IsBoolean() || !(IsWindowArgument(info[0]) || info[0].IsArray())) {
+        Napi::TypeError::New(env, "Window (or array of windows) and boolean topmost flag required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    TopmostJob job;
+    job.topmost = info[1].As<Napi::Boolean>().Value();
+    if (info[0].IsArray()) {
+        Napi::Array windows = info[0].As<Napi::Array>();
+        for (uint32_t i = 0; i < windows.Length(); i++) {
+            if (!AddJobTarget(windows.Get(i), &job)) {
+                Napi::TypeError::New(env, "Window handle or title string required").ThrowAsJavaScriptException();
+                return env.Null();
             }
         }
-        
-        return TRUE;
-    }, reinterpret_cast<LPARAM>(&enumData));
-    
+    } else {
+        AddJobTarget(info[0], &job);
+    }
+    return SubmitTopmostJob(State(info), env, std::move(job), kWatchNone);
+}
+
+// startWindowMonitoringAsync(window) -> Promise<boolean>
+// Lookup and raise happen on the worker; the watcher starts once they succeed.
+Napi::Value StartWindowMonitoringAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !IsWindowArgument(info[0])) {
+        Napi::TypeError::New(env, "Window handle or title string required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    TopmostJob job;
+    job.topmost = true;
+    AddJobTarget(info[0], &job);
+    return SubmitTopmostJob(State(info), env, std::move(job), kWatchReplace);
+}
+
+// watchWindowAsync(window, policy?) -> Promise<boolean>
+// watchWindow() with the lookup and raise on the worker
+Napi::Value WatchWindowAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !IsWindowArgument(info[0])) {
+        Napi::TypeError::New(env, "Window handle or title string required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    TopmostPolicy policy;
+    if (!ParsePolicy(env, info.Length() > 1 ? info[1] : env.Undefined(), &policy)) {
+        return env.Null();
+    }
+
+    TopmostJob job;
+    job.topmost = true;
+    AddJobTarget(info[0], &job);
+    return SubmitTopmostJob(State(info), env, std::move(job), kWatchAdd, policy);
+}
+
+// Get list of all visible windows (for debugging)
+Napi::Value GetVisibleWindowList(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    std::vector<WindowInfo> windows = GetVisibleWindows();
+    Napi::Array windowList = Napi::Array::New(env, windows.size());
+
+    for (size_t i = 0; i < windows.size(); i++) {
+        Napi::Object windowInfo = Napi::Object::New(env);
+        windowInfo.Set("title", Napi::String::New(env, windows[i].title));
+        windowInfo.Set("handle", Napi::Number::New(env, static_cast<double>(windows[i].handle)));
+        windowList.Set(static_cast<uint32_t>(i), windowInfo);
+    }
+
     return windowList;
 }
 
+// Enumerates and packs on a libuv worker thread; the JS thread only copies
+// the finished block into an ArrayBuffer. (Electron's V8 memory cage forbids
+// external ArrayBuffers, so the block cannot be handed over without that copy.)
+class WindowSnapshotWorker : public Napi::AsyncWorker {
+public:
+    explicit WindowSnapshotWorker(Napi::Env env)
+        : Napi::AsyncWorker(env), deferred_(Napi::Promise::Deferred::New(env)) {}
+
+    Napi::Promise GetPromise() { return deferred_.Promise(); }
+
+protected:
+    void Execute() override {
+        PackWindowSnapshot(GetWindowSnapshot(), &packed_);
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        Napi::ArrayBuffer buffer = Napi::ArrayBuffer::New(env, packed_.size());
+        memcpy(buffer.Data(), packed_.data(), packed_.size());
+        deferred_.Resolve(buffer);
+    }
+
+    void OnError(const Napi::Error& error) override {
+        deferred_.Reject(error.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred_;
+    std::vector<uint8_t> packed_;
+};
+
+// getWindowSnapshot() -> Promise<ArrayBuffer>; layout in window_snapshot.h
+Napi::Value GetWindowSnapshotAsync(const Napi::CallbackInfo& info) {
+    WindowSnapshotWorker* worker = new WindowSnapshotWorker(info.Env());
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+// Match many title patterns in one enumeration.
+// findWindows([pattern | { pattern, mode: 'substring'|'prefix'|'regex' }, ...])
+// returns one array of { handle, title } per pattern, in z-order.
+Napi::Value FindWindows(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Array of title patterns required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Array patterns = info[0].As<Napi::Array>();
+    TitleMatcher matcher;
+    for (uint32_t i = 0; i < patterns.Length(); i++) {
+        Napi::Value entry = patterns.Get(i);
+        std::string pattern;
+        TitleMatchMode mode = kTitleMatchSubstring;
+
+        if (entry.IsString()) {
+            pattern = entry.As<Napi::String>().Utf8Value();
+        } else if (entry.IsObject() && entry.As<Napi::Object>().Get("pattern").IsString()) {
+            Napi::Object object = entry.As<Napi::Object>();
+            pattern = object.Get("pattern").As<Napi::String>().Utf8Value();
+            Napi::Value modeValue = object.Get("mode");
+            std::string modeName = modeValue.IsString() ? modeValue.As<Napi::String>().Utf8Value() : "substring";
+            if (modeName == "prefix") {
+                mode = kTitleMatchPrefix;
+            } else if (modeName == "regex") {
+                mode = kTitleMatchRegex;
+            } else if (modeName != "substring") {
+                Napi::TypeError::New(env, "Unknown match mode: " + modeName).ThrowAsJavaScriptException();
+                return env.Null();
+            }
+        } else {
+            Napi::TypeError::New(env, "Pattern must be a string or { pattern, mode }").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        matcher.AddPattern(pattern, mode);
+    }
+    matcher.Compile();
+
+    std::vector<WindowInfo> windows = GetVisibleWindows();
+    std::vector<std::vector<uint32_t>> perPattern(matcher.PatternCount());
+    std::vector<uint32_t> matched;
+    for (uint32_t w = 0; w < windows.size(); w++) {
+        matched.clear();
+        matcher.Match(windows[w].title, &matched);
+        for (uint32_t patternId : matched) {
+            perPattern[patternId].push_back(w);
+        }
+    }
+
+    Napi::Array result = Napi::Array::New(env, perPattern.size());
+    for (size_t p = 0; p < perPattern.size(); p++) {
+        Napi::Array hits = Napi::Array::New(env, perPattern[p].size());
+        for (size_t i = 0; i < perPattern[p].size(); i++) {
+            const WindowInfo& window = windows[perPattern[p][i]];
+            Napi::Object windowInfo = Napi::Object::New(env);
+            windowInfo.Set("title", Napi::String::New(env, window.title));
+            windowInfo.Set("handle", Napi::Number::New(env, static_cast<double>(window.handle)));
+            hits.Set(static_cast<uint32_t>(i), windowInfo);
+        }
+        result.Set(static_cast<uint32_t>(p), hits);
+    }
+    return result;
+}
+
 // Force window to foreground (additional utility function)
-Napi::Value BringWindowToForeground(const Napi::CallbackInfo& info) {
+Napi::Value BringWindowToFront(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    
-    if (info.Length() < 1 || !info[0].IsString()) {
-        Napi::TypeError::New(env, "Window title string required").ThrowAsJavaScriptException();
+
+    if (info.Length() < 1 || !IsWindowArgument(info[0])) {
+        Napi::TypeError::New(env, "Window handle or title string required").ThrowAsJavaScriptException();
         return env.Null();
     }
-    
-    std::string windowTitle = info[0].As<Napi::String>().Utf8Value();
-    HWND targetWindow = FindWindowByTitle(windowTitle);
-    
+
+    WindowHandle targetWindow = ResolveWindow(info[0]);
+
     if (!targetWindow) {
         return Napi::Boolean::New(env, false);
     }
-    
-    // Multiple techniques to bring window to foreground
-    bool success = false;
-    
-    // Method 1: Standard approach
-    if (SetForegroundWindow(targetWindow)) {
-        success = true;
-    }
-    
-    // Method 2: Alternative approach for stubborn windows
-    if (!success) {
-        DWORD currentThreadId = GetCurrentThreadId();
-        DWORD targetThreadId = GetWindowThreadProcessId(targetWindow, NULL);
-        
-        AttachThreadInput(currentThreadId, targetThreadId, TRUE);
-        SetForegroundWindow(targetWindow);
-        AttachThreadInput(currentThreadId, targetThreadId, FALSE);
-        success = true;
-    }
-    
-    // Method 3: Force show and activate
-    ShowWindow(targetWindow, SW_SHOW);
-    SetActiveWindow(targetWindow);
-    
-    return Napi::Boolean::New(env, success);
+
+    return Napi::Boolean::New(env, BringWindowToForeground(targetWindow));
+}
+
+// Watcher counters; latencies in microseconds like the shortcut module
+Napi::Value GetMonitorStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    TopmostModule& state = State(info);
+    Napi::Object result = Napi::Object::New(env);
+
+    TopmostWatcherStats stats = state.watcher ? state.watcher->Stats() : TopmostTargetSet().Stats();
+    result.Set("running", Napi::Boolean::New(env, state.watcher && state.watcher->IsRunning()));
+    result.Set("hidden", Napi::Boolean::New(env, stats.hidden));
+    result.Set("windows", Napi::Number::New(env, stats.windows));
+    result.Set("events", Napi::Number::New(env, static_cast<double>(stats.events)));
+    result.Set("checks", Napi::Number::New(env, static_cast<double>(stats.checks)));
+    result.Set("reRaises", Napi::Number::New(env, static_cast<double>(stats.reRaises)));
+    result.Set("throttled", Napi::Number::New(env, static_cast<double>(stats.throttled)));
+    result.Set("backoffs", Napi::Number::New(env, static_cast<double>(stats.backoffs)));
+    result.Set("hides", Napi::Number::New(env, static_cast<double>(stats.hides)));
+
+    std::vector<TopmostTargetStats> targetStats;
+    if (state.watcher) {
+        targetStats = state.watcher->TargetStats();
+    }
+    Napi::Array targets = Napi::Array::New(env, targetStats.size());
+    for (size_t i = 0; i < targetStats.size(); i++) {
+        const TopmostTargetStats& target = targetStats[i];
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("handle", Napi::Number::New(env, static_cast<double>(target.window)));
+        entry.Set("priority", Napi::Number::New(env, target.policy.priority));
+        entry.Set("raiseBudget", Napi::Number::New(env, target.policy.raiseBudget));
+        entry.Set("backoffMs", Napi::Number::New(env, target.policy.backoffMs));
+        entry.Set("reRaises", Napi::Number::New(env, static_cast<double>(target.reRaises)));
+        entry.Set("throttled", Napi::Number::New(env, static_cast<double>(target.throttled)));
+        entry.Set("backoffs", Napi::Number::New(env, static_cast<double>(target.backoffs)));
+        entry.Set("hides", Napi::Number::New(env, static_cast<double>(target.hides)));
+        entry.Set("hidden", Napi::Boolean::New(env, target.hidden));
+        entry.Set("backingOff", Napi::Boolean::New(env, target.backingOff));
+        targets.Set(static_cast<uint32_t>(i), entry);
+    }
+    result.Set("targets", targets);
+
+    Napi::Object reaction = Napi::Object::New(env);
+    reaction.Set("count", Napi::Number::New(env, static_cast<double>(stats.reaction.count)));
+    reaction.Set("min", Napi::Number::New(env, stats.reaction.min / 1000.0));
+    reaction.Set("max", Napi::Number::New(env, stats.reaction.max / 1000.0));
+    reaction.Set("mean", Napi::Number::New(env, stats.reaction.mean / 1000.0));
+    reaction.Set("p50", Napi::Number::New(env, stats.reaction.p50 / 1000.0));
+    reaction.Set("p90", Napi::Number::New(env, stats.reaction.p90 / 1000.0));
+    reaction.Set("p99", Napi::Number::New(env, stats.reaction.p99 / 1000.0));
+    reaction.Set("p999", Napi::Number::New(env, stats.reaction.p999 / 1000.0));
+    result.Set("reaction", reaction);
+
+    WindowTitleCacheStats cacheStats = titleCache.Stats();
+    Napi::Object cache = Napi::Object::New(env);
+    cache.Set("hits", Napi::Number::New(env, static_cast<double>(cacheStats.hits)));
+    cache.Set("misses", Napi::Number::New(env, static_cast<double>(cacheStats.misses)));
+    cache.Set("invalidations", Napi::Number::New(env, static_cast<double>(cacheStats.invalidations)));
+    cache.Set("entries", Napi::Number::New(env, static_cast<double>(cacheStats.entries)));
+    result.Set("titleCache", cache);
+
+    TopmostWorkerStats workerStats = state.topmostWorker.Stats();
+    Napi::Object worker = Napi::Object::New(env);
+    worker.Set("jobs", Napi::Number::New(env, static_cast<double>(workerStats.jobs)));
+    worker.Set("batches", Napi::Number::New(env, static_cast<double>(workerStats.batches)));
+    worker.Set("retries", Napi::Number::New(env, static_cast<double>(workerStats.retries)));
+    result.Set("worker", worker);
+
+    return result;
 }
 
-// Module initialization
-Napi::Object Init(Napi::Env env, Napi::Object exports) {
-    exports.Set("startWindowMonitoring", Napi::Function::New(env, StartWindowMonitoring));
-    exports.Set("stopWindowMonitoring", Napi::Function::New(env, StopWindowMonitoring));
-    exports.Set("setWindowTopmost", Napi::Function::New(env, SetWindowTopmost));
-    exports.Set("getVisibleWindows", Napi::Function::New(env, GetVisibleWindows));
-    exports.Set("bringWindowToForeground", Napi::Function::New(env, BringWindowToForeground));
-    
-    return exports;
+Napi::Value ResetMonitorStats(const Napi::CallbackInfo& info) {
+    TopmostModule& state = State(info);
+    if (state.watcher) {
+        state.watcher->ResetStats();
+    }
+    return info.Env().Undefined();
 }
 
-NODE_API_MODULE(high_priority_topmost, Init)
\ No newline at end of file
+} // namespace
+
+RuntimeModule* CreateTopmostModule(Napi::Env env, Napi::Object exports) {
+    TopmostModule* state = new TopmostModule();
+    exports.Set("startWindowMonitoring", Napi::Function::New(env, StartWindowMonitoring, "startWindowMonitoring", state));
+    exports.Set("stopWindowMonitoring", Napi::Function::New(env, StopWindowMonitoring, "stopWindowMonitoring", state));
+    exports.Set("setWindowTopmost", Napi::Function::New(env, SetWindowTopmost, "setWindowTopmost", state));
+    exports.Set("startWindowMonitoringAsync", Napi::Function::New(env, StartWindowMonitoringAsync, "startWindowMonitoringAsync", state));
+    exports.Set("setWindowTopmostAsync", Napi::Function::New(env, SetWindowTopmostAsync, "setWindowTopmostAsync", state));
+    exports.Set("watchWindow", Napi::Function::New(env, WatchWindowSync, "watchWindow", state));
+    exports.Set("watchWindowAsync", Napi::Function::New(env, WatchWindowAsync, "watchWindowAsync", state));
+    exports.Set("unwatchWindow", Napi::Function::New(env, UnwatchWindow, "unwatchWindow", state));
+    exports.Set("getVisibleWindows", Napi::Function::New(env, GetVisibleWindowList, "getVisibleWindows", state));
+    exports.Set("getWindowSnapshot", Napi::Function::New(env, GetWindowSnapshotAsync, "getWindowSnapshot", state));
+    exports.Set("findWindows", Napi::Function::New(env, FindWindows, "findWindows", state));
+    exports.Set("bringWindowToForeground", Napi::Function::New(env, BringWindowToFront, "bringWindowToForeground", state));
+    exports.Set("getMonitorStats", Napi::Function::New(env, GetMonitorStats, "getMonitorStats", state));
+    exports.Set("resetMonitorStats", Napi::Function::New(env, ResetMonitorStats, "resetMonitorStats", state));
+    return state;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "shortcut_core.h"
+
+// Source of raw keyboard / mouse-button transitions for a ShortcutEngine.
+//
+// A backend owns whatever thread or hook delivers input on its platform and
+// calls engine->HandleKey / HandleMouseButton from exactly one thread (the
+// event queue has a single producer). Returning true from those calls means
+// the event matched a binding and the backend should swallow it. Each raw
+// event is bracketed with engine->BeginTrace / EndTrace so input traces see
+// it before any filtering.
+//
+// The delivering thread does nothing but match and enqueue, and runs at
+// elevated priority where the OS allows it. An InputWatchdog periodically
+// calls CheckHealth() from its own thread; the backend checks what it can
+// see without injecting input (a failed install, a lost device) and
+// reinstalls / reopens it.
+//
+// Mouse side buttons come through the full mouse stream by default
+// (WH_MOUSE_LL, or grabbed / unmasked devices), so a bound button is
+// swallowed and neither the game nor the browser's Back/Forward sees it, at
+// the cost of handling every move. mouseHook = false opts into a
+// button-only path instead: Raw Input on Windows, event-masked devices on
+// evdev. Pointer motion then never passes through the input thread
+// synchronously (Windows) or at all (evdev), but the buttons are only
+// observed, not swallowed.
+
+struct InputBackendOptions {
+    // evdev: take exclusive access to the devices and re-inject unmatched
+    // events through a uinput passthrough device. Ignored on Windows, where
+    // the low-level hooks can already swallow individual events.
+    bool grab;
+
+    // Route the whole mouse stream through the input thread so bound side
+    // buttons can be swallowed; false = observe them only (see above)
+    bool mouseHook;
+
+    // evdev: read only this device node instead of scanning /dev/input
+    // (used with a uinput loopback device in benchmarks)
+    std::string devicePath;
+
+    InputBackendOptions() : grab(false), mouseHook(true) {}
+};
+
+// Hook / device health as seen by the watchdog
+struct InputBackendHealth {
+    uint64_t probes;          // evdev: rescans for lost devices
+    uint64_t failures;        // hook found removed, device lost
+    uint64_t reinstalls;      // hooks reinstalled, devices reopened
+    uint64_t events;          // raw events the input thread handled, bound or not
+    uint64_t cpuNs;           // input thread CPU time
+    bool mouseTakenOver;      // Win32 raw input: another window of the process holds the mouse
+    bool elevatedPriority;    // input thread runs above normal priority
+    bool realtimePriority;    // ... in a realtime class (SCHED_FIFO / TIME_CRITICAL)
+};
+
+// Written by the input and watchdog threads, read from JS
+struct InputBackendCounters {
+    std::atomic<uint64_t> probes;
+    std::atomic<uint64_t> failures;
+    std::atomic<uint64_t> reinstalls;
+    std::atomic<uint64_t> events;
+    std::atomic<bool> mouseTakenOver;
+    std::atomic<bool> elevatedPriority;
+    std::atomic<bool> realtimePriority;
+
+    InputBackendCounters()
+        : probes(0), failures(0), reinstalls(0), events(0), mouseTakenOver(false), elevatedPriority(false),
+          realtimePriority(false) {}
+
+    InputBackendHealth Snapshot() const {
+        InputBackendHealth health;
+        health.probes = probes.load(std::memory_order_relaxed);
+        health.failures = failures.load(std::memory_order_relaxed);
+        health.reinstalls = reinstalls.load(std::memory_order_relaxed);
+        health.events = events.load(std::memory_order_relaxed);
+        health.cpuNs = 0;
+        health.mouseTakenOver = mouseTakenOver.load(std::memory_order_relaxed);
+        health.elevatedPriority = elevatedPriority.load(std::memory_order_relaxed);
+        health.realtimePriority = realtimePriority.load(std::memory_order_relaxed);
+        return health;
+    }
+};
+
+class InputBackend {
+public:
+    virtual ~InputBackend() {}
+
+    virtual const char* Name() const = 0;
+    // Stamped into input traces so a replay knows what the codes mean
+    virtual InputTracePlatform TracePlatform() const { return kTracePlatformUnknown; }
+
+    // Installs hooks / opens devices for the bindings currently in the engine
+    virtual bool Start(ShortcutEngine* engine, const InputBackendOptions& options) = 0;
+    virtual void Stop() = 0;
+
+    virtual bool KeyboardActive() const = 0;
+    virtual bool MouseActive() const = 0;
+
+    // Watchdog thread, only while started: reinstall the hooks / reopen the
+    // devices found failed or lost
+    virtual void CheckHealth(uint64_t) {}
+    virtual InputBackendHealth Health() const { return InputBackendCounters().Snapshot(); }
+
+    // True if the running backend already delivers everything `table` needs,
+    // so new bindings can be published without Stop()/Start()
+    virtual bool CanSwapBindings(const ShortcutTable& table, const InputBackendOptions&) const {
+        return (!table.HasKeyBindings() || KeyboardActive()) &&
+               (!table.HasMouseBindings() || MouseActive());
+    }
+};
+
+// Implemented once per platform (input_backend_win32.cc, input_backend_evdev.cc, ...)
+InputBackend* CreatePlatformInputBackend();
@@ -0,0 +1,593 @@
+#include "input_backend_evdev.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "trace_events.h"
+
+namespace {
+
+const char* const kPassthroughName = "teyvat-shortcut-passthrough";
+
+// Reader thread priority: low in the SCHED_FIFO range (it only matches and
+// enqueues), else this nice value
+const int kReaderFifoPriority = 10;
+const int kReaderNice = -10;
+
+// Lost devices are looked for again at most this often
+const uint64_t kRescanIntervalNs = 2000000000ull;
+
+const size_t kKeyBitsLongs = (KEY_MAX + 8 * sizeof(long)) / (8 * sizeof(long));
+
+bool TestBit(const unsigned long* bits, unsigned int bit) {
+    return (bits[bit / (8 * sizeof(long))] >> (bit % (8 * sizeof(long)))) & 1;
+}
+
+struct KeyMapping {
+    uint16_t code;
+    uint32_t vk;
+};
+
+const KeyMapping kKeyMappings[] = {
+    { KEY_A, 'A' }, { KEY_B, 'B' }, { KEY_C, 'C' }, { KEY_D, 'D' }, { KEY_E, 'E' },
+    { KEY_F, 'F' }, { KEY_G, 'G' }, { KEY_H, 'H' }, { KEY_I, 'I' }, { KEY_J, 'J' },
+    { KEY_K, 'K' }, { KEY_L, 'L' }, { KEY_M, 'M' }, { KEY_N, 'N' }, { KEY_O, 'O' },
+    { KEY_P, 'P' }, { KEY_Q, 'Q' }, { KEY_R, 'R' }, { KEY_S, 'S' }, { KEY_T, 'T' },
+    { KEY_U, 'U' }, { KEY_V, 'V' }, { KEY_W, 'W' }, { KEY_X, 'X' }, { KEY_Y, 'Y' },
+    { KEY_Z, 'Z' },
+    { KEY_0, '0' }, { KEY_1, '1' }, { KEY_2, '2' }, { KEY_3, '3' }, { KEY_4, '4' },
+    { KEY_5, '5' }, { KEY_6, '6' }, { KEY_7, '7' }, { KEY_8, '8' }, { KEY_9, '9' },
+    { KEY_F1, VK_F1 + 0 }, { KEY_F2, VK_F1 + 1 }, { KEY_F3, VK_F1 + 2 }, { KEY_F4, VK_F1 + 3 },
+    { KEY_F5, VK_F1 + 4 }, { KEY_F6, VK_F1 + 5 }, { KEY_F7, VK_F1 + 6 }, { KEY_F8, VK_F1 + 7 },
+    { KEY_F9, VK_F1 + 8 }, { KEY_F10, VK_F1 + 9 }, { KEY_F11, VK_F1 + 10 }, { KEY_F12, VK_F1 + 11 },
+    { KEY_F13, VK_F1 + 12 }, { KEY_F14, VK_F1 + 13 }, { KEY_F15, VK_F1 + 14 }, { KEY_F16, VK_F1 + 15 },
+    { KEY_F17, VK_F1 + 16 }, { KEY_F18, VK_F1 + 17 }, { KEY_F19, VK_F1 + 18 }, { KEY_F20, VK_F1 + 19 },
+    { KEY_F21, VK_F1 + 20 }, { KEY_F22, VK_F1 + 21 }, { KEY_F23, VK_F1 + 22 }, { KEY_F24, VK_F1 + 23 },
+    { KEY_INSERT, VK_INSERT }, { KEY_DELETE, VK_DELETE }, { KEY_HOME, VK_HOME }, { KEY_END, VK_END },
+    { KEY_PAGEUP, VK_PRIOR }, { KEY_PAGEDOWN, VK_NEXT },
+    { KEY_UP, VK_UP }, { KEY_DOWN, VK_DOWN }, { KEY_LEFT, VK_LEFT }, { KEY_RIGHT, VK_RIGHT },
+    { KEY_SPACE, VK_SPACE }, { KEY_TAB, VK_TAB }, { KEY_ENTER, VK_RETURN }, { KEY_ESC, VK_ESCAPE },
+    { KEY_BACKSPACE, VK_BACK }, { KEY_CAPSLOCK, VK_CAPITAL }, { KEY_NUMLOCK, VK_NUMLOCK },
+    { KEY_SCROLLLOCK, VK_SCROLL }, { KEY_SYSRQ, VK_SNAPSHOT }, { KEY_PAUSE, VK_PAUSE },
+    { KEY_COMPOSE, VK_APPS },
+    { KEY_KP0, VK_NUMPAD0 }, { KEY_KP1, VK_NUMPAD1 }, { KEY_KP2, VK_NUMPAD2 }, { KEY_KP3, VK_NUMPAD3 },
+    { KEY_KP4, VK_NUMPAD4 }, { KEY_KP5, VK_NUMPAD5 }, { KEY_KP6, VK_NUMPAD6 }, { KEY_KP7, VK_NUMPAD7 },
+    { KEY_KP8, VK_NUMPAD8 }, { KEY_KP9, VK_NUMPAD9 },
+    { KEY_KPASTERISK, VK_MULTIPLY }, { KEY_KPPLUS, VK_ADD }, { KEY_KPMINUS, VK_SUBTRACT },
+    { KEY_KPDOT, VK_DECIMAL }, { KEY_KPSLASH, VK_DIVIDE },
+    { KEY_VOLUMEUP, VK_VOLUME_UP }, { KEY_VOLUMEDOWN, VK_VOLUME_DOWN }, { KEY_MUTE, VK_VOLUME_MUTE },
+    { KEY_NEXTSONG, VK_MEDIA_NEXT_TRACK }, { KEY_PREVIOUSSONG, VK_MEDIA_PREV_TRACK },
+    { KEY_PLAYPAUSE, VK_MEDIA_PLAY_PAUSE }, { KEY_STOPCD, VK_MEDIA_STOP },
+    { KEY_GRAVE, VK_OEM_3 }, { KEY_MINUS, VK_OEM_MINUS }, { KEY_EQUAL, VK_OEM_PLUS },
+    { KEY_LEFTBRACE, VK_OEM_4 }, { KEY_RIGHTBRACE, VK_OEM_6 }, { KEY_BACKSLASH, VK_OEM_5 },
+    { KEY_SEMICOLON, VK_OEM_1 }, { KEY_APOSTROPHE, VK_OEM_7 }, { KEY_COMMA, VK_OEM_COMMA },
+    { KEY_DOT, VK_OEM_PERIOD }, { KEY_SLASH, VK_OEM_2 },
+    { KEY_LEFTSHIFT, VK_LSHIFT }, { KEY_RIGHTSHIFT, VK_RSHIFT },
+    { KEY_LEFTCTRL, VK_LCONTROL }, { KEY_RIGHTCTRL, VK_RCONTROL },
+    { KEY_LEFTALT, VK_LMENU }, { KEY_RIGHTALT, VK_RMENU },
+    { KEY_LEFTMETA, VK_LWIN }, { KEY_RIGHTMETA, VK_RWIN },
+};
+
+// Dense KEY_* -> VK lookup, built once
+struct EvdevKeyTable {
+    uint8_t vk[KEY_MAX + 1];
+
+    EvdevKeyTable() {
+        memset(vk, 0, sizeof(vk));
+        for (const KeyMapping& mapping : kKeyMappings) {
+            vk[mapping.code] = static_cast<uint8_t>(mapping.vk);
+        }
+    }
+};
+
+const EvdevKeyTable keyTable;
+
+uint64_t MonotonicNowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+} // namespace
+
+uint32_t EvdevKeyToVk(uint16_t code) {
+    return code <= KEY_MAX ? keyTable.vk[code] : 0;
+}
+
+// ---- UinputDevice ----
+
+UinputDevice::UinputDevice() : fd_(-1) {}
+
+UinputDevice::~UinputDevice() {
+    Destroy();
+}
+
+bool UinputDevice::Create(const std::string& name) {
+    Destroy();
+
+    fd_ = open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd_ < 0) {
+        error_ = std::string("open /dev/uinput: ") + strerror(errno);
+        return false;
+    }
+
+    ioctl(fd_, UI_SET_EVBIT, EV_KEY);
+    ioctl(fd_, UI_SET_EVBIT, EV_REL);
+    ioctl(fd_, UI_SET_EVBIT, EV_MSC);
+    ioctl(fd_, UI_SET_EVBIT, EV_SYN);
+    for (int code = KEY_ESC; code < KEY_MAX; code++) {
+        ioctl(fd_, UI_SET_KEYBIT, code);
+    }
+    ioctl(fd_, UI_SET_RELBIT, REL_X);
+    ioctl(fd_, UI_SET_RELBIT, REL_Y);
+    ioctl(fd_, UI_SET_RELBIT, REL_WHEEL);
+    ioctl(fd_, UI_SET_RELBIT, REL_HWHEEL);
+    ioctl(fd_, UI_SET_MSCBIT, MSC_SCAN);
+
+    uinput_setup setup;
+    memset(&setup, 0, sizeof(setup));
+    setup.id.bustype = BUS_VIRTUAL;
+    setup.id.vendor = 0x7e7a;
+    setup.id.product = 0x0001;
+    strncpy(setup.name, name.c_str(), UINPUT_MAX_NAME_SIZE - 1);
+
+    if (ioctl(fd_, UI_DEV_SETUP, &setup) < 0 || ioctl(fd_, UI_DEV_CREATE) < 0) {
+        error_ = std::string("create uinput device: ") + strerror(errno);
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+void UinputDevice::Destroy() {
+    if (fd_ >= 0) {
+        ioctl(fd_, UI_DEV_DESTROY);
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool UinputDevice::Write(const input_event* events, size_t count) {
+    if (fd_ < 0 || count == 0) return fd_ >= 0;
+    ssize_t bytes = write(fd_, events, count * sizeof(input_event));
+    return bytes == static_cast<ssize_t>(count * sizeof(input_event));
+}
+
+bool UinputDevice::Emit(uint16_t type, uint16_t code, int32_t value) {
+    input_event event;
+    memset(&event, 0, sizeof(event));
+    event.type = type;
+    event.code = code;
+    event.value = value;
+    return Write(&event, 1);
+}
+
+bool UinputDevice::Key(uint16_t code, bool down) {
+    input_event events[2];
+    memset(events, 0, sizeof(events));
+    events[0].type = EV_KEY;
+    events[0].code = code;
+    events[0].value = down ? 1 : 0;
+    events[1].type = EV_SYN;
+    events[1].code = SYN_REPORT;
+    return Write(events, 2);
+}
+
+std::string UinputDevice::EventNodePath() const {
+    char sysname[64] = {0};
+    if (fd_ < 0 || ioctl(fd_, UI_GET_SYSNAME(sizeof(sysname)), sysname) < 0) {
+        return std::string();
+    }
+
+    std::string sysDir = std::string("/sys/devices/virtual/input/") + sysname;
+    DIR* dir = opendir(sysDir.c_str());
+    if (!dir) return std::string();
+
+    std::string node;
+    while (dirent* entry = readdir(dir)) {
+        if (strncmp(entry->d_name, "event", 5) == 0) {
+            node = std::string("/dev/input/") + entry->d_name;
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+// ---- EvdevInputBackend ----
+
+EvdevInputBackend::EvdevInputBackend()
+    : engine_(nullptr), epollFd_(-1), stopFd_(-1), rescanFd_(-1), grab_(false), mouseHook_(false),
+      wantKeys_(false), wantButtons_(false), readerClock_(0), keyboardDevices_(0), mouseDevices_(0),
+      lostDevices_(0), lastRescanNs_(0), consumedKeys_(KEY_MAX + 1, false) {}
+
+EvdevInputBackend::~EvdevInputBackend() {
+    Stop();
+}
+
+bool EvdevInputBackend::OpenDevice(const std::string& path, std::string* error) {
+    for (const Device& device : devices_) {
+        if (device.path == path) return false;
+    }
+
+    int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        if (error && error->empty()) *error = path + ": " + strerror(errno);
+        return false;
+    }
+
+    // Never read back our own passthrough device (the evdev LLKHF_INJECTED)
+    char name[256] = {0};
+    ioctl(fd, EVIOCGNAME(sizeof(name) - 1), name);
+    if (strcmp(name, kPassthroughName) == 0) {
+        close(fd);
+        return false;
+    }
+
+    unsigned long keyBits[kKeyBitsLongs];
+    memset(keyBits, 0, sizeof(keyBits));
+    ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits);
+    bool isKeyboard = TestBit(keyBits, KEY_A) && TestBit(keyBits, KEY_SPACE);
+    bool hasSideButtons = TestBit(keyBits, BTN_SIDE) || TestBit(keyBits, BTN_EXTRA);
+
+    bool keyboard = wantKeys_ && isKeyboard;
+    bool mouse = wantButtons_ && hasSideButtons;
+    if (!keyboard && !mouse) {
+        close(fd);
+        return false;
+    }
+
+    // Event timestamps on the same clock as MonotonicNowNs()
+    int clockId = CLOCK_MONOTONIC;
+    ioctl(fd, EVIOCSCLOCKID, &clockId);
+
+    // A mouse alone is only grabbed for mouseHook: the passthrough would
+    // otherwise have to carry all of its motion
+    bool grabbed = grab_ && (keyboard || mouseHook_);
+    if (grabbed && ioctl(fd, EVIOCGRAB, 1) < 0) {
+        if (error) *error = path + ": EVIOCGRAB: " + strerror(errno);
+        close(fd);
+        return false;
+    }
+    if (!grabbed && !(mouse && mouseHook_)) {
+        MaskDevice(fd, keyboard, mouse);
+    }
+
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        close(fd);
+        return false;
+    }
+
+    devices_.push_back(Device{fd, path, keyboard, mouse, grabbed});
+    if (keyboard) keyboardDevices_++;
+    if (mouse) mouseDevices_++;
+    return true;
+}
+
+size_t EvdevInputBackend::ScanDevices(std::string* error) {
+    size_t opened = 0;
+    if (!devicePath_.empty()) {
+        return OpenDevice(devicePath_, error) ? 1 : 0;
+    }
+    DIR* dir = opendir("/dev/input");
+    if (!dir) return 0;
+    while (dirent* entry = readdir(dir)) {
+        if (strncmp(entry->d_name, "event", 5) == 0 &&
+            OpenDevice(std::string("/dev/input/") + entry->d_name, error)) {
+            opened++;
+        }
+    }
+    closedir(dir);
+    return opened;
+}
+
+void EvdevInputBackend::CloseDevice(int fd) {
+    for (size_t i = 0; i < devices_.size(); i++) {
+        if (devices_[i].fd != fd) continue;
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+        if (devices_[i].grabbed) ioctl(fd, EVIOCGRAB, 0);
+        close(fd);
+        if (devices_[i].keyboard) keyboardDevices_--;
+        if (devices_[i].mouse) mouseDevices_--;
+        devices_.erase(devices_.begin() + i);
+        return;
+    }
+}
+
+// Per-fd filter: keys (keyboards) and the side buttons (mice) stay, motion,
+// wheel, absolute axes and scan codes are dropped before they are queued.
+// Kernels without EVIOCSMASK (before 4.4) keep delivering the whole stream.
+void EvdevInputBackend::MaskDevice(int fd, bool keyboard, bool mouse) {
+    unsigned long keyBits[kKeyBitsLongs];
+    memset(keyBits, 0, sizeof(keyBits));
+    if (keyboard) {
+        memset(keyBits, 0xff, sizeof(keyBits));
+    } else if (mouse) {
+        keyBits[BTN_SIDE / (8 * sizeof(long))] |= 1ul << (BTN_SIDE % (8 * sizeof(long)));
+        keyBits[BTN_EXTRA / (8 * sizeof(long))] |= 1ul << (BTN_EXTRA % (8 * sizeof(long)));
+    }
+
+    input_mask mask;
+    mask.type = EV_KEY;
+    mask.codes_size = sizeof(keyBits);
+    mask.codes_ptr = reinterpret_cast<uintptr_t>(keyBits);
+    if (ioctl(fd, EVIOCSMASK, &mask) < 0) {
+        return;
+    }
+    // An empty mask filters every code of the type
+    for (uint32_t type : { EV_REL, EV_ABS, EV_MSC }) {
+        mask.type = type;
+        mask.codes_size = 0;
+        mask.codes_ptr = 0;
+        ioctl(fd, EVIOCSMASK, &mask);
+    }
+}
+
+bool EvdevInputBackend::Start(ShortcutEngine* engine, const InputBackendOptions& options) {
+    Stop();
+    engine_ = engine;
+    grab_ = options.grab;
+    mouseHook_ = options.mouseHook;
+    devicePath_ = options.devicePath;
+    error_.clear();
+
+    const ShortcutTable& table = engine->Table();
+    wantKeys_ = table.HasKeyBindings();
+    wantButtons_ = table.HasMouseBindings();
+    if (!wantKeys_ && !wantButtons_) {
+        return false;
+    }
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    stopFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    rescanFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || stopFd_ < 0 || rescanFd_ < 0) {
+        error_ = std::string("epoll/eventfd: ") + strerror(errno);
+        Stop();
+        return false;
+    }
+    for (int fd : { stopFd_, rescanFd_ }) {
+        epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    // The passthrough must exist before grabbing, or unmatched input is lost
+    if (grab_ && !passthrough_.Create(kPassthroughName)) {
+        error_ = passthrough_.Error();
+        Stop();
+        return false;
+    }
+
+    ScanDevices(&error_);
+    if (devices_.empty()) {
+        if (error_.empty()) error_ = "no matching input devices";
+        Stop();
+        return false;
+    }
+
+    forwardBuffer_.reserve(64);
+    readerThread_ = std::thread(&EvdevInputBackend::ReadLoop, this);
+    if (pthread_getcpuclockid(readerThread_.native_handle(), &readerClock_) != 0) {
+        readerClock_ = 0;
+    }
+    return true;
+}
+
+// The open device set depends on the bindings and options at Start()
+bool EvdevInputBackend::CanSwapBindings(const ShortcutTable& table, const InputBackendOptions& options) const {
+    return readerThread_.joinable() && options.grab == grab_ && options.mouseHook == mouseHook_ &&
+           options.devicePath == devicePath_ &&
+           InputBackend::CanSwapBindings(table, options);
+}
+
+void EvdevInputBackend::Stop() {
+    if (readerThread_.joinable()) {
+        uint64_t one = 1;
+        ssize_t ignored = write(stopFd_, &one, sizeof(one));
+        (void)ignored;
+        readerThread_.join();
+    }
+    readerClock_ = 0;
+
+    for (const Device& device : devices_) {
+        if (device.grabbed) ioctl(device.fd, EVIOCGRAB, 0);
+        close(device.fd);
+    }
+    devices_.clear();
+    keyboardDevices_ = 0;
+    mouseDevices_ = 0;
+    lostDevices_ = 0;
+    lastRescanNs_ = 0;
+
+    if (epollFd_ >= 0) {
+        close(epollFd_);
+        epollFd_ = -1;
+    }
+    if (stopFd_ >= 0) {
+        close(stopFd_);
+        stopFd_ = -1;
+    }
+    if (rescanFd_ >= 0) {
+        close(rescanFd_);
+        rescanFd_ = -1;
+    }
+    passthrough_.Destroy();
+    consumedKeys_.assign(KEY_MAX + 1, false);
+
+    if (engine_) {
+        engine_->ResetModifiers();
+        engine_ = nullptr;
+    }
+}
+
+// Watchdog thread: wake the reader to look for lost devices again
+void EvdevInputBackend::CheckHealth(uint64_t nowNs) {
+    if (lostDevices_.load(std::memory_order_relaxed) <= 0 || nowNs - lastRescanNs_ < kRescanIntervalNs) {
+        return;
+    }
+    lastRescanNs_ = nowNs;
+    counters_.probes.fetch_add(1, std::memory_order_relaxed);
+    uint64_t one = 1;
+    ssize_t ignored = write(rescanFd_, &one, sizeof(one));
+    (void)ignored;
+}
+
+InputBackendHealth EvdevInputBackend::Health() const {
+    InputBackendHealth health = counters_.Snapshot();
+    timespec ts;
+    if (readerClock_ != 0 && clock_gettime(readerClock_, &ts) == 0) {
+        health.cpuNs = static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    }
+    return health;
+}
+
+void EvdevInputBackend::RaiseReaderPriority() {
+    sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = kReaderFifoPriority;
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0) {
+        counters_.elevatedPriority.store(true, std::memory_order_relaxed);
+        counters_.realtimePriority.store(true, std::memory_order_relaxed);
+        return;
+    }
+    // Per-thread on Linux: the nice value applies to the tid
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), kReaderNice) == 0) {
+        counters_.elevatedPriority.store(true, std::memory_order_relaxed);
+    }
+}
+
+void EvdevInputBackend::ReadLoop() {
+    epoll_event ready[8];
+    input_event events[64];
+    RaiseReaderPriority();
+    SetTraceThreadName("shortcut input");
+
+    for (;;) {
+        int n = epoll_wait(epollFd_, ready, 8, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int fd = ready[i].data.fd;
+            if (fd == stopFd_) {
+                return;
+            }
+            if (fd == rescanFd_) {
+                uint64_t value;
+                ssize_t ignored = read(rescanFd_, &value, sizeof(value));
+                (void)ignored;
+                int found = static_cast<int>(ScanDevices(nullptr));
+                if (found > 0) {
+                    int lost = lostDevices_.load(std::memory_order_relaxed);
+                    lostDevices_.store(found >= lost ? 0 : lost - found, std::memory_order_relaxed);
+                    counters_.reinstalls.fetch_add(static_cast<uint64_t>(found), std::memory_order_relaxed);
+                }
+                continue;
+            }
+            if (ready[i].events & (EPOLLHUP | EPOLLERR)) {
+                // Device unplugged or revoked; the watchdog has it looked for again
+                CloseDevice(fd);
+                lostDevices_.fetch_add(1, std::memory_order_relaxed);
+                counters_.failures.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            bool forward = false;
+            for (const Device& device : devices_) {
+                if (device.fd == fd) forward = device.grabbed;
+            }
+            ssize_t bytes;
+            while ((bytes = read(fd, events, sizeof(events))) > 0) {
+                size_t count = static_cast<size_t>(bytes) / sizeof(input_event);
+                counters_.events.fetch_add(count, std::memory_order_relaxed);
+                ProcessEvents(events, count, forward);
+            }
+        }
+    }
+}
+
+// forward: the events come from a grabbed device and whatever is not
+// consumed is re-injected
+void EvdevInputBackend::ProcessEvents(const input_event* events, size_t count, bool forward) {
+    uint64_t now = MonotonicNowNs();
+    forwardBuffer_.clear();
+
+    for (size_t i = 0; i < count; i++) {
+        const input_event& event = events[i];
+        bool consumed = false;
+
+        if (event.type == EV_KEY) {
+            uint64_t eventNs = static_cast<uint64_t>(event.input_event_sec) * 1000000000ull +
+                               static_cast<uint64_t>(event.input_event_usec) * 1000ull;
+            uint64_t osDelay = now > eventNs ? now - eventNs : 0;
+            uint32_t osTime = static_cast<uint32_t>(eventNs / 1000000ull);
+            // value: 0 release, 1 press, 2 autorepeat (a repeated key-down, as on Windows)
+            bool down = event.value != 0;
+
+            if (event.code == BTN_SIDE || event.code == BTN_EXTRA) {
+                uint32_t button = event.code == BTN_SIDE ? kMouseXButton1 : kMouseXButton2;
+                TraceSpan span("input", "evdevButton");
+                InputTraceRecord* traced = engine_->BeginTrace(kTraceMouse, button, down ? kTraceDown : 0,
+                                                               event.code, event.value, osTime, osDelay);
+                consumed = engine_->HandleMouseButton(button, down, osTime, osDelay);
+                engine_->EndTrace(traced, consumed);
+                span.SetArg("consumed", consumed);
+            } else {
+                uint32_t vk = EvdevKeyToVk(event.code);
+                if (vk != 0) {
+                    TraceSpan span("input", "evdevKey");
+                    InputTraceRecord* traced = engine_->BeginTrace(kTraceKey, vk, down ? kTraceDown : 0,
+                                                                   event.code, event.value, osTime, osDelay);
+                    consumed = engine_->HandleKey(vk, down, osTime, osDelay);
+                    engine_->EndTrace(traced, consumed);
+                    span.SetArg("consumed", consumed);
+                }
+            }
+
+            if (event.code <= KEY_MAX) {
+                if (consumed && event.value == 1) {
+                    consumedKeys_[event.code] = true;
+                } else if (consumedKeys_[event.code]) {
+                    // Swallow the repeats and release of a consumed press
+                    consumed = true;
+                    if (event.value == 0) consumedKeys_[event.code] = false;
+                }
+            }
+        }
+
+        if (forward && !consumed) {
+            forwardBuffer_.push_back(event);
+        }
+    }
+
+    if (forward && !forwardBuffer_.empty()) {
+        passthrough_.Write(forwardBuffer_.data(), forwardBuffer_.size());
+    }
+}
+
+InputBackend* CreatePlatformInputBackend() {
+    return new EvdevInputBackend();
+}
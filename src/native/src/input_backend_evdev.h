@@ -0,0 +1,123 @@
+#pragma once
+
+#include <linux/input.h>
+#include <time.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "input_backend.h"
+
+// Linux backend: reads /dev/input/event* through epoll on its own thread.
+//
+// The reader thread asks for SCHED_FIFO and falls back to a negative nice
+// value; without CAP_SYS_NICE (or an rtkit grant) it stays at normal
+// priority. Devices that hang up (unplugged, or revoked on a VT switch)
+// are dropped; the watchdog then has the reader rescan /dev/input until
+// they are back.
+//
+// Without grab the devices are only observed, so matched keys still reach
+// other applications (there is no per-event veto in evdev). With grab the
+// devices are taken with EVIOCGRAB and every event that did not match a
+// binding is re-injected through a uinput passthrough device.
+//
+// Mice are read in full by default (mouseHook), and grabbed with grab so a
+// bound side button can be swallowed. With mouseHook off they are read
+// through an EVIOCSMASK event mask that only lets BTN_SIDE / BTN_EXTRA
+// through, so pointer motion is filtered in the kernel and never wakes the
+// reader (an empty SYN_REPORT is dropped too); they are not grabbed then.
+
+// Translate an evdev KEY_* code to the VK code space of the core (0 if unmapped)
+uint32_t EvdevKeyToVk(uint16_t code);
+
+// Thin wrapper around a /dev/uinput virtual device. Used as the grab
+// passthrough and as a loopback keyboard/mouse for benchmarks.
+class UinputDevice {
+public:
+    UinputDevice();
+    ~UinputDevice();
+
+    // Creates a device that can emit every key, the mouse side buttons and
+    // relative motion. Returns false (and sets Error()) on failure.
+    bool Create(const std::string& name);
+    void Destroy();
+    bool IsOpen() const { return fd_ >= 0; }
+
+    bool Write(const input_event* events, size_t count);
+    bool Emit(uint16_t type, uint16_t code, int32_t value);
+    // Key or button transition followed by SYN_REPORT
+    bool Key(uint16_t code, bool down);
+
+    // /dev/input/eventN node of this device, once udev has created it
+    std::string EventNodePath() const;
+    const std::string& Error() const { return error_; }
+
+private:
+    int fd_;
+    std::string error_;
+};
+
+class EvdevInputBackend : public InputBackend {
+public:
+    EvdevInputBackend();
+    ~EvdevInputBackend() override;
+
+    const char* Name() const override { return "linux-evdev"; }
+    InputTracePlatform TracePlatform() const override { return kTracePlatformEvdev; }
+
+    bool Start(ShortcutEngine* engine, const InputBackendOptions& options) override;
+    void Stop() override;
+
+    bool KeyboardActive() const override { return keyboardDevices_ > 0; }
+    bool MouseActive() const override { return mouseDevices_ > 0; }
+    bool CanSwapBindings(const ShortcutTable& table, const InputBackendOptions& options) const override;
+    void CheckHealth(uint64_t nowNs) override;
+    InputBackendHealth Health() const override;
+
+    const std::string& Error() const { return error_; }
+
+private:
+    struct Device {
+        int fd;
+        std::string path;
+        bool keyboard;
+        bool mouse;
+        bool grabbed;      // EVIOCGRAB held, unmatched events go to the passthrough
+    };
+
+    // error is only filled during Start(); rescans run on the reader thread
+    bool OpenDevice(const std::string& path, std::string* error);
+    // Opens every matching device not open yet; returns how many were added
+    size_t ScanDevices(std::string* error);
+    void CloseDevice(int fd);
+    void MaskDevice(int fd, bool keyboard, bool mouse);
+    void RaiseReaderPriority();
+    void ReadLoop();
+    void ProcessEvents(const input_event* events, size_t count, bool forward);
+
+    ShortcutEngine* engine_;
+    std::vector<Device> devices_;        // reader thread while it runs
+    int epollFd_;
+    int stopFd_;
+    int rescanFd_;                       // watchdog -> reader
+    bool grab_;
+    bool mouseHook_;
+    bool wantKeys_;
+    bool wantButtons_;
+    std::string devicePath_;
+    UinputDevice passthrough_;
+    std::thread readerThread_;
+    clockid_t readerClock_;              // reader thread CPU clock while it runs
+    std::atomic<int> keyboardDevices_;
+    std::atomic<int> mouseDevices_;
+    std::atomic<int> lostDevices_;       // hung up and not found again yet
+    uint64_t lastRescanNs_;              // watchdog thread only
+    InputBackendCounters counters_;
+    std::string error_;
+
+    // Keys whose press was consumed; their repeats and release are swallowed too
+    std::vector<bool> consumedKeys_;
+    std::vector<input_event> forwardBuffer_;
+};
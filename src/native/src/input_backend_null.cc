@@ -0,0 +1,21 @@
+#include "input_backend.h"
+
+// Fallback for platforms without a native backend: the engine still parses
+// and compiles bindings, but no input ever reaches it.
+
+namespace {
+
+class NullInputBackend : public InputBackend {
+public:
+    const char* Name() const override { return "none"; }
+    bool Start(ShortcutEngine*, const InputBackendOptions&) override { return false; }
+    void Stop() override {}
+    bool KeyboardActive() const override { return false; }
+    bool MouseActive() const override { return false; }
+};
+
+} // namespace
+
+InputBackend* CreatePlatformInputBackend() {
+    return new NullInputBackend();
+}
@@ -0,0 +1,555 @@
+#include <windows.h>
+#include <wtsapi32.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "input_backend.h"
+#include "trace_events.h"
+
+// WH_KEYBOARD_LL / WH_MOUSE_LL backend, with RegisterHotKey as a fallback
+// when the keyboard hook cannot be installed.
+//
+// Low-level hooks are called on the thread that installed them, through its
+// message loop, and Windows silently removes a hook that does not return
+// within LowLevelHooksTimeout. So the hooks live on a dedicated
+// time-critical input thread whose loop does nothing but match and enqueue,
+// never on the JS thread. Nothing is ever injected to test them: synthetic
+// input would reset the system idle timer and look like an input bot to
+// anti-cheat. A removed hook cannot be told apart from an idle one, so the
+// hooks are reinstalled after the events that are known to drop them -
+// session unlock / reconnect and resume from sleep, signalled to a
+// message-only window of the input thread - and the watchdog retries an
+// install that failed.
+//
+// Side buttons go through WH_MOUSE_LL, which swallows a bound button before
+// the game or the browser's Back/Forward sees it. options.mouseHook = false
+// opts into Raw Input instead (RIDEV_INPUTSINK on the same window): a
+// low-level mouse hook is called synchronously for every pointer move
+// before any application sees it, while raw input is posted, so moves reach
+// the game without waiting for us and cost one WM_INPUT that returns after
+// a flag test - but the buttons are only observed. The raw input mouse
+// registration is per process and Chromium registers its own (pointer
+// lock, Gamepad / pointer APIs); whoever registers last gets it. We never
+// take it back from another window, that would only start a tug of war:
+// the loss is reported as mouseTakenOver, and the mouse is registered again
+// only once nobody holds it.
+
+namespace {
+
+class Win32InputBackend;
+
+// Hook procs carry no context, so the running backend is kept here
+Win32InputBackend* activeBackend = nullptr;
+
+LRESULT CALLBACK KeyboardHookProc(int nCode, WPARAM wParam, LPARAM lParam);
+LRESULT CALLBACK MouseHookProc(int nCode, WPARAM wParam, LPARAM lParam);
+LRESULT CALLBACK InputWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
+
+const wchar_t* const kInputWindowClass = L"TeyvatShortcutInput";
+const USHORT kUsagePageGeneric = 0x01;
+const USHORT kUsageMouse = 0x02;
+const USHORT kRawSideButtonFlags = RI_MOUSE_BUTTON_4_DOWN | RI_MOUSE_BUTTON_4_UP |
+                                   RI_MOUSE_BUTTON_5_DOWN | RI_MOUSE_BUTTON_5_UP;
+
+// Posted to the input thread by the watchdog
+const UINT kMsgReinstallHooks = WM_APP + 1;
+
+// GetTickCount() based event time -> hook entry delay
+inline uint64_t OsDelayNs(DWORD osTime) {
+    return osTime != 0 ? static_cast<uint64_t>(GetTickCount() - osTime) * 1000000ull : 0;
+}
+
+class Win32InputBackend : public InputBackend {
+public:
+    Win32InputBackend()
+        : engine_(nullptr), keyboardHook_(NULL), mouseHook_(NULL), window_(NULL), powerNotify_(NULL),
+          keyboardHookRunning_(false), mouseHookRunning_(false), rawMouseRunning_(false), hotkeysRunning_(false),
+          wantKeyboard_(false), wantMouse_(false), mouseHookMode_(false), inputThreadHandle_(NULL), inputThreadId_(0) {}
+
+    ~Win32InputBackend() override { Stop(); }
+
+    const char* Name() const override { return "win32-ll-hook"; }
+    InputTracePlatform TracePlatform() const override { return kTracePlatformWin32; }
+
+    bool Start(ShortcutEngine* engine, const InputBackendOptions& options) override {
+        Stop();
+        engine_ = engine;
+        activeBackend = this;
+        mouseHookMode_ = options.mouseHook;
+        const ShortcutTable& table = engine->Table();
+        wantKeyboard_ = table.HasKeyBindings();
+        wantMouse_ = table.HasMouseBindings();
+        if (!wantKeyboard_ && !wantMouse_) {
+            return false;
+        }
+
+        // Recover the keyboard bindings from the table for the RegisterHotKey
+        // fallback, in case the keyboard hook cannot be installed
+        std::vector<HotkeyInfo> hotkeys;
+        if (wantKeyboard_) {
+            hotkeys = CollectHotkeys(table);
+        }
+
+        HANDLE ready = CreateEvent(NULL, TRUE, FALSE, NULL);
+        inputThread_ = std::thread(&Win32InputBackend::InputThread, this, hotkeys, ready);
+        inputThreadHandle_ = inputThread_.native_handle();
+        WaitForSingleObject(ready, INFINITE);
+        CloseHandle(ready);
+
+        return keyboardHookRunning_ || mouseHookRunning_ || rawMouseRunning_ || hotkeysRunning_;
+    }
+
+    void Stop() override {
+        // The input thread unhooks and unregisters everything on its way out
+        if (inputThread_.joinable()) {
+            inputThreadHandle_ = NULL;
+            PostThreadMessage(inputThreadId_, WM_QUIT, 0, 0);
+            inputThread_.join();
+        }
+        inputThreadId_ = 0;
+
+        // Reset modifier key states
+        if (engine_) {
+            engine_->ResetModifiers();
+        }
+        if (activeBackend == this) {
+            activeBackend = nullptr;
+        }
+        engine_ = nullptr;
+    }
+
+    bool KeyboardActive() const override { return keyboardHookRunning_ || hotkeysRunning_; }
+    bool MouseActive() const override { return mouseHookRunning_ || rawMouseRunning_; }
+
+    // RegisterHotKey registrations are fixed at start, so the fallback path
+    // always restarts; so does a change between raw input and the mouse hook
+    bool CanSwapBindings(const ShortcutTable& table, const InputBackendOptions& options) const override {
+        return !hotkeysRunning_ && (!MouseActive() || options.mouseHook == mouseHookMode_) &&
+               InputBackend::CanSwapBindings(table, options);
+    }
+
+    // Watchdog thread. Windows gives no sign when it drops a hook, so this
+    // only covers what can be seen without injecting input: an install
+    // that failed is retried on every check.
+    void CheckHealth(uint64_t) override {
+        if (inputThreadId_ == 0 || hotkeysRunning_) {
+            return;
+        }
+        if (wantMouse_ && !mouseHookMode_ && window_) {
+            HWND owner;
+            if (RawMouseOwner(&owner) && owner != window_) {
+                if (owner) {
+                    // Taken over; its owner will remove the registration on
+                    // its way out, so ours must not
+                    rawMouseRunning_ = false;
+                    MarkMouseTakenOver();
+                } else {
+                    // Released again: registering takes nothing from anyone
+                    PostThreadMessage(inputThreadId_, kMsgReinstallHooks, 0, 0);
+                    return;
+                }
+            }
+        }
+        if ((wantKeyboard_ && !keyboardHookRunning_) || (wantMouse_ && mouseHookMode_ && !mouseHookRunning_)) {
+            PostThreadMessage(inputThreadId_, kMsgReinstallHooks, 0, 0);
+        }
+    }
+
+    // Input thread, from the window: the session was unlocked or
+    // reconnected, or the machine resumed. The secure desktop and sleep are
+    // where low-level hooks get dropped without notice, so replace them.
+    void OnSessionResumed() {
+        if (hotkeysRunning_) {
+            return;
+        }
+        TraceEventInstant("input", "sessionResumed");
+        ReinstallHooks();
+    }
+
+    InputBackendHealth Health() const override {
+        InputBackendHealth health = counters_.Snapshot();
+        HANDLE thread = inputThreadHandle_;
+        FILETIME created, exited, kernel, user;
+        if (thread && GetThreadTimes(thread, &created, &exited, &kernel, &user)) {
+            ULARGE_INTEGER k, u;
+            k.LowPart = kernel.dwLowDateTime;
+            k.HighPart = kernel.dwHighDateTime;
+            u.LowPart = user.dwLowDateTime;
+            u.HighPart = user.dwHighDateTime;
+            health.cpuNs = (k.QuadPart + u.QuadPart) * 100;   // 100 ns units
+        }
+        return health;
+    }
+
+    // GAME-COMPATIBLE KEYBOARD HOOK - BASED ON CSDN RESEARCH!
+    LRESULT OnKeyboard(int nCode, WPARAM wParam, LPARAM lParam) {
+        // CRITICAL: Always process HC_ACTION, ignore nCode < 0 (as per CSDN article)
+        if (nCode == HC_ACTION && keyboardHookRunning_) {
+            KBDLLHOOKSTRUCT* pKeyboard = (KBDLLHOOKSTRUCT*)lParam;
+            counters_.events.fetch_add(1, std::memory_order_relaxed);
+            TraceSpan span("input", "keyboardHook");
+            bool isKeyDown = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
+            bool isKeyUp = (wParam == WM_KEYUP || wParam == WM_SYSKEYUP);
+            bool injected = (pKeyboard->flags & LLKHF_INJECTED) != 0;
+            uint64_t osDelayNs = OsDelayNs(pKeyboard->time);
+
+            // Recorded before filtering, so traces show injected input too
+            InputTraceRecord* traced = engine_->BeginTrace(
+                kTraceKey, pKeyboard->vkCode, (isKeyDown ? kTraceDown : 0) | (injected ? kTraceInjected : 0),
+                pKeyboard->scanCode, pKeyboard->flags, pKeyboard->time, osDelayNs);
+
+            // GAME COMPATIBILITY: Ignore injected events to prevent infinite loops
+            if (injected) {
+                engine_->EndTrace(traced, false);
+                return CallNextHookEx(keyboardHook_, nCode, wParam, lParam);
+            }
+
+            // GAME COMPATIBILITY: Always consume registered shortcuts
+            // This prevents games from receiving our hotkeys
+            bool consumed = (isKeyDown || isKeyUp) &&
+                            engine_->HandleKey(pKeyboard->vkCode, isKeyDown, pKeyboard->time, osDelayNs);
+            engine_->EndTrace(traced, consumed);
+            span.SetArg("consumed", consumed);
+            if (consumed) {
+                return 1;
+            }
+        }
+
+        // CRITICAL: Always call next hook for system stability
+        return CallNextHookEx(keyboardHook_, nCode, wParam, lParam);
+    }
+
+    // Mouse hook procedure (options.mouseHook): called for every move too
+    LRESULT OnMouse(int nCode, WPARAM wParam, LPARAM lParam) {
+        if (nCode >= 0 && mouseHookRunning_) {
+            counters_.events.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (nCode >= 0 && mouseHookRunning_ && (wParam == WM_XBUTTONDOWN || wParam == WM_XBUTTONUP)) {
+            MSLLHOOKSTRUCT* pMouseStruct = (MSLLHOOKSTRUCT*)lParam;
+            WORD xButton = HIWORD(pMouseStruct->mouseData);
+            UINT mouseButton = 0;
+            if (xButton == XBUTTON1) mouseButton = kMouseXButton1; // Mouse side button 1
+            else if (xButton == XBUTTON2) mouseButton = kMouseXButton2; // Mouse side button 2
+
+            TraceSpan span("input", "mouseHook");
+            bool down = wParam == WM_XBUTTONDOWN;
+            uint64_t osDelayNs = OsDelayNs(pMouseStruct->time);
+            InputTraceRecord* traced = engine_->BeginTrace(
+                kTraceMouse, mouseButton,
+                (down ? kTraceDown : 0) | ((pMouseStruct->flags & LLMHF_INJECTED) ? kTraceInjected : 0),
+                xButton, pMouseStruct->flags, pMouseStruct->time, osDelayNs);
+            bool consumed = engine_->HandleMouseButton(mouseButton, down, pMouseStruct->time, osDelayNs);
+            engine_->EndTrace(traced, consumed);
+            span.SetArg("consumed", consumed);
+            if (consumed) {
+                return 1; // Consume this event
+            }
+        }
+        return CallNextHookEx(mouseHook_, nCode, wParam, lParam);
+    }
+
+    // WM_INPUT on the input thread. Moves and the other buttons end at the
+    // flag test; nothing is ever swallowed, so the match result only goes
+    // into the trace.
+    void OnRawInput(HRAWINPUT handle) {
+        RAWINPUT input;
+        UINT size = sizeof(input);
+        if (GetRawInputData(handle, RID_INPUT, &input, &size, sizeof(RAWINPUTHEADER)) == static_cast<UINT>(-1)) {
+            return;
+        }
+        counters_.events.fetch_add(1, std::memory_order_relaxed);
+        if (input.header.dwType != RIM_TYPEMOUSE) {
+            return;
+        }
+        USHORT flags = input.data.mouse.usButtonFlags;
+        if ((flags & kRawSideButtonFlags) == 0) {
+            return;
+        }
+
+        DWORD time = static_cast<DWORD>(GetMessageTime());
+        uint64_t osDelayNs = OsDelayNs(time);
+        const struct {
+            USHORT down;
+            USHORT up;
+            UINT mouseButton;
+            WORD xButton;
+        } buttons[] = {
+            { RI_MOUSE_BUTTON_4_DOWN, RI_MOUSE_BUTTON_4_UP, kMouseXButton1, XBUTTON1 },
+            { RI_MOUSE_BUTTON_5_DOWN, RI_MOUSE_BUTTON_5_UP, kMouseXButton2, XBUTTON2 },
+        };
+        bool injected = input.header.hDevice == NULL;
+        for (const auto& button : buttons) {
+            if ((flags & (button.down | button.up)) == 0) continue;
+            bool down = (flags & button.down) != 0;
+            TraceSpan span("input", "rawMouseButton");
+            InputTraceRecord* traced = engine_->BeginTrace(
+                kTraceMouse, button.mouseButton, (down ? kTraceDown : 0) | (injected ? kTraceInjected : 0),
+                button.xButton, flags, time, osDelayNs);
+            bool matched = engine_->HandleMouseButton(button.mouseButton, down, time, osDelayNs);
+            engine_->EndTrace(traced, matched);
+            span.SetArg("matched", matched);
+        }
+    }
+
+private:
+    struct HotkeyInfo {
+        ActionId actionId;
+        UINT modifiers;
+        UINT vkCode;
+    };
+
+    // hotkey id = index + 1. RegisterHotKey sees single strokes only, so
+    // sequences are left out, and it cannot follow the focus, so only the
+    // default profile is registered.
+    static std::vector<HotkeyInfo> CollectHotkeys(const ShortcutTable& table) {
+        std::vector<HotkeyInfo> hotkeys;
+        for (UINT modifiers = 0; modifiers < kModifierCombinations; modifiers++) {
+            for (UINT vkCode = 1; vkCode < kKeyCodeCount; vkCode++) {
+                ActionId id = table.MatchKey(modifiers, vkCode);
+                if (id != kNoAction && !IsSequenceState(id)) {
+                    hotkeys.push_back({id, modifiers, vkCode});
+                }
+            }
+        }
+        return hotkeys;
+    }
+
+    // Input thread: (re)installs the hooks the bindings need. Raw input is
+    // only registered while no other window of the process holds the mouse.
+    void InstallHooks() {
+        if (wantKeyboard_ && !keyboardHook_) {
+            keyboardHook_ = SetWindowsHookEx(WH_KEYBOARD_LL, KeyboardHookProc, GetModuleHandle(NULL), 0);
+            keyboardHookRunning_ = keyboardHook_ != NULL;
+        }
+        if (wantMouse_ && mouseHookMode_ && !mouseHook_) {
+            mouseHook_ = SetWindowsHookEx(WH_MOUSE_LL, MouseHookProc, GetModuleHandle(NULL), 0);
+            mouseHookRunning_ = mouseHook_ != NULL;
+        }
+        if (wantMouse_ && !mouseHookMode_ && window_) {
+            HWND owner;
+            if (RawMouseOwner(&owner) && owner != NULL && owner != window_) {
+                rawMouseRunning_ = false;
+                MarkMouseTakenOver();
+                return;
+            }
+            RAWINPUTDEVICE device;
+            device.usUsagePage = kUsagePageGeneric;
+            device.usUsage = kUsageMouse;
+            device.dwFlags = RIDEV_INPUTSINK;   // also while another application has the focus
+            device.hwndTarget = window_;
+            rawMouseRunning_ = RegisterRawInputDevices(&device, 1, sizeof(device)) != FALSE;
+            counters_.mouseTakenOver.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    // Counted as a failure once per takeover
+    void MarkMouseTakenOver() {
+        if (!counters_.mouseTakenOver.exchange(true, std::memory_order_relaxed)) {
+            counters_.failures.fetch_add(1, std::memory_order_relaxed);
+            TraceEventInstant("input", "rawMouseTakenOver");
+        }
+    }
+
+    // Input thread: a message-only window to receive WM_INPUT and the
+    // session / power notifications. Without it the hooks still work, they
+    // just are not renewed after an unlock or resume.
+    void CreateInputWindow() {
+        WNDCLASSEXW windowClass;
+        ZeroMemory(&windowClass, sizeof(windowClass));
+        windowClass.cbSize = sizeof(windowClass);
+        windowClass.lpfnWndProc = InputWindowProc;
+        windowClass.hInstance = GetModuleHandle(NULL);
+        windowClass.lpszClassName = kInputWindowClass;
+        // Fails harmlessly when a previous start already registered it
+        RegisterClassExW(&windowClass);
+        window_ = CreateWindowExW(0, kInputWindowClass, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, NULL,
+                                  GetModuleHandle(NULL), NULL);
+        if (window_) {
+            WTSRegisterSessionNotification(window_, NOTIFY_FOR_THIS_SESSION);
+            powerNotify_ = RegisterSuspendResumeNotification(window_, DEVICE_NOTIFY_WINDOW_HANDLE);
+        }
+    }
+
+    void DestroyInputWindow() {
+        if (rawMouseRunning_) {
+            RAWINPUTDEVICE device;
+            device.usUsagePage = kUsagePageGeneric;
+            device.usUsage = kUsageMouse;
+            device.dwFlags = RIDEV_REMOVE;
+            device.hwndTarget = NULL;
+            RegisterRawInputDevices(&device, 1, sizeof(device));
+            rawMouseRunning_ = false;
+        }
+        if (powerNotify_) {
+            UnregisterSuspendResumeNotification(powerNotify_);
+            powerNotify_ = NULL;
+        }
+        if (window_) {
+            WTSUnRegisterSessionNotification(window_);
+            DestroyWindow(window_);
+            window_ = NULL;
+        }
+    }
+
+    // Window the process's raw input mouse registration targets, NULL if
+    // the mouse is not registered. False if that cannot be told.
+    bool RawMouseOwner(HWND* owner) const {
+        RAWINPUTDEVICE devices[16];
+        UINT count = 16;
+        UINT registered = GetRegisteredRawInputDevices(devices, &count, sizeof(RAWINPUTDEVICE));
+        if (registered == static_cast<UINT>(-1)) {
+            return false;   // more than 16 collections registered
+        }
+        *owner = NULL;
+        for (UINT i = 0; i < registered; i++) {
+            if (devices[i].usUsagePage == kUsagePageGeneric && devices[i].usUsage == kUsageMouse) {
+                *owner = devices[i].hwndTarget;
+                break;
+            }
+        }
+        return true;
+    }
+
+    void RemoveHooks() {
+        // Fails harmlessly if Windows already removed the hook
+        if (keyboardHook_) {
+            UnhookWindowsHookEx(keyboardHook_);
+            keyboardHook_ = NULL;
+        }
+        if (mouseHook_) {
+            UnhookWindowsHookEx(mouseHook_);
+            mouseHook_ = NULL;
+        }
+        keyboardHookRunning_ = false;
+        mouseHookRunning_ = false;
+    }
+
+    // Watchdog request or session resume: a dead hook looks exactly like a
+    // live one, so both are replaced. Keys held across the gap may have lost
+    // their release.
+    void ReinstallHooks() {
+        RemoveHooks();
+        InstallHooks();
+        engine_->ResetModifiers();
+        if (keyboardHookRunning_ || mouseHookRunning_ || rawMouseRunning_) {
+            counters_.reinstalls.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // The only thread that touches the hooks and the engine's input side.
+    // Its message loop serves the hook callbacks, WM_HOTKEY for the
+    // fallback, the input window and reinstall requests from the watchdog.
+    void InputThread(std::vector<HotkeyInfo> hotkeys, HANDLE ready) {
+        inputThreadId_ = GetCurrentThreadId();
+        SetTraceThreadName("shortcut input");
+
+        // Make sure the thread has a message queue before Stop() can post WM_QUIT
+        MSG msg = {0};
+        PeekMessage(&msg, NULL, WM_USER, WM_USER, PM_NOREMOVE);
+
+        if (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL)) {
+            counters_.elevatedPriority.store(true, std::memory_order_relaxed);
+            counters_.realtimePriority.store(true, std::memory_order_relaxed);
+        } else if (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST)) {
+            counters_.elevatedPriority.store(true, std::memory_order_relaxed);
+        }
+
+        CreateInputWindow();
+        // Install THE ULTIMATE KEYBOARD HOOK - Works in fullscreen games!
+        InstallHooks();
+
+        // Keep legacy RegisterHotKey as backup (in case hooks fail in some scenarios)
+        if (wantKeyboard_ && !keyboardHookRunning_) {
+            for (size_t i = 0; i < hotkeys.size(); i++) {
+                RegisterHotKey(NULL, static_cast<int>(i + 1), hotkeys[i].modifiers, hotkeys[i].vkCode);
+            }
+            hotkeysRunning_ = true;
+        }
+        SetEvent(ready);
+
+        // Message loop
+        while (GetMessage(&msg, NULL, 0, 0) > 0) {
+            if (msg.message == WM_HOTKEY) {
+                size_t index = static_cast<size_t>(msg.wParam) - 1;
+                if (index < hotkeys.size()) {
+                    engine_->Dispatch(hotkeys[index].actionId, kEventDown, msg.time,
+                                      OsDelayNs(msg.time), SteadyNowNs());
+                }
+            } else if (msg.message == kMsgReinstallHooks) {
+                ReinstallHooks();
+            } else {
+                // WM_INPUT and session changes for the input window
+                DispatchMessage(&msg);
+            }
+        }
+
+        RemoveHooks();
+        DestroyInputWindow();
+        if (hotkeysRunning_) {
+            // Clean up registered hotkeys
+            for (size_t i = 0; i < hotkeys.size(); i++) {
+                UnregisterHotKey(NULL, static_cast<int>(i + 1));
+            }
+            hotkeysRunning_ = false;
+        }
+    }
+
+    ShortcutEngine* engine_;
+    HHOOK keyboardHook_;                 // input thread only
+    HHOOK mouseHook_;
+    HWND window_;                        // set before Start() returns, cleared after the thread exits
+    HPOWERNOTIFY powerNotify_;           // input thread only
+    std::atomic<bool> keyboardHookRunning_;
+    std::atomic<bool> mouseHookRunning_;
+    std::atomic<bool> rawMouseRunning_;
+    std::atomic<bool> hotkeysRunning_;
+    bool wantKeyboard_;
+    bool wantMouse_;
+    bool mouseHookMode_;                 // WH_MOUSE_LL instead of raw input
+    std::thread inputThread_;
+    HANDLE inputThreadHandle_;           // for GetThreadTimes
+    std::atomic<DWORD> inputThreadId_;
+    InputBackendCounters counters_;
+};
+
+LRESULT CALLBACK KeyboardHookProc(int nCode, WPARAM wParam, LPARAM lParam) {
+    Win32InputBackend* backend = activeBackend;
+    if (!backend) {
+        return CallNextHookEx(NULL, nCode, wParam, lParam);
+    }
+    return backend->OnKeyboard(nCode, wParam, lParam);
+}
+
+LRESULT CALLBACK MouseHookProc(int nCode, WPARAM wParam, LPARAM lParam) {
+    Win32InputBackend* backend = activeBackend;
+    if (!backend) {
+        return CallNextHookEx(NULL, nCode, wParam, lParam);
+    }
+    return backend->OnMouse(nCode, wParam, lParam);
+}
+
+LRESULT CALLBACK InputWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam) {
+    Win32InputBackend* backend = activeBackend;
+    if (message == WM_INPUT && backend) {
+        backend->OnRawInput(reinterpret_cast<HRAWINPUT>(lParam));
+    } else if (message == WM_WTSSESSION_CHANGE && backend) {
+        if (wParam == WTS_SESSION_UNLOCK || wParam == WTS_CONSOLE_CONNECT || wParam == WTS_REMOTE_CONNECT) {
+            backend->OnSessionResumed();
+        }
+        return 0;
+    } else if (message == WM_POWERBROADCAST) {
+        if (wParam == PBT_APMRESUMEAUTOMATIC && backend) {
+            backend->OnSessionResumed();
+        }
+        return TRUE;
+    }
+    // DefWindowProc frees the WM_INPUT buffer
+    return DefWindowProcW(hwnd, message, wParam, lParam);
+}
+
+} // namespace
+
+InputBackend* CreatePlatformInputBackend() {
+    return new Win32InputBackend();
+}
@@ -0,0 +1,94 @@
+#include "input_trace.h"
+
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#include "event_ring.h"
+
+InputTraceWriter::InputTraceWriter() : header_(nullptr), records_(nullptr), capacity_(0) {}
+
+bool InputTraceWriter::Open(const std::string& path, uint64_t maxRecords, InputTracePlatform platform,
+                            std::string* error) {
+    Close();
+    if (maxRecords == 0) maxRecords = kDefaultTraceRecords;
+    size_t size = sizeof(InputTraceHeader) + static_cast<size_t>(maxRecords) * sizeof(InputTraceRecord);
+    if (!file_.Create(path, size, error)) {
+        return false;
+    }
+
+    header_ = new (file_.Data()) InputTraceHeader();
+    memcpy(header_->magic, kInputTraceMagic, sizeof(header_->magic));
+    header_->version = kInputTraceVersion;
+    header_->recordSize = sizeof(InputTraceRecord);
+    header_->platform = platform;
+    header_->finished = 0;
+    header_->startNs = SteadyNowNs();
+    header_->startUnixMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    header_->count.store(0, std::memory_order_relaxed);
+    header_->dropped.store(0, std::memory_order_relaxed);
+    memset(header_->reserved, 0, sizeof(header_->reserved));
+
+    records_ = reinterpret_cast<InputTraceRecord*>(static_cast<uint8_t*>(file_.Data()) + sizeof(InputTraceHeader));
+    capacity_ = maxRecords;
+    path_ = path;
+    return true;
+}
+
+void InputTraceWriter::Close() {
+    if (!header_) return;
+    uint64_t count = header_->count.load(std::memory_order_acquire);
+    header_->finished = 1;
+    header_ = nullptr;
+    records_ = nullptr;
+    capacity_ = 0;
+    file_.Close(sizeof(InputTraceHeader) + static_cast<size_t>(count) * sizeof(InputTraceRecord));
+}
+
+bool InputTraceReader::Open(const std::string& path, std::string* error) {
+    Close();
+    if (!file_.OpenRead(path, error)) {
+        return false;
+    }
+    if (file_.Size() < sizeof(InputTraceHeader)) {
+        if (error) *error = path + " is too short for a trace header";
+        Close();
+        return false;
+    }
+    const InputTraceHeader* header = static_cast<const InputTraceHeader*>(file_.Data());
+    if (memcmp(header->magic, kInputTraceMagic, sizeof(header->magic)) != 0) {
+        if (error) *error = path + " is not an input trace";
+        Close();
+        return false;
+    }
+    if (header->version != kInputTraceVersion || header->recordSize != sizeof(InputTraceRecord)) {
+        if (error) *error = path + ": unsupported trace version " + std::to_string(header->version);
+        Close();
+        return false;
+    }
+
+    uint64_t available = (file_.Size() - sizeof(InputTraceHeader)) / sizeof(InputTraceRecord);
+    uint64_t count = header->count.load(std::memory_order_acquire);
+    header_ = header;
+    records_ = reinterpret_cast<const InputTraceRecord*>(static_cast<const uint8_t*>(file_.Data()) +
+                                                         sizeof(InputTraceHeader));
+    count_ = static_cast<size_t>(count < available ? count : available);
+    return true;
+}
+
+void InputTraceReader::Close() {
+    file_.Close();
+    header_ = nullptr;
+    records_ = nullptr;
+    count_ = 0;
+}
+
+const char* InputTracePlatformName(uint32_t platform) {
+    switch (platform) {
+        case kTracePlatformWin32: return "win32";
+        case kTracePlatformEvdev: return "evdev";
+        case kTracePlatformSynthetic: return "synthetic";
+    }
+    return "unknown";
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "mapped_file.h"
+
+// Binary trace of the raw input stream the shortcut engine sees.
+//
+// A trace is one memory-mapped, append-only file: a 64-byte header followed
+// by fixed 32-byte records in arrival order. The capacity is chosen when the
+// file is created, so the input thread appends with a plain store into the
+// mapping and never makes a syscall; once full, further events are counted
+// as dropped. The record count in the header is published after each
+// record, so a trace left behind by a crash is still readable up to the
+// last complete record. Stopping the trace cuts the file to what was used.
+//
+// Records hold what the backend saw before any filtering (injected events
+// included) plus whether the engine consumed the event, so a replay through
+// the platform-neutral engine can be checked against the live run.
+
+const char kInputTraceMagic[8] = {'T', 'V', 'T', 'R', 'A', 'C', 'E', '\0'};
+const uint32_t kInputTraceVersion = 1;
+const uint64_t kDefaultTraceRecords = 1u << 20;   // 32 MiB
+
+enum InputTracePlatform {
+    kTracePlatformUnknown = 0,
+    kTracePlatformWin32,
+    kTracePlatformEvdev,
+    kTracePlatformSynthetic
+};
+
+enum InputTraceKind {
+    kTraceKey = 1,      // code = VK code
+    kTraceMouse = 2     // code = kMouseXButton1 / 2
+};
+
+enum InputTraceFlags {
+    kTraceDown = 1 << 0,
+    kTraceInjected = 1 << 1,   // synthesized by software (LLKHF_INJECTED / LLMHF_INJECTED)
+    kTraceConsumed = 1 << 2    // the engine swallowed the event
+};
+
+struct InputTraceRecord {
+    uint64_t timestampNs;   // hook entry, steady clock (SteadyNowNs)
+    uint64_t osDelayNs;     // OS event time -> hook entry, 0 if unknown
+    uint32_t osTime;        // OS event time in ms
+    uint32_t osFlags;       // KBDLLHOOKSTRUCT::flags / evdev value
+    uint16_t code;
+    uint16_t scanCode;      // OS scan code / evdev code
+    uint8_t kind;           // InputTraceKind
+    uint8_t flags;          // InputTraceFlags
+    uint16_t reserved;
+};
+
+static_assert(sizeof(InputTraceRecord) == 32, "InputTraceRecord is part of the file format");
+
+struct InputTraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t platform;               // InputTracePlatform
+    uint32_t finished;               // 1 once closed cleanly
+    uint64_t startNs;                // steady clock when recording started
+    uint64_t startUnixMs;            // wall clock, to line up with bug reports
+    std::atomic<uint64_t> count;     // complete records
+    std::atomic<uint64_t> dropped;   // events lost to a full file
+    uint8_t reserved[8];
+};
+
+static_assert(sizeof(InputTraceHeader) == 64, "InputTraceHeader is part of the file format");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "header counters live in shared memory");
+
+class InputTraceWriter {
+public:
+    InputTraceWriter();
+    ~InputTraceWriter() { Close(); }
+
+    InputTraceWriter(const InputTraceWriter&) = delete;
+    InputTraceWriter& operator=(const InputTraceWriter&) = delete;
+
+    bool Open(const std::string& path, uint64_t maxRecords, InputTracePlatform platform, std::string* error);
+    void Close();
+
+    // Single producer (the input thread). Returns the stored record so the
+    // caller can add kTraceConsumed, or nullptr once the file is full. Only
+    // writes into the mapping, hence const: the writer itself never changes
+    // between Open() and Close().
+    InputTraceRecord* Append(const InputTraceRecord& record) const {
+        uint64_t index = header_->count.load(std::memory_order_relaxed);
+        if (index >= capacity_) {
+            header_->dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        records_[index] = record;
+        header_->count.store(index + 1, std::memory_order_release);
+        return &records_[index];
+    }
+
+    bool IsOpen() const { return header_ != nullptr; }
+    const std::string& Path() const { return path_; }
+    uint64_t Count() const { return header_ ? header_->count.load(std::memory_order_acquire) : 0; }
+    uint64_t Dropped() const { return header_ ? header_->dropped.load(std::memory_order_relaxed) : 0; }
+    uint64_t Capacity() const { return capacity_; }
+
+private:
+    MappedFile file_;
+    std::string path_;
+    InputTraceHeader* header_;
+    InputTraceRecord* records_;
+    uint64_t capacity_;
+};
+
+class InputTraceReader {
+public:
+    InputTraceReader() : header_(nullptr), records_(nullptr), count_(0) {}
+
+    // Validates the header; the record count is clamped to the file size
+    bool Open(const std::string& path, std::string* error);
+    void Close();
+
+    const InputTraceHeader& Header() const { return *header_; }
+    const InputTraceRecord* Records() const { return records_; }
+    size_t Count() const { return count_; }
+
+private:
+    MappedFile file_;
+    const InputTraceHeader* header_;
+    const InputTraceRecord* records_;
+    size_t count_;
+};
+
+const char* InputTracePlatformName(uint32_t platform);
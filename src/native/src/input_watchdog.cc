@@ -0,0 +1,95 @@
+#include "input_watchdog.h"
+
+#include <chrono>
+
+InputWatchdog::InputWatchdog()
+    : engine_(nullptr), backend_(nullptr), periodMs_(kWatchdogPeriodMs),
+      stallNs_(kConsumerStallMs * 1000000ull), stopping_(false), lastDelivered_(0), backlogSinceNs_(0),
+      checks_(0), consumerStalls_(0), drainKicks_(0), consumerStalled_(false) {}
+
+InputWatchdog::~InputWatchdog() {
+    Stop();
+}
+
+void InputWatchdog::Start(ShortcutEngine* engine, InputBackend* backend, uint32_t periodMs, uint32_t stallMs) {
+    Stop();
+    engine_ = engine;
+    backend_ = backend;
+    periodMs_ = periodMs ? periodMs : 1;
+    stallNs_ = static_cast<uint64_t>(stallMs) * 1000000ull;
+    lastDelivered_ = engine->QueueStats().delivered;
+    backlogSinceNs_ = 0;
+    consumerStalled_.store(false, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = false;
+    }
+    thread_ = std::thread(&InputWatchdog::Run, this);
+}
+
+void InputWatchdog::Stop() {
+    if (!thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+    consumerStalled_.store(false, std::memory_order_relaxed);
+}
+
+InputWatchdogStats InputWatchdog::Stats() const {
+    InputWatchdogStats stats;
+    stats.checks = checks_.load(std::memory_order_relaxed);
+    stats.consumerStalls = consumerStalls_.load(std::memory_order_relaxed);
+    stats.drainKicks = drainKicks_.load(std::memory_order_relaxed);
+    stats.consumerStalled = consumerStalled_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void InputWatchdog::ResetStats() {
+    checks_.store(0, std::memory_order_relaxed);
+    consumerStalls_.store(0, std::memory_order_relaxed);
+    drainKicks_.store(0, std::memory_order_relaxed);
+}
+
+void InputWatchdog::Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        wake_.wait_for(lock, std::chrono::milliseconds(periodMs_));
+        if (stopping_) break;
+        lock.unlock();
+
+        uint64_t now = SteadyNowNs();
+        if (backend_) backend_->CheckHealth(now);
+        CheckConsumer(now);
+        checks_.fetch_add(1, std::memory_order_relaxed);
+
+        lock.lock();
+    }
+}
+
+void InputWatchdog::CheckConsumer(uint64_t nowNs) {
+    EventQueueStats stats = engine_->QueueStats();
+    bool progressed = stats.delivered != lastDelivered_;
+    lastDelivered_ = stats.delivered;
+
+    if (progressed || stats.published == stats.delivered) {
+        backlogSinceNs_ = progressed && stats.published != stats.delivered ? nowNs : 0;
+        consumerStalled_.store(false, std::memory_order_relaxed);
+        return;
+    }
+    if (backlogSinceNs_ == 0) {
+        backlogSinceNs_ = nowNs;
+        return;
+    }
+    if (nowNs - backlogSinceNs_ < stallNs_) return;
+
+    if (!consumerStalled_.exchange(true, std::memory_order_relaxed)) {
+        consumerStalls_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Queue size 1: fails harmlessly while a wakeup is still pending
+    if (engine_->KickDrain()) {
+        drainKicks_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
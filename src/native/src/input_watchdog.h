@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "input_backend.h"
+#include "shortcut_core.h"
+
+// Health monitor for the input path, on its own normal-priority thread.
+//
+// Every periodMs it lets the backend check its hooks / devices
+// (InputBackend::CheckHealth reinstalls whatever it finds failed) and
+// checks the consumer side: events queued but not delivered for stallMs
+// count as one consumer stall, and the JS wakeup is sent again in case it
+// was lost. A stall lasts until the consumer drains again.
+
+const uint32_t kWatchdogPeriodMs = 250;
+const uint32_t kConsumerStallMs = 1000;
+
+struct InputWatchdogStats {
+    uint64_t checks;
+    uint64_t consumerStalls;   // stall episodes
+    uint64_t drainKicks;       // wakeups re-sent during stalls
+    bool consumerStalled;      // a stall is in progress
+};
+
+class InputWatchdog {
+public:
+    InputWatchdog();
+    ~InputWatchdog();
+
+    // JS thread. The engine and backend must outlive Stop().
+    void Start(ShortcutEngine* engine, InputBackend* backend,
+               uint32_t periodMs = kWatchdogPeriodMs, uint32_t stallMs = kConsumerStallMs);
+    // Blocks until the watchdog thread has exited
+    void Stop();
+    bool Running() const { return thread_.joinable(); }
+
+    InputWatchdogStats Stats() const;
+    void ResetStats();
+
+private:
+    void Run();
+    void CheckConsumer(uint64_t nowNs);
+
+    ShortcutEngine* engine_;
+    InputBackend* backend_;
+    uint32_t periodMs_;
+    uint64_t stallNs_;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_;                  // guarded by mutex_
+
+    // Watchdog thread only
+    uint64_t lastDelivered_;
+    uint64_t backlogSinceNs_;        // 0 = consumer caught up
+
+    std::atomic<uint64_t> checks_;
+    std::atomic<uint64_t> consumerStalls_;
+    std::atomic<uint64_t> drainKicks_;
+    std::atomic<bool> consumerStalled_;
+};
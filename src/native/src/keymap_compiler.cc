@@ -0,0 +1,97 @@
+#include "keymap_compiler.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+bool SameStroke(const KeyStroke& a, const KeyStroke& b) {
+    return a.modifiers == b.modifiers && a.vkCode == b.vkCode;
+}
+
+// Number of leading strokes the two bindings share, or SIZE_MAX when they
+// are on different devices and can never collide
+size_t SharedPrefix(const CompiledKeymapBinding& a, const CompiledKeymapBinding& b) {
+    if (a.mouseButton != b.mouseButton) return SIZE_MAX;
+    if (a.mouseButton != 0) {
+        return a.strokes[0].modifiers == b.strokes[0].modifiers ? 1 : 0;
+    }
+    size_t shared = 0;
+    while (shared < a.strokes.size() && shared < b.strokes.size() &&
+           SameStroke(a.strokes[shared], b.strokes[shared])) {
+        shared++;
+    }
+    return shared;
+}
+
+} // namespace
+
+const char* KeymapIssueKindName(KeymapIssueKind kind) {
+    switch (kind) {
+        case kKeymapInvalid: return "invalid";
+        case kKeymapDuplicate: return "duplicate";
+        case kKeymapConflict: return "conflict";
+    }
+    return "unknown";
+}
+
+bool CompileKeymap(const std::vector<KeymapBinding>& input, CompiledKeymap* out) {
+    out->bindings.clear();
+    out->issues.clear();
+    out->bindings.reserve(input.size());
+
+    for (const KeymapBinding& binding : input) {
+        CompiledKeymapBinding compiled;
+        compiled.action = binding.action;
+        compiled.timeoutMs = binding.timeoutMs;
+        compiled.mouseButton = 0;
+
+        std::string error;
+        if (!ParseKeySequence(binding.keys, &compiled.strokes, compiled.mouseButton, &error)) {
+            out->issues.push_back({kKeymapInvalid, binding.action, binding.keys, std::string(), error, std::string()});
+            continue;
+        }
+        compiled.canonical = FormatKeySequence(compiled.strokes, compiled.mouseButton);
+
+        // Keymaps are a few dozen entries, so a pairwise check is plenty
+        bool accepted = true;
+        for (const CompiledKeymapBinding& existing : out->bindings) {
+            size_t shared = SharedPrefix(compiled, existing);
+            if (shared == SIZE_MAX) continue;
+            size_t shorter = std::min(compiled.strokes.size(), existing.strokes.size());
+            if (shared < shorter) continue;
+
+            KeymapIssue issue;
+            issue.action = binding.action;
+            issue.keys = binding.keys;
+            issue.other = existing.action;
+            if (compiled.strokes.size() == existing.strokes.size()) {
+                issue.kind = existing.action == compiled.action ? kKeymapDuplicate : kKeymapConflict;
+                issue.message = compiled.canonical + " is already bound to " + existing.action;
+            } else {
+                issue.kind = kKeymapConflict;
+                const CompiledKeymapBinding& prefix =
+                    compiled.strokes.size() < existing.strokes.size() ? compiled : existing;
+                const CompiledKeymapBinding& longer =
+                    compiled.strokes.size() < existing.strokes.size() ? existing : compiled;
+                issue.message = prefix.canonical + " (" + prefix.action + ") is a prefix of " +
+                                longer.canonical + " (" + longer.action + ")";
+            }
+            out->issues.push_back(issue);
+            accepted = false;
+            break;
+        }
+        if (accepted) out->bindings.push_back(std::move(compiled));
+    }
+    return out->issues.empty();
+}
+
+size_t ApplyKeymap(const CompiledKeymap& keymap, ShortcutEngine* engine, uint32_t profile) {
+    size_t applied = 0;
+    for (const CompiledKeymapBinding& binding : keymap.bindings) {
+        if (engine->BindStrokes(binding.action, binding.strokes, binding.mouseButton, binding.timeoutMs, profile)) {
+            applied++;
+        }
+    }
+    return applied;
+}
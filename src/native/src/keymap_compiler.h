@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "shortcut_core.h"
+
+// Keymap compiler: turns the user's { action: keys } map into canonical,
+// conflict-free bindings before anything reaches the engine.
+//
+// Every key string is parsed against the compile-time name table
+// (key_names.h) and re-spelled canonically, so "shift+control+f1" and
+// "Ctrl+Shift+F1" are recognised as the same stroke. Bindings are taken in
+// order and the first one wins; everything that had to be left out is
+// reported instead of being dropped silently:
+//   invalid    the key string does not parse (unknown name, missing key...)
+//   duplicate  the same action is bound to the same keys twice
+//   conflict   the keys are already taken by another action, or one binding
+//              is a prefix of the other's sequence ("Ctrl+K" vs "Ctrl+K, P")
+
+enum KeymapIssueKind {
+    kKeymapInvalid = 0,
+    kKeymapDuplicate,
+    kKeymapConflict
+};
+
+struct KeymapBinding {
+    std::string action;
+    std::string keys;
+    uint32_t timeoutMs;
+};
+
+struct KeymapIssue {
+    KeymapIssueKind kind;
+    std::string action;
+    std::string keys;       // as written
+    std::string other;      // action already holding the keys (duplicate / conflict)
+    std::string message;
+    std::string profile;    // keymap profile the binding belongs to, empty = default
+};
+
+struct CompiledKeymapBinding {
+    std::string action;
+    std::string canonical;  // FormatKeySequence() spelling
+    std::vector<KeyStroke> strokes;
+    uint32_t mouseButton;
+    uint32_t timeoutMs;
+};
+
+struct CompiledKeymap {
+    std::vector<CompiledKeymapBinding> bindings;
+    std::vector<KeymapIssue> issues;
+};
+
+const char* KeymapIssueKindName(KeymapIssueKind kind);
+
+// Returns true when there were no issues; out holds the accepted bindings either way
+bool CompileKeymap(const std::vector<KeymapBinding>& input, CompiledKeymap* out);
+
+// Adds the accepted bindings to the engine's pending table (see
+// ShortcutEngine::AddBinding), into the default keymap or a profile from
+// ShortcutEngine::AddProfile(); PublishBindings() is left to the caller.
+// Returns the number of bindings the table took.
+size_t ApplyKeymap(const CompiledKeymap& keymap, ShortcutEngine* engine, uint32_t profile = kDefaultProfile);
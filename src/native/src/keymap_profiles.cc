@@ -0,0 +1,96 @@
+#include "keymap_profiles.h"
+
+#include <algorithm>
+
+namespace {
+
+// Executable and class names are ASCII in practice; other bytes are kept as is
+std::string FoldAscii(const std::string& text) {
+    std::string out(text);
+    for (char& c : out) {
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    }
+    return out;
+}
+
+bool Contains(const std::vector<std::string>& names, const std::string& name) {
+    return !name.empty() && std::find(names.begin(), names.end(), name) != names.end();
+}
+
+} // namespace
+
+KeymapProfileSwitcher::KeymapProfileSwitcher()
+    : engine_(nullptr), generation_(0), profile_(kDefaultProfile), foregroundChanges_(0), switches_(0) {}
+
+void KeymapProfileSwitcher::SetRules(ShortcutEngine* engine, uint32_t generation,
+                                     const std::vector<KeymapProfileRule>& rules) {
+    std::vector<FoldedRule> folded;
+    folded.reserve(rules.size());
+    for (const KeymapProfileRule& rule : rules) {
+        FoldedRule entry;
+        entry.profile = rule.profile;
+        for (const std::string& name : rule.processes) entry.processes.push_back(FoldAscii(name));
+        for (const std::string& name : rule.windowClasses) entry.windowClasses.push_back(FoldAscii(name));
+        folded.push_back(entry);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    engine_ = engine;
+    generation_ = generation;
+    rules_.swap(folded);
+    // Always stored: the generation is new even if the profile index is not
+    profile_ = MatchLocked(foldedProcess_, foldedClass_);
+    if (engine_) engine_->SetActiveProfile(generation_, profile_);
+}
+
+uint32_t KeymapProfileSwitcher::Match(const ForegroundApp& app) const {
+    std::string process = FoldAscii(app.process);
+    std::string windowClass = FoldAscii(app.windowClass);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return MatchLocked(process, windowClass);
+}
+
+uint32_t KeymapProfileSwitcher::MatchLocked(const std::string& process, const std::string& windowClass) const {
+    for (const FoldedRule& rule : rules_) {
+        if (Contains(rule.processes, process) || Contains(rule.windowClasses, windowClass)) {
+            return rule.profile;
+        }
+    }
+    return kDefaultProfile;
+}
+
+void KeymapProfileSwitcher::OnForegroundChanged(const ForegroundApp& app, void* context) {
+    static_cast<KeymapProfileSwitcher*>(context)->Select(app);
+}
+
+void KeymapProfileSwitcher::Select(const ForegroundApp& app) {
+    std::string process = FoldAscii(app.process);
+    std::string windowClass = FoldAscii(app.windowClass);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    foregroundChanges_++;
+    app_ = app;
+    foldedProcess_.swap(process);
+    foldedClass_.swap(windowClass);
+    uint32_t profile = MatchLocked(foldedProcess_, foldedClass_);
+    if (profile == profile_) return;
+    profile_ = profile;
+    switches_++;
+    if (engine_) engine_->SetActiveProfile(generation_, profile_);
+}
+
+KeymapProfileStats KeymapProfileSwitcher::Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    KeymapProfileStats stats;
+    stats.foregroundChanges = foregroundChanges_;
+    stats.switches = switches_;
+    stats.profile = profile_;
+    stats.app = app_;
+    return stats;
+}
+
+void KeymapProfileSwitcher::ResetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    foregroundChanges_ = 0;
+    switches_ = 0;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "foreground_monitor.h"
+#include "shortcut_core.h"
+
+// Per-application keymap profiles.
+//
+// Every profile is compiled into the same ShortcutTable as the default
+// keymap (see shortcut_table.h). The switcher is fed by a ForegroundMonitor:
+// on each focus change it matches the focused application against the
+// profile rules and, if the profile differs, selects it with
+// ShortcutEngine::SetActiveProfile(). The input thread sees the new keymap
+// from its next key, and JS is not involved at all.
+
+struct KeymapProfileRule {
+    uint32_t profile;                        // index in the published table
+    std::vector<std::string> processes;      // executable names ("Code.exe"), case-insensitive
+    std::vector<std::string> windowClasses;  // window classes, case-insensitive
+};
+
+struct KeymapProfileStats {
+    uint64_t foregroundChanges;   // focus changes reported by the monitor
+    uint64_t switches;            // profile changes that followed
+    uint32_t profile;             // profile of the focused application
+    ForegroundApp app;            // last focused application
+};
+
+class KeymapProfileSwitcher {
+public:
+    KeymapProfileSwitcher();
+
+    // JS thread, right after PublishBindings(): the rules for the table with
+    // this generation. The application focused now is matched again at once,
+    // so the new table starts on the right profile.
+    void SetRules(ShortcutEngine* engine, uint32_t generation, const std::vector<KeymapProfileRule>& rules);
+    // First matching rule's profile, kDefaultProfile if none
+    uint32_t Match(const ForegroundApp& app) const;
+
+    // Monitor thread: pass as the ForegroundMonitor callback with the switcher as context
+    static void OnForegroundChanged(const ForegroundApp& app, void* context);
+    void Select(const ForegroundApp& app);
+
+    KeymapProfileStats Stats() const;
+    void ResetStats();
+
+private:
+    struct FoldedRule {
+        uint32_t profile;
+        std::vector<std::string> processes;
+        std::vector<std::string> windowClasses;
+    };
+
+    // mutex_ held
+    uint32_t MatchLocked(const std::string& process, const std::string& windowClass) const;
+
+    mutable std::mutex mutex_;
+    ShortcutEngine* engine_;
+    uint32_t generation_;
+    std::vector<FoldedRule> rules_;
+    ForegroundApp app_;
+    std::string foldedProcess_;
+    std::string foldedClass_;
+    uint32_t profile_;
+    uint64_t foregroundChanges_;
+    uint64_t switches_;
+};
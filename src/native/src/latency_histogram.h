@@ -0,0 +1,147 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// HDR-style log-linear latency histogram.
+//
+// Values are nanoseconds. Every power of two is split into 16 linear
+// sub-buckets, giving ~6% worst-case relative error from 32 ns up to ~36
+// minutes in 608 fixed counters. Recording is a couple of shifts, two
+// relaxed atomic adds (bucket and sum) and a relaxed load each of min and
+// max; a compare-exchange only follows when the value is a new extreme,
+// which stops happening once a few samples are in. There are no locks, so it
+// is safe to call from the hook thread.
+
+const uint32_t kLatencySubBucketBits = 4;
+const uint32_t kLatencySubBuckets = 1u << kLatencySubBucketBits;           // 16
+const uint32_t kLatencyLinearLimit = kLatencySubBuckets * 2;               // values < 32 are exact
+const uint32_t kLatencyMaxShift = 36;
+const uint32_t kLatencyBucketCount = (kLatencyMaxShift + 2) * kLatencySubBuckets; // 608
+
+struct LatencySummary {
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    double mean;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+};
+
+class LatencyHistogram {
+public:
+    LatencyHistogram() { Reset(); }
+
+    void Record(uint64_t ns) {
+        counts_[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(ns, std::memory_order_relaxed);
+
+        uint64_t current = min_.load(std::memory_order_relaxed);
+        while (ns < current && !min_.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {}
+        current = max_.load(std::memory_order_relaxed);
+        while (ns > current && !max_.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {}
+    }
+
+    void Reset() {
+        for (size_t i = 0; i < kLatencyBucketCount; i++) {
+            counts_[i].store(0, std::memory_order_relaxed);
+        }
+        sum_.store(0, std::memory_order_relaxed);
+        min_.store(UINT64_MAX, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    LatencySummary Summarize() const {
+        LatencySummary summary;
+        uint64_t snapshot[kLatencyBucketCount];
+        uint64_t total = 0;
+        for (size_t i = 0; i < kLatencyBucketCount; i++) {
+            snapshot[i] = counts_[i].load(std::memory_order_relaxed);
+            total += snapshot[i];
+        }
+
+        summary.count = total;
+        summary.min = total ? min_.load(std::memory_order_relaxed) : 0;
+        summary.max = max_.load(std::memory_order_relaxed);
+        summary.mean = total ? static_cast<double>(sum_.load(std::memory_order_relaxed)) / total : 0.0;
+        summary.p50 = ValueAtQuantile(snapshot, total, 0.50);
+        summary.p90 = ValueAtQuantile(snapshot, total, 0.90);
+        summary.p99 = ValueAtQuantile(snapshot, total, 0.99);
+        summary.p999 = ValueAtQuantile(snapshot, total, 0.999);
+        return summary;
+    }
+
+    static uint32_t BucketIndex(uint64_t ns) {
+        if (ns < kLatencyLinearLimit) return static_cast<uint32_t>(ns);
+        uint32_t shift = HighestBit(ns) - kLatencySubBucketBits;
+        if (shift > kLatencyMaxShift) return kLatencyBucketCount - 1;
+        return shift * kLatencySubBuckets + static_cast<uint32_t>(ns >> shift);
+    }
+
+    // Midpoint of the values that land in a bucket
+    static uint64_t BucketValue(uint32_t index) {
+        if (index < kLatencyLinearLimit) return index;
+        uint32_t shift = index / kLatencySubBuckets - 1;
+        uint64_t mantissa = index - shift * kLatencySubBuckets;
+        uint64_t lower = mantissa << shift;
+        return lower + ((1ull << shift) >> 1);
+    }
+
+private:
+    static uint32_t HighestBit(uint64_t value) {
+        uint32_t bit = 0;
+        while (value >>= 1) bit++;
+        return bit;
+    }
+
+    static uint64_t ValueAtQuantile(const uint64_t* snapshot, uint64_t total, double quantile) {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(total) + 0.5);
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < kLatencyBucketCount; i++) {
+            seen += snapshot[i];
+            if (seen >= rank) return BucketValue(i);
+        }
+        return BucketValue(kLatencyBucketCount - 1);
+    }
+
+    std::atomic<uint64_t> counts_[kLatencyBucketCount];
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> min_;
+    std::atomic<uint64_t> max_;
+};
+
+// Hotkey pipeline stages, in the order an event passes through them
+enum LatencyStage {
+    kStageOsToHook = 0,     // OS event time -> hook entry
+    kStageHookToDispatch,   // hook entry -> event queued for the TSFN
+    kStageDispatchToJs,     // queued -> JS callback entry
+    kStageJsToComplete,     // JS callback entry -> handler reported completion
+    kStageHookToComplete,   // hook entry -> completion (end to end)
+    kLatencyStageCount
+};
+
+inline const char* LatencyStageName(int stage) {
+    static const char* const names[kLatencyStageCount] = {
+        "osToHook", "hookToDispatch", "dispatchToJs", "jsToComplete", "hookToComplete"
+    };
+    return (stage >= 0 && stage < kLatencyStageCount) ? names[stage] : "unknown";
+}
+
+class LatencyRecorder {
+public:
+    void Record(LatencyStage stage, uint64_t ns) { stages_[stage].Record(ns); }
+
+    void Reset() {
+        for (int i = 0; i < kLatencyStageCount; i++) stages_[i].Reset();
+    }
+
+    LatencySummary Summarize(LatencyStage stage) const { return stages_[stage].Summarize(); }
+
+private:
+    LatencyHistogram stages_[kLatencyStageCount];
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Memory-mapped file. Implemented by mapped_file_posix.cc (mmap) and
+// mapped_file_win32.cc (file mapping objects); paths are UTF-8 on both.
+
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Creates (or truncates) the file, sizes it to `size` bytes and maps it
+    // read-write. Pages nobody writes stay sparse where the filesystem allows.
+    bool Create(const std::string& path, size_t size, std::string* error);
+
+    // Maps an existing file read-only
+    bool OpenRead(const std::string& path, std::string* error);
+
+    // Unmaps and closes. A writable file is cut to `finalSize` bytes first;
+    // SIZE_MAX keeps the mapped size.
+    void Close(size_t finalSize = SIZE_MAX);
+
+    bool IsOpen() const { return data_ != nullptr; }
+    void* Data() const { return data_; }
+    size_t Size() const { return size_; }
+
+private:
+    void* data_;
+    size_t size_;
+    bool writable_;
+    intptr_t file_;      // fd / HANDLE, -1 when closed
+    intptr_t mapping_;   // Win32 mapping HANDLE, unused on POSIX
+};
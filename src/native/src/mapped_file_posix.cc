@@ -0,0 +1,90 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+void SetError(std::string* error, const char* what, const std::string& path) {
+    if (error) *error = std::string(what) + " " + path + ": " + strerror(errno);
+}
+
+} // namespace
+
+MappedFile::MappedFile() : data_(nullptr), size_(0), writable_(false), file_(-1), mapping_(-1) {}
+
+bool MappedFile::Create(const std::string& path, size_t size, std::string* error) {
+    Close();
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        SetError(error, "open", path);
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        SetError(error, "ftruncate", path);
+        close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        SetError(error, "mmap", path);
+        close(fd);
+        return false;
+    }
+    data_ = data;
+    size_ = size;
+    writable_ = true;
+    file_ = fd;
+    return true;
+}
+
+bool MappedFile::OpenRead(const std::string& path, std::string* error) {
+    Close();
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        SetError(error, "open", path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        if (error) *error = "empty or unreadable file " + path;
+        close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        SetError(error, "mmap", path);
+        close(fd);
+        return false;
+    }
+    data_ = data;
+    size_ = size;
+    writable_ = false;
+    file_ = fd;
+    return true;
+}
+
+void MappedFile::Close(size_t finalSize) {
+    if (data_) {
+        munmap(data_, size_);
+        data_ = nullptr;
+    }
+    if (file_ >= 0) {
+        int fd = static_cast<int>(file_);
+        if (writable_ && finalSize != SIZE_MAX) {
+            // On failure the file keeps the mapped size; readers go by the header
+            int truncated = ftruncate(fd, static_cast<off_t>(finalSize));
+            (void)truncated;
+        }
+        close(fd);
+        file_ = -1;
+    }
+    size_ = 0;
+    writable_ = false;
+}
@@ -0,0 +1,116 @@
+#include <windows.h>
+
+#include "mapped_file.h"
+
+namespace {
+
+std::wstring Widen(const std::string& text) {
+    int length = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), NULL, 0);
+    std::wstring wide(static_cast<size_t>(length), L'\0');
+    if (length > 0) {
+        MultiByteToWideChar(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), &wide[0], length);
+    }
+    return wide;
+}
+
+void SetError(std::string* error, const char* what, const std::string& path) {
+    if (error) *error = std::string(what) + " " + path + " failed (error " + std::to_string(GetLastError()) + ")";
+}
+
+} // namespace
+
+MappedFile::MappedFile() : data_(nullptr), size_(0), writable_(false), file_(-1), mapping_(-1) {}
+
+bool MappedFile::Create(const std::string& path, size_t size, std::string* error) {
+    Close();
+    HANDLE file = CreateFileW(Widen(path).c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        SetError(error, "CreateFile", path);
+        return false;
+    }
+    // Sparse, so a large capacity costs no disk until it is written
+    DWORD returned = 0;
+    DeviceIoControl(file, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &returned, NULL);
+
+    ULARGE_INTEGER mappedSize;
+    mappedSize.QuadPart = size;
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READWRITE, mappedSize.HighPart, mappedSize.LowPart, NULL);
+    if (mapping == NULL) {
+        SetError(error, "CreateFileMapping", path);
+        CloseHandle(file);
+        return false;
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (data == NULL) {
+        SetError(error, "MapViewOfFile", path);
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    data_ = data;
+    size_ = size;
+    writable_ = true;
+    file_ = reinterpret_cast<intptr_t>(file);
+    mapping_ = reinterpret_cast<intptr_t>(mapping);
+    return true;
+}
+
+bool MappedFile::OpenRead(const std::string& path, std::string* error) {
+    Close();
+    HANDLE file = CreateFileW(Widen(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        SetError(error, "CreateFile", path);
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        if (error) *error = "empty or unreadable file " + path;
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        SetError(error, "CreateFileMapping", path);
+        CloseHandle(file);
+        return false;
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL) {
+        SetError(error, "MapViewOfFile", path);
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    data_ = data;
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+    writable_ = false;
+    file_ = reinterpret_cast<intptr_t>(file);
+    mapping_ = reinterpret_cast<intptr_t>(mapping);
+    return true;
+}
+
+void MappedFile::Close(size_t finalSize) {
+    if (data_) {
+        if (writable_) FlushViewOfFile(data_, 0);
+        UnmapViewOfFile(data_);
+        data_ = nullptr;
+    }
+    if (mapping_ != -1) {
+        CloseHandle(reinterpret_cast<HANDLE>(mapping_));
+        mapping_ = -1;
+    }
+    if (file_ != -1) {
+        HANDLE file = reinterpret_cast<HANDLE>(file_);
+        if (writable_ && finalSize != SIZE_MAX) {
+            LARGE_INTEGER end;
+            end.QuadPart = static_cast<LONGLONG>(finalSize);
+            if (SetFilePointerEx(file, end, NULL, FILE_BEGIN)) SetEndOfFile(file);
+        }
+        CloseHandle(file);
+        file_ = -1;
+    }
+    size_ = 0;
+    writable_ = false;
+}
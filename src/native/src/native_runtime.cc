@@ -0,0 +1,243 @@
+#include <napi.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+#include "native_runtime.h"
+#include "trace_events.h"
+
+// Entry point of teyvat_native.node. Loading it only builds the runtime
+// object; a sub-module's state and exports come into being the first time
+// JS reads runtime.shortcut / .topmost / .governor, so a worker that only
+// needs window lookups never pays for the shortcut engine. Threads start
+// later still, when the sub-module is first used.
+
+namespace {
+
+std::atomic<const void*> resourceOwners[kProcessResourceCount];
+
+// Shared foreground monitor. lifecycleMutex serializes starting and stopping
+// it; subscriberMutex is what the monitor thread takes to fan out, so Stop()
+// can join the thread without deadlocking on it.
+struct ForegroundSubscriber {
+    ForegroundChangedFn callback;
+    void* context;
+
+    bool operator==(const ForegroundSubscriber& other) const {
+        return callback == other.callback && context == other.context;
+    }
+};
+
+std::mutex lifecycleMutex;
+std::unique_ptr<ForegroundMonitor> foregroundMonitor;
+std::mutex subscriberMutex;
+std::vector<ForegroundSubscriber> foregroundSubscribers;
+bool foregroundKnown = false;
+ForegroundApp lastForeground;
+
+// Monitor thread
+void DispatchForeground(const ForegroundApp& app, void*) {
+    std::lock_guard<std::mutex> lock(subscriberMutex);
+    foregroundKnown = true;
+    lastForeground = app;
+    for (const ForegroundSubscriber& subscriber : foregroundSubscribers) {
+        subscriber.callback(app, subscriber.context);
+    }
+}
+
+// Timeline spans (see trace_events.h). The buffers are per process, so these
+// live on the runtime itself rather than on a sub-module: one collect covers
+// the spans of every sub-module.
+Napi::Value SetTraceEvents(const Napi::CallbackInfo& info) {
+    SetTraceEventsEnabled(info.Length() > 0 && info[0].IsBoolean() && info[0].As<Napi::Boolean>().Value());
+    return info.Env().Undefined();
+}
+
+Napi::Value GetTraceEventStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    TraceEventStats stats = ::GetTraceEventStats();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("enabled", Napi::Boolean::New(env, stats.enabled));
+    result.Set("recorded", Napi::Number::New(env, static_cast<double>(stats.recorded)));
+    result.Set("overwritten", Napi::Number::New(env, static_cast<double>(stats.overwritten)));
+    result.Set("threads", Napi::Number::New(env, stats.threads));
+    return result;
+}
+
+// Buffered spans as comma-separated trace-event JSON objects
+Napi::Value CollectTraceEvents(const Napi::CallbackInfo& info) {
+    std::string json;
+    AppendTraceEventsJson(&json);
+    return Napi::String::New(info.Env(), json);
+}
+
+// dumpTrace(path): writes the buffered spans as a Chrome trace-event JSON
+// file (opens in Perfetto / chrome://tracing). Returns the number of events;
+// throws if the file cannot be written.
+Napi::Value DumpTrace(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected a file path").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string json = "{\"traceEvents\":[\n";
+    size_t count = AppendTraceEventsJson(&json);
+    json += "\n]}\n";
+
+    MappedFile file;
+    std::string error;
+    if (!file.Create(info[0].As<Napi::String>().Utf8Value(), json.size(), &error)) {
+        Napi::Error::New(env, "Failed to write trace: " + error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::memcpy(file.Data(), json.data(), json.size());
+    file.Close(json.size());
+    return Napi::Number::New(env, static_cast<double>(count));
+}
+
+void AddTraceExports(Napi::Env env, Napi::Object exports) {
+    exports.Set("setTraceEvents", Napi::Function::New(env, SetTraceEvents, "setTraceEvents"));
+    exports.Set("getTraceEventStats", Napi::Function::New(env, GetTraceEventStats, "getTraceEventStats"));
+    exports.Set("collectTraceEvents", Napi::Function::New(env, CollectTraceEvents, "collectTraceEvents"));
+    exports.Set("dumpTrace", Napi::Function::New(env, DumpTrace, "dumpTrace"));
+}
+
+enum SubModule {
+    kSubModuleShortcut,
+    kSubModuleTopmost,
+    kSubModuleGovernor,
+    kSubModuleCount
+};
+
+class NativeRuntime : public Napi::Addon<NativeRuntime> {
+public:
+    NativeRuntime(Napi::Env env, Napi::Object exports) {
+        // The JS thread of this environment: main thread or a worker
+        SetTraceThreadName("js");
+        DefineAddon(exports, {
+            InstanceAccessor<&NativeRuntime::GetShortcut>("shortcut", napi_enumerable),
+            InstanceAccessor<&NativeRuntime::GetTopmost>("topmost", napi_enumerable),
+            InstanceAccessor<&NativeRuntime::GetGovernor>("governor", napi_enumerable)
+        });
+        AddTraceExports(env, exports);
+    }
+
+private:
+    Napi::Value GetShortcut(const Napi::CallbackInfo& info) {
+        return Load(info.Env(), kSubModuleShortcut);
+    }
+
+    Napi::Value GetTopmost(const Napi::CallbackInfo& info) {
+        return Load(info.Env(), kSubModuleTopmost);
+    }
+
+    Napi::Value GetGovernor(const Napi::CallbackInfo& info) {
+        return Load(info.Env(), kSubModuleGovernor);
+    }
+
+    // Builds the sub-module on first access; later reads return the same object
+    Napi::Value Load(Napi::Env env, SubModule index) {
+        if (exports_[index].IsEmpty()) {
+            Napi::Object exports = Napi::Object::New(env);
+            switch (index) {
+                case kSubModuleShortcut:
+                    modules_[index].reset(CreateShortcutModule(env, exports));
+                    break;
+                case kSubModuleTopmost:
+                    modules_[index].reset(CreateTopmostModule(env, exports));
+                    break;
+                default:
+                    modules_[index].reset(CreateGovernorModule(env, exports));
+                    break;
+            }
+            modules_[index]->ArmShutdownHook(env);
+            exports_[index] = Napi::Persistent(exports);
+        }
+        return exports_[index].Value();
+    }
+
+    std::unique_ptr<RuntimeModule> modules_[kSubModuleCount];
+    Napi::ObjectReference exports_[kSubModuleCount];
+};
+
+} // namespace
+
+RuntimeModule::~RuntimeModule() {
+    if (hookEnv_) {
+        napi_remove_env_cleanup_hook(hookEnv_, RunShutdownHook, this);
+    }
+}
+
+void RuntimeModule::ArmShutdownHook(Napi::Env env) {
+    // Re-registering moves the hook behind the newest TSFN
+    if (hookEnv_) {
+        napi_remove_env_cleanup_hook(hookEnv_, RunShutdownHook, this);
+    }
+    hookEnv_ = env;
+    napi_add_env_cleanup_hook(hookEnv_, RunShutdownHook, this);
+}
+
+void RuntimeModule::RunShutdownHook(void* module) {
+    RuntimeModule* self = static_cast<RuntimeModule*>(module);
+    self->hookEnv_ = nullptr;
+    self->Shutdown();
+}
+
+bool ClaimProcessResource(ProcessResource resource, const void* owner) {
+    const void* expected = nullptr;
+    return resourceOwners[resource].compare_exchange_strong(expected, owner) || expected == owner;
+}
+
+void ReleaseProcessResource(ProcessResource resource, const void* owner) {
+    const void* expected = owner;
+    resourceOwners[resource].compare_exchange_strong(expected, nullptr);
+}
+
+bool SubscribeForeground(ForegroundChangedFn callback, void* context) {
+    std::lock_guard<std::mutex> lifecycle(lifecycleMutex);
+    if (!foregroundMonitor) {
+        foregroundMonitor.reset(CreateForegroundMonitor());
+    }
+    bool running = foregroundMonitor->IsRunning();
+    ForegroundSubscriber subscriber = { callback, context };
+    {
+        std::lock_guard<std::mutex> lock(subscriberMutex);
+        if (!running) foregroundKnown = false;
+        if (std::find(foregroundSubscribers.begin(), foregroundSubscribers.end(), subscriber) ==
+            foregroundSubscribers.end()) {
+            foregroundSubscribers.push_back(subscriber);
+            if (foregroundKnown) callback(lastForeground, context);
+        }
+    }
+    // Start() reports the window focused now, which reaches the new subscriber
+    if (running || foregroundMonitor->Start(DispatchForeground, nullptr)) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(subscriberMutex);
+    foregroundSubscribers.erase(std::remove(foregroundSubscribers.begin(), foregroundSubscribers.end(), subscriber),
+                                foregroundSubscribers.end());
+    return false;
+}
+
+void UnsubscribeForeground(ForegroundChangedFn callback, void* context) {
+    std::lock_guard<std::mutex> lifecycle(lifecycleMutex);
+    ForegroundSubscriber subscriber = { callback, context };
+    bool last;
+    {
+        std::lock_guard<std::mutex> lock(subscriberMutex);
+        foregroundSubscribers.erase(std::remove(foregroundSubscribers.begin(), foregroundSubscribers.end(), subscriber),
+                                    foregroundSubscribers.end());
+        last = foregroundSubscribers.empty();
+    }
+    if (last && foregroundMonitor) {
+        foregroundMonitor->Stop();
+    }
+}
+
+NODE_API_ADDON(NativeRuntime)
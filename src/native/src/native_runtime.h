@@ -0,0 +1,82 @@
+#pragma once
+
+#include <napi.h>
+
+#include "foreground_monitor.h"
+
+// One addon (teyvat_native.node) carries the shortcut, topmost and governor
+// APIs. native_runtime.cc exposes them as the lazily built sub-modules
+// `shortcut`, `topmost` and `governor`; the high_priority_*.cc glue files
+// each provide one of them.
+//
+// Every environment that loads the addon (the main thread, a worker_thread)
+// gets its own runtime. A sub-module keeps its JS-facing state - engine,
+// TSFNs, pending jobs - in its RuntimeModule, and the functions it exports
+// carry that module as callback data. Everything the OS only offers once per
+// process stays per process: the Win32 hook and WinEvent procs dispatch to
+// one global instance each (input backend, topmost watcher, window change
+// and foreground monitors), and the title cache and trace buffers are
+// shared. So a second environment does not get its own input listener,
+// topmost watcher or governor; it fails to claim the resource below.
+//
+// Threads are not merged yet: the input thread, timer wheel, input
+// watchdog, foreground monitor, topmost watcher, topmost worker and governor
+// each still run on their own, started only while in use. Moving the hooks,
+// the watcher and the timer wheel onto one loop per runtime, with dispatch
+// keyed by that loop instead of the globals above, is request user-026;
+// the resource claims below go away with it.
+
+class RuntimeModule {
+public:
+    RuntimeModule() : hookEnv_(nullptr) {}
+    virtual ~RuntimeModule();
+
+    // Environment teardown: stop every thread that could still call back into
+    // JS and give back the process-wide resources. The module is destroyed
+    // later, with the runtime.
+    virtual void Shutdown() = 0;
+
+    // Env teardown runs cleanup hooks newest first, and a TSFN is finalized
+    // from the hook it registers when created. Called once at creation and
+    // again right after creating a TSFN, so Shutdown() runs before any of
+    // the module's TSFNs go away.
+    void ArmShutdownHook(Napi::Env env);
+
+private:
+    static void RunShutdownHook(void* module);
+
+    napi_env hookEnv_;   // env the hook is registered with, nullptr once it ran
+};
+
+// Sub-module factories: fill exports and return the module that owns the
+// state behind them
+RuntimeModule* CreateShortcutModule(Napi::Env env, Napi::Object exports);
+RuntimeModule* CreateTopmostModule(Napi::Env env, Napi::Object exports);
+RuntimeModule* CreateGovernorModule(Napi::Env env, Napi::Object exports);
+
+// OS-level resources there can only be one of per process, whatever the
+// number of environments: the Win32 low-level input and WinEvent hooks
+// dispatch to a single active instance, and the governor owns the process
+// priorities. The first environment to start one owns it until it stops.
+enum ProcessResource {
+    kResourceInputListener,
+    kResourceTopmostWatcher,
+    kResourceGovernor,
+    kProcessResourceCount
+};
+
+// Any thread. True if owner now holds the resource (also if it already did).
+bool ClaimProcessResource(ProcessResource resource, const void* owner);
+// No-op unless owner holds it
+void ReleaseProcessResource(ProcessResource resource, const void* owner);
+
+// The focus notifications are process-wide as well (the Win32 WinEvent hook
+// dispatches to a single monitor), so every sub-module that follows the
+// foreground window subscribes to one shared ForegroundMonitor. It runs
+// while anyone is subscribed; a new subscriber is called at once with the
+// last reported app. Callbacks run on the monitor thread.
+//
+// JS thread. False if the focus cannot be tracked on this platform.
+bool SubscribeForeground(ForegroundChangedFn callback, void* context);
+// JS thread. Once it returns, the callback is neither running nor called again.
+void UnsubscribeForeground(ForegroundChangedFn callback, void* context);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-process CPU controls used by the resource governor.
+//
+// Implemented by process_control_linux.cc (per-thread setpriority and
+// sched_setaffinity, plus cpu.weight / cpuset.cpus of the app's own cgroup
+// v2 group), process_control_win32.cc (priority class, EcoQoS power
+// throttling, affinity mask) and process_control_null.cc. Only the governor
+// thread calls into it, so implementations keep their state unlocked.
+//
+// Everything applied is reversible: the original state of a process is
+// recorded on the first change and written back by RestoreAll(). Threads
+// that run above their process's priority (the input thread, audio) are
+// left alone.
+
+const size_t kMaxGovernorCpus = 256;
+typedef std::bitset<kMaxGovernorCpus> CpuSet;
+
+enum ProcessPriorityLevel {
+    kProcessPriorityNormal,       // as found
+    kProcessPriorityBackground,   // nice 10 / BELOW_NORMAL_PRIORITY_CLASS
+    kProcessPriorityEfficiency    // nice 19 / IDLE_PRIORITY_CLASS + EcoQoS
+};
+
+// Which controls took effect on the last Apply()
+struct ProcessControlCaps {
+    bool priority;     // nice / priority class lowered (and restorable)
+    bool efficiency;   // EcoQoS, or a lowered cgroup cpu.weight
+    bool affinity;     // CPU affinity restricted
+    bool cgroup;       // the app's cgroup v2 group was adjusted
+};
+
+class ProcessControl {
+public:
+    virtual ~ProcessControl() {}
+
+    // Lowers every process in pids to `level` and confines it to `cpus`
+    // (none = leave the affinity as found). Processes lowered earlier that
+    // are no longer in pids are restored. False if nothing could be applied.
+    virtual bool Apply(const std::vector<uint32_t>& pids, ProcessPriorityLevel level, const CpuSet& cpus) = 0;
+    // Writes back everything recorded since the first Apply()
+    virtual void RestoreAll() = 0;
+
+    // CPUs the overlay may keep while gamePid is foreground; none = no restriction
+    virtual CpuSet OverlayCpus(uint32_t gamePid) = 0;
+    // Executable file name without directory, empty if unknown
+    virtual std::string ProcessName(uint32_t pid) = 0;
+
+    virtual ProcessControlCaps Caps() const = 0;
+};
+
+// Implemented once per platform (process_control_linux.cc, process_control_win32.cc, ...)
+ProcessControl* CreateProcessControl();
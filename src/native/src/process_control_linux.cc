@@ -0,0 +1,424 @@
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "process_control.h"
+
+// Linux implementation of the governor's process controls.
+//
+// setpriority() and sched_setaffinity() act on single threads here, so every
+// task of a process is visited. Lowering the nice value is always allowed,
+// but going back needs CAP_SYS_NICE or a large enough RLIMIT_NICE; without
+// either the nice values are left alone rather than lowered for good, and
+// the cgroup's cpu.weight carries the priority change. The cgroup is only
+// touched when it holds nothing but the app's own processes.
+
+namespace {
+
+const int kBackgroundNice = 10;
+const int kEfficiencyNice = 19;
+
+// cpu.weight of the app's cgroup (kernel default 100)
+const char* const kBackgroundWeight = "50";
+const char* const kEfficiencyWeight = "20";
+
+// A game CPU stays reserved for this many samples after its last use
+const size_t kGameCpuSamples = 4;
+
+std::vector<int> ListTasks(uint32_t pid) {
+    std::vector<int> tasks;
+    std::string path = "/proc/" + std::to_string(pid) + "/task";
+    DIR* dir = opendir(path.c_str());
+    if (!dir) return tasks;
+    while (dirent* entry = readdir(dir)) {
+        int tid = atoi(entry->d_name);
+        if (tid > 0) tasks.push_back(tid);
+    }
+    closedir(dir);
+    return tasks;
+}
+
+bool ReadFile(const std::string& path, std::string* contents) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    contents->clear();
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        contents->append(buffer, static_cast<size_t>(n));
+    }
+    close(fd);
+    return n == 0;
+}
+
+bool WriteFile(const std::string& path, const std::string& value) {
+    int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool ok = write(fd, value.data(), value.size()) == static_cast<ssize_t>(value.size());
+    close(fd);
+    return ok;
+}
+
+std::string TrimLine(std::string value) {
+    while (!value.empty() && (value.back() == '\n' || value.back() == ' ')) value.pop_back();
+    return value;
+}
+
+bool GetNice(int tid, int* nice) {
+    errno = 0;
+    int value = getpriority(PRIO_PROCESS, static_cast<id_t>(tid));
+    if (value == -1 && errno != 0) return false;
+    *nice = value;
+    return true;
+}
+
+// An unprivileged thread may only return to `nice` within RLIMIT_NICE
+bool CanRestoreNice(int nice) {
+    if (geteuid() == 0) return true;
+    rlimit limit;
+    if (getrlimit(RLIMIT_NICE, &limit) != 0) return false;
+    return limit.rlim_cur == RLIM_INFINITY || static_cast<rlim_t>(20 - nice) <= limit.rlim_cur;
+}
+
+bool GetAffinity(int tid, CpuSet* cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(tid, sizeof(set), &set) != 0) return false;
+    cpus->reset();
+    for (size_t cpu = 0; cpu < kMaxGovernorCpus && cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set)) cpus->set(cpu);
+    }
+    return true;
+}
+
+bool SetAffinity(int tid, const CpuSet& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t cpu = 0; cpu < kMaxGovernorCpus && cpu < CPU_SETSIZE; cpu++) {
+        if (cpus.test(cpu)) CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(tid, sizeof(set), &set) == 0;
+}
+
+// Realtime threads and threads above their process's nice value were raised
+// on purpose (the input reader, audio) and keep their priority and CPUs
+bool IsElevated(int tid, int nice, int baseNice) {
+    int policy = sched_getscheduler(tid);
+    return policy == SCHED_FIFO || policy == SCHED_RR || nice < baseNice;
+}
+
+// "0-3,6" as cpuset.cpus wants it
+std::string FormatCpuList(const CpuSet& cpus) {
+    std::string list;
+    for (size_t cpu = 0; cpu < kMaxGovernorCpus; cpu++) {
+        if (!cpus.test(cpu)) continue;
+        size_t last = cpu;
+        while (last + 1 < kMaxGovernorCpus && cpus.test(last + 1)) last++;
+        if (!list.empty()) list += ',';
+        list += std::to_string(cpu);
+        if (last != cpu) list += '-' + std::to_string(last);
+        cpu = last;
+    }
+    return list;
+}
+
+struct SavedProcess {
+    int baseNice;                          // main thread, as found
+    CpuSet baseCpus;                       // main thread, as found
+    std::unordered_map<int, int> nice;     // tid -> nice before we changed it
+    std::unordered_set<int> elevated;      // never touched
+    bool reniced = false;                  // new threads inherit our nice value
+    bool affinityChanged = false;
+};
+
+// Original value of a cgroup file, recorded by the first write
+struct SavedCgroupValue {
+    bool valid = false;
+    std::string value;
+};
+
+class LinuxProcessControl : public ProcessControl {
+public:
+    LinuxProcessControl() : caps_(), gamePid_(0), samples_(0) {
+        GetAffinity(0, &ownCpus_);
+    }
+
+    ~LinuxProcessControl() override { RestoreAll(); }
+
+    bool Apply(const std::vector<uint32_t>& pids, ProcessPriorityLevel level, const CpuSet& cpus) override {
+        caps_ = ProcessControlCaps();
+        bool applied = false;
+        for (uint32_t pid : pids) {
+            applied |= ApplyProcess(pid, level, cpus);
+        }
+        for (auto it = saved_.begin(); it != saved_.end();) {
+            if (std::find(pids.begin(), pids.end(), it->first) == pids.end()) {
+                RestoreProcess(it->first, it->second);
+                it = saved_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        applied |= ApplyCgroup(pids, level, cpus);
+        return applied;
+    }
+
+    void RestoreAll() override {
+        for (auto& entry : saved_) {
+            RestoreProcess(entry.first, entry.second);
+        }
+        saved_.clear();
+        RestoreCgroup();
+        caps_ = ProcessControlCaps();
+    }
+
+    // Samples which CPUs the game's threads ran on since the last call: a
+    // thread whose CPU time grew last ran on the CPU in field 39 of its stat
+    CpuSet OverlayCpus(uint32_t gamePid) override {
+        if (gamePid != gamePid_) {
+            gamePid_ = gamePid;
+            gameTicks_.clear();
+            for (CpuSet& history : busyHistory_) history.reset();
+            samples_ = 0;
+        }
+
+        CpuSet busy;
+        std::unordered_map<int, uint64_t> ticks;
+        std::string stat;
+        for (int tid : ListTasks(gamePid)) {
+            if (!ReadFile("/proc/" + std::to_string(gamePid) + "/task/" + std::to_string(tid) + "/stat", &stat)) {
+                continue;
+            }
+            // The command may contain spaces and parentheses; fields resume after the last ')'
+            size_t close = stat.rfind(')');
+            if (close == std::string::npos) continue;
+            const char* cursor = stat.c_str() + close + 1;
+            uint64_t cpuTime = 0;
+            long processor = -1;
+            for (int field = 3; field <= 39 && *cursor; field++) {
+                char* end;
+                while (*cursor == ' ') cursor++;
+                if (field == 14 || field == 15) {
+                    cpuTime += strtoull(cursor, &end, 10);
+                } else if (field == 39) {
+                    processor = strtol(cursor, &end, 10);
+                } else {
+                    end = const_cast<char*>(strchr(cursor, ' '));
+                    if (!end) break;
+                }
+                cursor = end;
+            }
+            ticks[tid] = cpuTime;
+            auto previous = gameTicks_.find(tid);
+            if (previous != gameTicks_.end() && cpuTime > previous->second &&
+                processor >= 0 && static_cast<size_t>(processor) < kMaxGovernorCpus) {
+                busy.set(static_cast<size_t>(processor));
+            }
+        }
+        gameTicks_.swap(ticks);
+        busyHistory_[samples_++ % kGameCpuSamples] = busy;
+
+        CpuSet gameCpus;
+        for (const CpuSet& history : busyHistory_) gameCpus |= history;
+        if (gameCpus.none()) return CpuSet();
+
+        CpuSet overlay = ownCpus_ & ~gameCpus;
+        if (overlay.none()) {
+            // The game keeps every CPU busy: share the highest-numbered one
+            for (size_t cpu = kMaxGovernorCpus; cpu-- > 0;) {
+                if (ownCpus_.test(cpu)) {
+                    overlay.set(cpu);
+                    break;
+                }
+            }
+        }
+        return overlay;
+    }
+
+    // argv[0] rather than comm, which is cut at 15 bytes; Wine puts the
+    // Windows path there, so '\' separates directories too
+    std::string ProcessName(uint32_t pid) override {
+        std::string contents;
+        std::string base = "/proc/" + std::to_string(pid);
+        if (ReadFile(base + "/cmdline", &contents) && !contents.empty()) {
+            std::string argv0 = contents.substr(0, contents.find('\0'));
+            size_t slash = argv0.find_last_of("/\\");
+            return slash == std::string::npos ? argv0 : argv0.substr(slash + 1);
+        }
+        return ReadFile(base + "/comm", &contents) ? TrimLine(contents) : std::string();
+    }
+
+    ProcessControlCaps Caps() const override { return caps_; }
+
+private:
+    bool ApplyProcess(uint32_t pid, ProcessPriorityLevel level, const CpuSet& cpus) {
+        auto found = saved_.find(pid);
+        if (found == saved_.end()) {
+            SavedProcess process;
+            if (!GetNice(static_cast<int>(pid), &process.baseNice) ||
+                !GetAffinity(static_cast<int>(pid), &process.baseCpus)) {
+                return false;
+            }
+            found = saved_.emplace(pid, process).first;
+        }
+        SavedProcess& process = found->second;
+
+        int targetNice = level == kProcessPriorityEfficiency ? kEfficiencyNice :
+                         level == kProcessPriorityBackground ? kBackgroundNice : process.baseNice;
+        bool renice = level != kProcessPriorityNormal && CanRestoreNice(process.baseNice);
+        CpuSet targetCpus = cpus & process.baseCpus;
+        bool restrict = targetCpus.any();
+        bool applied = false;
+
+        for (int tid : ListTasks(pid)) {
+            if (process.elevated.count(tid)) continue;
+            int nice;
+            if (!GetNice(tid, &nice)) continue;
+            auto savedNice = process.nice.find(tid);
+            if (savedNice == process.nice.end()) {
+                if (IsElevated(tid, nice, process.baseNice)) {
+                    process.elevated.insert(tid);
+                    continue;
+                }
+                // Threads started while lowered inherited our nice value
+                savedNice = process.nice.emplace(tid, process.reniced ? process.baseNice : nice).first;
+            }
+
+            int wanted = renice ? std::max(targetNice, savedNice->second) : savedNice->second;
+            if (nice != wanted && CanRestoreNice(savedNice->second) &&
+                setpriority(PRIO_PROCESS, static_cast<id_t>(tid), wanted) == 0 && renice) {
+                caps_.priority = true;
+                applied = true;
+            }
+            if ((restrict || process.affinityChanged) && SetAffinity(tid, restrict ? targetCpus : process.baseCpus) &&
+                restrict) {
+                caps_.affinity = true;
+                applied = true;
+            }
+        }
+        process.reniced = renice;
+        process.affinityChanged = restrict;
+        return applied;
+    }
+
+    void RestoreProcess(uint32_t pid, SavedProcess& process) {
+        for (int tid : ListTasks(pid)) {
+            if (process.elevated.count(tid)) continue;
+            auto savedNice = process.nice.find(tid);
+            int original = savedNice != process.nice.end() ? savedNice->second : process.baseNice;
+            int nice;
+            if (process.reniced && GetNice(tid, &nice) && nice != original) {
+                setpriority(PRIO_PROCESS, static_cast<id_t>(tid), original);
+            }
+            if (process.affinityChanged) {
+                SetAffinity(tid, process.baseCpus);
+            }
+        }
+        process.reniced = false;
+        process.affinityChanged = false;
+    }
+
+    // The app's own cgroup v2 group, if it holds only the app's processes
+    bool ApplyCgroup(const std::vector<uint32_t>& pids, ProcessPriorityLevel level, const CpuSet& cpus) {
+        if (!cgroupProbed_) {
+            cgroupProbed_ = true;
+            std::string contents;
+            if (ReadFile("/proc/self/cgroup", &contents)) {
+                size_t start = contents.find("0::");
+                if (start != std::string::npos) {
+                    std::string path = TrimLine(contents.substr(start + 3, contents.find('\n', start) - start - 3));
+                    if (path != "/" && !path.empty()) cgroupDir_ = "/sys/fs/cgroup" + path;
+                }
+            }
+        }
+        if (cgroupDir_.empty()) return false;
+
+        std::string members;
+        if (!ReadFile(cgroupDir_ + "/cgroup.procs", &members)) return false;
+        const char* cursor = members.c_str();
+        while (*cursor) {
+            char* end;
+            unsigned long member = strtoul(cursor, &end, 10);
+            if (end == cursor) break;
+            if (std::find(pids.begin(), pids.end(), static_cast<uint32_t>(member)) == pids.end()) {
+                RestoreCgroup();
+                return false;
+            }
+            cursor = end;
+            while (*cursor == '\n') cursor++;
+        }
+
+        bool applied = false;
+        if (level != kProcessPriorityNormal) {
+            applied |= WriteCgroupFile("cpu.weight",
+                                       level == kProcessPriorityEfficiency ? kEfficiencyWeight : kBackgroundWeight,
+                                       &savedWeight_);
+            caps_.efficiency |= applied && level == kProcessPriorityEfficiency;
+        } else {
+            RestoreCgroupFile("cpu.weight", &savedWeight_);
+        }
+        if (cpus.any()) {
+            applied |= WriteCgroupFile("cpuset.cpus", FormatCpuList(cpus), &savedCpus_);
+        } else {
+            RestoreCgroupFile("cpuset.cpus", &savedCpus_);
+        }
+        caps_.cgroup = applied;
+        return applied;
+    }
+
+    bool WriteCgroupFile(const char* name, const std::string& value, SavedCgroupValue* saved) {
+        std::string path = cgroupDir_ + "/" + name;
+        if (!saved->valid) {
+            std::string original;
+            if (access(path.c_str(), W_OK) != 0 || !ReadFile(path, &original)) return false;
+            saved->value = TrimLine(original);
+            saved->valid = true;
+        }
+        return WriteFile(path, value);
+    }
+
+    // An empty cpuset.cpus means "inherit the parent's"
+    void RestoreCgroupFile(const char* name, SavedCgroupValue* saved) {
+        if (!saved->valid) return;
+        WriteFile(cgroupDir_ + "/" + name, saved->value.empty() ? std::string("\n") : saved->value);
+        saved->valid = false;
+    }
+
+    void RestoreCgroup() {
+        if (cgroupDir_.empty()) return;
+        RestoreCgroupFile("cpu.weight", &savedWeight_);
+        RestoreCgroupFile("cpuset.cpus", &savedCpus_);
+    }
+
+    ProcessControlCaps caps_;
+    std::unordered_map<uint32_t, SavedProcess> saved_;
+    CpuSet ownCpus_;
+
+    bool cgroupProbed_ = false;
+    std::string cgroupDir_;
+    SavedCgroupValue savedWeight_;
+    SavedCgroupValue savedCpus_;
+
+    uint32_t gamePid_;
+    std::unordered_map<int, uint64_t> gameTicks_;
+    CpuSet busyHistory_[kGameCpuSamples];
+    size_t samples_;
+};
+
+} // namespace
+
+ProcessControl* CreateProcessControl() {
+    return new LinuxProcessControl();
+}
@@ -0,0 +1,21 @@
+#include "process_control.h"
+
+// Fallback for platforms without process controls: the governor still
+// tracks states and time spent in them, but nothing is changed.
+
+namespace {
+
+class NullProcessControl : public ProcessControl {
+public:
+    bool Apply(const std::vector<uint32_t>&, ProcessPriorityLevel, const CpuSet&) override { return false; }
+    void RestoreAll() override {}
+    CpuSet OverlayCpus(uint32_t) override { return CpuSet(); }
+    std::string ProcessName(uint32_t) override { return std::string(); }
+    ProcessControlCaps Caps() const override { return ProcessControlCaps(); }
+};
+
+} // namespace
+
+ProcessControl* CreateProcessControl() {
+    return new NullProcessControl();
+}
@@ -0,0 +1,227 @@
+#include <windows.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "process_control.h"
+
+// Win32 implementation of the governor's process controls.
+//
+// Priority classes are relative: the TIME_CRITICAL input thread keeps
+// priority 15 even in IDLE_PRIORITY_CLASS, so the app's own process is only
+// given a lower class. EcoQoS and the affinity mask would apply to that
+// thread too and are kept for the other processes (renderers, GPU).
+//
+// Windows does not report which cores a process runs on without a kernel
+// trace, so the overlay is confined to the efficiency cores of a hybrid CPU,
+// or to the highest quarter of the logical processors where the scheduler
+// puts game threads last.
+
+namespace {
+
+struct SavedProcess {
+    DWORD priorityClass;
+    DWORD_PTR affinity;
+    bool throttled = false;
+    bool affinityChanged = false;
+};
+
+HANDLE OpenForControl(uint32_t pid) {
+    return OpenProcess(PROCESS_SET_INFORMATION | PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+}
+
+// EcoQoS on (Windows 11 also moves the process to efficiency cores), or back
+// to letting the system decide
+bool SetEfficiencyMode(HANDLE process, bool enable) {
+    PROCESS_POWER_THROTTLING_STATE state;
+    ZeroMemory(&state, sizeof(state));
+    state.Version = PROCESS_POWER_THROTTLING_CURRENT_VERSION;
+    state.ControlMask = enable ? PROCESS_POWER_THROTTLING_EXECUTION_SPEED : 0;
+    state.StateMask = enable ? PROCESS_POWER_THROTTLING_EXECUTION_SPEED : 0;
+    return SetProcessInformation(process, ProcessPowerThrottling, &state, sizeof(state)) != FALSE;
+}
+
+DWORD_PTR ToMask(const CpuSet& cpus) {
+    DWORD_PTR mask = 0;
+    for (size_t cpu = 0; cpu < sizeof(DWORD_PTR) * 8; cpu++) {
+        if (cpus.test(cpu)) mask |= static_cast<DWORD_PTR>(1) << cpu;
+    }
+    return mask;
+}
+
+class Win32ProcessControl : public ProcessControl {
+public:
+    Win32ProcessControl() : caps_(), overlayCpusKnown_(false) {}
+    ~Win32ProcessControl() override { RestoreAll(); }
+
+    bool Apply(const std::vector<uint32_t>& pids, ProcessPriorityLevel level, const CpuSet& cpus) override {
+        caps_ = ProcessControlCaps();
+        bool applied = false;
+        for (uint32_t pid : pids) {
+            applied |= ApplyProcess(pid, level, cpus);
+        }
+        for (auto it = saved_.begin(); it != saved_.end();) {
+            if (std::find(pids.begin(), pids.end(), it->first) == pids.end()) {
+                RestoreProcess(it->first, it->second);
+                it = saved_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return applied;
+    }
+
+    void RestoreAll() override {
+        for (auto& entry : saved_) {
+            RestoreProcess(entry.first, entry.second);
+        }
+        saved_.clear();
+        caps_ = ProcessControlCaps();
+    }
+
+    CpuSet OverlayCpus(uint32_t) override {
+        if (!overlayCpusKnown_) {
+            overlayCpus_ = FindOverlayCpus();
+            overlayCpusKnown_ = true;
+        }
+        return overlayCpus_;
+    }
+
+    std::string ProcessName(uint32_t pid) override {
+        HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+        if (!process) return std::string();
+        wchar_t path[MAX_PATH];
+        DWORD length = MAX_PATH;
+        std::string name;
+        if (QueryFullProcessImageNameW(process, 0, path, &length)) {
+            const wchar_t* base = path;
+            for (DWORD i = 0; i < length; i++) {
+                if (path[i] == L'\\' || path[i] == L'/') base = path + i + 1;
+            }
+            int baseLength = static_cast<int>(path + length - base);
+            int utf8Length = WideCharToMultiByte(CP_UTF8, 0, base, baseLength, NULL, 0, NULL, NULL);
+            if (utf8Length > 0) {
+                name.resize(utf8Length);
+                WideCharToMultiByte(CP_UTF8, 0, base, baseLength, &name[0], utf8Length, NULL, NULL);
+            }
+        }
+        CloseHandle(process);
+        return name;
+    }
+
+    ProcessControlCaps Caps() const override { return caps_; }
+
+private:
+    bool ApplyProcess(uint32_t pid, ProcessPriorityLevel level, const CpuSet& cpus) {
+        HANDLE process = OpenForControl(pid);
+        if (!process) return false;
+
+        auto found = saved_.find(pid);
+        if (found == saved_.end()) {
+            SavedProcess saved;
+            DWORD_PTR systemAffinity;
+            saved.priorityClass = GetPriorityClass(process);
+            if (saved.priorityClass == 0 || !GetProcessAffinityMask(process, &saved.affinity, &systemAffinity)) {
+                CloseHandle(process);
+                return false;
+            }
+            found = saved_.emplace(pid, saved).first;
+        }
+        SavedProcess& saved = found->second;
+        bool own = pid == GetCurrentProcessId();
+        bool applied = false;
+
+        DWORD priorityClass = level == kProcessPriorityEfficiency ? IDLE_PRIORITY_CLASS :
+                              level == kProcessPriorityBackground ? BELOW_NORMAL_PRIORITY_CLASS : saved.priorityClass;
+        if (SetPriorityClass(process, priorityClass) && level != kProcessPriorityNormal) {
+            caps_.priority = true;
+            applied = true;
+        }
+
+        bool throttle = level == kProcessPriorityEfficiency && !own;
+        if (throttle != saved.throttled && SetEfficiencyMode(process, throttle)) {
+            saved.throttled = throttle;
+        }
+        caps_.efficiency |= saved.throttled;
+        applied |= saved.throttled;
+
+        DWORD_PTR mask = own ? 0 : ToMask(cpus) & saved.affinity;
+        if (mask != 0 && SetProcessAffinityMask(process, mask)) {
+            saved.affinityChanged = true;
+            caps_.affinity = true;
+            applied = true;
+        } else if (mask == 0 && saved.affinityChanged && SetProcessAffinityMask(process, saved.affinity)) {
+            saved.affinityChanged = false;
+        }
+
+        CloseHandle(process);
+        return applied;
+    }
+
+    void RestoreProcess(uint32_t pid, SavedProcess& saved) {
+        HANDLE process = OpenForControl(pid);
+        if (!process) return;
+        SetPriorityClass(process, saved.priorityClass);
+        if (saved.throttled) SetEfficiencyMode(process, false);
+        if (saved.affinityChanged) SetProcessAffinityMask(process, saved.affinity);
+        saved.throttled = false;
+        saved.affinityChanged = false;
+        CloseHandle(process);
+    }
+
+    // Efficiency cores (lowest EfficiencyClass) of a hybrid CPU in group 0,
+    // else the top quarter of the process's processors
+    static CpuSet FindOverlayCpus() {
+        CpuSet cpus;
+        ULONG length = 0;
+        GetSystemCpuSetInformation(NULL, 0, &length, GetCurrentProcess(), 0);
+        std::vector<char> buffer(length);
+        if (length && GetSystemCpuSetInformation(reinterpret_cast<PSYSTEM_CPU_SET_INFORMATION>(buffer.data()),
+                                                 length, &length, GetCurrentProcess(), 0)) {
+            BYTE lowest = 0xFF, highest = 0;
+            for (ULONG offset = 0; offset < length;) {
+                auto* info = reinterpret_cast<PSYSTEM_CPU_SET_INFORMATION>(buffer.data() + offset);
+                if (info->Type == CpuSetInformation && info->CpuSet.Group == 0) {
+                    lowest = (std::min)(lowest, info->CpuSet.EfficiencyClass);
+                    highest = (std::max)(highest, info->CpuSet.EfficiencyClass);
+                }
+                offset += info->Size;
+            }
+            for (ULONG offset = 0; lowest < highest && offset < length;) {
+                auto* info = reinterpret_cast<PSYSTEM_CPU_SET_INFORMATION>(buffer.data() + offset);
+                if (info->Type == CpuSetInformation && info->CpuSet.Group == 0 &&
+                    info->CpuSet.EfficiencyClass == lowest && info->CpuSet.LogicalProcessorIndex < kMaxGovernorCpus) {
+                    cpus.set(info->CpuSet.LogicalProcessorIndex);
+                }
+                offset += info->Size;
+            }
+            if (cpus.any()) return cpus;
+        }
+
+        DWORD_PTR processAffinity, systemAffinity;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &processAffinity, &systemAffinity)) return cpus;
+        std::vector<size_t> allowed;
+        for (size_t cpu = 0; cpu < sizeof(DWORD_PTR) * 8; cpu++) {
+            if (processAffinity & (static_cast<DWORD_PTR>(1) << cpu)) allowed.push_back(cpu);
+        }
+        size_t keep = (std::max)(allowed.size() / 4, static_cast<size_t>(1));
+        if (allowed.size() <= keep) return cpus;
+        for (size_t i = allowed.size() - keep; i < allowed.size(); i++) {
+            cpus.set(allowed[i]);
+        }
+        return cpus;
+    }
+
+    ProcessControlCaps caps_;
+    std::unordered_map<uint32_t, SavedProcess> saved_;
+    bool overlayCpusKnown_;
+    CpuSet overlayCpus_;
+};
+
+} // namespace
+
+ProcessControl* CreateProcessControl() {
+    return new Win32ProcessControl();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Single-reader RCU pointer.
+//
+// One reader thread (the input thread) brackets each access with ReadLock()/
+// ReadUnlock(); one writer thread (the JS thread) swaps in new objects with
+// Publish(). The writer never waits for the reader: a replaced object is
+// retired with the epoch of its replacement and deleted by a later Publish()
+// or Reclaim() once the reader is outside a read section or has entered one
+// in a newer epoch. The reader side costs one store and two loads.
+
+template <typename T>
+class RcuPointer {
+public:
+    RcuPointer() : current_(nullptr), epoch_(1), readerEpoch_(0) {}
+
+    ~RcuPointer() {
+        delete current_.load(std::memory_order_relaxed);
+        for (const Retired& retired : retired_) {
+            delete retired.object;
+        }
+    }
+
+    RcuPointer(const RcuPointer&) = delete;
+    RcuPointer& operator=(const RcuPointer&) = delete;
+
+    // Reader thread. The returned object stays valid until ReadUnlock().
+    const T* ReadLock() {
+        // Invariant: a reader announcing epoch E holds no object retired with
+        // an epoch <= E. Publish() swaps the pointer before the fetch_add that
+        // makes E, so the acquire load of E orders our pointer load after that
+        // swap and we cannot get the object E retired. The seq_cst store then
+        // load covers the other side: a writer that does not see this epoch
+        // has published before our load, so we cannot hold what it retires.
+        readerEpoch_.store(epoch_.load(std::memory_order_acquire), std::memory_order_seq_cst);
+        return current_.load(std::memory_order_seq_cst);
+    }
+
+    void ReadUnlock() {
+        readerEpoch_.store(0, std::memory_order_release);
+    }
+
+    // Writer thread: takes ownership of `next`
+    void Publish(T* next) {
+        T* old = current_.exchange(next, std::memory_order_seq_cst);
+        uint64_t epoch = epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+        if (old) {
+            retired_.push_back(Retired{old, epoch});
+        }
+        Reclaim();
+    }
+
+    // Writer thread: frees every retired object the reader can no longer hold
+    void Reclaim() {
+        if (retired_.empty()) return;
+        uint64_t reader = readerEpoch_.load(std::memory_order_seq_cst);
+        size_t kept = 0;
+        for (size_t i = 0; i < retired_.size(); i++) {
+            if (reader == 0 || reader >= retired_[i].epoch) {
+                delete retired_[i].object;
+            } else {
+                retired_[kept++] = retired_[i];
+            }
+        }
+        retired_.resize(kept);
+    }
+
+    // Writer thread only
+    const T* Current() const { return current_.load(std::memory_order_relaxed); }
+    size_t RetiredCount() const { return retired_.size(); }
+
+private:
+    struct Retired {
+        T* object;
+        uint64_t epoch;
+    };
+
+    std::atomic<T*> current_;
+    std::atomic<uint64_t> epoch_;
+    std::atomic<uint64_t> readerEpoch_;   // 0 = reader outside a read section
+    std::vector<Retired> retired_;        // writer thread only
+};
@@ -0,0 +1,236 @@
+#include "resource_governor.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "event_ring.h"
+#include "title_matcher.h"
+#include "window_platform.h"
+
+namespace {
+
+const char* const kGovernorStateNames[kGovernorStateCount] = { "active", "background", "game" };
+
+} // namespace
+
+const char* GovernorStateName(int state) {
+    return state >= 0 && state < kGovernorStateCount ? kGovernorStateNames[state] : "unknown";
+}
+
+ResourceGovernor::ResourceGovernor()
+    : control_(nullptr), stopping_(false), dirty_(false), visible_(true), reportedPid_(0), showRequestNs_(0),
+      state_(kGovernorActive), stateSinceNs_(SteadyNowNs()), stateNs_(), transitions_(0), steps_(0), applies_(0),
+      applyFailures_(0), foregroundPid_(0), caps_(), checkedPid_(0), checkedIsGame_(false) {}
+
+ResourceGovernor::~ResourceGovernor() {
+    Stop();
+}
+
+void ResourceGovernor::Start(ProcessControl* control, const GovernorConfig& config) {
+    Stop();
+    control_ = control;
+    config_ = config;
+    if (config_.periodMs == 0) config_.periodMs = 1;
+    foldedGames_.clear();
+    for (const std::string& game : config_.games) {
+        foldedGames_.push_back(FoldCaseUtf8(game));
+    }
+    checkedPid_ = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = false;
+        dirty_ = true;
+    }
+    thread_ = std::thread(&ResourceGovernor::Run, this);
+}
+
+void ResourceGovernor::Stop() {
+    if (!thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+
+    control_->RestoreAll();
+    std::lock_guard<std::mutex> lock(mutex_);
+    AccountTime(SteadyNowNs());
+    if (state_ != kGovernorActive) transitions_++;
+    state_ = kGovernorActive;
+    cpus_.reset();
+    caps_ = ProcessControlCaps();
+}
+
+void ResourceGovernor::SetProcesses(const std::vector<uint32_t>& pids) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pids == pids_) return;
+        pids_ = pids;
+        dirty_ = true;
+    }
+    wake_.notify_one();
+}
+
+void ResourceGovernor::SetOverlayVisible(bool visible) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (visible == visible_) return;
+        visible_ = visible;
+        dirty_ = true;
+        showRequestNs_ = visible && state_ != kGovernorActive ? SteadyNowNs() : 0;
+    }
+    wake_.notify_one();
+}
+
+void ResourceGovernor::OnForegroundChanged(const ForegroundApp& app, void* governor) {
+    static_cast<ResourceGovernor*>(governor)->SetForegroundPid(app.pid);
+}
+
+void ResourceGovernor::SetForegroundPid(uint32_t pid) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pid == reportedPid_) return;
+        reportedPid_ = pid;
+        // Picked up when the overlay hides
+        if (visible_) return;
+        dirty_ = true;
+    }
+    wake_.notify_one();
+}
+
+GovernorStats ResourceGovernor::Stats() const {
+    GovernorStats stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.state = state_;
+        stats.foregroundPid = foregroundPid_;
+        stats.transitions = transitions_;
+        stats.steps = steps_;
+        stats.applies = applies_;
+        stats.applyFailures = applyFailures_;
+        for (int state = 0; state < kGovernorStateCount; state++) {
+            stats.stateNs[state] = stateNs_[state];
+        }
+        stats.stateNs[state_] += SteadyNowNs() - stateSinceNs_;
+        stats.overlayCpus = cpus_.count();
+        stats.caps = caps_;
+    }
+    stats.restore = restore_.Summarize();
+    return stats;
+}
+
+void ResourceGovernor::ResetStats() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int state = 0; state < kGovernorStateCount; state++) {
+            stateNs_[state] = 0;
+        }
+        stateSinceNs_ = SteadyNowNs();
+        transitions_ = 0;
+        steps_ = 0;
+        applies_ = 0;
+        applyFailures_ = 0;
+    }
+    restore_.Reset();
+}
+
+void ResourceGovernor::AccountTime(uint64_t nowNs) {
+    stateNs_[state_] += nowNs - stateSinceNs_;
+    stateSinceNs_ = nowNs;
+}
+
+void ResourceGovernor::Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        lock.unlock();
+        Step();
+        lock.lock();
+        auto changed = [this] { return stopping_ || dirty_; };
+        bool poll = !visible_ &&
+                    (!config_.foregroundEvents || (state_ == kGovernorGame && config_.restrictAffinity));
+        if (poll) {
+            wake_.wait_for(lock, std::chrono::milliseconds(config_.periodMs), changed);
+        } else {
+            wake_.wait(lock, changed);
+        }
+    }
+}
+
+// Governor thread: one look at the foreground, applied if anything changed
+void ResourceGovernor::Step() {
+    std::vector<uint32_t> pids;
+    bool visible;
+    bool dirty;
+    GovernorState previous;
+    CpuSet previousCpus;
+    uint32_t foregroundPid;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pids = pids_;
+        visible = visible_;
+        dirty = dirty_;
+        dirty_ = false;
+        previous = state_;
+        previousCpus = cpus_;
+        foregroundPid = reportedPid_;
+        steps_++;
+    }
+
+    if (!config_.foregroundEvents) {
+        foregroundPid = 0;
+        GetForegroundWindowPid(&foregroundPid);
+    }
+    bool ours = std::find(pids.begin(), pids.end(), foregroundPid) != pids.end();
+
+    GovernorState state = kGovernorActive;
+    if (!visible && !ours) {
+        state = foregroundPid != 0 && IsGame(foregroundPid) ? kGovernorGame : kGovernorBackground;
+    }
+    CpuSet cpus;
+    if (state == kGovernorGame && config_.restrictAffinity) {
+        cpus = control_->OverlayCpus(foregroundPid);
+    }
+
+    bool apply = dirty || state != previous || cpus != previousCpus;
+    bool failed = false;
+    if (apply) {
+        if (state == kGovernorActive) {
+            control_->RestoreAll();
+        } else {
+            ProcessPriorityLevel level = state == kGovernorGame && config_.efficiency ? kProcessPriorityEfficiency
+                                                                                      : kProcessPriorityBackground;
+            failed = !control_->Apply(pids, level, cpus);
+        }
+    }
+
+    uint64_t now = SteadyNowNs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    foregroundPid_ = foregroundPid;
+    if (state != previous) {
+        AccountTime(now);
+        state_ = state;
+        transitions_++;
+    }
+    if (apply) {
+        applies_++;
+        if (failed) applyFailures_++;
+        cpus_ = cpus;
+        caps_ = control_->Caps();
+    }
+    if (showRequestNs_ != 0 && state == kGovernorActive) {
+        restore_.Record(now - showRequestNs_);
+        showRequestNs_ = 0;
+    }
+}
+
+// Executable names are looked up once per foreground process
+bool ResourceGovernor::IsGame(uint32_t pid) {
+    if (foldedGames_.empty()) return true;
+    if (pid != checkedPid_) {
+        checkedPid_ = pid;
+        std::string name = FoldCaseUtf8(control_->ProcessName(pid));
+        checkedIsGame_ = std::find(foldedGames_.begin(), foldedGames_.end(), name) != foldedGames_.end();
+    }
+    return checkedIsGame_;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "foreground_monitor.h"
+#include "latency_histogram.h"
+#include "process_control.h"
+
+// Lowers the app's CPU priority while the overlay is out of the way.
+//
+// A governor thread moves the app's processes (main, renderers, GPU; given
+// from JS) between:
+//   active      overlay visible, or one of the app's windows focused:
+//               everything as found
+//   background  overlay hidden, another application focused: background
+//               priority
+//   game        overlay hidden, a game focused: efficiency priority, and
+//               confined to CPUs the game is not using
+// The thread only wakes when something reports a change: the overlay shown
+// or hidden, the process list, or a ForegroundMonitor (via
+// OnForegroundChanged) reporting a newly focused window. While the overlay
+// is visible nothing else can change the state, so it stays asleep. The one
+// poll left is the game state re-sampling the game's CPUs every periodMs;
+// without foreground events the foreground window is polled the same way,
+// but only while the overlay is hidden.
+
+const uint32_t kGovernorPeriodMs = 500;
+
+enum GovernorState {
+    kGovernorActive,
+    kGovernorBackground,
+    kGovernorGame,
+    kGovernorStateCount
+};
+
+const char* GovernorStateName(int state);
+
+struct GovernorConfig {
+    // game: affinity re-sample period; also the foreground poll period
+    // without foregroundEvents
+    uint32_t periodMs = kGovernorPeriodMs;
+    // The foreground comes from OnForegroundChanged() instead of polling
+    bool foregroundEvents = false;
+    bool efficiency = true;          // game: efficiency instead of background priority
+    bool restrictAffinity = true;    // game: keep off the game's CPUs
+    // Executable names that count as games (case-insensitive); empty = any other application
+    std::vector<std::string> games;
+};
+
+struct GovernorStats {
+    GovernorState state;
+    uint32_t foregroundPid;
+    uint64_t transitions;
+    uint64_t steps;                          // governor thread wakeups
+    uint64_t applies;                        // ProcessControl calls
+    uint64_t applyFailures;                  // calls that changed nothing
+    uint64_t stateNs[kGovernorStateCount];   // including the current stretch
+    size_t overlayCpus;                      // CPUs the app is confined to, 0 = all
+    ProcessControlCaps caps;
+    LatencySummary restore;                  // overlay shown -> restored, ns
+};
+
+class ResourceGovernor {
+public:
+    ResourceGovernor();
+    ~ResourceGovernor();
+
+    // JS thread. The control must outlive Stop().
+    void Start(ProcessControl* control, const GovernorConfig& config);
+    // Restores everything, then joins the governor thread
+    void Stop();
+    bool Running() const { return thread_.joinable(); }
+
+    void SetProcesses(const std::vector<uint32_t>& pids);
+    void SetOverlayVisible(bool visible);
+    // Any thread, also before Start(). A ForegroundChangedFn, context = the governor.
+    static void OnForegroundChanged(const ForegroundApp& app, void* governor);
+
+    GovernorStats Stats() const;
+    void ResetStats();
+
+private:
+    void Run();
+    void Step();
+    void SetForegroundPid(uint32_t pid);
+    bool IsGame(uint32_t pid);
+    // mutex_ held
+    void AccountTime(uint64_t nowNs);
+
+    ProcessControl* control_;
+    GovernorConfig config_;
+    std::vector<std::string> foldedGames_;
+
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+
+    // Guarded by mutex_
+    bool stopping_;
+    bool dirty_;                    // processes or visibility changed since the last step
+    std::vector<uint32_t> pids_;
+    bool visible_;
+    uint32_t reportedPid_;          // last OnForegroundChanged(), 0 = none yet
+    uint64_t showRequestNs_;        // 0 = no restore pending
+    GovernorState state_;
+    uint64_t stateSinceNs_;
+    uint64_t stateNs_[kGovernorStateCount];
+    uint64_t transitions_;
+    uint64_t steps_;
+    uint64_t applies_;
+    uint64_t applyFailures_;
+    uint32_t foregroundPid_;
+    CpuSet cpus_;
+    ProcessControlCaps caps_;
+
+    // Governor thread only: the last foreground process checked against the games
+    uint32_t checkedPid_;
+    bool checkedIsGame_;
+
+    LatencyHistogram restore_;
+};
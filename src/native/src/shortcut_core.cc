@@ -0,0 +1,541 @@
+#include "shortcut_core.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "key_names.h"
+
+namespace {
+
+inline bool IsBlank(char c) {
+    return isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+void SetError(std::string* error, const std::string& message) {
+    if (error) *error = message;
+}
+
+// [begin, end) without surrounding whitespace
+void Trim(const char* text, size_t& begin, size_t& end) {
+    while (begin < end && IsBlank(text[begin])) begin++;
+    while (end > begin && IsBlank(text[end - 1])) end--;
+}
+
+} // namespace
+
+bool ParseKeyStroke(const char* text, size_t length, KeyStroke* stroke, uint32_t& mouseButton,
+                    std::string* error) {
+    stroke->modifiers = 0;
+    stroke->vkCode = 0;
+    mouseButton = 0;
+
+    size_t begin = 0, end = length;
+    Trim(text, begin, end);
+    if (begin == end) {
+        SetError(error, "empty key");
+        return false;
+    }
+
+    // The key is the last '+'-separated token; "Ctrl++" and "+" name the '+' key
+    size_t keyBegin, modsEnd;
+    bool hasModifiers;
+    if (text[end - 1] == '+') {
+        size_t sep = end - 1;
+        while (sep > begin && IsBlank(text[sep - 1])) sep--;
+        hasModifiers = sep != begin;
+        if (hasModifiers && text[sep - 1] != '+') {
+            SetError(error, "missing key after '" + std::string(text + begin, end - begin) + "'");
+            return false;
+        }
+        modsEnd = hasModifiers ? sep - 1 : begin;
+        keyBegin = end - 1;
+    } else {
+        keyBegin = end;
+        while (keyBegin > begin && text[keyBegin - 1] != '+') keyBegin--;
+        hasModifiers = keyBegin != begin;
+        modsEnd = hasModifiers ? keyBegin - 1 : begin;
+    }
+
+    // Modifiers
+    for (size_t pos = begin; hasModifiers; ) {
+        size_t next = pos;
+        while (next < modsEnd && text[next] != '+') next++;
+        size_t tokenBegin = pos, tokenEnd = next;
+        Trim(text, tokenBegin, tokenEnd);
+        if (tokenBegin == tokenEnd) {
+            SetError(error, "empty key name in '" + std::string(text + begin, end - begin) + "'");
+            return false;
+        }
+        std::string token(text + tokenBegin, tokenEnd - tokenBegin);
+        const KeyName* name = FindKeyName(token.data(), token.size());
+        if (!name) {
+            SetError(error, "unknown key '" + token + "'");
+            return false;
+        }
+        if (name->kind != kKeyNameModifier) {
+            SetError(error, "'" + token + "' is not a modifier");
+            return false;
+        }
+        stroke->modifiers |= name->code;
+        if (next >= modsEnd) break;
+        pos = next + 1;
+    }
+
+    // Main key
+    size_t tokenBegin = keyBegin, tokenEnd = end;
+    Trim(text, tokenBegin, tokenEnd);
+    std::string token(text + tokenBegin, tokenEnd - tokenBegin);
+    if (token.empty()) {
+        SetError(error, "missing key in '" + std::string(text + begin, end - begin) + "'");
+        return false;
+    }
+    const KeyName* name = FindKeyName(token.data(), token.size());
+    if (!name) {
+        SetError(error, "unknown key '" + token + "'");
+        return false;
+    }
+    switch (name->kind) {
+        case kKeyNameModifier:
+            SetError(error, "missing key after '" + token + "'");
+            return false;
+        case kKeyNameMouse:
+            mouseButton = name->code;
+            return true;
+        default:
+            stroke->vkCode = name->code;
+            return true;
+    }
+}
+
+// Enhanced function to convert string to virtual key code and modifiers
+bool StringToVk(const std::string& keyString, uint32_t& vkCode, uint32_t& modifiers, uint32_t& mouseButton) {
+    KeyStroke stroke = {0, 0};
+    bool ok = ParseKeyStroke(keyString.data(), keyString.size(), &stroke, mouseButton, nullptr);
+    vkCode = ok ? stroke.vkCode : 0;
+    modifiers = ok ? stroke.modifiers : 0;
+    if (!ok) mouseButton = 0;
+    return ok;
+}
+
+bool ParseKeySequence(const std::string& keyString, std::vector<KeyStroke>* strokes, uint32_t& mouseButton,
+                      std::string* error) {
+    strokes->clear();
+    mouseButton = 0;
+
+    // Split into strokes: a comma or whitespace ends a stroke, except around
+    // '+' ("Ctrl + K") and where the comma is the key itself ("Ctrl+,")
+    std::vector<std::string> parts;
+    std::string stroke;
+    for (size_t i = 0; i <= keyString.size(); i++) {
+        char c = i < keyString.size() ? keyString[i] : ',';
+        if (IsBlank(c)) {
+            size_t next = keyString.find_first_not_of(" \t\r\n", i);
+            if (!stroke.empty() && stroke.back() != '+' &&
+                (next == std::string::npos || keyString[next] != '+')) {
+                parts.push_back(stroke);
+                stroke.clear();
+            }
+        } else if (c == ',' && !stroke.empty() && stroke.back() != '+') {
+            parts.push_back(stroke);
+            stroke.clear();
+        } else if (i < keyString.size()) {
+            stroke += c;
+        }
+    }
+    if (!stroke.empty()) parts.push_back(stroke);
+    if (parts.empty()) {
+        SetError(error, "empty key");
+        return false;
+    }
+
+    for (const std::string& part : parts) {
+        KeyStroke parsed = {0, 0};
+        uint32_t button = 0;
+        if (!ParseKeyStroke(part.data(), part.size(), &parsed, button, error)) {
+            return false;
+        }
+        if (button != 0) {
+            if (parts.size() != 1) {
+                SetError(error, "mouse buttons cannot be part of a sequence");
+                return false;
+            }
+            mouseButton = button;
+            strokes->push_back(parsed);
+            return true;
+        }
+        strokes->push_back(parsed);
+    }
+    return true;
+}
+
+std::string FormatKeyStroke(uint32_t modifiers, uint32_t vkCode, uint32_t mouseButton) {
+    static const uint32_t kModifierOrder[] = {kModControl, kModAlt, kModShift, kModWin};
+
+    std::string out;
+    for (uint32_t bit : kModifierOrder) {
+        if (modifiers & bit) {
+            out += KeyNameForModifier(bit);
+            out += '+';
+        }
+    }
+    const char* name = mouseButton != 0 ? KeyNameForMouseButton(mouseButton) : KeyNameForVk(vkCode);
+    if (name) {
+        out += name;
+    } else {
+        // No name for it (only reachable through a raw vk code)
+        char hex[8];
+        snprintf(hex, sizeof(hex), "0x%02X", vkCode & 0xFF);
+        out += hex;
+    }
+    return out;
+}
+
+std::string FormatKeySequence(const std::vector<KeyStroke>& strokes, uint32_t mouseButton) {
+    std::string out;
+    for (size_t i = 0; i < strokes.size(); i++) {
+        if (i != 0) out += ", ";
+        out += FormatKeyStroke(strokes[i].modifiers, strokes[i].vkCode, mouseButton);
+    }
+    return out;
+}
+
+uint32_t ModifierBitForVk(uint32_t vkCode) {
+    switch (vkCode) {
+        case VK_LSHIFT:
+        case VK_RSHIFT:
+            return kModShift;
+        case VK_LCONTROL:
+        case VK_RCONTROL:
+            return kModControl;
+        case VK_LMENU:
+        case VK_RMENU:
+            return kModAlt;
+        case VK_LWIN:
+        case VK_RWIN:
+            return kModWin;
+    }
+    return 0;
+}
+
+ShortcutEngine::ShortcutEngine()
+    : clock_(SteadyNowNs), tracing_(false), activeProfile_(0), drainRequest_(nullptr), drainContext_(nullptr),
+      generation_(0), modifiers_(0), sequence_(0),
+      sequenceState_(kNoAction), sequenceGeneration_(0), sequenceStepNs_(0),
+      holdSerial_(0), holdSequence_(0) {
+    memset(keyDown_, 0, sizeof(keyDown_));
+    for (uint32_t i = 0; i < kKeyCodeCount; i++) {
+        activeHolds_[i].store(0, std::memory_order_relaxed);
+    }
+    holdTimers_.SetCallback(OnHoldTimer, this);
+    tables_.Publish(new ShortcutTable());
+}
+
+void ShortcutEngine::Clear() {
+    StopTimers();
+    pending_.reset();
+    tables_.Publish(new ShortcutTable());
+    queue_.Reset();
+    ResetModifiers();
+}
+
+const ShortcutTable& ShortcutEngine::PendingTable() {
+    if (!pending_) {
+        pending_.reset(new ShortcutTable());
+        pending_->InheritActions(Table());
+    }
+    return *pending_;
+}
+
+bool ShortcutEngine::AddBinding(const std::string& actionName, const std::string& keyString, uint32_t timeoutMs) {
+    std::vector<KeyStroke> strokes;
+    uint32_t mouseButton = 0;
+    if (!ParseKeySequence(keyString, &strokes, mouseButton)) {
+        return false;
+    }
+    return BindStrokes(actionName, strokes, mouseButton, timeoutMs);
+}
+
+bool ShortcutEngine::BindStrokes(const std::string& actionName, const std::vector<KeyStroke>& strokes,
+                                 uint32_t mouseButton, uint32_t timeoutMs, uint32_t profile) {
+    if (strokes.empty()) return false;
+    PendingTable();
+    if (profile >= pending_->ProfileCount()) return false;
+    ActionId id = pending_->AddAction(actionName);
+    if (mouseButton != 0) {
+        return pending_->BindMouseButton(strokes[0].modifiers, mouseButton, id, profile);
+    }
+    return pending_->BindSequence(strokes, id, timeoutMs, profile);
+}
+
+uint32_t ShortcutEngine::AddProfile(const std::string& name) {
+    PendingTable();
+    return pending_->AddProfile(name);
+}
+
+bool ShortcutEngine::SetRepeatPolicy(const std::string& actionName, const RepeatPolicy& policy) {
+    PendingTable();
+    ActionId id = pending_->AddAction(actionName);
+    if (id == kNoAction) return false;
+    pending_->SetRepeatPolicy(id, policy);
+    return true;
+}
+
+bool ShortcutEngine::SetTriggerPolicy(const std::string& actionName, const TriggerPolicy& policy) {
+    PendingTable();
+    ActionId id = pending_->AddAction(actionName);
+    if (id == kNoAction) return false;
+    pending_->SetTriggerPolicy(id, policy);
+    return true;
+}
+
+void ShortcutEngine::PublishBindings() {
+    PendingTable();
+    if (pending_->HasTimedTriggers()) {
+        holdTimers_.Start();
+    }
+    pending_->SetGeneration(++generation_);
+    tables_.Publish(pending_.release());
+}
+
+bool ShortcutEngine::HandleSequenceKey(const ShortcutTable& table, uint32_t profile, uint32_t vkCode,
+                                       bool isModifier, bool repeat, uint32_t osTime, uint64_t osDelayNs) {
+    if (sequenceState_ != kNoAction && sequenceGeneration_ != table.Generation()) {
+        sequenceState_ = kNoAction;
+    }
+
+    if (sequenceState_ != kNoAction) {
+        // Modifiers for the next stroke and autorepeat of the last one keep waiting
+        if (isModifier || repeat) return false;
+
+        uint32_t timeoutMs = 0;
+        ActionId next = table.MatchSequence(sequenceState_ & ~kSequenceStateBit, modifiers_, vkCode, &timeoutMs);
+        uint64_t now = clock_();
+        sequenceState_ = kNoAction;
+        if (next != kNoAction && now - sequenceStepNs_ <= static_cast<uint64_t>(timeoutMs) * 1000000ull) {
+            if (IsSequenceState(next)) {
+                sequenceState_ = next;
+                sequenceStepNs_ = now;
+            } else {
+                Dispatch(next, kEventDown, osTime, osDelayNs, now);
+            }
+            return true;
+        }
+        // Broken or timed out: the stroke is matched again from the root
+    }
+
+    // Sequence states are unique across profiles, so one started before a
+    // profile switch can still finish after it
+    ActionId id = table.MatchKey(modifiers_, vkCode, profile);
+    if (id == kNoAction) return false;
+    if (IsSequenceState(id)) {
+        if (!repeat) {
+            sequenceState_ = id;
+            sequenceGeneration_ = table.Generation();
+            sequenceStepNs_ = clock_();
+        }
+        // The leading stroke still reaches the focused window
+        return false;
+    }
+    DispatchKey(table, id, vkCode, repeat, osTime, osDelayNs);
+    return true;
+}
+
+void ShortcutEngine::DispatchHeldKey(ActionId id, const RepeatPolicy& policy, uint32_t vkCode, bool repeat,
+                                     uint32_t osTime, uint64_t osDelayNs) {
+    uint64_t now = clock_();
+    if (!repeat || held_.vkCode != vkCode || held_.id != id) {
+        // A new press: deliver what the previous key still owed, then this one
+        if (held_.vkCode != 0) ReleaseHeldKey(osTime);
+        held_.vkCode = vkCode;
+        held_.id = id;
+        held_.policy = policy;
+        held_.lastEmitNs = now;
+        held_.pending = 0;
+        Dispatch(id, kEventDown, osTime, osDelayNs, now);
+        return;
+    }
+
+    // Repeats are consumed whether or not they are delivered
+    uint64_t intervalNs = static_cast<uint64_t>(held_.policy.intervalMs) * 1000000ull;
+    switch (held_.policy.mode) {
+        case kRepeatDrop:
+            break;
+        case kRepeatRate:
+            if (now - held_.lastEmitNs >= intervalNs) {
+                held_.lastEmitNs = now;
+                Dispatch(id, kEventDown | kEventRepeat, osTime, osDelayNs, now);
+            }
+            break;
+        case kRepeatCoalesce:
+            held_.pending++;
+            if (now - held_.lastEmitNs >= intervalNs) {
+                held_.lastEmitNs = now;
+                Dispatch(id, kEventDown | kEventRepeat, osTime, osDelayNs, now, held_.pending);
+                held_.pending = 0;
+            }
+            break;
+    }
+}
+
+void ShortcutEngine::DispatchTriggers(ActionId id, const TriggerPolicy& policy, uint32_t vkCode, bool repeat,
+                                      uint32_t osTime, uint64_t osDelayNs) {
+    // The hold timer replaces OS autorepeat
+    if (repeat && holds_[vkCode].id == id) return;
+    if (holds_[vkCode].id != kNoAction) EndHold(vkCode, osTime);
+
+    if (policy.triggers & kTriggerPress) {
+        Dispatch(id, kEventDown, osTime, osDelayNs, clock_());
+    }
+
+    HoldState& hold = holds_[vkCode];
+    hold.id = id;
+    hold.triggers = policy.triggers;
+    if (policy.triggers & (kTriggerHold | kTriggerRepeat)) {
+        hold.triggers |= kTriggerRelease;
+        if (++holdSerial_ == 0) holdSerial_ = 1;
+        bool hasHold = (policy.triggers & kTriggerHold) != 0;
+        // serial | hold flag | action | key: everything the wheel thread needs
+        hold.cookie = (static_cast<uint64_t>(holdSerial_) << 32) | (static_cast<uint64_t>(hasHold) << 31) |
+                      (static_cast<uint64_t>(id) << 8) | vkCode;
+        activeHolds_[vkCode].store(holdSerial_, std::memory_order_release);
+
+        uint32_t periodMs = 0;
+        if (policy.triggers & kTriggerRepeat) periodMs = policy.repeatMs > 0 ? policy.repeatMs : 1;
+        holdTimers_.Schedule(hold.cookie, hasHold ? policy.holdMs : periodMs, periodMs);
+    }
+}
+
+void ShortcutEngine::EndHold(uint32_t vkCode, uint32_t osTime) {
+    HoldState hold = holds_[vkCode];
+    holds_[vkCode] = HoldState();
+    if (hold.cookie != 0) {
+        // Disarm before timestamping the release: a tick that still gets
+        // through is stamped earlier, so the consumer can discard it
+        activeHolds_[vkCode].store(0, std::memory_order_release);
+        holdTimers_.Cancel(hold.cookie);
+    }
+    if (hold.triggers & kTriggerRelease) {
+        Dispatch(hold.id, kEventUp, osTime, 0, clock_());
+    }
+}
+
+bool ShortcutEngine::OnHoldTimer(void* context, uint64_t cookie, uint32_t fireCount, uint64_t nowNs) {
+    ShortcutEngine* engine = static_cast<ShortcutEngine*>(context);
+    uint32_t vkCode = static_cast<uint32_t>(cookie & 0xFF);
+    uint32_t serial = static_cast<uint32_t>(cookie >> 32);
+    bool hasHold = (cookie >> 31) & 1;
+    if (engine->activeHolds_[vkCode].load(std::memory_order_acquire) != serial) {
+        return false;  // released or abandoned
+    }
+
+    ShortcutEvent event;
+    event.actionId = static_cast<ActionId>((cookie >> 8) & kMaxActionId);
+    event.modifiers = 0;
+    event.osTime = 0;
+    event.timestamp = nowNs;
+    event.sequence = ++engine->holdSequence_;
+    event.reserved = 0;
+    if (hasHold && fireCount == 1) {
+        event.flags = kEventHold;
+        event.count = 1;
+    } else {
+        event.flags = kEventHold | kEventRepeat;
+        event.count = hasHold ? fireCount - 1 : fireCount;
+    }
+    uint64_t queuedAt = SteadyNowNs();
+    event.dispatchDelay = static_cast<uint32_t>(queuedAt - nowNs);
+
+    if (engine->holdQueue_.Publish(event) && engine->drainRequest_) {
+        if (!engine->drainRequest_(engine->drainContext_)) {
+            engine->holdQueue_.CancelDrain();
+        }
+    }
+    return true;
+}
+
+void ShortcutEngine::ReleaseHeldKey(uint32_t osTime) {
+    if (held_.pending != 0) {
+        Dispatch(held_.id, kEventDown | kEventRepeat, osTime, 0, clock_(), held_.pending);
+    }
+    held_ = HeldKey();
+}
+
+void ShortcutEngine::SetInputTrace(InputTraceWriter* trace) {
+    if (!trace) tracing_.store(false, std::memory_order_relaxed);
+    traces_.Publish(trace);
+    if (trace) tracing_.store(true, std::memory_order_relaxed);
+
+    // Close the old file now rather than on some later publish; the input
+    // thread holds a trace record for one event at most
+    while (traces_.RetiredCount() != 0) {
+        std::this_thread::yield();
+        traces_.Reclaim();
+    }
+}
+
+void ShortcutEngine::SetDrainRequest(DrainRequestFn fn, void* context) {
+    drainRequest_ = fn;
+    drainContext_ = context;
+}
+
+void ShortcutEngine::Dispatch(ActionId id, uint8_t flags, uint32_t osTime, uint64_t osDelayNs, uint64_t hookEntry,
+                              uint32_t count) {
+    if (osDelayNs != 0) {
+        latency_.Record(kStageOsToHook, osDelayNs);
+    }
+
+    ShortcutEvent event;
+    event.actionId = id;
+    event.flags = flags;
+    event.modifiers = static_cast<uint8_t>(modifiers_);
+    event.osTime = osTime;
+    event.timestamp = hookEntry;
+    event.sequence = ++sequence_;
+    event.count = count;
+    event.reserved = 0;
+    uint64_t queuedAt = clock_();
+    event.dispatchDelay = static_cast<uint32_t>(queuedAt - hookEntry);
+    latency_.Record(kStageHookToDispatch, queuedAt - hookEntry);
+
+    if (queue_.Publish(event) && drainRequest_) {
+        if (!drainRequest_(drainContext_)) {
+            queue_.CancelDrain();
+        }
+    }
+}
+
+size_t ShortcutEngine::DrainBatch(ShortcutEvent* out, size_t maxItems, uint64_t consumerEntry) {
+    size_t count = 0;
+    size_t n;
+    while (count < maxItems && (n = queue_.Drain(out + count, maxItems - count)) > 0) {
+        count += n;
+    }
+    size_t inputCount = count;
+    while (count < maxItems && (n = holdQueue_.Drain(out + count, maxItems - count)) > 0) {
+        count += n;
+    }
+    if (inputCount != 0 && count != inputCount) {
+        // Each queue is already in timestamp order
+        std::inplace_merge(out, out + inputCount, out + count,
+                           [](const ShortcutEvent& a, const ShortcutEvent& b) { return a.timestamp < b.timestamp; });
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        uint64_t queuedAt = out[i].timestamp + out[i].dispatchDelay;
+        latency_.Record(kStageDispatchToJs, consumerEntry > queuedAt ? consumerEntry - queuedAt : 0);
+    }
+    return count;
+}
+
+EventQueueStats ShortcutEngine::QueueStats() const {
+    EventQueueStats stats = queue_.Stats();
+    EventQueueStats hold = holdQueue_.Stats();
+    stats.published += hold.published;
+    stats.dropped += hold.dropped;
+    stats.delivered += hold.delivered;
+    stats.batches += hold.batches;
+    return stats;
+}
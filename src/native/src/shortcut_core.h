@@ -0,0 +1,293 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "key_codes.h"
+#include "shortcut_table.h"
+#include "event_ring.h"
+#include "input_trace.h"
+#include "latency_histogram.h"
+#include "rcu_pointer.h"
+#include "timer_wheel.h"
+
+// Platform-neutral shortcut engine: key-name parsing, modifier tracking,
+// matching and dispatch into the event queue. Input backends feed it raw key
+// and button transitions from their input thread; the N-API layer drains the
+// queue on the JS thread. Nothing here depends on Win32 or N-API.
+
+// Parse "Ctrl+Shift+F1" / "XButton2" into a VK code or mouse button plus MOD_* mask.
+// Names come from key_names.h and are case-insensitive; an unknown name or a
+// non-modifier before the last '+' fails, with the reason in *error if given.
+bool ParseKeyStroke(const char* text, size_t length, KeyStroke* stroke, uint32_t& mouseButton,
+                    std::string* error);
+bool StringToVk(const std::string& keyString, uint32_t& vkCode, uint32_t& modifiers, uint32_t& mouseButton);
+
+// Parse "Ctrl+K, P" / "Insert Insert" into strokes (commas or spaces between
+// strokes). Mouse buttons are only accepted as a single stroke.
+bool ParseKeySequence(const std::string& keyString, std::vector<KeyStroke>* strokes, uint32_t& mouseButton,
+                      std::string* error = nullptr);
+
+// Canonical spelling: modifiers in Ctrl+Alt+Shift+Win order, then the key's
+// first name in key_names.h. Parsing the result gives the same stroke back.
+std::string FormatKeyStroke(uint32_t modifiers, uint32_t vkCode, uint32_t mouseButton);
+std::string FormatKeySequence(const std::vector<KeyStroke>& strokes, uint32_t mouseButton);
+
+// Returns the kMod* bit for a modifier key, 0 for anything else
+uint32_t ModifierBitForVk(uint32_t vkCode);
+
+// Called on the input thread when a drain must be scheduled on the consumer.
+// Returns false if the wakeup could not be queued.
+typedef bool (*DrainRequestFn)(void* context);
+
+// Time source for the input-thread paths (SteadyNowNs unless replaying)
+typedef uint64_t (*ClockFn)();
+
+class ShortcutEngine {
+public:
+    ShortcutEngine();
+
+    // Configuration (JS thread). AddBinding() fills a pending table that
+    // starts with the published table's action ids, so events still queued
+    // under the old bindings keep mapping to the right names.
+    // PublishBindings() swaps it in atomically; the input thread never sees
+    // a half-built table and the backend keeps running.
+    // timeoutMs is the maximum gap between the strokes of a sequence.
+    bool AddBinding(const std::string& actionName, const std::string& keyString,
+                    uint32_t timeoutMs = kDefaultSequenceTimeoutMs);
+    // Same with already-parsed strokes (see keymap_compiler.h), into the
+    // default keymap or a profile from AddProfile()
+    bool BindStrokes(const std::string& actionName, const std::vector<KeyStroke>& strokes,
+                     uint32_t mouseButton, uint32_t timeoutMs = kDefaultSequenceTimeoutMs,
+                     uint32_t profile = kDefaultProfile);
+    // Adds a named keymap profile to the pending table; kNoProfile if full
+    uint32_t AddProfile(const std::string& name);
+    // Autorepeat handling for an action (added to the pending table if new)
+    bool SetRepeatPolicy(const std::string& actionName, const RepeatPolicy& policy);
+    // Press / release / hold / repeat-while-held events for an action. Hold
+    // and repeat run on the engine's timer wheel thread and imply release,
+    // so consumers can tell when the hold ended.
+    bool SetTriggerPolicy(const std::string& actionName, const TriggerPolicy& policy);
+    const ShortcutTable& PendingTable();
+    void PublishBindings();
+    void DiscardBindings() { pending_.reset(); }
+    // Drops all bindings and action ids; only while no backend is running
+    void Clear();
+    // Joins the hold timer thread (restarted by the next publish that needs it)
+    void StopTimers() { holdTimers_.Stop(); }
+    // Frees replaced tables the input thread can no longer be reading
+    void ReclaimTables() { tables_.Reclaim(); }
+
+    // Published table; not for the input thread
+    const ShortcutTable& Table() const { return *tables_.Current(); }
+
+    // Any thread (the foreground tracker). Selects the profile the input
+    // thread matches against, for the table with this generation only; a
+    // table published later starts on the default profile until it is
+    // selected again. One atomic store, nothing else changes.
+    void SetActiveProfile(uint32_t generation, uint32_t profile) {
+        activeProfile_.store((static_cast<uint64_t>(generation) << 32) | profile, std::memory_order_relaxed);
+    }
+    // Profile in use for a table (kDefaultProfile if none was selected for it)
+    uint32_t ActiveProfile(const ShortcutTable& table) const {
+        uint64_t active = activeProfile_.load(std::memory_order_relaxed);
+        uint32_t profile = static_cast<uint32_t>(active);
+        return static_cast<uint32_t>(active >> 32) == table.Generation() && profile < table.ProfileCount()
+                   ? profile : kDefaultProfile;
+    }
+    void SetDrainRequest(DrainRequestFn fn, void* context);
+    // Any thread: sends the consumer wakeup again for events still queued,
+    // in case the original one was lost. Returns false if it could not be sent.
+    bool KickDrain() { return drainRequest_ && drainRequest_(drainContext_); }
+    // Replay drives the engine from trace timestamps; not while a backend runs
+    void SetClock(ClockFn clock) { clock_ = clock ? clock : SteadyNowNs; }
+
+    // JS thread. Starts recording the raw input stream into `trace` (owned),
+    // or stops with nullptr. The previous trace is closed before returning.
+    void SetInputTrace(InputTraceWriter* trace);
+    // JS thread; nullptr when not tracing
+    const InputTraceWriter* InputTrace() const { return traces_.Current(); }
+
+    // Input thread, at hook entry before any filtering. Returns the stored
+    // record while a trace is running; it stays valid until EndTrace().
+    InputTraceRecord* BeginTrace(uint8_t kind, uint32_t code, uint8_t flags, uint32_t scanCode,
+                                 uint32_t osFlags, uint32_t osTime, uint64_t osDelayNs) {
+        if (!tracing_.load(std::memory_order_relaxed)) return nullptr;
+        const InputTraceWriter* trace = traces_.ReadLock();
+        InputTraceRecord* record = nullptr;
+        if (trace) {
+            InputTraceRecord entry;
+            entry.timestampNs = clock_();
+            entry.osDelayNs = osDelayNs;
+            entry.osTime = osTime;
+            entry.osFlags = osFlags;
+            entry.code = static_cast<uint16_t>(code);
+            entry.scanCode = static_cast<uint16_t>(scanCode);
+            entry.kind = kind;
+            entry.flags = flags;
+            entry.reserved = 0;
+            record = trace->Append(entry);
+        }
+        if (!record) traces_.ReadUnlock();
+        return record;
+    }
+    void EndTrace(InputTraceRecord* record, bool consumed) {
+        if (!record) return;
+        if (consumed) record->flags |= kTraceConsumed;
+        traces_.ReadUnlock();
+    }
+
+    // Input thread only. Returns true when the event matched a binding and
+    // should be consumed. osDelayNs is the OS event time -> hook entry delay
+    // as measured by the backend (0 if unknown).
+    bool HandleKey(uint32_t vkCode, bool down, uint32_t osTime, uint64_t osDelayNs) {
+        uint32_t bit = ModifierBitForVk(vkCode);
+        if (bit) {
+            modifiers_ = down ? (modifiers_ | bit) : (modifiers_ & ~bit);
+        }
+        if (vkCode >= kKeyCodeCount) return false;
+        bool repeat = down && keyDown_[vkCode];
+        keyDown_[vkCode] = down;
+        if (!down) {
+            if (held_.vkCode == vkCode) ReleaseHeldKey(osTime);
+            if (holds_[vkCode].id != kNoAction) EndHold(vkCode, osTime);
+            return false;
+        }
+
+        const ShortcutTable* table = tables_.ReadLock();
+        uint32_t profile = ActiveProfile(*table);
+        if (sequenceState_ != 0 || table->HasSequences()) {
+            bool consumed = HandleSequenceKey(*table, profile, vkCode, bit != 0, repeat, osTime, osDelayNs);
+            tables_.ReadUnlock();
+            return consumed;
+        }
+
+        // Single table load; keys unbound in the current profile fall straight through
+        ActionId id = table->MatchKey(modifiers_, vkCode, profile);
+        if (id != kNoAction) DispatchKey(*table, id, vkCode, repeat, osTime, osDelayNs);
+        tables_.ReadUnlock();
+        return id != kNoAction;
+    }
+
+    bool HandleMouseButton(uint32_t mouseButton, bool down, uint32_t osTime, uint64_t osDelayNs) {
+        if (!down) return false;
+        const ShortcutTable* table = tables_.ReadLock();
+        ActionId id = table->MatchMouseButton(modifiers_, mouseButton, ActiveProfile(*table));
+        tables_.ReadUnlock();
+        if (id == kNoAction) return false;
+        Dispatch(id, kEventDown, osTime, osDelayNs, clock_());
+        return true;
+    }
+
+    // Queue an already-resolved action (e.g. from RegisterHotKey)
+    void Dispatch(ActionId id, uint8_t flags, uint32_t osTime, uint64_t osDelayNs, uint64_t hookEntry,
+                  uint32_t count = 1);
+
+    // Also abandons held keys; their timers disarm on the next tick
+    void ResetModifiers() {
+        modifiers_ = 0;
+        sequenceState_ = 0;
+        memset(keyDown_, 0, sizeof(keyDown_));
+        held_ = HeldKey();
+        for (uint32_t i = 0; i < kKeyCodeCount; i++) {
+            holds_[i] = HoldState();
+            activeHolds_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+    uint32_t Modifiers() const { return modifiers_; }
+
+    // Consumer side: pull everything queued so far (input and timer events
+    // merged by timestamp) and record queue latency
+    size_t DrainBatch(ShortcutEvent* out, size_t maxItems, uint64_t consumerEntry);
+    void ResetQueue() {
+        queue_.Reset();
+        holdQueue_.Reset();
+    }
+
+    EventQueueStats QueueStats() const;
+    LatencyRecorder& Latency() { return latency_; }
+
+private:
+    // The key whose autorepeat is being filtered. The OS only repeats the
+    // most recent key-down, so one record is enough.
+    struct HeldKey {
+        uint32_t vkCode;       // 0 = none
+        ActionId id;
+        RepeatPolicy policy;
+        uint64_t lastEmitNs;
+        uint32_t pending;      // coalesced repeats not yet delivered
+
+        HeldKey() : vkCode(0), id(kNoAction), policy{kRepeatPass, 0}, lastEmitNs(0), pending(0) {}
+    };
+
+    // A key whose action has release / hold / repeat triggers
+    struct HoldState {
+        ActionId id;           // kNoAction = not held
+        uint32_t triggers;
+        uint64_t cookie;       // armed timer, 0 = none
+
+        HoldState() : id(kNoAction), triggers(0), cookie(0) {}
+    };
+
+    // Matched key-down under the action's trigger and repeat policies; table read-locked
+    void DispatchKey(const ShortcutTable& table, ActionId id, uint32_t vkCode, bool repeat,
+                     uint32_t osTime, uint64_t osDelayNs) {
+        const TriggerPolicy& triggers = table.Triggers(id);
+        if (triggers.triggers != kTriggerPress) {
+            DispatchTriggers(id, triggers, vkCode, repeat, osTime, osDelayNs);
+            return;
+        }
+        const RepeatPolicy& policy = table.Repeat(id);
+        if (policy.mode == kRepeatPass) {
+            Dispatch(id, kEventDown, osTime, osDelayNs, clock_());
+        } else {
+            DispatchHeldKey(id, policy, vkCode, repeat, osTime, osDelayNs);
+        }
+    }
+    void DispatchHeldKey(ActionId id, const RepeatPolicy& policy, uint32_t vkCode, bool repeat,
+                         uint32_t osTime, uint64_t osDelayNs);
+    void ReleaseHeldKey(uint32_t osTime);
+    void DispatchTriggers(ActionId id, const TriggerPolicy& policy, uint32_t vkCode, bool repeat,
+                          uint32_t osTime, uint64_t osDelayNs);
+    void EndHold(uint32_t vkCode, uint32_t osTime);
+    // Timer wheel thread
+    static bool OnHoldTimer(void* context, uint64_t cookie, uint32_t fireCount, uint64_t nowNs);
+
+    // Sequence DFA step; only reached once a table has sequence bindings
+    bool HandleSequenceKey(const ShortcutTable& table, uint32_t profile, uint32_t vkCode, bool isModifier,
+                           bool repeat, uint32_t osTime, uint64_t osDelayNs);
+
+    ClockFn clock_;
+    RcuPointer<ShortcutTable> tables_;
+    RcuPointer<InputTraceWriter> traces_;
+    std::atomic<bool> tracing_;
+    std::atomic<uint64_t> activeProfile_;      // table generation << 32 | profile
+    std::unique_ptr<ShortcutTable> pending_;   // JS thread only
+    EventQueue queue_;
+    LatencyRecorder latency_;
+    DrainRequestFn drainRequest_;
+    void* drainContext_;
+    uint32_t generation_; // JS thread only
+    uint32_t modifiers_;  // input thread only
+    uint32_t sequence_;   // input thread only
+
+    // Sequence progress; input thread only
+    bool keyDown_[kKeyCodeCount];    // tells autorepeat from a new press
+    ActionId sequenceState_;         // 0 = at the root
+    uint32_t sequenceGeneration_;    // table generation the state belongs to
+    uint64_t sequenceStepNs_;        // time of the last accepted stroke
+    HeldKey held_;                   // autorepeat filtering
+
+    // Timed triggers. The wheel thread is the only producer of holdQueue_.
+    HoldState holds_[kKeyCodeCount];                   // input thread only
+    uint32_t holdSerial_;                              // input thread only
+    std::atomic<uint32_t> activeHolds_[kKeyCodeCount]; // serial of the armed hold, 0 = none
+    EventQueue holdQueue_;
+    uint32_t holdSequence_;                            // timer wheel thread only
+    TimerWheel holdTimers_;  // declared last: its thread stops before the state above goes away
+};
@@ -0,0 +1,351 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Platform-neutral shortcut dispatch table.
+//
+// Start() and update() compile the JS shortcut object into a fresh table that
+// ShortcutEngine swaps in whole; the hook procs then resolve (modifier mask,
+// vkCode) with a single indexed load. Only the small integer action id leaves
+// the hook, and lib/binding.js turns it back into the action name.
+//
+// Sequence bindings ("Ctrl+K, P", "Insert Insert") make the table a DFA: the
+// root entry of a leading stroke holds a state (kSequenceStateBit) instead of
+// an action, and every later stroke is one lookup of (state, modifiers, vk)
+// in an open-addressing edge table. A stroke is either a complete binding or
+// a sequence prefix, never both.
+//
+// A table may hold several keymap profiles (per-application keymaps). They
+// share the action ids, policies and sequence states; each profile has its
+// own key and mouse-button slots, and profile 0 is the default keymap. The
+// input thread picks a profile by index, so switching profiles touches
+// nothing but that index.
+
+typedef uint16_t ActionId;
+
+const ActionId kNoAction = 0;
+
+// Modifier bits use the same values as Win32 MOD_* so masks pass through unchanged
+const uint32_t kModAlt = 0x0001;
+const uint32_t kModControl = 0x0002;
+const uint32_t kModShift = 0x0004;
+const uint32_t kModWin = 0x0008;
+const uint32_t kModMask = 0x000F;
+
+const uint32_t kModifierCombinations = 16;
+const uint32_t kKeyCodeCount = 256;
+const uint32_t kMouseButtonCount = 4; // 1 = XBUTTON1, 2 = XBUTTON2
+
+// Table entries with this bit hold a sequence state, not an action id
+const ActionId kSequenceStateBit = 0x8000;
+const ActionId kMaxActionId = 0x7FFF;
+const uint32_t kMaxSequenceStates = 0x7FFF;
+
+// Default time allowed between two strokes of a sequence
+const uint32_t kDefaultSequenceTimeoutMs = 1000;
+
+const uint32_t kDefaultProfile = 0;
+const uint32_t kMaxKeymapProfiles = 64;
+const uint32_t kNoProfile = 0xFFFFFFFF;
+
+inline bool IsSequenceState(ActionId entry) {
+    return (entry & kSequenceStateBit) != 0;
+}
+
+// What happens to OS autorepeat while a bound key is held. The first press
+// is always delivered; repeats are then passed on, dropped, limited to one
+// per interval, or summed into one event per interval (plus one on release).
+enum RepeatMode {
+    kRepeatPass = 0,
+    kRepeatDrop,
+    kRepeatRate,
+    kRepeatCoalesce
+};
+
+struct RepeatPolicy {
+    uint32_t mode;        // RepeatMode
+    uint32_t intervalMs;  // kRepeatRate / kRepeatCoalesce
+};
+
+// Which events an action produces while its key goes down, stays down and
+// comes back up. Actions default to press only; hold and repeat-while-held
+// are timed on the engine's TimerWheel thread and replace OS autorepeat.
+enum TriggerBits {
+    kTriggerPress = 0x01,
+    kTriggerRelease = 0x02,
+    kTriggerHold = 0x04,      // once, holdMs after the press
+    kTriggerRepeat = 0x08     // every repeatMs while held (after the hold, if any)
+};
+
+struct TriggerPolicy {
+    uint32_t triggers;    // TriggerBits
+    uint32_t holdMs;
+    uint32_t repeatMs;
+};
+
+struct KeyStroke {
+    uint32_t modifiers;
+    uint32_t vkCode;
+};
+
+class ShortcutTable {
+public:
+    ShortcutTable() { Clear(); }
+
+    void Clear() {
+        keys_.assign(kKeySlots, kNoAction);
+        mouseButtons_.assign(kMouseSlots, kNoAction);
+        profileNames_.assign(1, std::string()); // profile 0 is the default keymap
+        actionNames_.clear();
+        actionNames_.push_back(std::string()); // id 0 is kNoAction
+        repeatPolicies_.assign(1, RepeatPolicy{kRepeatPass, 0});
+        triggerPolicies_.assign(1, TriggerPolicy{kTriggerPress, 0, 0});
+        timedTriggers_ = 0;
+        keyBindings_ = 0;
+        mouseBindings_ = 0;
+        edges_.clear();
+        edgeCount_ = 0;
+        stateCount_ = 0;
+        generation_ = 0;
+    }
+
+    // Start from another table's action ids so ids stay stable across rebuilds
+    void InheritActions(const ShortcutTable& previous) {
+        actionNames_ = previous.actionNames_;
+        repeatPolicies_.assign(actionNames_.size(), RepeatPolicy{kRepeatPass, 0});
+        triggerPolicies_.assign(actionNames_.size(), TriggerPolicy{kTriggerPress, 0, 0});
+    }
+
+    // Returns the index of a named profile, adding an empty one if needed;
+    // kNoProfile once kMaxKeymapProfiles are in use
+    uint32_t AddProfile(const std::string& name) {
+        for (size_t i = 1; i < profileNames_.size(); i++) {
+            if (profileNames_[i] == name) return static_cast<uint32_t>(i);
+        }
+        if (name.empty() || profileNames_.size() >= kMaxKeymapProfiles) return kNoProfile;
+        profileNames_.push_back(name);
+        keys_.resize(profileNames_.size() * kKeySlots, kNoAction);
+        mouseButtons_.resize(profileNames_.size() * kMouseSlots, kNoAction);
+        return static_cast<uint32_t>(profileNames_.size() - 1);
+    }
+
+    uint32_t ProfileCount() const { return static_cast<uint32_t>(profileNames_.size()); }
+    // Index = profile; entry 0 (the default keymap) is empty
+    const std::vector<std::string>& ProfileNames() const { return profileNames_; }
+
+    // Returns the id for an action name, assigning the next free one if needed
+    ActionId AddAction(const std::string& name) {
+        for (size_t i = 1; i < actionNames_.size(); i++) {
+            if (actionNames_[i] == name) return static_cast<ActionId>(i);
+        }
+        if (actionNames_.size() > kMaxActionId) return kNoAction;
+        actionNames_.push_back(name);
+        repeatPolicies_.push_back(RepeatPolicy{kRepeatPass, 0});
+        triggerPolicies_.push_back(TriggerPolicy{kTriggerPress, 0, 0});
+        return static_cast<ActionId>(actionNames_.size() - 1);
+    }
+
+    void SetRepeatPolicy(ActionId id, const RepeatPolicy& policy) {
+        if (id != kNoAction && id < repeatPolicies_.size()) repeatPolicies_[id] = policy;
+    }
+
+    void SetTriggerPolicy(ActionId id, const TriggerPolicy& policy) {
+        if (id == kNoAction || id >= triggerPolicies_.size()) return;
+        bool wasTimed = (triggerPolicies_[id].triggers & (kTriggerHold | kTriggerRepeat)) != 0;
+        bool timed = (policy.triggers & (kTriggerHold | kTriggerRepeat)) != 0;
+        timedTriggers_ += (timed ? 1 : 0) - (wasTimed ? 1 : 0);
+        triggerPolicies_[id] = policy;
+    }
+
+    // id must come from this table
+    const RepeatPolicy& Repeat(ActionId id) const { return repeatPolicies_[id]; }
+    const TriggerPolicy& Triggers(ActionId id) const { return triggerPolicies_[id]; }
+    bool HasTimedTriggers() const { return timedTriggers_ != 0; }
+
+    // Fails if the key already leads a sequence
+    bool BindKey(uint32_t modifiers, uint32_t vkCode, ActionId id, uint32_t profile = kDefaultProfile) {
+        if (id == kNoAction || vkCode == 0 || vkCode >= kKeyCodeCount || profile >= ProfileCount()) return false;
+        ActionId& slot = keys_[KeyIndex(profile, modifiers, vkCode)];
+        if (IsSequenceState(slot)) return false;
+        if (slot == kNoAction) keyBindings_++;
+        slot = id;
+        return true;
+    }
+
+    // Binds a stroke sequence; each stroke must follow the previous one within
+    // timeoutMs. Fails (leaving the table unchanged) if a prefix of it is a
+    // complete binding or it is itself a prefix of another sequence.
+    bool BindSequence(const std::vector<KeyStroke>& strokes, ActionId id, uint32_t timeoutMs,
+                      uint32_t profile = kDefaultProfile) {
+        if (strokes.size() == 1) return BindKey(strokes[0].modifiers, strokes[0].vkCode, id, profile);
+        if (strokes.empty() || id == kNoAction || profile >= ProfileCount()) return false;
+        for (const KeyStroke& stroke : strokes) {
+            if (stroke.vkCode == 0 || stroke.vkCode >= kKeyCodeCount) return false;
+        }
+
+        // Dry run along the existing path
+        ActionId entry = keys_[KeyIndex(profile, strokes[0].modifiers, strokes[0].vkCode)];
+        size_t newStates = 0;
+        for (size_t i = 1; i < strokes.size(); i++) {
+            if (entry != kNoAction && !IsSequenceState(entry)) return false;
+            if (entry == kNoAction) {
+                newStates += strokes.size() - i;
+                break;
+            }
+            entry = FindEdge(entry & ~kSequenceStateBit, strokes[i]);
+        }
+        if (newStates == 0 && IsSequenceState(entry)) return false;
+        if (stateCount_ + newStates > kMaxSequenceStates) return false;
+
+        ActionId& root = keys_[KeyIndex(profile, strokes[0].modifiers, strokes[0].vkCode)];
+        if (root == kNoAction) {
+            root = NewState();
+            keyBindings_++;
+        }
+        uint32_t state = root & ~kSequenceStateBit;
+        for (size_t i = 1; i < strokes.size(); i++) {
+            bool last = i + 1 == strokes.size();
+            SequenceEdge* edge = InsertEdge(state, strokes[i]);
+            if (last) {
+                edge->target = id;
+                edge->timeoutMs = timeoutMs;
+            } else {
+                if (edge->target == kNoAction) edge->target = NewState();
+                // Shared prefixes wait as long as the most patient binding
+                if (timeoutMs > edge->timeoutMs) edge->timeoutMs = timeoutMs;
+                state = edge->target & ~kSequenceStateBit;
+            }
+        }
+        return true;
+    }
+
+    bool BindMouseButton(uint32_t modifiers, uint32_t mouseButton, ActionId id, uint32_t profile = kDefaultProfile) {
+        if (id == kNoAction || mouseButton == 0 || mouseButton >= kMouseButtonCount || profile >= ProfileCount()) {
+            return false;
+        }
+        ActionId& slot = mouseButtons_[MouseIndex(profile, modifiers, mouseButton)];
+        if (slot == kNoAction) mouseBindings_++;
+        slot = id;
+        return true;
+    }
+
+    // Hot path: one bounds check and one load, never allocates. profile must
+    // be below ProfileCount().
+    ActionId MatchKey(uint32_t modifiers, uint32_t vkCode, uint32_t profile = kDefaultProfile) const {
+        if (vkCode >= kKeyCodeCount) return kNoAction;
+        return keys_[KeyIndex(profile, modifiers, vkCode)];
+    }
+
+    ActionId MatchMouseButton(uint32_t modifiers, uint32_t mouseButton, uint32_t profile = kDefaultProfile) const {
+        if (mouseButton >= kMouseButtonCount) return kNoAction;
+        return mouseButtons_[MouseIndex(profile, modifiers, mouseButton)];
+    }
+
+    // Next entry from a sequence state (state = entry without kSequenceStateBit);
+    // one probe sequence in the edge table
+    ActionId MatchSequence(uint32_t state, uint32_t modifiers, uint32_t vkCode, uint32_t* timeoutMs) const {
+        if (vkCode >= kKeyCodeCount || edges_.empty()) return kNoAction;
+        uint32_t key = EdgeKey(state, modifiers, vkCode);
+        size_t mask = edges_.size() - 1;
+        for (size_t i = EdgeHash(key) & mask;; i = (i + 1) & mask) {
+            const SequenceEdge& edge = edges_[i];
+            if (edge.key == key) {
+                *timeoutMs = edge.timeoutMs;
+                return edge.target;
+            }
+            if (edge.key == 0) return kNoAction;
+        }
+    }
+
+    bool HasKeyBindings() const { return keyBindings_ != 0; }
+    bool HasMouseBindings() const { return mouseBindings_ != 0; }
+    bool HasSequences() const { return stateCount_ != 0; }
+
+    // Set by ShortcutEngine on publish; lets the input thread notice that a
+    // sequence in progress belongs to a replaced table
+    uint32_t Generation() const { return generation_; }
+    void SetGeneration(uint32_t generation) { generation_ = generation; }
+
+    // Index = action id; entry 0 is empty
+    const std::vector<std::string>& ActionNames() const { return actionNames_; }
+
+private:
+    struct SequenceEdge {
+        uint32_t key;         // EdgeKey(), 0 = empty slot
+        ActionId target;      // action id or kSequenceStateBit | state
+        uint32_t timeoutMs;
+    };
+
+    static uint32_t EdgeKey(uint32_t state, uint32_t modifiers, uint32_t vkCode) {
+        // States start at 1, so no valid key is 0
+        return (state << 12) | ((modifiers & kModMask) << 8) | vkCode;
+    }
+
+    static size_t EdgeHash(uint32_t key) {
+        return static_cast<size_t>((key * 0x9E3779B1u) >> 8);
+    }
+
+    ActionId NewState() {
+        return static_cast<ActionId>(kSequenceStateBit | ++stateCount_);
+    }
+
+    ActionId FindEdge(uint32_t state, const KeyStroke& stroke) const {
+        uint32_t timeoutMs;
+        return MatchSequence(state, stroke.modifiers, stroke.vkCode, &timeoutMs);
+    }
+
+    // Existing edge, or a new empty one; keeps the load factor at most 1/2
+    SequenceEdge* InsertEdge(uint32_t state, const KeyStroke& stroke) {
+        if ((edgeCount_ + 1) * 2 > edges_.size()) {
+            std::vector<SequenceEdge> old;
+            old.swap(edges_);
+            edges_.assign(old.empty() ? 16 : old.size() * 2, SequenceEdge{0, kNoAction, 0});
+            for (const SequenceEdge& edge : old) {
+                if (edge.key != 0) *Probe(edge.key) = edge;
+            }
+        }
+        uint32_t key = EdgeKey(state, stroke.modifiers, stroke.vkCode);
+        SequenceEdge* edge = Probe(key);
+        if (edge->key == 0) {
+            edge->key = key;
+            edgeCount_++;
+        }
+        return edge;
+    }
+
+    SequenceEdge* Probe(uint32_t key) {
+        size_t mask = edges_.size() - 1;
+        size_t i = EdgeHash(key) & mask;
+        while (edges_[i].key != 0 && edges_[i].key != key) {
+            i = (i + 1) & mask;
+        }
+        return &edges_[i];
+    }
+
+    static constexpr uint32_t kKeySlots = kModifierCombinations * kKeyCodeCount;
+    static constexpr uint32_t kMouseSlots = kModifierCombinations * kMouseButtonCount;
+
+    static uint32_t KeyIndex(uint32_t profile, uint32_t modifiers, uint32_t vkCode) {
+        return profile * kKeySlots + (((modifiers & kModMask) << 8) | vkCode);
+    }
+
+    static uint32_t MouseIndex(uint32_t profile, uint32_t modifiers, uint32_t mouseButton) {
+        return profile * kMouseSlots + (((modifiers & kModMask) << 2) | mouseButton);
+    }
+
+    std::vector<ActionId> keys_;            // kKeySlots per profile
+    std::vector<ActionId> mouseButtons_;    // kMouseSlots per profile
+    std::vector<std::string> profileNames_;
+    std::vector<std::string> actionNames_;
+    std::vector<RepeatPolicy> repeatPolicies_;  // indexed like actionNames_
+    std::vector<TriggerPolicy> triggerPolicies_;
+    uint32_t timedTriggers_;                    // actions with hold / repeat triggers
+    uint32_t keyBindings_;
+    uint32_t mouseBindings_;
+    std::vector<SequenceEdge> edges_;
+    size_t edgeCount_;
+    uint32_t stateCount_;
+    uint32_t generation_;
+};
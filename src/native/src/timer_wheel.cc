@@ -0,0 +1,192 @@
+#include "timer_wheel.h"
+
+#include <chrono>
+
+namespace {
+
+uint64_t NowTick() {
+    return SteadyNowNs() / 1000000ull;
+}
+
+} // namespace
+
+TimerWheel::TimerWheel()
+    : fire_(nullptr), context_(nullptr), stopping_(false), idle_(false), woken_(false),
+      currentTick_(0), armed_(0) {
+    for (uint32_t i = 0; i < kTimerWheelSlots; i++) slots_[i] = -1;
+}
+
+TimerWheel::~TimerWheel() {
+    Stop();
+}
+
+void TimerWheel::SetCallback(TimerFireFn fire, void* context) {
+    fire_ = fire;
+    context_ = context;
+}
+
+void TimerWheel::Start() {
+    if (thread_.joinable()) return;
+    stopping_.store(false, std::memory_order_relaxed);
+    currentTick_ = NowTick();
+    thread_ = std::thread(&TimerWheel::Run, this);
+}
+
+void TimerWheel::Stop() {
+    if (!thread_.joinable()) return;
+    stopping_.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        woken_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+
+    // The thread is gone, so the wheel and the consumer side of the ring are ours
+    Command stale[kTimerCommandCapacity];
+    while (commands_.PopBatch(stale, kTimerCommandCapacity) > 0) {}
+    timers_.clear();
+    freeTimers_.clear();
+    for (uint32_t i = 0; i < kTimerWheelSlots; i++) slots_[i] = -1;
+    armed_ = 0;
+    woken_ = false;
+    idle_.store(false, std::memory_order_relaxed);
+}
+
+bool TimerWheel::Schedule(uint64_t cookie, uint32_t delayMs, uint32_t periodMs) {
+    return Push(Command{cookie, SteadyNowNs() + static_cast<uint64_t>(delayMs) * 1000000ull, periodMs, false});
+}
+
+bool TimerWheel::Cancel(uint64_t cookie) {
+    return Push(Command{cookie, 0, 0, true});
+}
+
+bool TimerWheel::Push(const Command& command) {
+    if (!commands_.TryPush(command)) return false;
+
+    // Pairs with the fence in Run(): either the thread sees the command
+    // before it sleeps, or we see it idle and wake it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (idle_.load(std::memory_order_relaxed)) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            woken_ = true;
+        }
+        wake_.notify_one();
+    }
+    return true;
+}
+
+void TimerWheel::Run() {
+    while (!stopping_.load(std::memory_order_acquire)) {
+        ApplyCommands();
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        ApplyCommands();
+        if (armed_ == 0) {
+            wake_.wait(lock, [this]() { return woken_; });
+        } else {
+            // Sleep straight to the earliest due tick; a new command wakes us
+            // early in case it is due sooner
+            auto dueTick = std::chrono::steady_clock::time_point(std::chrono::milliseconds(NextDueTick()));
+            wake_.wait_until(lock, dueTick, [this]() { return woken_; });
+        }
+        woken_ = false;
+        idle_.store(false, std::memory_order_relaxed);
+        lock.unlock();
+        if (armed_ != 0) Advance(NowTick());
+    }
+}
+
+uint64_t TimerWheel::NextDueTick() const {
+    uint64_t next = UINT64_MAX;
+    for (const Timer& timer : timers_) {
+        if (timer.armed && timer.dueTick < next) next = timer.dueTick;
+    }
+    return next;
+}
+
+void TimerWheel::ApplyCommands() {
+    Command batch[kTimerCommandCapacity];
+    size_t count;
+    while ((count = commands_.PopBatch(batch, kTimerCommandCapacity)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            const Command& command = batch[i];
+            if (command.cancel) {
+                for (Timer& timer : timers_) {
+                    if (timer.armed && timer.cookie == command.cookie) {
+                        // Unlinked lazily when its slot comes up
+                        timer.armed = false;
+                        armed_--;
+                    }
+                }
+                continue;
+            }
+
+            int32_t index;
+            if (!freeTimers_.empty()) {
+                index = freeTimers_.back();
+                freeTimers_.pop_back();
+            } else {
+                index = static_cast<int32_t>(timers_.size());
+                timers_.push_back(Timer());
+            }
+            Timer& timer = timers_[index];
+            timer.cookie = command.cookie;
+            // Round up: a timer never fires early. Already-due timers fire on the next tick.
+            timer.dueTick = (command.dueNs + 999999ull) / 1000000ull;
+            if (timer.dueTick <= currentTick_) timer.dueTick = currentTick_ + 1;
+            timer.periodTicks = command.periodMs;
+            timer.fired = 0;
+            timer.armed = true;
+            armed_++;
+            Insert(index);
+        }
+    }
+}
+
+void TimerWheel::Insert(int32_t index) {
+    uint32_t slot = static_cast<uint32_t>(timers_[index].dueTick & (kTimerWheelSlots - 1));
+    timers_[index].next = slots_[slot];
+    slots_[slot] = index;
+}
+
+void TimerWheel::Advance(uint64_t nowTick) {
+    // After a long stall every slot is visited once; due times are absolute,
+    // so nothing is lost
+    uint64_t first = currentTick_ + 1;
+    if (nowTick >= kTimerWheelSlots && first + kTimerWheelSlots <= nowTick) {
+        first = nowTick - kTimerWheelSlots + 1;
+    }
+
+    for (uint64_t tick = first; tick <= nowTick; tick++) {
+        uint32_t slot = static_cast<uint32_t>(tick & (kTimerWheelSlots - 1));
+        int32_t index = slots_[slot];
+        slots_[slot] = -1;
+        while (index >= 0) {
+            Timer& timer = timers_[index];
+            int32_t next = timer.next;
+            if (!timer.armed) {
+                freeTimers_.push_back(index);
+            } else if (timer.dueTick > nowTick) {
+                Insert(index);  // a later lap
+            } else {
+                timer.fired++;
+                bool keep = fire_ && fire_(context_, timer.cookie, timer.fired, SteadyNowNs());
+                if (keep && timer.periodTicks != 0) {
+                    timer.dueTick += timer.periodTicks;
+                    if (timer.dueTick <= nowTick) timer.dueTick = nowTick + 1;
+                    Insert(index);
+                } else {
+                    timer.armed = false;
+                    armed_--;
+                    freeTimers_.push_back(index);
+                }
+            }
+            index = next;
+        }
+    }
+    if (nowTick > currentTick_) currentTick_ = nowTick;
+}
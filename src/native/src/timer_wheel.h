@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "event_ring.h"
+
+// Single thread serving every hold / repeat-while-held timer.
+//
+// Timers live in a hashed wheel of kTimerWheelSlots one-millisecond slots
+// (longer delays wrap around and are skipped until due). Only the wheel
+// thread touches the wheel: the input thread hands Schedule()/Cancel() over
+// through an SPSC command ring, so it never blocks or allocates. The thread
+// sleeps on a condition variable until the earliest armed timer is due (or
+// indefinitely while none is), so a 400 ms hold costs one wakeup, not 400.
+
+const uint32_t kTimerWheelSlots = 256;
+const size_t kTimerCommandCapacity = 64;
+
+// Runs on the wheel thread. fireCount is 1 for the first expiry. Returning
+// false disarms a periodic timer.
+typedef bool (*TimerFireFn)(void* context, uint64_t cookie, uint32_t fireCount, uint64_t nowNs);
+
+class TimerWheel {
+public:
+    TimerWheel();
+    ~TimerWheel();
+
+    // JS thread, before Start()
+    void SetCallback(TimerFireFn fire, void* context);
+    void Start();
+    void Stop();
+    bool Running() const { return thread_.joinable(); }
+
+    // Single producer (the input thread). periodMs 0 = one-shot. A timer is
+    // identified by its cookie; Cancel() disarms every timer with it.
+    // Returns false if the command ring is full.
+    bool Schedule(uint64_t cookie, uint32_t delayMs, uint32_t periodMs);
+    bool Cancel(uint64_t cookie);
+
+private:
+    struct Command {
+        uint64_t cookie;
+        uint64_t dueNs;     // stamped by the producer, so ring latency does not shift it
+        uint32_t periodMs;
+        bool cancel;
+    };
+
+    struct Timer {
+        uint64_t cookie;
+        uint64_t dueTick;
+        uint32_t periodTicks;
+        uint32_t fired;
+        int32_t next;       // slot list link, -1 = end
+        bool armed;
+    };
+
+    bool Push(const Command& command);
+    void Run();
+    void ApplyCommands();
+    void Insert(int32_t index);
+    uint64_t NextDueTick() const;
+    void Advance(uint64_t nowTick);
+
+    TimerFireFn fire_;
+    void* context_;
+
+    SpscRing<Command, kTimerCommandCapacity> commands_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::thread thread_;
+    std::atomic<bool> stopping_;
+    std::atomic<bool> idle_;
+    bool woken_;                          // guarded by mutex_
+
+    // Wheel thread only
+    std::vector<Timer> timers_;
+    std::vector<int32_t> freeTimers_;
+    int32_t slots_[kTimerWheelSlots];
+    uint64_t currentTick_;
+    uint32_t armed_;
+};
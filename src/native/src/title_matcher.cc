@@ -0,0 +1,416 @@
+#include "title_matcher.h"
+
+#include <cstring>
+
+namespace {
+
+// Decodes one UTF-8 sequence; returns its length, or 0 if malformed
+size_t DecodeUtf8(const unsigned char* p, size_t available, uint32_t* codepoint) {
+    unsigned char lead = p[0];
+    if (lead < 0x80) {
+        *codepoint = lead;
+        return 1;
+    }
+
+    size_t length;
+    uint32_t value;
+    if ((lead & 0xE0) == 0xC0) { length = 2; value = lead & 0x1F; }
+    else if ((lead & 0xF0) == 0xE0) { length = 3; value = lead & 0x0F; }
+    else if ((lead & 0xF8) == 0xF0) { length = 4; value = lead & 0x07; }
+    else return 0;
+
+    if (length > available) return 0;
+    for (size_t i = 1; i < length; i++) {
+        if ((p[i] & 0xC0) != 0x80) return 0;
+        value = (value << 6) | (p[i] & 0x3F);
+    }
+    *codepoint = value;
+    return length;
+}
+
+size_t EncodeUtf8(uint32_t codepoint, unsigned char* out) {
+    if (codepoint < 0x80) {
+        out[0] = static_cast<unsigned char>(codepoint);
+        return 1;
+    } else if (codepoint < 0x800) {
+        out[0] = static_cast<unsigned char>(0xC0 | (codepoint >> 6));
+        out[1] = static_cast<unsigned char>(0x80 | (codepoint & 0x3F));
+        return 2;
+    } else if (codepoint < 0x10000) {
+        out[0] = static_cast<unsigned char>(0xE0 | (codepoint >> 12));
+        out[1] = static_cast<unsigned char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out[2] = static_cast<unsigned char>(0x80 | (codepoint & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<unsigned char>(0xF0 | (codepoint >> 18));
+    out[1] = static_cast<unsigned char>(0x80 | ((codepoint >> 12) & 0x3F));
+    out[2] = static_cast<unsigned char>(0x80 | ((codepoint >> 6) & 0x3F));
+    out[3] = static_cast<unsigned char>(0x80 | (codepoint & 0x3F));
+    return 4;
+}
+
+// Next folded code point of `text` as UTF-8 bytes; advances *i
+inline size_t NextFolded(const unsigned char* text, size_t length, size_t* i, unsigned char* out) {
+    unsigned char c = text[*i];
+    if (c < 0x80) {
+        out[0] = (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c + 0x20) : c;
+        (*i)++;
+        return 1;
+    }
+    uint32_t codepoint;
+    size_t n = DecodeUtf8(text + *i, length - *i, &codepoint);
+    if (n == 0) {
+        // Invalid byte: copied unchanged
+        out[0] = c;
+        (*i)++;
+        return 1;
+    }
+    *i += n;
+    return EncodeUtf8(FoldCodepoint(codepoint), out);
+}
+
+const uint32_t kOutputFlag = 0x80000000u;
+
+// Length of the UTF-8 sequence starting at p (1 for stray bytes)
+size_t Utf8Length(const char* p, size_t available) {
+    uint32_t ignored;
+    size_t length = DecodeUtf8(reinterpret_cast<const unsigned char*>(p), available, &ignored);
+    return length ? length : 1;
+}
+
+// Glob match on folded text: `*` any run, `?` one UTF-8 character
+bool GlobMatch(const char* pattern, size_t patternLength, const char* text, size_t textLength) {
+    size_t p = 0, t = 0;
+    size_t starP = std::string::npos, starT = 0;
+    while (t < textLength) {
+        if (p < patternLength && pattern[p] == '?') {
+            p++;
+            t += Utf8Length(text + t, textLength - t);
+        } else if (p < patternLength && pattern[p] == '*') {
+            starP = p++;
+            starT = t;
+        } else if (p < patternLength && pattern[p] == text[t]) {
+            p++;
+            t++;
+        } else if (starP != std::string::npos) {
+            p = starP + 1;
+            starT += Utf8Length(text + starT, textLength - starT);
+            t = starT;
+        } else {
+            return false;
+        }
+    }
+    while (p < patternLength && pattern[p] == '*') p++;
+    return p == patternLength;
+}
+
+} // namespace
+
+uint32_t FoldCodepoint(uint32_t c) {
+    if (c < 0x80) {
+        return (c >= 'A' && c <= 'Z') ? c + 0x20 : c;
+    }
+    if (c < 0x100) {
+        // Latin-1 supplement, except the multiplication sign
+        return (c >= 0xC0 && c <= 0xDE && c != 0xD7) ? c + 0x20 : c;
+    }
+    if (c < 0x180) {
+        // Latin Extended-A: upper/lower pairs, parity flips at 0x139 and 0x179
+        if (c == 0x130) return 'i';
+        if (c == 0x178) return 0xFF;
+        if (c == 0x17F) return 's';
+        if ((c >= 0x100 && c <= 0x137) || (c >= 0x14A && c <= 0x177)) return c | 1;
+        if ((c >= 0x139 && c <= 0x148) || (c >= 0x179 && c <= 0x17E)) return (c & 1) ? c + 1 : c;
+        return c;
+    }
+    if (c >= 0x391 && c <= 0x3A9 && c != 0x3A2) return c + 0x20;   // Greek capitals
+    if (c == 0x3C2) return 0x3C3;                                   // final sigma
+    if (c >= 0x400 && c <= 0x40F) return c + 0x50;                  // Cyrillic Ѐ-Џ
+    if (c >= 0x410 && c <= 0x42F) return c + 0x20;                  // Cyrillic А-Я
+    if (c >= 0xFF21 && c <= 0xFF3A) return c + 0x20;                // fullwidth Ａ-Ｚ
+    return c;
+}
+
+void FoldCaseUtf8(const char* text, size_t length, std::string* out) {
+    out->clear();
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(text);
+    unsigned char buffer[4];
+    size_t i = 0;
+    while (i < length) {
+        size_t n = NextFolded(p, length, &i, buffer);
+        out->append(reinterpret_cast<const char*>(buffer), n);
+    }
+}
+
+std::string FoldCaseUtf8(const std::string& text) {
+    std::string folded;
+    FoldCaseUtf8(text.data(), text.size(), &folded);
+    return folded;
+}
+
+TitleMatcher::TitleMatcher() {
+    Clear();
+}
+
+void TitleMatcher::Clear() {
+    patterns_.clear();
+    segments_.clear();
+    segmentText_.clear();
+    alwaysMatch_.clear();
+    memset(byteClass_, 0, sizeof(byteClass_));
+    alphabetSize_ = 1;
+    stateCount_ = 1;
+    transitions_.assign(1, 0);
+    outputStart_.assign(2, 0);
+    outputs_.clear();
+    outputLink_.assign(1, 0);
+    compiled_ = false;
+    hasRegex_ = false;
+    stamp_ = 0;
+}
+
+uint32_t TitleMatcher::AddSegment(uint32_t pattern, const std::string& literal) {
+    Segment segment;
+    segment.pattern = pattern;
+    segment.length = static_cast<uint32_t>(literal.size());
+    segments_.push_back(segment);
+    segmentText_.push_back(literal);
+    return static_cast<uint32_t>(segments_.size() - 1);
+}
+
+uint32_t TitleMatcher::AddPattern(const std::string& source, TitleMatchMode mode) {
+    uint32_t id = static_cast<uint32_t>(patterns_.size());
+    Pattern pattern;
+    pattern.mode = mode;
+    pattern.anchorStart = mode == kTitleMatchPrefix;
+    pattern.anchorEnd = false;
+    pattern.firstSegment = static_cast<uint32_t>(segments_.size());
+    pattern.segmentCount = 0;
+
+    std::string body = source;
+    if (mode == kTitleMatchRegex) {
+        if (!body.empty() && body[0] == '^') {
+            pattern.anchorStart = true;
+            body.erase(0, 1);
+        }
+        if (!body.empty() && body[body.size() - 1] == '$') {
+            pattern.anchorEnd = true;
+            body.erase(body.size() - 1);
+        }
+    }
+    pattern.folded = FoldCaseUtf8(body);
+
+    if (mode == kTitleMatchRegex) {
+        // Literal pieces between wildcards go into the automaton
+        std::string literal;
+        for (char c : pattern.folded) {
+            if (c == '*' || c == '?') {
+                if (!literal.empty()) {
+                    AddSegment(id, literal);
+                    pattern.segmentCount++;
+                    literal.clear();
+                }
+            } else {
+                literal.push_back(c);
+            }
+        }
+        if (!literal.empty()) {
+            AddSegment(id, literal);
+            pattern.segmentCount++;
+        }
+    } else if (!pattern.folded.empty()) {
+        AddSegment(id, pattern.folded);
+        pattern.segmentCount = 1;
+    }
+
+    if (pattern.segmentCount == 0) {
+        alwaysMatch_.push_back(id);
+    }
+    patterns_.push_back(pattern);
+    compiled_ = false;
+    return id;
+}
+
+void TitleMatcher::Compile() {
+    // Byte classes: every byte used by a pattern gets its own class, all
+    // other bytes share class 0, which keeps the transition rows short
+    memset(byteClass_, 0, sizeof(byteClass_));
+    alphabetSize_ = 1;
+    for (const std::string& text : segmentText_) {
+        for (unsigned char c : text) {
+            if (byteClass_[c] == 0) {
+                byteClass_[c] = static_cast<uint16_t>(alphabetSize_++);
+            }
+        }
+    }
+
+    // Trie; kNoState marks missing edges until the failure pass fills them
+    const uint32_t kNoState = UINT32_MAX;
+    std::vector<std::vector<uint32_t>> stateOutputs(1);
+    transitions_.assign(alphabetSize_, kNoState);
+    stateCount_ = 1;
+    for (uint32_t s = 0; s < segmentText_.size(); s++) {
+        uint32_t state = 0;
+        for (unsigned char c : segmentText_[s]) {
+            uint32_t& next = transitions_[state * alphabetSize_ + byteClass_[c]];
+            if (next == kNoState) {
+                next = stateCount_++;
+                transitions_.resize(static_cast<size_t>(stateCount_) * alphabetSize_, kNoState);
+                stateOutputs.resize(stateCount_);
+            }
+            state = transitions_[state * alphabetSize_ + byteClass_[c]];
+        }
+        stateOutputs[state].push_back(s);
+    }
+
+    // Breadth-first failure links, turning the trie into a full DFA
+    std::vector<uint32_t> failure(stateCount_, 0);
+    outputLink_.assign(stateCount_, 0);
+    std::vector<uint32_t> queue;
+    queue.reserve(stateCount_);
+    for (uint32_t a = 0; a < alphabetSize_; a++) {
+        uint32_t& next = transitions_[a];
+        if (next == kNoState) {
+            next = 0;
+        } else {
+            failure[next] = 0;
+            queue.push_back(next);
+        }
+    }
+    for (size_t head = 0; head < queue.size(); head++) {
+        uint32_t state = queue[head];
+        uint32_t fail = failure[state];
+        outputLink_[state] = stateOutputs[fail].empty() ? outputLink_[fail] : fail;
+        for (uint32_t a = 0; a < alphabetSize_; a++) {
+            uint32_t& next = transitions_[state * alphabetSize_ + a];
+            if (next == kNoState) {
+                next = transitions_[fail * alphabetSize_ + a];
+            } else {
+                failure[next] = transitions_[fail * alphabetSize_ + a];
+                queue.push_back(next);
+            }
+        }
+    }
+
+    // Store row offsets instead of state ids so the scan loop needs no
+    // multiply, and flag edges into states that report anything
+    for (uint32_t& next : transitions_) {
+        bool reports = !stateOutputs[next].empty() || outputLink_[next] != 0;
+        next = next * alphabetSize_ | (reports ? kOutputFlag : 0);
+    }
+
+    // Flatten outputs
+    outputStart_.assign(stateCount_ + 1, 0);
+    outputs_.clear();
+    for (uint32_t state = 0; state < stateCount_; state++) {
+        outputStart_[state] = static_cast<uint32_t>(outputs_.size());
+        outputs_.insert(outputs_.end(), stateOutputs[state].begin(), stateOutputs[state].end());
+    }
+    outputStart_[stateCount_] = static_cast<uint32_t>(outputs_.size());
+
+    hasRegex_ = false;
+    for (const Pattern& pattern : patterns_) {
+        if (pattern.mode == kTitleMatchRegex) hasRegex_ = true;
+    }
+
+    segmentStamp_.assign(segments_.size(), 0);
+    patternStamp_.assign(patterns_.size(), 0);
+    candidateStamp_.assign(patterns_.size(), 0);
+    stamp_ = 0;
+    compiled_ = true;
+}
+
+bool TitleMatcher::VerifyRegex(const Pattern& pattern, const std::string& folded) const {
+    std::string glob;
+    glob.reserve(pattern.folded.size() + 2);
+    if (!pattern.anchorStart) glob.push_back('*');
+    glob += pattern.folded;
+    if (!pattern.anchorEnd) glob.push_back('*');
+    return GlobMatch(glob.data(), glob.size(), folded.data(), folded.size());
+}
+
+void TitleMatcher::ReportOutputs(uint32_t state, size_t position, std::vector<uint32_t>* matched) {
+    for (uint32_t s = state; s != 0; s = outputLink_[s]) {
+        for (uint32_t o = outputStart_[s]; o < outputStart_[s + 1]; o++) {
+            uint32_t segmentId = outputs_[o];
+            const Segment& segment = segments_[segmentId];
+            uint32_t patternId = segment.pattern;
+            if (patternStamp_[patternId] == stamp_) continue;
+
+            const Pattern& pattern = patterns_[patternId];
+            if (pattern.mode == kTitleMatchSubstring) {
+                patternStamp_[patternId] = stamp_;
+                matched->push_back(patternId);
+            } else if (pattern.mode == kTitleMatchPrefix) {
+                if (position + 1 == segment.length) {
+                    patternStamp_[patternId] = stamp_;
+                    matched->push_back(patternId);
+                }
+            } else if (segmentStamp_[segmentId] != stamp_) {
+                segmentStamp_[segmentId] = stamp_;
+                if (candidateStamp_[patternId] != stamp_) {
+                    candidateStamp_[patternId] = stamp_;
+                    candidates_.push_back(patternId);
+                }
+            }
+        }
+    }
+}
+
+void TitleMatcher::Match(const char* title, size_t length, std::vector<uint32_t>* matched) {
+    if (!compiled_) {
+        Compile();
+    }
+    if (++stamp_ == 0) {
+        // Stamp wrapped: clear once every 4 billion titles
+        segmentStamp_.assign(segments_.size(), 0);
+        patternStamp_.assign(patterns_.size(), 0);
+        candidateStamp_.assign(patterns_.size(), 0);
+        stamp_ = 1;
+    }
+
+    // Fold and scan in one pass; the folded copy is only kept for regex verification
+    folded_.clear();
+    candidates_.clear();
+    const unsigned char* text = reinterpret_cast<const unsigned char*>(title);
+    const uint32_t* transitions = transitions_.data();
+    unsigned char buffer[4];
+    uint32_t row = 0;
+    size_t position = 0;
+    size_t i = 0;
+    while (i < length) {
+        size_t n = NextFolded(text, length, &i, buffer);
+        if (hasRegex_) {
+            folded_.append(reinterpret_cast<const char*>(buffer), n);
+        }
+        for (size_t k = 0; k < n; k++, position++) {
+            uint32_t next = transitions[row + byteClass_[buffer[k]]];
+            row = next & ~kOutputFlag;
+            if (next & kOutputFlag) {
+                ReportOutputs(row / alphabetSize_, position, matched);
+            }
+        }
+    }
+
+    // Regex patterns are verified only if every literal piece was found
+    for (uint32_t p : candidates_) {
+        const Pattern& pattern = patterns_[p];
+        bool allSeen = true;
+        for (uint32_t s = pattern.firstSegment; s < pattern.firstSegment + pattern.segmentCount; s++) {
+            if (segmentStamp_[s] != stamp_) {
+                allSeen = false;
+                break;
+            }
+        }
+        if (allSeen && VerifyRegex(pattern, folded_)) {
+            matched->push_back(p);
+        }
+    }
+
+    for (uint32_t p : alwaysMatch_) {
+        const Pattern& pattern = patterns_[p];
+        if (pattern.mode != kTitleMatchRegex || VerifyRegex(pattern, folded_)) {
+            matched->push_back(p);
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Multi-pattern window title matcher.
+//
+// Patterns are compiled once into an Aho-Corasick automaton over case-folded
+// UTF-8, so every title is scanned a single time no matter how many patterns
+// there are. Case folding is the simple (1:1) Unicode folding for Latin,
+// Greek, Cyrillic and fullwidth ASCII, which covers the titles we match;
+// CJK text has no case and passes through unchanged.
+//
+// Modes:
+//   substring  pattern occurs anywhere in the title
+//   prefix     title starts with the pattern
+//   regex      "regex-like": `*` any run, `?` one character, leading `^` and
+//              trailing `$` anchor the match (unanchored otherwise). The
+//              literal pieces are fed to the automaton and the full pattern
+//              is only verified for titles that contain all of them.
+
+enum TitleMatchMode {
+    kTitleMatchSubstring = 0,
+    kTitleMatchPrefix,
+    kTitleMatchRegex
+};
+
+// Simple case folding of one code point
+uint32_t FoldCodepoint(uint32_t codepoint);
+
+// Case-folded copy of a UTF-8 string (invalid bytes are copied unchanged)
+void FoldCaseUtf8(const char* text, size_t length, std::string* out);
+std::string FoldCaseUtf8(const std::string& text);
+
+class TitleMatcher {
+public:
+    TitleMatcher();
+
+    void Clear();
+    // Returns the pattern id (0, 1, 2, ... in call order)
+    uint32_t AddPattern(const std::string& pattern, TitleMatchMode mode);
+    // Must be called after the last AddPattern and before matching
+    void Compile();
+
+    size_t PatternCount() const { return patterns_.size(); }
+    size_t StateCount() const { return stateCount_; }
+
+    // Appends the ids of all patterns matching the title (each id once)
+    void Match(const char* title, size_t length, std::vector<uint32_t>* matched);
+    void Match(const std::string& title, std::vector<uint32_t>* matched) {
+        Match(title.data(), title.size(), matched);
+    }
+
+private:
+    struct Pattern {
+        TitleMatchMode mode;
+        std::string folded;       // whole folded pattern (regex mode: without anchors)
+        bool anchorStart;
+        bool anchorEnd;
+        uint32_t firstSegment;
+        uint32_t segmentCount;
+    };
+
+    struct Segment {
+        uint32_t pattern;
+        uint32_t length;          // folded bytes
+    };
+
+    uint32_t AddSegment(uint32_t pattern, const std::string& literal);
+    bool VerifyRegex(const Pattern& pattern, const std::string& folded) const;
+    void ReportOutputs(uint32_t state, size_t position, std::vector<uint32_t>* matched);
+
+    std::vector<Pattern> patterns_;
+    std::vector<Segment> segments_;
+    std::vector<std::string> segmentText_;
+
+    // Automaton: dense transitions over byte classes
+    uint16_t byteClass_[256];
+    uint32_t alphabetSize_;
+    uint32_t stateCount_;
+    std::vector<uint32_t> transitions_;   // stateCount_ * alphabetSize_ row offsets, top bit = reports
+    std::vector<uint32_t> outputStart_;   // per state, into outputs_
+    std::vector<uint32_t> outputs_;       // segment ids, grouped by state
+    std::vector<uint32_t> outputLink_;    // nearest suffix state with outputs (0 = none)
+    bool compiled_;
+    bool hasRegex_;
+    std::vector<uint32_t> alwaysMatch_;   // regex patterns without literal pieces
+
+    // Per-scan scratch; stamps avoid clearing between titles
+    std::string folded_;
+    uint32_t stamp_;
+    std::vector<uint32_t> segmentStamp_;
+    std::vector<uint32_t> patternStamp_;
+    std::vector<uint32_t> candidateStamp_;
+    std::vector<uint32_t> candidates_;    // regex patterns with a literal piece seen
+};
@@ -0,0 +1,265 @@
+#include "topmost_targets.h"
+
+#include <algorithm>
+
+#include "event_ring.h"
+#include "trace_events.h"
+
+TopmostTargetSet::Target* TopmostTargetSet::Find(WindowHandle window) {
+    for (Target& target : targets_) {
+        if (target.window == window) return &target;
+    }
+    return nullptr;
+}
+
+const TopmostTargetSet::Target* TopmostTargetSet::Find(WindowHandle window) const {
+    for (const Target& target : targets_) {
+        if (target.window == window) return &target;
+    }
+    return nullptr;
+}
+
+void TopmostTargetSet::Add(WindowHandle window, const TopmostPolicy& policy, bool hidden) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Target target = {};
+    Target* existing = Find(window);
+    if (existing) {
+        // Same window, new policy: counters and budget carry over
+        target = *existing;
+        targets_.erase(targets_.begin() + (existing - targets_.data()));
+    } else {
+        target.window = window;
+        target.hidden = hidden;
+    }
+    target.policy = policy;
+
+    // Kept sorted, so a raise batch is already in stacking order
+    auto position = std::find_if(targets_.begin(), targets_.end(),
+                                 [&](const Target& other) { return other.policy.priority < policy.priority; });
+    targets_.insert(position, target);
+}
+
+void TopmostTargetSet::Retire(const Target& target) {
+    retired_.reRaises += target.reRaises;
+    retired_.throttled += target.throttled;
+    retired_.backoffs += target.backoffs;
+    retired_.hides += target.hides;
+}
+
+bool TopmostTargetSet::Remove(WindowHandle window) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Target* target = Find(window);
+    if (!target) return false;
+    Retire(*target);
+    targets_.erase(targets_.begin() + (target - targets_.data()));
+    return true;
+}
+
+void TopmostTargetSet::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Target& target : targets_) {
+        Retire(target);
+    }
+    targets_.clear();
+}
+
+bool TopmostTargetSet::Contains(WindowHandle window) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Find(window) != nullptr;
+}
+
+bool TopmostTargetSet::Empty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return targets_.empty();
+}
+
+bool TopmostTargetSet::AnyVisible() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Target& target : targets_) {
+        if (!target.hidden) return true;
+    }
+    return false;
+}
+
+bool TopmostTargetSet::SetHidden(WindowHandle window, bool hidden) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Target* target = Find(window);
+    if (!target || target->hidden == hidden) return false;
+    target->hidden = hidden;
+    if (hidden) {
+        target->hides++;
+        // Nothing to retry while it cannot be seen
+        target->pending = false;
+    }
+    return true;
+}
+
+bool TopmostTargetSet::TakeBudget(Target& target, uint64_t nowNs) {
+    if (nowNs < target.backoffUntilNs) {
+        target.throttled++;
+        target.pending = true;
+        return false;
+    }
+
+    const TopmostPolicy& policy = target.policy;
+    const uint64_t periodNs = static_cast<uint64_t>(kTopmostBudgetPeriodMs) * 1000000ull;
+    if (nowNs - target.periodStartNs >= periodNs) {
+        // A whole period passed without running out: the fight is over
+        target.periodStartNs = nowNs;
+        target.periodRaises = 0;
+        target.backoffMs = 0;
+    }
+    if (policy.raiseBudget != 0 && target.periodRaises >= policy.raiseBudget) {
+        target.backoffMs = target.backoffMs == 0 ? policy.backoffMs
+                                                 : std::min(target.backoffMs * 2, kTopmostMaxBackoffMs);
+        // A zero backoff waits out the rest of the period
+        target.backoffUntilNs = target.backoffMs != 0
+            ? nowNs + static_cast<uint64_t>(target.backoffMs) * 1000000ull
+            : target.periodStartNs + periodNs;
+        target.periodStartNs = target.backoffUntilNs;
+        target.periodRaises = 0;
+        target.backoffs++;
+        target.throttled++;
+        target.pending = true;
+        return false;
+    }
+
+    target.periodRaises++;
+    target.pending = false;
+    return true;
+}
+
+size_t TopmostTargetSet::Check(uint64_t nowNs, uint64_t eventNs) {
+    TraceSpan span("topmost", "monitorCheck");
+    span.SetArg("reRaised", 0);
+
+    visible_.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        checks_++;
+        for (const Target& target : targets_) {
+            if (!target.hidden) visible_.push_back(target.window);
+        }
+    }
+    if (visible_.empty()) {
+        return 0;
+    }
+
+    // One z-order read for every target; the lock is not held across it
+    std::vector<bool> onTop = AreWindowsNearTop(visible_, kTopmostCheckDepth);
+
+    raise_.clear();
+    size_t raised = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Only the watcher thread changes targets_, so it still matches visible_
+        covered_.assign(targets_.size(), false);
+        int32_t lowestRaised = 0;
+        size_t v = 0;
+        for (size_t i = 0; i < targets_.size(); i++) {
+            Target& target = targets_[i];
+            if (target.hidden) continue;
+            if (onTop[v++]) {
+                target.pending = false;
+                continue;
+            }
+            if (TakeBudget(target, nowNs)) {
+                covered_[i] = true;
+                lowestRaised = target.policy.priority;
+                raised++;
+            }
+        }
+        if (raised == 0) {
+            return 0;
+        }
+
+        // Raised windows land on top of the topmost band; visible targets
+        // that outrank them go along so the priority order holds
+        for (size_t i = 0; i < targets_.size(); i++) {
+            Target& target = targets_[i];
+            if (covered_[i]) {
+                target.reRaises++;
+                raise_.push_back(target.window);
+            } else if (!target.hidden && target.policy.priority > lowestRaised) {
+                raise_.push_back(target.window);
+            }
+        }
+    }
+
+    SetWindowsAlwaysOnTop(raise_, true);
+    span.SetArg("reRaised", static_cast<int64_t>(raised));
+    uint64_t done = SteadyNowNs();
+    reaction_.Record(done > eventNs ? done - eventNs : 0);
+    return raised;
+}
+
+uint64_t TopmostTargetSet::RetryDeadline() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t deadline = 0;
+    for (const Target& target : targets_) {
+        if (target.pending && !target.hidden && (deadline == 0 || target.backoffUntilNs < deadline)) {
+            deadline = target.backoffUntilNs;
+        }
+    }
+    return deadline;
+}
+
+void TopmostTargetSet::CountEvent() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_++;
+}
+
+TopmostWatcherStats TopmostTargetSet::Stats() const {
+    TopmostWatcherStats stats = {};
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.events = events_;
+    stats.checks = checks_;
+    stats.windows = static_cast<uint32_t>(targets_.size());
+    stats.reRaises = retired_.reRaises;
+    stats.throttled = retired_.throttled;
+    stats.backoffs = retired_.backoffs;
+    stats.hides = retired_.hides;
+    stats.hidden = true;
+    for (const Target& target : targets_) {
+        stats.reRaises += target.reRaises;
+        stats.throttled += target.throttled;
+        stats.backoffs += target.backoffs;
+        stats.hides += target.hides;
+        stats.hidden = stats.hidden && target.hidden;
+    }
+    stats.reaction = reaction_.Summarize();
+    return stats;
+}
+
+std::vector<TopmostTargetStats> TopmostTargetSet::TargetStats() const {
+    std::vector<TopmostTargetStats> result;
+    uint64_t now = SteadyNowNs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Target& target : targets_) {
+        TopmostTargetStats stats;
+        stats.window = target.window;
+        stats.policy = target.policy;
+        stats.reRaises = target.reRaises;
+        stats.throttled = target.throttled;
+        stats.backoffs = target.backoffs;
+        stats.hides = target.hides;
+        stats.hidden = target.hidden;
+        stats.backingOff = now < target.backoffUntilNs;
+        result.push_back(stats);
+    }
+    return result;
+}
+
+void TopmostTargetSet::ResetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_ = 0;
+    checks_ = 0;
+    retired_ = Target();
+    for (Target& target : targets_) {
+        target.reRaises = 0;
+        target.throttled = 0;
+        target.backoffs = 0;
+        target.hides = 0;
+    }
+    reaction_.Reset();
+}
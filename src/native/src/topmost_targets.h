@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "latency_histogram.h"
+#include "window_platform.h"
+
+// The windows one topmost watcher keeps on top, each with its own policy.
+//
+// The platform watchers (topmost_watcher_*.cc) only translate window system
+// notifications into "this target was shown/hidden" and "something may have
+// covered a target". Everything else happens here, on the watcher thread:
+// one z-order read per notification tells for every visible target at once
+// whether it is still near the top, and the covered ones are raised in one
+// batch with the highest priority on top. A window that keeps getting covered
+// (a fullscreen game fighting for the top) spends its re-raise budget and
+// then backs off, the pause doubling every time the budget runs out again,
+// instead of trading raises with the game as fast as events arrive.
+//
+// Only the watcher thread changes the set; Stats() and TargetStats() may be
+// called from any thread.
+
+// Only this many windows from the top of the z-order count as "on top"
+const int kTopmostCheckDepth = 10;
+// Re-raise budgets are counted per period
+const uint32_t kTopmostBudgetPeriodMs = 1000;
+const uint32_t kTopmostMaxBackoffMs = 10000;
+
+struct TopmostPolicy {
+    int32_t priority = 0;        // higher priority windows end up above lower ones
+    uint32_t raiseBudget = 20;   // re-raises per budget period; 0 = unlimited
+    uint32_t backoffMs = 250;    // first pause once the budget is spent, doubled on each further one
+};
+
+struct TopmostTargetStats {
+    WindowHandle window;
+    TopmostPolicy policy;
+    uint64_t reRaises;     // times the window had to be raised again
+    uint64_t throttled;    // covered while backing off, raise deferred
+    uint64_t backoffs;     // times the budget ran out
+    uint64_t hides;        // hidden/minimized transitions
+    bool hidden;
+    bool backingOff;
+};
+
+// All targets together
+struct TopmostWatcherStats {
+    uint64_t events;       // notifications that woke the watcher
+    uint64_t checks;       // z-order checks performed (one covers every target)
+    uint64_t reRaises;
+    uint64_t throttled;
+    uint64_t backoffs;
+    uint64_t hides;
+    uint32_t windows;      // targets being watched
+    bool hidden;           // every target hidden (also with no targets)
+    LatencySummary reaction; // OS event -> re-raise completed, ns
+};
+
+class TopmostTargetSet {
+public:
+    // Adds a window, or changes the policy of one already in the set
+    void Add(WindowHandle window, const TopmostPolicy& policy, bool hidden);
+    bool Remove(WindowHandle window);
+    void Clear();
+    bool Contains(WindowHandle window) const;
+    bool Empty() const;
+    // False once every target is hidden: the watcher can drop its global subscriptions
+    bool AnyVisible() const;
+    // True if the state changed
+    bool SetHidden(WindowHandle window, bool hidden);
+
+    // Something may have covered the visible targets. Raises the covered ones
+    // whose policy allows it and returns how many were raised; eventNs is when
+    // the notification was sent (reaction latency is recorded from there).
+    size_t Check(uint64_t nowNs, uint64_t eventNs);
+    // When the earliest deferred raise may happen (SteadyNowNs), 0 if none;
+    // the watcher calls Check() again then
+    uint64_t RetryDeadline() const;
+
+    void CountEvent();
+    TopmostWatcherStats Stats() const;
+    std::vector<TopmostTargetStats> TargetStats() const;
+    void ResetStats();
+
+private:
+    struct Target {
+        WindowHandle window;
+        TopmostPolicy policy;
+        bool hidden;
+        bool pending;              // covered while backing off
+        uint64_t periodStartNs;    // budget period
+        uint32_t periodRaises;
+        uint32_t backoffMs;        // current pause, 0 while not escalated
+        uint64_t backoffUntilNs;
+        uint64_t reRaises;
+        uint64_t throttled;
+        uint64_t backoffs;
+        uint64_t hides;
+    };
+
+    // mutex_ held. Keeps the counters of a target that leaves in the totals.
+    void Retire(const Target& target);
+    // mutex_ held; nullptr if absent
+    Target* Find(WindowHandle window);
+    const Target* Find(WindowHandle window) const;
+    // mutex_ held. True if the policy allows raising now; otherwise marks it pending.
+    bool TakeBudget(Target& target, uint64_t nowNs);
+
+    mutable std::mutex mutex_;
+    std::vector<Target> targets_;       // highest priority first
+    uint64_t events_ = 0;
+    uint64_t checks_ = 0;
+    Target retired_ = {};               // counters of removed targets
+    LatencyHistogram reaction_;
+
+    // Check() scratch, watcher thread only
+    std::vector<WindowHandle> visible_;
+    std::vector<WindowHandle> raise_;
+    std::vector<bool> covered_;
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "topmost_targets.h"
+#include "trace_events.h"
+#include "window_platform.h"
+
+// Event-driven topmost enforcement.
+//
+// Instead of polling the z-order, one watcher thread subscribes to the window
+// system's z-order / foreground notifications (WinEvent hooks on Windows,
+// ConfigureNotify and _NET_ACTIVE_WINDOW on X11) and re-raises covered
+// targets as soon as something covers them. Any number of windows share the
+// thread and its subscriptions, so the cost grows with the notifications,
+// not with the windows; per-window policies and the raise decision live in
+// TopmostTargetSet. While every target is hidden or minimized the global
+// subscriptions are dropped, so the thread sleeps with zero wakeups until
+// one is shown again.
+
+// Watch()/Unwatch() calls handed to the watcher thread, which owns the
+// per-window subscriptions. The caller blocks until the thread applied them.
+class TopmostCommandQueue {
+public:
+    struct Command {
+        WindowHandle window;
+        TopmostPolicy policy;
+        bool add;
+        bool done;
+        bool result;
+    };
+
+    void Open() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = true;
+    }
+
+    // Fails everything still queued; later pushes fail right away
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = false;
+        for (Command* command : queued_) {
+            command->done = true;
+            command->result = false;
+        }
+        queued_.clear();
+        done_.notify_all();
+    }
+
+    // Caller thread; false if the watcher is not running
+    bool Push(Command* command) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!open_) return false;
+        command->done = false;
+        command->result = false;
+        queued_.push_back(command);
+        return true;
+    }
+
+    // Caller thread, after waking the watcher
+    bool Wait(Command* command) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [command]() { return command->done; });
+        return command->result;
+    }
+
+    // Watcher thread
+    void Take(std::vector<Command*>* commands) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        commands->swap(queued_);
+        queued_.clear();
+    }
+
+    void Complete(Command* command, bool result) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        command->result = result;
+        command->done = true;
+        done_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable done_;
+    std::vector<Command*> queued_;
+    bool open_ = false;
+};
+
+class TopmostWatcher {
+public:
+    virtual ~TopmostWatcher() {}
+
+    // Starts the watcher thread with no windows; it sleeps until one is added
+    virtual bool Start() = 0;
+    // Drops every window and blocks until the watcher thread has exited
+    virtual void Stop() = 0;
+    virtual bool IsRunning() const = 0;
+
+    // Adds a window, assumed to be topmost already, or changes its policy.
+    // Returns once the watcher thread has subscribed to it; false if the
+    // window is invalid or the watcher is not running.
+    virtual bool Watch(WindowHandle window, const TopmostPolicy& policy) = 0;
+    // Destroyed windows leave the set on their own
+    virtual bool Unwatch(WindowHandle window) = 0;
+
+    virtual TopmostWatcherStats Stats() const = 0;
+    virtual std::vector<TopmostTargetStats> TargetStats() const = 0;
+    virtual void ResetStats() = 0;
+};
+
+// SetWindowAlwaysOnTop() recorded as a trace span, for every single-window
+// raise or lower the topmost module makes
+inline bool TracedSetWindowAlwaysOnTop(WindowHandle window, bool topmost) {
+    TraceSpan span("topmost", "SetWindowAlwaysOnTop");
+    bool success = SetWindowAlwaysOnTop(window, topmost);
+    span.SetArg("success", success);
+    return success;
+}
+
+// Implemented once per platform (topmost_watcher_win32.cc, topmost_watcher_x11.cc)
+TopmostWatcher* CreateTopmostWatcher();
@@ -0,0 +1,362 @@
+#include <windows.h>
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "event_ring.h"
+#include "topmost_watcher.h"
+
+// WinEvent based watcher. Out-of-context WinEvent hooks are delivered through
+// the message queue of the thread that installed them, so the watcher thread
+// only runs a GetMessage loop and wakes up exactly when the z-order or the
+// foreground window changes.
+//
+// While any target is visible three global hooks are active:
+//   EVENT_SYSTEM_FOREGROUND   another window was activated
+//   EVENT_OBJECT_SHOW         a new top-level window appeared
+//   EVENT_OBJECT_REORDER      the z-order changed
+// One notification leads to one check covering every target. The targets'
+// own show/hide/minimize/destroy events come from hooks scoped to their
+// processes, one pair per process however many targets it owns. When every
+// target is hidden or minimized the global hooks are removed, leaving only
+// the process-scoped ones, so nothing else wakes us up.
+//
+// Watch()/Unwatch() are posted to the thread as kMsgCommands, and a target
+// backing off is re-checked from a thread timer when its pause ends.
+
+namespace {
+
+class Win32TopmostWatcher;
+
+// WinEvent procs carry no context, so the running watcher is kept here
+Win32TopmostWatcher* activeWatcher = nullptr;
+
+void CALLBACK WinEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd, LONG idObject,
+                           LONG idChild, DWORD eventThread, DWORD eventTime);
+
+const DWORD kHookFlags = WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS;
+const UINT kMsgCommands = WM_APP + 1;
+
+class Win32TopmostWatcher : public TopmostWatcher {
+public:
+    Win32TopmostWatcher()
+        : threadId_(0), foregroundHook_(NULL), showHook_(NULL), reorderHook_(NULL),
+          retryTimer_(0), running_(false) {}
+
+    ~Win32TopmostWatcher() override { Stop(); }
+
+    bool Start() override {
+        Stop();
+
+        targets_.Clear();
+        commands_.Open();
+        activeWatcher = this;
+        running_ = true;
+
+        HANDLE readyEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+        watcherThread_ = std::thread([this, readyEvent]() {
+            threadId_ = GetCurrentThreadId();
+            SetTraceThreadName("topmost watcher");
+
+            // Make sure the thread has a message queue before Start() returns,
+            // otherwise an early PostThreadMessage would be lost
+            MSG msg;
+            PeekMessage(&msg, NULL, WM_USER, WM_USER, PM_NOREMOVE);
+            SetEvent(readyEvent);
+
+            while (GetMessage(&msg, NULL, 0, 0) > 0) {
+                if (msg.hwnd == NULL && msg.message == kMsgCommands) {
+                    RunCommands();
+                    continue;
+                }
+                if (msg.hwnd == NULL && msg.message == WM_TIMER && msg.wParam == retryTimer_) {
+                    KillTimer(NULL, retryTimer_);
+                    retryTimer_ = 0;
+                    uint64_t now = SteadyNowNs();
+                    targets_.Check(now, now);
+                    ArmRetry();
+                    continue;
+                }
+                TranslateMessage(&msg);
+                DispatchMessage(&msg);
+            }
+
+            if (retryTimer_) {
+                KillTimer(NULL, retryTimer_);
+                retryTimer_ = 0;
+            }
+            RemoveGlobalHooks();
+            for (const ProcessHooks& hooks : processHooks_) {
+                if (hooks.stateHook) UnhookWinEvent(hooks.stateHook);
+                if (hooks.objectHook) UnhookWinEvent(hooks.objectHook);
+            }
+            processHooks_.clear();
+            targetProcesses_.clear();
+            // Callers still waiting get false instead of blocking on a dead thread
+            commands_.Close();
+        });
+
+        WaitForSingleObject(readyEvent, INFINITE);
+        CloseHandle(readyEvent);
+        return true;
+    }
+
+    void Stop() override {
+        if (watcherThread_.joinable()) {
+            PostThreadMessage(threadId_, WM_QUIT, 0, 0);
+            watcherThread_.join();
+        }
+        commands_.Close();
+        targets_.Clear();
+        threadId_ = 0;
+        running_ = false;
+        if (activeWatcher == this) {
+            activeWatcher = nullptr;
+        }
+    }
+
+    bool IsRunning() const override { return running_; }
+
+    bool Watch(WindowHandle window, const TopmostPolicy& policy) override {
+        TopmostCommandQueue::Command command = { window, policy, true, false, false };
+        return Send(&command);
+    }
+
+    bool Unwatch(WindowHandle window) override {
+        TopmostCommandQueue::Command command = { window, TopmostPolicy(), false, false, false };
+        return Send(&command);
+    }
+
+    TopmostWatcherStats Stats() const override { return targets_.Stats(); }
+    std::vector<TopmostTargetStats> TargetStats() const override { return targets_.TargetStats(); }
+    void ResetStats() override { targets_.ResetStats(); }
+
+    void OnWinEvent(DWORD event, HWND hwnd, LONG idObject, LONG idChild, DWORD eventTime) {
+        targets_.CountEvent();
+
+        // Only whole top-level windows are interesting, not their child objects
+        if (idObject != OBJID_WINDOW || idChild != CHILDID_SELF) {
+            return;
+        }
+
+        uint64_t entry = SteadyNowNs();
+        uint64_t osDelayNs = eventTime != 0 ? static_cast<uint64_t>(GetTickCount() - eventTime) * 1000000ull : 0;
+        WindowHandle window = reinterpret_cast<WindowHandle>(hwnd);
+
+        if (targets_.Contains(window)) {
+            switch (event) {
+                case EVENT_OBJECT_DESTROY:
+                    // Target is gone; nothing left to keep on top
+                    RemoveTarget(hwnd);
+                    return;
+                case EVENT_OBJECT_HIDE:
+                case EVENT_SYSTEM_MINIMIZESTART:
+                    if (targets_.SetHidden(window, true)) {
+                        UpdateGlobalHooks();
+                    }
+                    return;
+                case EVENT_OBJECT_SHOW:
+                case EVENT_SYSTEM_MINIMIZEEND:
+                    if (!IsHidden(hwnd)) {
+                        if (targets_.SetHidden(window, false)) {
+                            UpdateGlobalHooks();
+                        }
+                        Check(entry, osDelayNs);
+                    }
+                    return;
+                default:
+                    return;
+            }
+        }
+
+        if (!targets_.AnyVisible()) {
+            return;
+        }
+        if (event != EVENT_SYSTEM_FOREGROUND && GetAncestor(hwnd, GA_ROOT) != hwnd) {
+            return;
+        }
+
+        Check(entry, osDelayNs);
+    }
+
+private:
+    // Process-scoped hooks, shared by every target of that process
+    struct ProcessHooks {
+        DWORD processId;
+        HWINEVENTHOOK stateHook;
+        HWINEVENTHOOK objectHook;
+        int targets;
+    };
+
+    static bool IsHidden(HWND window) {
+        return !IsWindowVisible(window) || IsIconic(window);
+    }
+
+    bool Send(TopmostCommandQueue::Command* command) {
+        if (!commands_.Push(command)) {
+            return false;
+        }
+        PostThreadMessage(threadId_, kMsgCommands, 0, 0);
+        return commands_.Wait(command);
+    }
+
+    void RunCommands() {
+        std::vector<TopmostCommandQueue::Command*> commands;
+        commands_.Take(&commands);
+        for (TopmostCommandQueue::Command* command : commands) {
+            HWND hwnd = reinterpret_cast<HWND>(command->window);
+            bool result;
+            if (!command->add) {
+                result = RemoveTarget(hwnd);
+            } else if (targets_.Contains(command->window)) {
+                targets_.Add(command->window, command->policy, false);
+                result = true;
+            } else if (IsWindow(hwnd)) {
+                AddProcessHooks(hwnd);
+                targets_.Add(command->window, command->policy, IsHidden(hwnd));
+                UpdateGlobalHooks();
+                result = true;
+            } else {
+                result = false;
+            }
+            commands_.Complete(command, result);
+        }
+    }
+
+    void Check(uint64_t entry, uint64_t osDelayNs) {
+        targets_.Check(entry, entry - osDelayNs);
+        ArmRetry();
+    }
+
+    // One timer for the earliest target whose backoff ends
+    void ArmRetry() {
+        uint64_t deadline = targets_.RetryDeadline();
+        if (deadline == 0) {
+            if (retryTimer_) {
+                KillTimer(NULL, retryTimer_);
+                retryTimer_ = 0;
+            }
+            return;
+        }
+        uint64_t now = SteadyNowNs();
+        UINT delayMs = deadline > now ? static_cast<UINT>((deadline - now + 999999) / 1000000) : 1;
+        // Without a window the id argument is ignored; SetTimer hands out a new one
+        if (retryTimer_) {
+            KillTimer(NULL, retryTimer_);
+        }
+        retryTimer_ = SetTimer(NULL, 0, delayMs, NULL);
+    }
+
+    bool RemoveTarget(HWND hwnd) {
+        if (!targets_.Remove(reinterpret_cast<WindowHandle>(hwnd))) {
+            return false;
+        }
+        for (size_t i = 0; i < targetProcesses_.size(); i++) {
+            if (targetProcesses_[i].first == hwnd) {
+                ReleaseProcessHooks(targetProcesses_[i].second);
+                targetProcesses_.erase(targetProcesses_.begin() + i);
+                break;
+            }
+        }
+        UpdateGlobalHooks();
+        ArmRetry();
+        return true;
+    }
+
+    void AddProcessHooks(HWND hwnd) {
+        DWORD processId = 0;
+        GetWindowThreadProcessId(hwnd, &processId);
+        targetProcesses_.push_back(std::make_pair(hwnd, processId));
+        for (ProcessHooks& hooks : processHooks_) {
+            if (hooks.processId == processId) {
+                hooks.targets++;
+                return;
+            }
+        }
+
+        // Targets usually live in our own process, so these must not skip it
+        const DWORD flags = WINEVENT_OUTOFCONTEXT;
+        ProcessHooks hooks;
+        hooks.processId = processId;
+        hooks.stateHook = SetWinEventHook(EVENT_SYSTEM_MINIMIZESTART, EVENT_SYSTEM_MINIMIZEEND,
+                                          NULL, WinEventProc, processId, 0, flags);
+        // EVENT_OBJECT_DESTROY, EVENT_OBJECT_SHOW and EVENT_OBJECT_HIDE are consecutive
+        hooks.objectHook = SetWinEventHook(EVENT_OBJECT_DESTROY, EVENT_OBJECT_HIDE,
+                                           NULL, WinEventProc, processId, 0, flags);
+        hooks.targets = 1;
+        processHooks_.push_back(hooks);
+    }
+
+    void ReleaseProcessHooks(DWORD processId) {
+        for (size_t i = 0; i < processHooks_.size(); i++) {
+            ProcessHooks& hooks = processHooks_[i];
+            if (hooks.processId != processId || --hooks.targets > 0) {
+                continue;
+            }
+            if (hooks.stateHook) UnhookWinEvent(hooks.stateHook);
+            if (hooks.objectHook) UnhookWinEvent(hooks.objectHook);
+            processHooks_.erase(processHooks_.begin() + i);
+            return;
+        }
+    }
+
+    void UpdateGlobalHooks() {
+        if (targets_.AnyVisible()) {
+            InstallGlobalHooks();
+        } else {
+            RemoveGlobalHooks();
+        }
+    }
+
+    void InstallGlobalHooks() {
+        if (!foregroundHook_) {
+            foregroundHook_ = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND,
+                                              NULL, WinEventProc, 0, 0, kHookFlags);
+        }
+        if (!showHook_) {
+            showHook_ = SetWinEventHook(EVENT_OBJECT_SHOW, EVENT_OBJECT_SHOW,
+                                        NULL, WinEventProc, 0, 0, kHookFlags);
+        }
+        if (!reorderHook_) {
+            reorderHook_ = SetWinEventHook(EVENT_OBJECT_REORDER, EVENT_OBJECT_REORDER,
+                                           NULL, WinEventProc, 0, 0, kHookFlags);
+        }
+    }
+
+    void RemoveGlobalHooks() {
+        HWINEVENTHOOK* hooks[] = { &foregroundHook_, &showHook_, &reorderHook_ };
+        for (HWINEVENTHOOK* hook : hooks) {
+            if (*hook) {
+                UnhookWinEvent(*hook);
+                *hook = NULL;
+            }
+        }
+    }
+
+    DWORD threadId_;
+    HWINEVENTHOOK foregroundHook_;
+    HWINEVENTHOOK showHook_;
+    HWINEVENTHOOK reorderHook_;
+    // Watcher thread only
+    std::vector<ProcessHooks> processHooks_;
+    std::vector<std::pair<HWND, DWORD>> targetProcesses_;
+    UINT_PTR retryTimer_;
+    std::thread watcherThread_;
+    volatile bool running_;
+    TopmostCommandQueue commands_;
+    TopmostTargetSet targets_;
+};
+
+void CALLBACK WinEventProc(HWINEVENTHOOK, DWORD event, HWND hwnd, LONG idObject,
+                           LONG idChild, DWORD, DWORD eventTime) {
+    if (activeWatcher && hwnd) {
+        activeWatcher->OnWinEvent(event, hwnd, idObject, idChild, eventTime);
+    }
+}
+
+} // namespace
+
+TopmostWatcher* CreateTopmostWatcher() {
+    return new Win32TopmostWatcher();
+}
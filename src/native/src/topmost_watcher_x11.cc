@@ -0,0 +1,285 @@
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include "event_ring.h"
+#include "topmost_watcher.h"
+#include "x11_connection.h"
+
+// X11 watcher. It runs on its own XCB connection and blocks in poll() on the
+// connection fd plus two eventfds: one to stop it, one to hand it
+// Watch()/Unwatch() calls.
+//
+// While any target is mapped it selects on the root window:
+//   SubstructureNotify  ConfigureNotify/MapNotify of any top-level window
+//                       (restacks and newly shown windows)
+//   PropertyChange      _NET_ACTIVE_WINDOW / _NET_CLIENT_LIST_STACKING updates
+// and StructureNotify on every target for map/unmap/destroy. Everything
+// queued when the thread wakes is coalesced into at most one check covering
+// all targets. When every target is unmapped (hidden or iconified) the root
+// selection is cleared, so the only thing that can wake the thread is a
+// target being mapped again. A target backing off is re-checked through the
+// poll() timeout when its pause ends.
+//
+// X events carry no timestamp on a clock we can compare with, so reaction
+// latency is measured from the poll() wakeup to the re-raise completing.
+
+namespace {
+
+class X11TopmostWatcher : public TopmostWatcher {
+public:
+    X11TopmostWatcher() : stopFd_(-1), commandFd_(-1), rootSelected_(false), running_(false) {}
+
+    ~X11TopmostWatcher() override { Stop(); }
+
+    bool Start() override {
+        Stop();
+
+        targets_.Clear();
+        if (!connection_.Open()) {
+            return false;
+        }
+        stopFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        commandFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (stopFd_ < 0 || commandFd_ < 0) {
+            Stop();
+            return false;
+        }
+
+        rootSelected_ = false;
+        commands_.Open();
+        running_ = true;
+        watcherThread_ = std::thread(&X11TopmostWatcher::WatchLoop, this);
+        return true;
+    }
+
+    void Stop() override {
+        if (watcherThread_.joinable()) {
+            Signal(stopFd_);
+            watcherThread_.join();
+        }
+        commands_.Close();
+        targets_.Clear();
+        int* fds[] = { &stopFd_, &commandFd_ };
+        for (int* fd : fds) {
+            if (*fd >= 0) {
+                close(*fd);
+                *fd = -1;
+            }
+        }
+        connection_.Close();
+        running_ = false;
+    }
+
+    bool IsRunning() const override { return running_; }
+
+    bool Watch(WindowHandle window, const TopmostPolicy& policy) override {
+        TopmostCommandQueue::Command command = { window, policy, true, false, false };
+        return Send(&command);
+    }
+
+    bool Unwatch(WindowHandle window) override {
+        TopmostCommandQueue::Command command = { window, TopmostPolicy(), false, false, false };
+        return Send(&command);
+    }
+
+    TopmostWatcherStats Stats() const override { return targets_.Stats(); }
+    std::vector<TopmostTargetStats> TargetStats() const override { return targets_.TargetStats(); }
+    void ResetStats() override { targets_.ResetStats(); }
+
+private:
+    static void Signal(int fd) {
+        uint64_t one = 1;
+        ssize_t ignored = write(fd, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    bool Send(TopmostCommandQueue::Command* command) {
+        if (!commands_.Push(command)) {
+            return false;
+        }
+        Signal(commandFd_);
+        return commands_.Wait(command);
+    }
+
+    // Watcher thread
+    void RunCommands() {
+        std::vector<TopmostCommandQueue::Command*> commands;
+        commands_.Take(&commands);
+        for (TopmostCommandQueue::Command* command : commands) {
+            bool result;
+            if (!command->add) {
+                result = targets_.Remove(command->window);
+                if (result) {
+                    const uint32_t noEvents = XCB_EVENT_MASK_NO_EVENT;
+                    xcb_change_window_attributes(connection_.Get(), static_cast<xcb_window_t>(command->window),
+                                                 XCB_CW_EVENT_MASK, &noEvents);
+                }
+            } else if (targets_.Contains(command->window)) {
+                targets_.Add(command->window, command->policy, false);
+                result = true;
+            } else {
+                result = AddTarget(command->window, command->policy);
+            }
+            commands_.Complete(command, result);
+        }
+        UpdateRootSelection();
+    }
+
+    bool AddTarget(WindowHandle window, const TopmostPolicy& policy) {
+        xcb_connection_t* c = connection_.Get();
+        xcb_window_t target = static_cast<xcb_window_t>(window);
+        const uint32_t targetMask = XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+        xcb_void_cookie_t select = xcb_change_window_attributes_checked(c, target, XCB_CW_EVENT_MASK, &targetMask);
+        xcb_get_window_attributes_reply_t* attributes = xcb_get_window_attributes_reply(c,
+            xcb_get_window_attributes(c, target), nullptr);
+        xcb_generic_error_t* error = xcb_request_check(c, select);
+        bool valid = attributes != nullptr && error == nullptr;
+        bool hidden = attributes && attributes->map_state != XCB_MAP_STATE_VIEWABLE;
+        free(attributes);
+        free(error);
+        if (valid) {
+            targets_.Add(window, policy, hidden);
+        }
+        return valid;
+    }
+
+    void UpdateRootSelection() {
+        bool selected = targets_.AnyVisible();
+        if (selected == rootSelected_) {
+            return;
+        }
+        rootSelected_ = selected;
+        const uint32_t rootMask = selected
+            ? XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_PROPERTY_CHANGE
+            : XCB_EVENT_MASK_NO_EVENT;
+        xcb_change_window_attributes(connection_.Get(), connection_.Root(), XCB_CW_EVENT_MASK, &rootMask);
+        xcb_flush(connection_.Get());
+    }
+
+    // Returns true if the event may have changed the stacking order
+    bool HandleEvent(const xcb_generic_event_t* event) {
+        const X11Atoms& atoms = connection_.Atoms();
+        xcb_window_t root = connection_.Root();
+
+        switch (event->response_type & ~0x80) {
+            case XCB_DESTROY_NOTIFY: {
+                const xcb_destroy_notify_event_t* e = reinterpret_cast<const xcb_destroy_notify_event_t*>(event);
+                // Target is gone; nothing left to keep on top
+                targets_.Remove(e->window);
+                return false;
+            }
+            case XCB_UNMAP_NOTIFY: {
+                const xcb_unmap_notify_event_t* e = reinterpret_cast<const xcb_unmap_notify_event_t*>(event);
+                targets_.SetHidden(e->window, true);
+                return false;
+            }
+            case XCB_MAP_NOTIFY: {
+                const xcb_map_notify_event_t* e = reinterpret_cast<const xcb_map_notify_event_t*>(event);
+                return targets_.SetHidden(e->window, false) || e->event == root;
+            }
+            case XCB_CONFIGURE_NOTIFY: {
+                const xcb_configure_notify_event_t* e = reinterpret_cast<const xcb_configure_notify_event_t*>(event);
+                return e->event == root || targets_.Contains(e->window);
+            }
+            case XCB_PROPERTY_NOTIFY: {
+                const xcb_property_notify_event_t* e = reinterpret_cast<const xcb_property_notify_event_t*>(event);
+                return e->window == root &&
+                       (e->atom == atoms.netActiveWindow || e->atom == atoms.netClientListStacking);
+            }
+            default:
+                return false;
+        }
+    }
+
+    // poll() timeout until the earliest backoff ends, -1 if none
+    int RetryTimeoutMs() const {
+        uint64_t deadline = targets_.RetryDeadline();
+        if (deadline == 0) return -1;
+        uint64_t now = SteadyNowNs();
+        return deadline > now ? static_cast<int>((deadline - now + 999999) / 1000000) : 0;
+    }
+
+    void WatchLoop() {
+        SetTraceThreadName("topmost watcher");
+        xcb_connection_t* c = connection_.Get();
+        pollfd fds[3];
+        fds[0].fd = xcb_get_file_descriptor(c);
+        fds[0].events = POLLIN;
+        fds[1].fd = stopFd_;
+        fds[1].events = POLLIN;
+        fds[2].fd = commandFd_;
+        fds[2].events = POLLIN;
+
+        uint64_t wakeup = SteadyNowNs();
+        while (true) {
+            // Commands wait for replies, which may pull events into XCB's
+            // queue, so they go first and the queue is drained after them
+            RunCommands();
+
+            // Coalesce everything that is queued into at most one check
+            bool needCheck = false;
+            xcb_generic_event_t* event;
+            while ((event = xcb_poll_for_event(c)) != nullptr) {
+                if (HandleEvent(event)) {
+                    needCheck = true;
+                }
+                free(event);
+            }
+            if (xcb_connection_has_error(c)) {
+                break;
+            }
+            UpdateRootSelection();
+
+            if (RetryTimeoutMs() == 0) {
+                needCheck = true;
+            }
+            if (needCheck && targets_.AnyVisible()) {
+                targets_.Check(SteadyNowNs(), wakeup);
+            }
+
+            fds[0].revents = 0;
+            fds[1].revents = 0;
+            fds[2].revents = 0;
+            if (poll(fds, 3, RetryTimeoutMs()) < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (fds[1].revents) {
+                break;
+            }
+            wakeup = SteadyNowNs();
+            if (fds[0].revents) {
+                targets_.CountEvent();
+            }
+            if (fds[2].revents) {
+                uint64_t count;
+                ssize_t ignored = read(commandFd_, &count, sizeof(count));
+                (void)ignored;
+            }
+        }
+
+        // Callers still waiting get false instead of blocking on a dead thread
+        commands_.Close();
+        running_ = false;
+    }
+
+    X11Connection connection_;
+    int stopFd_;
+    int commandFd_;
+    bool rootSelected_;       // watcher thread only
+    std::thread watcherThread_;
+    volatile bool running_;
+    TopmostCommandQueue commands_;
+    TopmostTargetSet targets_;
+};
+
+} // namespace
+
+TopmostWatcher* CreateTopmostWatcher() {
+    return new X11TopmostWatcher();
+}
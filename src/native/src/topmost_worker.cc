@@ -0,0 +1,237 @@
+#include "topmost_worker.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "event_ring.h"
+#include "trace_events.h"
+
+namespace {
+
+const uint64_t kRetryIntervalNs = static_cast<uint64_t>(kTopmostRetryMs) * 1000000;
+
+std::chrono::steady_clock::time_point ToTimePoint(uint64_t ns) {
+    return std::chrono::steady_clock::time_point(std::chrono::nanoseconds(ns));
+}
+
+} // namespace
+
+TopmostWorker::TopmostWorker()
+    : resolve_(nullptr), done_(nullptr), context_(nullptr),
+      running_(false), stopping_(false), jobs_(0), batches_(0), retryBatches_(0) {}
+
+TopmostWorker::~TopmostWorker() {
+    Stop();
+}
+
+void TopmostWorker::SetCallbacks(TopmostResolveFn resolve, TopmostDoneFn done, void* context) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    resolve_ = resolve;
+    done_ = done;
+    context_ = context;
+}
+
+void TopmostWorker::Submit(TopmostJob job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        EnsureThread();
+        pending_.push_back(std::move(job));
+    }
+    wake_.notify_one();
+}
+
+void TopmostWorker::ScheduleRetries(const std::vector<WindowHandle>& windows) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        EnsureThread();
+        pendingRetries_.insert(pendingRetries_.end(), windows.begin(), windows.end());
+    }
+    wake_.notify_one();
+}
+
+void TopmostWorker::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) return;
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+    stopping_ = false;
+    pending_.clear();
+    pendingRetries_.clear();
+    retries_.clear();
+}
+
+TopmostWorkerStats TopmostWorker::Stats() const {
+    TopmostWorkerStats stats;
+    stats.jobs = jobs_.load(std::memory_order_relaxed);
+    stats.batches = batches_.load(std::memory_order_relaxed);
+    stats.retries = retryBatches_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// Called with mutex_ held
+void TopmostWorker::EnsureThread() {
+    if (!running_) {
+        running_ = true;
+        thread_ = std::thread(&TopmostWorker::Run, this);
+    }
+}
+
+void TopmostWorker::Run() {
+    SetTraceThreadName("topmost worker");
+    std::vector<TopmostJob> jobs;
+    std::vector<WindowHandle> raisedElsewhere;
+    std::vector<TopmostJobResult> results;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        if (pending_.empty() && pendingRetries_.empty() && !stopping_) {
+            if (retries_.empty()) {
+                wake_.wait(lock);
+            } else {
+                uint64_t next = retries_.front().deadlineNs;
+                for (const Retry& retry : retries_) {
+                    next = std::min(next, retry.deadlineNs);
+                }
+                wake_.wait_until(lock, ToTimePoint(next));
+            }
+        }
+        if (stopping_) break;
+
+        jobs.swap(pending_);
+        raisedElsewhere.swap(pendingRetries_);
+        TopmostDoneFn done = done_;
+        void* context = context_;
+        lock.unlock();
+
+        results.clear();
+        if (!jobs.empty()) {
+            ApplyJobs(jobs, &results);
+        }
+        if (!raisedElsewhere.empty()) {
+            AddRetries(raisedElsewhere, SteadyNowNs());
+        }
+        RunDueRetries(SteadyNowNs());
+
+        if (done) {
+            for (const TopmostJobResult& result : results) {
+                done(result, context);
+            }
+        }
+        jobs.clear();
+        raisedElsewhere.clear();
+
+        lock.lock();
+    }
+}
+
+// The newest job wins for a window named by several jobs, and its windows end
+// up above those of older jobs
+void TopmostWorker::ApplyJobs(std::vector<TopmostJob>& jobs, std::vector<TopmostJobResult>* results) {
+    jobs_.fetch_add(jobs.size(), std::memory_order_relaxed);
+
+    for (TopmostJob& job : jobs) {
+        for (size_t i = 0; i < job.windows.size(); i++) {
+            if (!job.windows[i] && i < job.titles.size() && resolve_) {
+                job.windows[i] = resolve_(job.titles[i], context_);
+            }
+        }
+    }
+
+    std::vector<WindowHandle> raise;
+    std::vector<WindowHandle> lower;
+    std::vector<WindowHandle> seen;
+    for (size_t j = jobs.size(); j-- > 0;) {
+        for (WindowHandle window : jobs[j].windows) {
+            if (!window || std::find(seen.begin(), seen.end(), window) != seen.end()) continue;
+            seen.push_back(window);
+            (jobs[j].topmost ? raise : lower).push_back(window);
+        }
+    }
+
+    std::vector<bool> raised;
+    std::vector<bool> lowered;
+    if (!raise.empty()) {
+        TraceSpan span("topmost", "SetWindowsAlwaysOnTop");
+        span.SetArg("raise", static_cast<int64_t>(raise.size()));
+        raised = SetWindowsAlwaysOnTop(raise, true);
+        batches_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!lower.empty()) {
+        TraceSpan span("topmost", "SetWindowsAlwaysOnTop");
+        span.SetArg("lower", static_cast<int64_t>(lower.size()));
+        lowered = SetWindowsAlwaysOnTop(lower, false);
+        batches_.fetch_add(1, std::memory_order_relaxed);
+        CancelRetries(lower);
+    }
+
+    std::vector<WindowHandle> retry;
+    for (size_t i = 0; i < raise.size(); i++) {
+        if (raised[i]) retry.push_back(raise[i]);
+    }
+    AddRetries(retry, SteadyNowNs());
+
+    for (const TopmostJob& job : jobs) {
+        TopmostJobResult result;
+        result.id = job.id;
+        result.success = !job.windows.empty();
+        result.windows = job.windows;
+        for (WindowHandle window : job.windows) {
+            const std::vector<WindowHandle>& list = job.topmost ? raise : lower;
+            const std::vector<bool>& applied = job.topmost ? raised : lowered;
+            size_t index = std::find(list.begin(), list.end(), window) - list.begin();
+            // Not in this direction's list: unresolved, or overridden by a newer job
+            if (!window || index == list.size() || !applied[index]) {
+                result.success = false;
+            }
+        }
+        results->push_back(std::move(result));
+    }
+}
+
+void TopmostWorker::RunDueRetries(uint64_t nowNs) {
+    std::vector<WindowHandle> due;
+    for (Retry& retry : retries_) {
+        if (retry.deadlineNs <= nowNs) {
+            due.push_back(retry.window);
+            retry.remaining--;
+            retry.deadlineNs = nowNs + kRetryIntervalNs;
+        }
+    }
+    if (due.empty()) return;
+
+    TraceSpan span("topmost", "reassertTopmost");
+    span.SetArg("windows", static_cast<int64_t>(due.size()));
+    ReassertWindowsTopmost(due);
+    retryBatches_.fetch_add(1, std::memory_order_relaxed);
+    retries_.erase(std::remove_if(retries_.begin(), retries_.end(),
+                                  [](const Retry& retry) { return retry.remaining <= 0; }),
+                   retries_.end());
+}
+
+void TopmostWorker::AddRetries(const std::vector<WindowHandle>& windows, uint64_t nowNs) {
+    for (WindowHandle window : windows) {
+        Retry fresh = { nowNs + kRetryIntervalNs, window, kTopmostRetryCount };
+        bool found = false;
+        for (Retry& retry : retries_) {
+            if (retry.window == window) {
+                retry = fresh;
+                found = true;
+            }
+        }
+        if (!found) {
+            retries_.push_back(fresh);
+        }
+    }
+}
+
+void TopmostWorker::CancelRetries(const std::vector<WindowHandle>& windows) {
+    retries_.erase(std::remove_if(retries_.begin(), retries_.end(), [&windows](const Retry& retry) {
+        return std::find(windows.begin(), windows.end(), retry.window) != windows.end();
+    }), retries_.end());
+}
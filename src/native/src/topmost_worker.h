@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "window_platform.h"
+
+// Dedicated thread for topmost changes requested from JS.
+//
+// Jobs are queued without blocking the caller. Everything queued by the time
+// the thread wakes is applied as one batch per direction through
+// SetWindowsAlwaysOnTop(), so N windows cost one deferred z-order operation.
+// Raised windows are reasserted kTopmostRetryCount times, kTopmostRetryMs
+// apart, from a timer queue on the same thread instead of sleeping.
+
+const int kTopmostRetryCount = 3;
+const int kTopmostRetryMs = 10;
+
+struct TopmostJob {
+    uint32_t id;
+    bool topmost;
+    // A target is a handle, or (handle 0) a title resolved on the worker
+    std::vector<WindowHandle> windows;
+    std::vector<std::string> titles;
+};
+
+struct TopmostJobResult {
+    uint32_t id;
+    bool success;                         // every target resolved and applied
+    std::vector<WindowHandle> windows;    // resolved handles, 0 if not found
+};
+
+struct TopmostWorkerStats {
+    uint64_t jobs;
+    uint64_t batches;      // SetWindowsAlwaysOnTop calls
+    uint64_t retries;      // ReassertWindowsTopmost calls
+};
+
+// Both run on the worker thread
+typedef WindowHandle (*TopmostResolveFn)(const std::string& title, void* context);
+typedef void (*TopmostDoneFn)(const TopmostJobResult& result, void* context);
+
+class TopmostWorker {
+public:
+    TopmostWorker();
+    ~TopmostWorker();
+
+    // Callbacks must be set before the first Submit
+    void SetCallbacks(TopmostResolveFn resolve, TopmostDoneFn done, void* context);
+
+    // Queue a job; starts the thread on first use
+    void Submit(TopmostJob job);
+    // Schedule the timed reasserts for windows raised outside the worker
+    void ScheduleRetries(const std::vector<WindowHandle>& windows);
+
+    void Stop();
+
+    TopmostWorkerStats Stats() const;
+
+private:
+    struct Retry {
+        uint64_t deadlineNs;
+        WindowHandle window;
+        int remaining;
+    };
+
+    void EnsureThread();
+    void Run();
+    void ApplyJobs(std::vector<TopmostJob>& jobs, std::vector<TopmostJobResult>* results);
+    void RunDueRetries(uint64_t nowNs);
+    void AddRetries(const std::vector<WindowHandle>& windows, uint64_t nowNs);
+    void CancelRetries(const std::vector<WindowHandle>& windows);
+
+    TopmostResolveFn resolve_;
+    TopmostDoneFn done_;
+    void* context_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::thread thread_;
+    bool running_;
+    bool stopping_;
+    std::vector<TopmostJob> pending_;
+    std::vector<WindowHandle> pendingRetries_;
+    std::vector<Retry> retries_;          // worker thread only
+
+    std::atomic<uint64_t> jobs_;
+    std::atomic<uint64_t> batches_;
+    std::atomic<uint64_t> retryBatches_;
+};
@@ -0,0 +1,202 @@
+#include "trace_events.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+std::atomic<bool> traceEventsEnabled(false);
+
+namespace {
+
+struct TraceThreadBuffer {
+    std::atomic<uint64_t> head;      // events ever written
+    std::atomic<uint64_t> cleared;   // events before this index are discarded
+    std::atomic<bool> owned;         // a live thread writes into it
+    TraceEvent events[kTraceEventsPerThread];
+};
+
+// Buffers are never freed: a ring handed back by an exited thread is reused
+// by the next new one, so the set stays as large as the most threads that
+// recorded at once. Thread exit may also race module teardown.
+std::mutex registryMutex;
+std::vector<TraceThreadBuffer*> buffers;
+std::vector<std::pair<uint32_t, const char*>> threadNames;
+
+uint32_t CurrentThreadId() {
+    // Positive, so every trace viewer accepts it
+    return static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id())) & 0x7fffffffu;
+}
+
+struct ThreadSlot {
+    TraceThreadBuffer* buffer = nullptr;
+    uint32_t threadId = 0;
+
+    ~ThreadSlot() {
+        if (buffer) buffer->owned.store(false, std::memory_order_release);
+    }
+};
+
+thread_local ThreadSlot threadSlot;
+
+TraceThreadBuffer* AcquireBuffer() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (TraceThreadBuffer* buffer : buffers) {
+        if (!buffer->owned.load(std::memory_order_acquire)) {
+            buffer->owned.store(true, std::memory_order_relaxed);
+            return buffer;
+        }
+    }
+    TraceThreadBuffer* buffer = new TraceThreadBuffer();
+    buffer->head.store(0, std::memory_order_relaxed);
+    buffer->cleared.store(0, std::memory_order_relaxed);
+    buffer->owned.store(true, std::memory_order_relaxed);
+    buffers.push_back(buffer);
+    return buffer;
+}
+
+void Record(const char* category, const char* name, char phase, uint64_t startNs, uint64_t durationNs,
+            const char* argName, int64_t argValue) {
+    ThreadSlot& slot = threadSlot;
+    if (!slot.buffer) {
+        slot.buffer = AcquireBuffer();
+        slot.threadId = CurrentThreadId();
+    }
+    TraceThreadBuffer* buffer = slot.buffer;
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    TraceEvent& event = buffer->events[head & (kTraceEventsPerThread - 1)];
+    event.startNs = startNs;
+    event.durationNs = durationNs;
+    event.category = category;
+    event.name = name;
+    event.argName = argName;
+    event.argValue = argValue;
+    event.threadId = slot.threadId;
+    event.phase = phase;
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+// First index still in the ring and not cleared. The slot after head may be
+// mid-write, so a ring holds kTraceEventsPerThread - 1 readable events.
+uint64_t FirstLive(const TraceThreadBuffer* buffer, uint64_t head) {
+    const uint64_t window = kTraceEventsPerThread - 1;
+    uint64_t first = head > window ? head - window : 0;
+    uint64_t cleared = buffer->cleared.load(std::memory_order_relaxed);
+    return cleared > first ? cleared : first;
+}
+
+void AppendEventJson(const TraceEvent& event, std::string* out) {
+    // ts and dur are microseconds
+    char line[384];
+    int length = snprintf(line, sizeof(line),
+                          "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%" PRIu64 ".%03u,",
+                          event.name, event.category, event.phase, event.startNs / 1000,
+                          static_cast<unsigned>(event.startNs % 1000));
+    if (event.phase == 'X') {
+        length += snprintf(line + length, sizeof(line) - length, "\"dur\":%" PRIu64 ".%03u,",
+                           event.durationNs / 1000, static_cast<unsigned>(event.durationNs % 1000));
+    } else {
+        length += snprintf(line + length, sizeof(line) - length, "\"s\":\"t\",");
+    }
+    length += snprintf(line + length, sizeof(line) - length, "\"pid\":1,\"tid\":%u", event.threadId);
+    if (event.argName) {
+        length += snprintf(line + length, sizeof(line) - length, ",\"args\":{\"%s\":%" PRId64 "}",
+                           event.argName, event.argValue);
+    }
+    out->append(line, static_cast<size_t>(length));
+    out->append("}");
+}
+
+} // namespace
+
+void SetTraceEventsEnabled(bool enabled) {
+    if (enabled && !traceEventsEnabled.load(std::memory_order_relaxed)) {
+        ClearTraceEvents();
+    }
+    traceEventsEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void ClearTraceEvents() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (TraceThreadBuffer* buffer : buffers) {
+        buffer->cleared.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+TraceEventStats GetTraceEventStats() {
+    TraceEventStats stats;
+    stats.enabled = TraceEventsEnabled();
+    stats.recorded = 0;
+    stats.overwritten = 0;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    stats.threads = static_cast<uint32_t>(buffers.size());
+    for (const TraceThreadBuffer* buffer : buffers) {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t cleared = buffer->cleared.load(std::memory_order_relaxed);
+        uint64_t first = FirstLive(buffer, head);
+        stats.recorded += head - cleared;
+        stats.overwritten += first - cleared;
+    }
+    return stats;
+}
+
+void TraceEventComplete(const char* category, const char* name, uint64_t startNs, uint64_t endNs,
+                        const char* argName, int64_t argValue) {
+    Record(category, name, 'X', startNs, endNs > startNs ? endNs - startNs : 0, argName, argValue);
+}
+
+void TraceEventInstant(const char* category, const char* name, const char* argName, int64_t argValue) {
+    if (!TraceEventsEnabled()) return;
+    Record(category, name, 'i', SteadyNowNs(), 0, argName, argValue);
+}
+
+void SetTraceThreadName(const char* name) {
+    uint32_t threadId = CurrentThreadId();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (auto& entry : threadNames) {
+        if (entry.first == threadId) {
+            entry.second = name;
+            return;
+        }
+    }
+    threadNames.emplace_back(threadId, name);
+}
+
+size_t AppendTraceEventsJson(std::string* out) {
+    std::vector<TraceEvent> events;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const TraceThreadBuffer* buffer : buffers) {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t first = FirstLive(buffer, head);
+        size_t copied = events.size();
+        for (uint64_t i = first; i < head; i++) {
+            events.push_back(buffer->events[i & (kTraceEventsPerThread - 1)]);
+        }
+        // The writer may have lapped the copy; drop what it overwrote meanwhile,
+        // including the slot of the event it is writing right now
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = buffer->head.load(std::memory_order_relaxed) + 1;
+        uint64_t safe = after > kTraceEventsPerThread ? after - kTraceEventsPerThread : 0;
+        if (safe > first) {
+            uint64_t torn = safe - first < head - first ? safe - first : head - first;
+            events.erase(events.begin() + copied, events.begin() + copied + static_cast<size_t>(torn));
+        }
+    }
+
+    for (const auto& entry : threadNames) {
+        if (!out->empty()) out->append(",\n");
+        char line[256];
+        int length = snprintf(line, sizeof(line),
+                              "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                              entry.first, entry.second);
+        out->append(line, static_cast<size_t>(length));
+    }
+    for (const TraceEvent& event : events) {
+        if (!out->empty()) out->append(",\n");
+        AppendEventJson(event, out);
+    }
+    return events.size();
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "event_ring.h"
+
+// Timeline spans in Chrome trace-event JSON, for Perfetto / chrome://tracing.
+//
+// Every thread that records gets its own ring of kTraceEventsPerThread
+// events on first use; after that a span is two clock reads and a few plain
+// stores into the ring, with no lock and no allocation. A full ring keeps
+// overwriting its oldest events (the newest kTraceEventsPerThread - 1 stay
+// readable). With tracing off a span is one relaxed load.
+// Names, categories and argument names must be string literals: only the
+// pointers are kept.
+//
+// The buffers are per process: the shortcut and topmost sub-modules of the
+// native runtime, and every environment that loads it, record into the same
+// rings. Timestamps come from the process-wide steady clock and events carry
+// pid 1 and a tid derived from std::thread::id, so the spans of every thread
+// line up on a single timeline.
+
+const size_t kTraceEventsPerThread = 1u << 14;
+
+struct TraceEvent {
+    uint64_t startNs;       // SteadyNowNs()
+    uint64_t durationNs;    // 0 for instants
+    const char* category;
+    const char* name;
+    const char* argName;    // nullptr if the event has no argument
+    int64_t argValue;
+    uint32_t threadId;
+    char phase;             // 'X' complete, 'i' instant
+};
+
+struct TraceEventStats {
+    bool enabled;
+    uint64_t recorded;      // since the last clear
+    uint64_t overwritten;   // lost to full rings
+    uint32_t threads;
+};
+
+extern std::atomic<bool> traceEventsEnabled;
+
+inline bool TraceEventsEnabled() {
+    return traceEventsEnabled.load(std::memory_order_relaxed);
+}
+
+// Turning tracing on discards what earlier sessions left in the rings
+void SetTraceEventsEnabled(bool enabled);
+void ClearTraceEvents();
+TraceEventStats GetTraceEventStats();
+
+void TraceEventComplete(const char* category, const char* name, uint64_t startNs, uint64_t endNs,
+                        const char* argName = nullptr, int64_t argValue = 0);
+void TraceEventInstant(const char* category, const char* name, const char* argName = nullptr,
+                       int64_t argValue = 0);
+// Label for the calling thread's track; recorded even while tracing is off
+void SetTraceThreadName(const char* name);
+
+// Appends the buffered events to out as comma-separated trace-event JSON
+// objects, without the enclosing array: dumpTrace() in native_runtime.cc
+// wraps them. Returns the number of events.
+size_t AppendTraceEventsJson(std::string* out);
+
+// Records a complete event for the enclosing scope
+class TraceSpan {
+public:
+    TraceSpan(const char* category, const char* name)
+        : category_(category), name_(name), argName_(nullptr), argValue_(0),
+          startNs_(TraceEventsEnabled() ? SteadyNowNs() : 0) {}
+
+    ~TraceSpan() {
+        if (startNs_ != 0) {
+            TraceEventComplete(category_, name_, startNs_, SteadyNowNs(), argName_, argValue_);
+        }
+    }
+
+    void SetArg(const char* name, int64_t value) {
+        argName_ = name;
+        argValue_ = value;
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* category_;
+    const char* name_;
+    const char* argName_;
+    int64_t argValue_;
+    uint64_t startNs_;
+};
@@ -0,0 +1,215 @@
+#include "trace_replay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+namespace {
+
+// The engine clock only carries a function pointer
+uint64_t replayNowNs = 0;
+
+uint64_t ReplayClock() {
+    return replayNowNs;
+}
+
+std::string Trimmed(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) return std::string();
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+const char* RepeatModeName(uint32_t mode) {
+    switch (mode) {
+        case kRepeatDrop: return "drop";
+        case kRepeatRate: return "rate";
+        case kRepeatCoalesce: return "coalesce";
+        default: return "pass";
+    }
+}
+
+// "drop" / "rate:100" / "coalesce:100"
+bool ParseRepeat(const std::string& text, RepeatPolicy* policy) {
+    std::string mode = text.substr(0, text.find(':'));
+    uint32_t intervalMs = 100;
+    if (mode.size() < text.size()) {
+        intervalMs = static_cast<uint32_t>(strtoul(text.c_str() + mode.size() + 1, nullptr, 10));
+    }
+    if (mode == "pass") *policy = RepeatPolicy{kRepeatPass, 0};
+    else if (mode == "drop") *policy = RepeatPolicy{kRepeatDrop, 0};
+    else if (mode == "rate") *policy = RepeatPolicy{kRepeatRate, intervalMs};
+    else if (mode == "coalesce") *policy = RepeatPolicy{kRepeatCoalesce, intervalMs};
+    else return false;
+    return true;
+}
+
+} // namespace
+
+bool ReplayInputTrace(const InputTraceRecord* records, size_t count, ShortcutEngine* engine,
+                      const ReplayOptions& options, std::vector<ReplayedAction>* actions, ReplayStats* stats) {
+    *stats = ReplayStats();
+    stats->records = count;
+    stats->firstMismatch = SIZE_MAX;
+    stats->minNs = UINT64_MAX;
+    if (count == 0) {
+        stats->minNs = 0;
+        return true;
+    }
+
+    std::vector<uint64_t> samples;
+    samples.reserve(count);
+    ShortcutEvent batch[kEventRingCapacity];
+    const uint64_t firstNs = records[0].timestampNs;
+    const auto wallStart = std::chrono::steady_clock::now();
+    const double speed = options.speed > 0 ? options.speed : 1.0;
+
+    engine->SetClock(ReplayClock);
+    engine->ResetModifiers();
+    engine->ResetQueue();
+
+    for (size_t i = 0; i < count; i++) {
+        const InputTraceRecord& record = records[i];
+        if (record.flags & kTraceInjected) {
+            stats->injected++;
+            continue;
+        }
+
+        uint64_t offsetNs = record.timestampNs >= firstNs ? record.timestampNs - firstNs : 0;
+        if (options.realtime) {
+            std::this_thread::sleep_until(wallStart + std::chrono::nanoseconds(static_cast<uint64_t>(offsetNs / speed)));
+        }
+        replayNowNs = record.timestampNs;
+
+        bool down = (record.flags & kTraceDown) != 0;
+        uint64_t start = SteadyNowNs();
+        bool consumed = record.kind == kTraceMouse
+            ? engine->HandleMouseButton(record.code, down, record.osTime, record.osDelayNs)
+            : engine->HandleKey(record.code, down, record.osTime, record.osDelayNs);
+        uint64_t elapsed = SteadyNowNs() - start;
+        samples.push_back(elapsed);
+        stats->totalNs += elapsed;
+        stats->replayed++;
+
+        if (consumed != ((record.flags & kTraceConsumed) != 0)) {
+            if (stats->consumedMismatches++ == 0) stats->firstMismatch = i;
+        }
+
+        size_t drained = engine->DrainBatch(batch, kEventRingCapacity, record.timestampNs);
+        for (size_t j = 0; j < drained; j++) {
+            const ShortcutEvent& event = batch[j];
+            actions->push_back(ReplayedAction{i, event.timestamp - firstNs, event.actionId, event.flags, event.count});
+        }
+    }
+
+    engine->SetClock(nullptr);
+
+    std::sort(samples.begin(), samples.end());
+    if (!samples.empty()) {
+        stats->minNs = samples.front();
+        stats->p50Ns = samples[samples.size() / 2];
+        stats->p99Ns = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+        stats->maxNs = samples.back();
+    } else {
+        stats->minNs = 0;
+    }
+    return stats->consumedMismatches == 0;
+}
+
+bool WriteReplayKeymap(const std::string& path, const CompiledKeymap& keymap, const ShortcutTable& table,
+                       std::string* error) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        if (error) *error = "cannot write " + path;
+        return false;
+    }
+    fprintf(file, "# action = keys [| repeat=drop|rate:MS|coalesce:MS] [| timeout=MS]\n");
+    const std::vector<std::string>& names = table.ActionNames();
+    for (const CompiledKeymapBinding& binding : keymap.bindings) {
+        fprintf(file, "%s = %s", binding.action.c_str(), binding.canonical.c_str());
+        ActionId id = kNoAction;
+        for (size_t i = 1; i < names.size(); i++) {
+            if (names[i] == binding.action) id = static_cast<ActionId>(i);
+        }
+        if (id != kNoAction) {
+            const RepeatPolicy& repeat = table.Repeat(id);
+            if (repeat.mode == kRepeatDrop) {
+                fprintf(file, " | repeat=drop");
+            } else if (repeat.mode != kRepeatPass) {
+                fprintf(file, " | repeat=%s:%u", RepeatModeName(repeat.mode), repeat.intervalMs);
+            }
+        }
+        if (binding.strokes.size() > 1) {
+            fprintf(file, " | timeout=%u", binding.timeoutMs);
+        }
+        fprintf(file, "\n");
+    }
+    bool ok = fclose(file) == 0;
+    if (!ok && error) *error = "cannot write " + path;
+    return ok;
+}
+
+bool LoadReplayKeymap(const std::string& path, ShortcutEngine* engine, std::string* error) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        if (error) *error = "cannot read " + path;
+        return false;
+    }
+
+    std::vector<KeymapBinding> input;
+    std::vector<std::pair<std::string, RepeatPolicy>> repeats;
+    char buffer[1024];
+    size_t lineNumber = 0;
+    bool ok = true;
+    while (ok && fgets(buffer, sizeof(buffer), file)) {
+        lineNumber++;
+        std::string line(buffer);
+        line = Trimmed(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            if (error) *error = path + ":" + std::to_string(lineNumber) + ": expected 'action = keys'";
+            ok = false;
+            break;
+        }
+        KeymapBinding binding;
+        binding.action = Trimmed(line.substr(0, equals));
+        binding.timeoutMs = kDefaultSequenceTimeoutMs;
+        std::string rest = line.substr(equals + 1);
+        size_t bar = rest.find('|');
+        binding.keys = Trimmed(rest.substr(0, bar));
+
+        while (bar != std::string::npos) {
+            size_t next = rest.find('|', bar + 1);
+            std::string option = Trimmed(rest.substr(bar + 1, next == std::string::npos ? std::string::npos : next - bar - 1));
+            bar = next;
+            RepeatPolicy policy;
+            if (option.compare(0, 7, "repeat=") == 0 && ParseRepeat(option.substr(7), &policy)) {
+                repeats.push_back(std::make_pair(binding.action, policy));
+            } else if (option.compare(0, 8, "timeout=") == 0) {
+                binding.timeoutMs = static_cast<uint32_t>(strtoul(option.c_str() + 8, nullptr, 10));
+            } else {
+                if (error) *error = path + ":" + std::to_string(lineNumber) + ": unknown option '" + option + "'";
+                ok = false;
+                break;
+            }
+        }
+        input.push_back(binding);
+    }
+    fclose(file);
+    if (!ok) return false;
+
+    CompiledKeymap keymap;
+    if (!CompileKeymap(input, &keymap)) {
+        if (error) *error = path + ": " + keymap.issues[0].action + ": " + keymap.issues[0].message;
+        return false;
+    }
+    ApplyKeymap(keymap, engine);
+    for (const auto& repeat : repeats) {
+        engine->SetRepeatPolicy(repeat.first, repeat.second);
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "input_trace.h"
+#include "keymap_compiler.h"
+#include "shortcut_core.h"
+
+// Deterministic replay of an input trace through the platform-neutral
+// engine.
+//
+// The engine's clock is driven by the record timestamps, so sequence
+// timeouts and autorepeat rates come out exactly as in the recorded run no
+// matter how fast the replay goes. Injected events are skipped like the
+// Win32 hook skips them. Hold / repeat-while-held triggers run on the timer
+// wheel's wall clock and are not part of a replay.
+//
+// The bindings a trace was recorded under are saved next to it as
+// "<trace>.keymap", one binding per line:
+//   action = keys [| repeat=drop|rate:MS|coalesce:MS] [| timeout=MS]
+// (MS = interval / sequence timeout in milliseconds, '#' starts a comment).
+
+struct ReplayOptions {
+    bool realtime;      // sleep to the recorded spacing (scaled by speed)
+    double speed;
+
+    ReplayOptions() : realtime(false), speed(1.0) {}
+};
+
+struct ReplayedAction {
+    size_t record;          // index of the record that produced it
+    uint64_t offsetNs;      // trace time since the first record
+    ActionId id;
+    uint8_t flags;          // kEvent*
+    uint32_t count;
+};
+
+struct ReplayStats {
+    size_t records;
+    size_t replayed;            // records fed to the engine
+    size_t injected;            // skipped
+    size_t consumedMismatches;  // engine decision differs from the recorded one
+    size_t firstMismatch;       // record index, SIZE_MAX if none
+    uint64_t totalNs;           // time spent inside the engine
+    uint64_t minNs;
+    uint64_t p50Ns;
+    uint64_t p99Ns;
+    uint64_t maxNs;
+};
+
+// The engine must already have its bindings published and no backend
+// running. Actions are appended in dispatch order.
+bool ReplayInputTrace(const InputTraceRecord* records, size_t count, ShortcutEngine* engine,
+                      const ReplayOptions& options, std::vector<ReplayedAction>* actions, ReplayStats* stats);
+
+// Writes the published bindings of `table` (canonical keys from `keymap`)
+bool WriteReplayKeymap(const std::string& path, const CompiledKeymap& keymap, const ShortcutTable& table,
+                       std::string* error);
+
+// Adds the bindings in a keymap file to the engine's pending table;
+// PublishBindings() is left to the caller
+bool LoadReplayKeymap(const std::string& path, ShortcutEngine* engine, std::string* error);
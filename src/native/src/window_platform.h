@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Platform window operations used by the topmost module.
+//
+// Implemented by window_platform_win32.cc (Win32) and window_platform_x11.cc
+// (X11/EWMH). Window handles are HWNDs on Windows and X window ids on X11,
+// both carried as an integer so JS can pass them around as numbers.
+
+typedef uintptr_t WindowHandle;
+
+// WindowInfo::flags bits (only filled by GetWindowSnapshot)
+enum WindowFlags {
+    kWindowFlagTopmost = 1 << 0,
+    kWindowFlagMinimized = 1 << 1,
+    kWindowFlagForeground = 1 << 2
+};
+
+struct WindowInfo {
+    WindowHandle handle;
+    std::string title;
+    uint32_t pid = 0;        // 0 if unknown
+    uint32_t flags = 0;      // WindowFlags
+};
+
+// Function to find window by title (case-insensitive partial match); 0 if not found
+WindowHandle FindWindowByTitle(const std::string& titleSubstring);
+
+// Advanced window topmost setting with UIAccess-like behavior
+bool SetWindowAlwaysOnTop(WindowHandle window, bool topmost);
+
+// Applies one topmost change to many windows as a single deferred z-order
+// operation (DeferWindowPos on Win32, one pipelined XCB batch on X11).
+// windows[0] ends up on top. Returns per-window success.
+std::vector<bool> SetWindowsAlwaysOnTop(const std::vector<WindowHandle>& windows, bool topmost);
+
+// Moves already-topmost windows back to the top of the topmost band, batched
+// like SetWindowsAlwaysOnTop(). Used for the timed retries that fullscreen
+// applications fighting over the z-order need.
+void ReassertWindowsTopmost(const std::vector<WindowHandle>& windows);
+
+// True if the window is among the first `depth` windows of the z-order
+bool IsWindowNearTop(WindowHandle window, int depth);
+
+// IsWindowNearTop() for several windows from a single read of the z-order
+std::vector<bool> AreWindowsNearTop(const std::vector<WindowHandle>& windows, int depth);
+
+bool IsWindowValid(WindowHandle window);
+
+// All visible windows with a non-empty title, top of the z-order first
+std::vector<WindowInfo> GetVisibleWindows();
+
+// Same windows and order as GetVisibleWindows(), with pid and flags filled in
+std::vector<WindowInfo> GetWindowSnapshot();
+
+// Force window to foreground (additional utility function)
+bool BringWindowToForeground(WindowHandle window);
+
+// The window with input focus and its owning process (0 if unknown); 0 if none
+WindowHandle GetForegroundWindowPid(uint32_t* pid);
+
+// Destroy/rename notifications for a set of windows, used to invalidate
+// cached title lookups. The callback runs on the monitor's own thread.
+typedef void (*WindowChangedFn)(WindowHandle window, void* context);
+
+class WindowChangeMonitor {
+public:
+    virtual ~WindowChangeMonitor() {}
+
+    virtual bool Start(WindowChangedFn callback, void* context) = 0;
+    virtual void Stop() = 0;
+    // Report destroy/rename of this window from now on (callable from any thread)
+    virtual void Watch(WindowHandle window) = 0;
+};
+
+WindowChangeMonitor* CreateWindowChangeMonitor();
@@ -0,0 +1,316 @@
+#include "window_platform_mock.h"
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "title_matcher.h"
+#include "topmost_watcher.h"
+
+namespace {
+
+struct MockWindow {
+    std::string title;
+    uint32_t pid;
+    bool visible;
+    bool topmost;
+};
+
+class MockWindowChangeMonitor;
+
+std::mutex mockMutex;
+// Top of the z-order first; topmost windows always form a prefix
+std::vector<WindowHandle> zOrder;
+std::unordered_map<WindowHandle, MockWindow> windows;
+std::vector<MockWindowChangeMonitor*> monitors;
+WindowHandle nextHandle = 0x10000;
+WindowHandle foreground = 0;
+uint64_t restacks = 0;
+
+size_t TopmostBand() {
+    size_t band = 0;
+    while (band < zOrder.size() && windows[zOrder[band]].topmost) band++;
+    return band;
+}
+
+// Takes the window out of the z-order; false if it does not exist
+bool Unlink(WindowHandle window) {
+    auto it = std::find(zOrder.begin(), zOrder.end(), window);
+    if (it == zOrder.end()) return false;
+    zOrder.erase(it);
+    return true;
+}
+
+void Restack(WindowHandle window, bool topmost) {
+    if (!Unlink(window)) return;
+    windows[window].topmost = topmost;
+    zOrder.insert(zOrder.begin() + (topmost ? 0 : TopmostBand()), window);
+    restacks++;
+}
+
+typedef std::vector<std::pair<WindowChangedFn, void*>> PendingNotifications;
+PendingNotifications CollectNotifications(WindowHandle window);
+
+void Deliver(WindowHandle window, const PendingNotifications& pending) {
+    for (const auto& notification : pending) {
+        notification.first(window, notification.second);
+    }
+}
+
+std::vector<WindowInfo> EnumerateVisible(bool details) {
+    std::vector<WindowInfo> result;
+    result.reserve(zOrder.size());
+    for (WindowHandle handle : zOrder) {
+        const MockWindow& window = windows[handle];
+        if (!window.visible || window.title.empty()) continue;
+        WindowInfo info;
+        info.handle = handle;
+        info.title = window.title;
+        if (details) {
+            info.pid = window.pid;
+            if (window.topmost) info.flags |= kWindowFlagTopmost;
+            if (handle == foreground) info.flags |= kWindowFlagForeground;
+        }
+        result.push_back(std::move(info));
+    }
+    return result;
+}
+
+// Notifications are delivered synchronously from the call that changed the
+// window, after the platform lock is released
+class MockWindowChangeMonitor : public WindowChangeMonitor {
+public:
+    ~MockWindowChangeMonitor() override { Stop(); }
+
+    bool Start(WindowChangedFn callback, void* context) override {
+        std::lock_guard<std::mutex> lock(mockMutex);
+        if (callback_) return true;
+        callback_ = callback;
+        context_ = context;
+        monitors.push_back(this);
+        return true;
+    }
+
+    void Stop() override {
+        std::lock_guard<std::mutex> lock(mockMutex);
+        monitors.erase(std::remove(monitors.begin(), monitors.end(), this), monitors.end());
+        callback_ = nullptr;
+        watched_.clear();
+    }
+
+    void Watch(WindowHandle window) override {
+        std::lock_guard<std::mutex> lock(mockMutex);
+        watched_.insert(window);
+    }
+
+    // mockMutex held
+    bool Watching(WindowHandle window) const { return watched_.count(window) != 0; }
+    WindowChangedFn Callback() const { return callback_; }
+    void* Context() const { return context_; }
+
+private:
+    WindowChangedFn callback_ = nullptr;
+    void* context_ = nullptr;
+    std::unordered_set<WindowHandle> watched_;
+};
+
+PendingNotifications CollectNotifications(WindowHandle window) {
+    PendingNotifications pending;
+    for (MockWindowChangeMonitor* monitor : monitors) {
+        if (monitor->Watching(window)) pending.push_back(std::make_pair(monitor->Callback(), monitor->Context()));
+    }
+    return pending;
+}
+
+class NullTopmostWatcher : public TopmostWatcher {
+public:
+    bool Start() override { return false; }
+    void Stop() override {}
+    bool IsRunning() const override { return false; }
+    bool Watch(WindowHandle, const TopmostPolicy&) override { return false; }
+    bool Unwatch(WindowHandle) override { return false; }
+    TopmostWatcherStats Stats() const override { return targets_.Stats(); }
+    std::vector<TopmostTargetStats> TargetStats() const override { return targets_.TargetStats(); }
+    void ResetStats() override {}
+
+private:
+    TopmostTargetSet targets_;
+};
+
+} // namespace
+
+void MockWindowsReset() {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    zOrder.clear();
+    windows.clear();
+    foreground = 0;
+    restacks = 0;
+}
+
+WindowHandle MockWindowCreate(const std::string& title, uint32_t pid) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    WindowHandle handle = nextHandle++;
+    windows[handle] = MockWindow{title, pid, true, false};
+    zOrder.insert(zOrder.begin() + TopmostBand(), handle);
+    return handle;
+}
+
+bool MockWindowDestroy(WindowHandle window) {
+    PendingNotifications pending;
+    {
+        std::lock_guard<std::mutex> lock(mockMutex);
+        if (!Unlink(window)) return false;
+        windows.erase(window);
+        if (foreground == window) foreground = 0;
+        pending = CollectNotifications(window);
+    }
+    Deliver(window, pending);
+    return true;
+}
+
+bool MockWindowSetTitle(WindowHandle window, const std::string& title) {
+    PendingNotifications pending;
+    {
+        std::lock_guard<std::mutex> lock(mockMutex);
+        auto it = windows.find(window);
+        if (it == windows.end()) return false;
+        it->second.title = title;
+        pending = CollectNotifications(window);
+    }
+    Deliver(window, pending);
+    return true;
+}
+
+bool MockWindowSetVisible(WindowHandle window, bool visible) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    auto it = windows.find(window);
+    if (it == windows.end()) return false;
+    it->second.visible = visible;
+    return true;
+}
+
+bool MockWindowLower(WindowHandle window) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    if (!Unlink(window)) return false;
+    windows[window].topmost = false;
+    zOrder.push_back(window);
+    restacks++;
+    return true;
+}
+
+size_t MockWindowCount() {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    return zOrder.size();
+}
+
+uint64_t MockWindowRestacks() {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    return restacks;
+}
+
+WindowHandle FindWindowByTitle(const std::string& titleSubstring) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+
+    // Case-insensitive search, top of the z-order first like the real backends
+    std::string foldedTarget = FoldCaseUtf8(titleSubstring);
+    std::string foldedTitle;
+    for (const WindowInfo& window : EnumerateVisible(false)) {
+        FoldCaseUtf8(window.title.data(), window.title.size(), &foldedTitle);
+        if (foldedTitle.find(foldedTarget) != std::string::npos) {
+            return window.handle;
+        }
+    }
+    return 0;
+}
+
+bool SetWindowAlwaysOnTop(WindowHandle window, bool topmost) {
+    return SetWindowsAlwaysOnTop(std::vector<WindowHandle>(1, window), topmost)[0];
+}
+
+std::vector<bool> SetWindowsAlwaysOnTop(const std::vector<WindowHandle>& targets, bool topmost) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    std::vector<bool> results(targets.size(), false);
+    // Back to front, so targets[0] ends up on top
+    for (size_t i = targets.size(); i-- > 0;) {
+        if (windows.count(targets[i]) == 0) continue;
+        Restack(targets[i], topmost);
+        results[i] = true;
+    }
+    return results;
+}
+
+void ReassertWindowsTopmost(const std::vector<WindowHandle>& targets) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    for (size_t i = targets.size(); i-- > 0;) {
+        auto it = windows.find(targets[i]);
+        if (it != windows.end() && it->second.topmost) Restack(targets[i], true);
+    }
+}
+
+bool IsWindowNearTop(WindowHandle window, int depth) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    int position = 0;
+    for (WindowHandle handle : zOrder) {
+        if (position >= depth) break;
+        if (handle == window) return true;
+        if (windows[handle].visible) position++;
+    }
+    return false;
+}
+
+std::vector<bool> AreWindowsNearTop(const std::vector<WindowHandle>& targets, int depth) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    std::vector<bool> nearTop(targets.size(), false);
+    int position = 0;
+    for (WindowHandle handle : zOrder) {
+        if (position >= depth) break;
+        for (size_t i = 0; i < targets.size(); i++) {
+            if (targets[i] == handle) nearTop[i] = true;
+        }
+        if (windows[handle].visible) position++;
+    }
+    return nearTop;
+}
+
+bool IsWindowValid(WindowHandle window) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    return windows.count(window) != 0;
+}
+
+std::vector<WindowInfo> GetVisibleWindows() {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    return EnumerateVisible(false);
+}
+
+std::vector<WindowInfo> GetWindowSnapshot() {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    return EnumerateVisible(true);
+}
+
+bool BringWindowToForeground(WindowHandle window) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    auto it = windows.find(window);
+    if (it == windows.end()) return false;
+    it->second.visible = true;
+    Restack(window, it->second.topmost);
+    foreground = window;
+    return true;
+}
+
+WindowHandle GetForegroundWindowPid(uint32_t* pid) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    auto it = windows.find(foreground);
+    *pid = it != windows.end() ? it->second.pid : 0;
+    return it != windows.end() ? foreground : 0;
+}
+
+TopmostWatcher* CreateTopmostWatcher() {
+    return new NullTopmostWatcher();
+}
+
+WindowChangeMonitor* CreateWindowChangeMonitor() {
+    return new MockWindowChangeMonitor();
+}
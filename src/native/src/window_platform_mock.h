@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "window_platform.h"
+
+// In-memory window system behind window_platform.h, for benchmarks on
+// machines without a display (topmost_bench_mock).
+//
+// Windows live in one z-ordered list, topmost band first, with the same
+// observable behaviour as the X11 backend: enumeration returns visible
+// titled windows top first, SetWindowsAlwaysOnTop() moves windows into the
+// topmost band with windows[0] on top, and the change monitor reports
+// renames and destroys of watched windows synchronously. The topmost
+// watcher is the null one.
+
+// Removes every window
+void MockWindowsReset();
+
+// New visible window at the top of the normal band; handles are never reused
+WindowHandle MockWindowCreate(const std::string& title, uint32_t pid);
+bool MockWindowDestroy(WindowHandle window);
+bool MockWindowSetTitle(WindowHandle window, const std::string& title);
+bool MockWindowSetVisible(WindowHandle window, bool visible);
+
+// Moves a window to the bottom of the z-order and drops its topmost state,
+// standing in for another application covering it
+bool MockWindowLower(WindowHandle window);
+
+size_t MockWindowCount();
+// z-order changes applied since the last reset
+uint64_t MockWindowRestacks();
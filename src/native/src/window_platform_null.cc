@@ -0,0 +1,58 @@
+#include "topmost_watcher.h"
+#include "window_platform.h"
+
+// Fallback for platforms without a native window backend: every operation
+// reports failure and the watcher never starts.
+
+WindowHandle FindWindowByTitle(const std::string&) { return 0; }
+bool SetWindowAlwaysOnTop(WindowHandle, bool) { return false; }
+std::vector<bool> SetWindowsAlwaysOnTop(const std::vector<WindowHandle>& windows, bool) {
+    return std::vector<bool>(windows.size(), false);
+}
+void ReassertWindowsTopmost(const std::vector<WindowHandle>&) {}
+bool IsWindowNearTop(WindowHandle, int) { return false; }
+std::vector<bool> AreWindowsNearTop(const std::vector<WindowHandle>& windows, int) {
+    return std::vector<bool>(windows.size(), false);
+}
+bool IsWindowValid(WindowHandle) { return false; }
+std::vector<WindowInfo> GetVisibleWindows() { return std::vector<WindowInfo>(); }
+std::vector<WindowInfo> GetWindowSnapshot() { return std::vector<WindowInfo>(); }
+bool BringWindowToForeground(WindowHandle) { return false; }
+WindowHandle GetForegroundWindowPid(uint32_t* pid) {
+    *pid = 0;
+    return 0;
+}
+
+namespace {
+
+class NullWindowChangeMonitor : public WindowChangeMonitor {
+public:
+    bool Start(WindowChangedFn, void*) override { return false; }
+    void Stop() override {}
+    void Watch(WindowHandle) override {}
+};
+
+class NullTopmostWatcher : public TopmostWatcher {
+public:
+    bool Start() override { return false; }
+    void Stop() override {}
+    bool IsRunning() const override { return false; }
+    bool Watch(WindowHandle, const TopmostPolicy&) override { return false; }
+    bool Unwatch(WindowHandle) override { return false; }
+    TopmostWatcherStats Stats() const override { return targets_.Stats(); }
+    std::vector<TopmostTargetStats> TargetStats() const override { return targets_.TargetStats(); }
+    void ResetStats() override {}
+
+private:
+    TopmostTargetSet targets_;
+};
+
+} // namespace
+
+TopmostWatcher* CreateTopmostWatcher() {
+    return new NullTopmostWatcher();
+}
+
+WindowChangeMonitor* CreateWindowChangeMonitor() {
+    return new NullWindowChangeMonitor();
+}
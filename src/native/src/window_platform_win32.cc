@@ -0,0 +1,392 @@
+#include <windows.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "title_matcher.h"
+#include "window_platform.h"
+
+namespace {
+
+HWND ToHwnd(WindowHandle window) {
+    return reinterpret_cast<HWND>(window);
+}
+
+// Title of a window as UTF-8; prefers the Unicode text
+std::string WindowTitleUtf8(HWND hwnd) {
+    wchar_t windowTextW[512];
+    int length = GetWindowTextW(hwnd, windowTextW, sizeof(windowTextW)/sizeof(wchar_t));
+    if (length > 0) {
+        int utf8Length = WideCharToMultiByte(CP_UTF8, 0, windowTextW, length, NULL, 0, NULL, NULL);
+        if (utf8Length > 0) {
+            std::string title(utf8Length, '\0');
+            WideCharToMultiByte(CP_UTF8, 0, windowTextW, length, &title[0], utf8Length, NULL, NULL);
+            return title;
+        }
+    }
+
+    char windowTextA[512];
+    if (GetWindowTextA(hwnd, windowTextA, sizeof(windowTextA)) > 0) {
+        return std::string(windowTextA);
+    }
+    return std::string();
+}
+
+struct FindData {
+    std::string foldedTarget;
+    std::string foldedTitle;
+    HWND found;
+};
+
+// Enhanced window enumeration callback for finding target windows
+BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam) {
+    FindData* data = reinterpret_cast<FindData*>(lParam);
+
+    // Check if window is visible and has a title
+    if (!IsWindowVisible(hwnd)) {
+        return TRUE;
+    }
+
+    // Case-insensitive search for window title
+    std::string title = WindowTitleUtf8(hwnd);
+    FoldCaseUtf8(title.data(), title.size(), &data->foldedTitle);
+    if (!title.empty() && data->foldedTitle.find(data->foldedTarget) != std::string::npos) {
+        data->found = hwnd;
+        return FALSE; // Stop enumeration when found
+    }
+
+    return TRUE; // Continue enumeration
+}
+
+// One deferred z-order change for all windows; windows[0] ends up on top.
+// DeferWindowPos abandons the whole batch on any failure (e.g. a window
+// destroyed in between), in which case each window is moved on its own.
+bool DeferTopmost(const std::vector<HWND>& windows, HWND insertAfter) {
+    const UINT flags = SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE;
+    if (windows.empty()) {
+        return true;
+    }
+
+    HDWP batch = BeginDeferWindowPos(static_cast<int>(windows.size()));
+    for (size_t i = windows.size(); batch && i-- > 0;) {
+        batch = DeferWindowPos(batch, windows[i], insertAfter, 0, 0, 0, 0, flags);
+    }
+    if (batch && EndDeferWindowPos(batch)) {
+        return true;
+    }
+
+    bool result = true;
+    for (size_t i = windows.size(); i-- > 0;) {
+        result = SetWindowPos(windows[i], insertAfter, 0, 0, 0, 0, flags) && result;
+    }
+    return result;
+}
+
+struct EnumVisibleData {
+    std::vector<WindowInfo>* windows;
+    bool details;
+    HWND foreground;
+};
+
+BOOL CALLBACK EnumVisibleProc(HWND hwnd, LPARAM lParam) {
+    EnumVisibleData* data = reinterpret_cast<EnumVisibleData*>(lParam);
+
+    if (IsWindowVisible(hwnd)) {
+        std::string title = WindowTitleUtf8(hwnd);
+        if (!title.empty()) {
+            WindowInfo info;
+            info.handle = reinterpret_cast<WindowHandle>(hwnd);
+            info.title = title;
+            if (data->details) {
+                DWORD processId = 0;
+                GetWindowThreadProcessId(hwnd, &processId);
+                info.pid = processId;
+                if (GetWindowLongPtr(hwnd, GWL_EXSTYLE) & WS_EX_TOPMOST) {
+                    info.flags |= kWindowFlagTopmost;
+                }
+                if (IsIconic(hwnd)) {
+                    info.flags |= kWindowFlagMinimized;
+                }
+                if (hwnd == data->foreground) {
+                    info.flags |= kWindowFlagForeground;
+                }
+            }
+            data->windows->push_back(info);
+        }
+    }
+
+    return TRUE;
+}
+
+std::vector<WindowInfo> EnumerateVisible(bool details) {
+    std::vector<WindowInfo> windows;
+    EnumVisibleData data = { &windows, details, details ? GetForegroundWindow() : NULL };
+    EnumWindows(EnumVisibleProc, reinterpret_cast<LPARAM>(&data));
+    return windows;
+}
+
+} // namespace
+
+WindowHandle FindWindowByTitle(const std::string& titleSubstring) {
+    FindData data;
+    data.foldedTarget = FoldCaseUtf8(titleSubstring);
+    data.found = NULL;
+    EnumWindows(EnumWindowsProc, reinterpret_cast<LPARAM>(&data));
+    return reinterpret_cast<WindowHandle>(data.found);
+}
+
+bool SetWindowAlwaysOnTop(WindowHandle window, bool topmost) {
+    return SetWindowsAlwaysOnTop(std::vector<WindowHandle>(1, window), topmost)[0];
+}
+
+std::vector<bool> SetWindowsAlwaysOnTop(const std::vector<WindowHandle>& windows, bool topmost) {
+    std::vector<bool> applied(windows.size(), false);
+    std::vector<HWND> valid;
+    for (size_t i = 0; i < windows.size(); i++) {
+        if (IsWindow(ToHwnd(windows[i]))) {
+            applied[i] = true;
+            valid.push_back(ToHwnd(windows[i]));
+        }
+    }
+
+    if (!DeferTopmost(valid, topmost ? HWND_TOPMOST : HWND_NOTOPMOST)) {
+        for (size_t i = 0; i < windows.size(); i++) {
+            applied[i] = false;
+        }
+        return applied;
+    }
+
+    if (topmost) {
+        // Enhanced approach: Force window to stay on top
+        // This mimics UIAccess behavior for better fullscreen game compatibility
+        for (HWND hwnd : valid) {
+            // Add WS_EX_TOPMOST and WS_EX_NOACTIVATE for better compatibility
+            LONG_PTR exStyle = GetWindowLongPtr(hwnd, GWL_EXSTYLE);
+            exStyle |= WS_EX_TOPMOST | WS_EX_NOACTIVATE;
+            SetWindowLongPtr(hwnd, GWL_EXSTYLE, exStyle);
+        }
+    }
+
+    return applied;
+}
+
+void ReassertWindowsTopmost(const std::vector<WindowHandle>& windows) {
+    std::vector<HWND> valid;
+    for (WindowHandle window : windows) {
+        if (IsWindow(ToHwnd(window))) {
+            valid.push_back(ToHwnd(window));
+        }
+    }
+    DeferTopmost(valid, HWND_TOPMOST);
+}
+
+bool IsWindowNearTop(WindowHandle window, int depth) {
+    HWND targetWindow = ToHwnd(window);
+
+    // Walk through top-level windows to check if our window is among the topmost
+    HWND currentWindow = GetTopWindow(GetDesktopWindow());
+    for (int i = 0; i < depth && currentWindow; i++) {
+        if (currentWindow == targetWindow) {
+            return true;
+        }
+        currentWindow = GetNextWindow(currentWindow, GW_HWNDNEXT);
+    }
+    return false;
+}
+
+std::vector<bool> AreWindowsNearTop(const std::vector<WindowHandle>& windows, int depth) {
+    std::vector<bool> nearTop(windows.size(), false);
+    HWND currentWindow = GetTopWindow(GetDesktopWindow());
+    for (int i = 0; i < depth && currentWindow; i++) {
+        for (size_t w = 0; w < windows.size(); w++) {
+            if (ToHwnd(windows[w]) == currentWindow) nearTop[w] = true;
+        }
+        currentWindow = GetNextWindow(currentWindow, GW_HWNDNEXT);
+    }
+    return nearTop;
+}
+
+bool IsWindowValid(WindowHandle window) {
+    return IsWindow(ToHwnd(window)) != FALSE;
+}
+
+std::vector<WindowInfo> GetVisibleWindows() {
+    return EnumerateVisible(false);
+}
+
+std::vector<WindowInfo> GetWindowSnapshot() {
+    return EnumerateVisible(true);
+}
+
+bool BringWindowToForeground(WindowHandle window) {
+    HWND targetWindow = ToHwnd(window);
+
+    // Multiple techniques to bring window to foreground
+    bool success = false;
+
+    // Method 1: Standard approach
+    if (SetForegroundWindow(targetWindow)) {
+        success = true;
+    }
+
+    // Method 2: Alternative approach for stubborn windows
+    if (!success) {
+        DWORD currentThreadId = GetCurrentThreadId();
+        DWORD targetThreadId = GetWindowThreadProcessId(targetWindow, NULL);
+
+        AttachThreadInput(currentThreadId, targetThreadId, TRUE);
+        SetForegroundWindow(targetWindow);
+        AttachThreadInput(currentThreadId, targetThreadId, FALSE);
+        success = true;
+    }
+
+    // Method 3: Force show and activate
+    ShowWindow(targetWindow, SW_SHOW);
+    SetActiveWindow(targetWindow);
+
+    return success;
+}
+
+WindowHandle GetForegroundWindowPid(uint32_t* pid) {
+    HWND foreground = GetForegroundWindow();
+    DWORD processId = 0;
+    if (foreground) {
+        GetWindowThreadProcessId(foreground, &processId);
+    }
+    *pid = static_cast<uint32_t>(processId);
+    return reinterpret_cast<WindowHandle>(foreground);
+}
+
+namespace {
+
+class Win32WindowChangeMonitor;
+
+// WinEvent procs carry no context, so the running monitor is kept here
+Win32WindowChangeMonitor* activeChangeMonitor = nullptr;
+
+void CALLBACK ChangeEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd, LONG idObject,
+                              LONG idChild, DWORD eventThread, DWORD eventTime);
+
+const UINT kWatchWindowMessage = WM_APP + 1;
+
+// WinEvent hooks can only be filtered by process, so one destroy and one
+// name-change hook is installed per process owning a watched window and the
+// callback filters on the watched handles. Title lookups are nearly always for
+// our own window, which keeps this to a single process.
+class Win32WindowChangeMonitor : public WindowChangeMonitor {
+public:
+    Win32WindowChangeMonitor() : callback_(nullptr), context_(nullptr), threadId_(0) {}
+    ~Win32WindowChangeMonitor() override { Stop(); }
+
+    bool Start(WindowChangedFn callback, void* context) override {
+        Stop();
+        callback_ = callback;
+        context_ = context;
+        activeChangeMonitor = this;
+
+        HANDLE readyEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+        monitorThread_ = std::thread([this, readyEvent]() {
+            threadId_ = GetCurrentThreadId();
+            MSG msg;
+            PeekMessage(&msg, NULL, WM_USER, WM_USER, PM_NOREMOVE);
+            SetEvent(readyEvent);
+
+            while (GetMessage(&msg, NULL, 0, 0) > 0) {
+                if (msg.hwnd == NULL && msg.message == kWatchWindowMessage) {
+                    AddWatch(reinterpret_cast<HWND>(msg.wParam));
+                    continue;
+                }
+                TranslateMessage(&msg);
+                DispatchMessage(&msg);
+            }
+
+            for (HWINEVENTHOOK hook : hooks_) {
+                UnhookWinEvent(hook);
+            }
+            hooks_.clear();
+            hookedProcesses_.clear();
+            watched_.clear();
+        });
+
+        WaitForSingleObject(readyEvent, INFINITE);
+        CloseHandle(readyEvent);
+        return true;
+    }
+
+    void Stop() override {
+        if (monitorThread_.joinable()) {
+            PostThreadMessage(threadId_, WM_QUIT, 0, 0);
+            monitorThread_.join();
+        }
+        threadId_ = 0;
+        if (activeChangeMonitor == this) {
+            activeChangeMonitor = nullptr;
+        }
+    }
+
+    void Watch(WindowHandle window) override {
+        if (threadId_) {
+            PostThreadMessage(threadId_, kWatchWindowMessage, static_cast<WPARAM>(window), 0);
+        }
+    }
+
+    void OnWinEvent(DWORD event, HWND hwnd, LONG idObject, LONG idChild) {
+        if (idObject != OBJID_WINDOW || idChild != CHILDID_SELF) {
+            return;
+        }
+        for (size_t i = 0; i < watched_.size(); i++) {
+            if (watched_[i] == hwnd) {
+                if (event == EVENT_OBJECT_DESTROY) {
+                    watched_.erase(watched_.begin() + i);
+                }
+                callback_(reinterpret_cast<WindowHandle>(hwnd), context_);
+                return;
+            }
+        }
+    }
+
+private:
+    void AddWatch(HWND hwnd) {
+        for (HWND watched : watched_) {
+            if (watched == hwnd) return;
+        }
+        DWORD processId = 0;
+        if (!GetWindowThreadProcessId(hwnd, &processId)) {
+            return;
+        }
+        watched_.push_back(hwnd);
+
+        for (DWORD hooked : hookedProcesses_) {
+            if (hooked == processId) return;
+        }
+        hookedProcesses_.push_back(processId);
+        hooks_.push_back(SetWinEventHook(EVENT_OBJECT_DESTROY, EVENT_OBJECT_DESTROY,
+                                         NULL, ChangeEventProc, processId, 0, WINEVENT_OUTOFCONTEXT));
+        hooks_.push_back(SetWinEventHook(EVENT_OBJECT_NAMECHANGE, EVENT_OBJECT_NAMECHANGE,
+                                         NULL, ChangeEventProc, processId, 0, WINEVENT_OUTOFCONTEXT));
+    }
+
+    WindowChangedFn callback_;
+    void* context_;
+    volatile DWORD threadId_;
+    std::thread monitorThread_;
+
+    // Owned by the monitor thread
+    std::vector<HWND> watched_;
+    std::vector<DWORD> hookedProcesses_;
+    std::vector<HWINEVENTHOOK> hooks_;
+};
+
+void CALLBACK ChangeEventProc(HWINEVENTHOOK, DWORD event, HWND hwnd, LONG idObject,
+                              LONG idChild, DWORD, DWORD) {
+    if (activeChangeMonitor && hwnd) {
+        activeChangeMonitor->OnWinEvent(event, hwnd, idObject, idChild);
+    }
+}
+
+} // namespace
+
+WindowChangeMonitor* CreateWindowChangeMonitor() {
+    return new Win32WindowChangeMonitor();
+}
@@ -0,0 +1,463 @@
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "title_matcher.h"
+#include "window_platform.h"
+#include "x11_connection.h"
+
+// X11/EWMH implementation of the window platform.
+//
+// Z-order comes from _NET_CLIENT_LIST_STACKING (bottom to top); on a bare X
+// server without a window manager the root's children from QueryTree are
+// used instead. Topmost is requested with _NET_WM_STATE_ABOVE and enforced
+// with a direct restack so it also works without a window manager.
+
+namespace {
+
+X11Connection display;
+std::mutex displayMutex;
+
+const uint32_t kNetWmStateRemove = 0;
+const uint32_t kNetWmStateAdd = 1;
+
+bool EnsureDisplay() {
+    // Reconnect after the X server dropped us (e.g. a restarted Xvfb)
+    if (display.IsOpen() && xcb_connection_has_error(display.Get())) {
+        display.Close();
+    }
+    return display.IsOpen() || display.Open();
+}
+
+// Top-level windows, bottom of the stack first
+std::vector<xcb_window_t> ReadStacking() {
+    std::vector<xcb_window_t> windows;
+    xcb_connection_t* c = display.Get();
+
+    xcb_get_property_reply_t* reply = xcb_get_property_reply(c,
+        xcb_get_property(c, 0, display.Root(), display.Atoms().netClientListStacking,
+                         XCB_ATOM_WINDOW, 0, UINT32_MAX / 4), nullptr);
+    if (reply && reply->format == 32 && xcb_get_property_value_length(reply) > 0) {
+        const xcb_window_t* values = static_cast<const xcb_window_t*>(xcb_get_property_value(reply));
+        windows.assign(values, values + xcb_get_property_value_length(reply) / 4);
+        free(reply);
+        return windows;
+    }
+    free(reply);
+
+    // No EWMH window manager: the root's children are the top-level windows
+    xcb_query_tree_reply_t* tree = xcb_query_tree_reply(c, xcb_query_tree(c, display.Root()), nullptr);
+    if (tree) {
+        const xcb_window_t* children = xcb_query_tree_children(tree);
+        windows.assign(children, children + xcb_query_tree_children_length(tree));
+        free(tree);
+    }
+    return windows;
+}
+
+std::string PropertyString(xcb_get_property_reply_t* reply) {
+    if (!reply || xcb_get_property_value_length(reply) <= 0) {
+        return std::string();
+    }
+    return std::string(static_cast<const char*>(xcb_get_property_value(reply)),
+                       xcb_get_property_value_length(reply));
+}
+
+uint32_t PropertyCardinal(xcb_get_property_reply_t* reply) {
+    if (!reply || reply->format != 32 || xcb_get_property_value_length(reply) < 4) {
+        return 0;
+    }
+    return *static_cast<const uint32_t*>(xcb_get_property_value(reply));
+}
+
+bool PropertyHasAtom(xcb_get_property_reply_t* reply, xcb_atom_t atom) {
+    if (!reply || reply->format != 32 || atom == XCB_ATOM_NONE) {
+        return false;
+    }
+    const xcb_atom_t* values = static_cast<const xcb_atom_t*>(xcb_get_property_value(reply));
+    int count = xcb_get_property_value_length(reply) / 4;
+    for (int i = 0; i < count; i++) {
+        if (values[i] == atom) return true;
+    }
+    return false;
+}
+
+// Viewable top-level windows with a title, top of the stack first.
+//
+// After the stacking list is read, the attributes, _NET_WM_NAME and WM_NAME
+// requests for every window are all written before the first reply is
+// awaited, so the whole enumeration costs one more round-trip no matter how
+// many windows there are. With `details` the _NET_WM_PID and _NET_WM_STATE
+// requests (and one _NET_ACTIVE_WINDOW) join the same batch.
+std::vector<WindowInfo> EnumerateVisible(bool details) {
+    std::vector<WindowInfo> result;
+    xcb_connection_t* c = display.Get();
+    const X11Atoms& atoms = display.Atoms();
+
+    std::vector<xcb_window_t> windows = ReadStacking();
+    const size_t count = windows.size();
+
+    std::vector<xcb_get_window_attributes_cookie_t> attributeCookies(count);
+    std::vector<xcb_get_property_cookie_t> netNameCookies(count);
+    std::vector<xcb_get_property_cookie_t> wmNameCookies(count);
+    std::vector<xcb_get_property_cookie_t> pidCookies(details ? count : 0);
+    std::vector<xcb_get_property_cookie_t> stateCookies(details ? count : 0);
+    xcb_get_property_cookie_t activeCookie = {};
+    if (details) {
+        activeCookie = xcb_get_property(c, 0, display.Root(), atoms.netActiveWindow, XCB_ATOM_WINDOW, 0, 1);
+    }
+    for (size_t i = 0; i < count; i++) {
+        attributeCookies[i] = xcb_get_window_attributes(c, windows[i]);
+        netNameCookies[i] = xcb_get_property(c, 0, windows[i], atoms.netWmName, atoms.utf8String, 0, 1024);
+        wmNameCookies[i] = xcb_get_property(c, 0, windows[i], XCB_ATOM_WM_NAME, XCB_GET_PROPERTY_TYPE_ANY, 0, 1024);
+        if (details) {
+            pidCookies[i] = xcb_get_property(c, 0, windows[i], atoms.netWmPid, XCB_ATOM_CARDINAL, 0, 1);
+            stateCookies[i] = xcb_get_property(c, 0, windows[i], atoms.netWmState, XCB_ATOM_ATOM, 0, 64);
+        }
+    }
+
+    xcb_window_t activeWindow = XCB_NONE;
+    if (details) {
+        xcb_get_property_reply_t* active = xcb_get_property_reply(c, activeCookie, nullptr);
+        activeWindow = PropertyCardinal(active);
+        free(active);
+    }
+
+    // Every reply must be collected (or discarded) so none are left queued
+    result.reserve(count);
+    for (size_t n = count; n-- > 0;) {
+        xcb_get_window_attributes_reply_t* attributes = xcb_get_window_attributes_reply(c, attributeCookies[n], nullptr);
+        xcb_get_property_reply_t* netName = xcb_get_property_reply(c, netNameCookies[n], nullptr);
+        xcb_get_property_reply_t* wmName = xcb_get_property_reply(c, wmNameCookies[n], nullptr);
+        xcb_get_property_reply_t* pid = details ? xcb_get_property_reply(c, pidCookies[n], nullptr) : nullptr;
+        xcb_get_property_reply_t* state = details ? xcb_get_property_reply(c, stateCookies[n], nullptr) : nullptr;
+
+        if (attributes && attributes->map_state == XCB_MAP_STATE_VIEWABLE) {
+            WindowInfo info;
+            info.handle = static_cast<WindowHandle>(windows[n]);
+            info.title = PropertyString(netName);
+            if (info.title.empty()) {
+                info.title = PropertyString(wmName);
+            }
+            if (details) {
+                info.pid = PropertyCardinal(pid);
+                if (PropertyHasAtom(state, atoms.netWmStateAbove)) {
+                    info.flags |= kWindowFlagTopmost;
+                }
+                if (PropertyHasAtom(state, atoms.netWmStateHidden)) {
+                    info.flags |= kWindowFlagMinimized;
+                }
+                if (windows[n] == activeWindow) {
+                    info.flags |= kWindowFlagForeground;
+                }
+            }
+            if (!info.title.empty()) {
+                result.push_back(info);
+            }
+        }
+
+        free(attributes);
+        free(netName);
+        free(wmName);
+        free(pid);
+        free(state);
+    }
+    return result;
+}
+
+void SendRootMessage(xcb_window_t window, xcb_atom_t type, uint32_t d0, uint32_t d1, uint32_t d2) {
+    xcb_client_message_event_t event = {};
+    event.response_type = XCB_CLIENT_MESSAGE;
+    event.format = 32;
+    event.window = window;
+    event.type = type;
+    event.data.data32[0] = d0;
+    event.data.data32[1] = d1;
+    event.data.data32[2] = d2;
+    xcb_send_event(display.Get(), 0, display.Root(),
+                   XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY,
+                   reinterpret_cast<const char*>(&event));
+}
+
+// Last restacked ends on top, so go backwards to leave windows[0] there
+void RestackAbove(const std::vector<WindowHandle>& windows) {
+    const uint32_t stackMode = XCB_STACK_MODE_ABOVE;
+    for (size_t i = windows.size(); i-- > 0;) {
+        xcb_configure_window(display.Get(), static_cast<xcb_window_t>(windows[i]),
+                             XCB_CONFIG_WINDOW_STACK_MODE, &stackMode);
+    }
+}
+
+// The attributes replies double as the validity check and flush everything
+// queued before them in one round-trip. Errors from the unchecked requests
+// (e.g. BadWindow for a window destroyed meanwhile) land in the event queue
+// of this request/reply-only connection and are dropped here.
+std::vector<bool> CheckWindows(const std::vector<WindowHandle>& windows) {
+    xcb_connection_t* c = display.Get();
+    std::vector<xcb_get_window_attributes_cookie_t> cookies(windows.size());
+    for (size_t i = 0; i < windows.size(); i++) {
+        cookies[i] = xcb_get_window_attributes(c, static_cast<xcb_window_t>(windows[i]));
+    }
+
+    std::vector<bool> valid(windows.size(), false);
+    for (size_t i = 0; i < windows.size(); i++) {
+        xcb_get_window_attributes_reply_t* attributes = xcb_get_window_attributes_reply(c, cookies[i], nullptr);
+        valid[i] = attributes != nullptr;
+        free(attributes);
+    }
+
+    while (xcb_generic_event_t* event = xcb_poll_for_queued_event(c)) {
+        free(event);
+    }
+    return valid;
+}
+
+} // namespace
+
+WindowHandle FindWindowByTitle(const std::string& titleSubstring) {
+    std::lock_guard<std::mutex> lock(displayMutex);
+    if (!EnsureDisplay()) return 0;
+
+    // Case-insensitive search for window title
+    std::string foldedTarget = FoldCaseUtf8(titleSubstring);
+    std::string foldedTitle;
+    std::vector<WindowInfo> windows = EnumerateVisible(false);
+    for (const WindowInfo& window : windows) {
+        FoldCaseUtf8(window.title.data(), window.title.size(), &foldedTitle);
+        if (foldedTitle.find(foldedTarget) != std::string::npos) {
+            return window.handle;
+        }
+    }
+    return 0;
+}
+
+bool SetWindowAlwaysOnTop(WindowHandle window, bool topmost) {
+    return SetWindowsAlwaysOnTop(std::vector<WindowHandle>(1, window), topmost)[0];
+}
+
+std::vector<bool> SetWindowsAlwaysOnTop(const std::vector<WindowHandle>& windows, bool topmost) {
+    std::lock_guard<std::mutex> lock(displayMutex);
+    if (!EnsureDisplay()) return std::vector<bool>(windows.size(), false);
+
+    // Ask the window manager to keep each window in its "above" layer
+    for (WindowHandle window : windows) {
+        SendRootMessage(static_cast<xcb_window_t>(window), display.Atoms().netWmState,
+                        topmost ? kNetWmStateAdd : kNetWmStateRemove,
+                        display.Atoms().netWmStateAbove, 0);
+    }
+
+    // Restack immediately; with a WM this becomes a ConfigureRequest it honours
+    if (topmost) {
+        RestackAbove(windows);
+    }
+    return CheckWindows(windows);
+}
+
+void ReassertWindowsTopmost(const std::vector<WindowHandle>& windows) {
+    std::lock_guard<std::mutex> lock(displayMutex);
+    if (!EnsureDisplay()) return;
+
+    RestackAbove(windows);
+    CheckWindows(windows);
+}
+
+bool IsWindowNearTop(WindowHandle window, int depth) {
+    std::lock_guard<std::mutex> lock(displayMutex);
+    if (!EnsureDisplay()) return false;
+
+    std::vector<xcb_window_t> windows = ReadStacking();
+    xcb_window_t target = static_cast<xcb_window_t>(window);
+    int checked = 0;
+    for (auto it = windows.rbegin(); it != windows.rend() && checked < depth; ++it, ++checked) {
+        if (*it == target) return true;
+    }
+    return false;
+}
+
+std::vector<bool> AreWindowsNearTop(const std::vector<WindowHandle>& windows, int depth) {
+    std::vector<bool> nearTop(windows.size(), false);
+    std::lock_guard<std::mutex> lock(displayMutex);
+    if (!EnsureDisplay()) return nearTop;
+
+    std::vector<xcb_window_t> stacking = ReadStacking();
+    int checked = 0;
+    for (auto it = stacking.rbegin(); it != stacking.rend() && checked < depth; ++it, ++checked) {
+        for (size_t w = 0; w < windows.size(); w++) {
+            if (static_cast<xcb_window_t>(windows[w]) == *it) nearTop[w] = true;
+        }
+    }
+    return nearTop;
+}
+
+bool IsWindowValid(WindowHandle window) {
+    std::lock_guard<std::mutex> lock(displayMutex);
+    if (!EnsureDisplay()) return false;
+
+    xcb_connection_t* c = display.Get();
+    xcb_get_window_attributes_reply_t* attributes = xcb_get_window_attributes_reply(c,
+        xcb_get_window_attributes(c, static_cast<xcb_window_t>(window)), nullptr);
+    bool valid = attributes != nullptr;
+    free(attributes);
+    return valid;
+}
+
+std::vector<WindowInfo> GetVisibleWindows() {
+    std::lock_guard<std::mutex> lock(displayMutex);
+    if (!EnsureDisplay()) return std::vector<WindowInfo>();
+    return EnumerateVisible(false);
+}
+
+std::vector<WindowInfo> GetWindowSnapshot() {
+    std::lock_guard<std::mutex> lock(displayMutex);
+    if (!EnsureDisplay()) return std::vector<WindowInfo>();
+    return EnumerateVisible(true);
+}
+
+bool BringWindowToForeground(WindowHandle window) {
+    std::lock_guard<std::mutex> lock(displayMutex);
+    if (!EnsureDisplay()) return false;
+
+    xcb_connection_t* c = display.Get();
+    xcb_window_t target = static_cast<xcb_window_t>(window);
+
+    // Source indication 2 (pager) so focus-stealing prevention lets it through
+    SendRootMessage(target, display.Atoms().netActiveWindow, 2, XCB_CURRENT_TIME, 0);
+
+    // Without a window manager nobody handles the message, so do it directly
+    xcb_map_window(c, target);
+    const uint32_t stackMode = XCB_STACK_MODE_ABOVE;
+    xcb_configure_window(c, target, XCB_CONFIG_WINDOW_STACK_MODE, &stackMode);
+    xcb_void_cookie_t focus = xcb_set_input_focus_checked(c, XCB_INPUT_FOCUS_POINTER_ROOT,
+                                                          target, XCB_CURRENT_TIME);
+    // BadMatch only means the WM has not mapped it yet; BadWindow means it is gone
+    xcb_generic_error_t* error = xcb_request_check(c, focus);
+    bool success = error == nullptr || error->error_code != XCB_WINDOW;
+    free(error);
+    return success;
+}
+
+// _NET_ACTIVE_WINDOW, then its _NET_WM_PID: two round-trips
+WindowHandle GetForegroundWindowPid(uint32_t* pid) {
+    *pid = 0;
+    std::lock_guard<std::mutex> lock(displayMutex);
+    if (!EnsureDisplay()) return 0;
+
+    xcb_connection_t* c = display.Get();
+    const X11Atoms& atoms = display.Atoms();
+    xcb_get_property_reply_t* active = xcb_get_property_reply(c,
+        xcb_get_property(c, 0, display.Root(), atoms.netActiveWindow, XCB_ATOM_WINDOW, 0, 1), nullptr);
+    xcb_window_t window = PropertyCardinal(active);
+    free(active);
+    if (window == XCB_NONE) return 0;
+
+    xcb_get_property_reply_t* owner = xcb_get_property_reply(c,
+        xcb_get_property(c, 0, window, atoms.netWmPid, XCB_ATOM_CARDINAL, 0, 1), nullptr);
+    *pid = PropertyCardinal(owner);
+    free(owner);
+    return static_cast<WindowHandle>(window);
+}
+
+namespace {
+
+// X11 can select events per window, so each watched window gets
+// PropertyChange (title) and StructureNotify (destroy) on a private
+// connection; nothing else reaches this thread.
+class X11WindowChangeMonitor : public WindowChangeMonitor {
+public:
+    X11WindowChangeMonitor() : callback_(nullptr), context_(nullptr), stopFd_(-1) {}
+    ~X11WindowChangeMonitor() override { Stop(); }
+
+    bool Start(WindowChangedFn callback, void* context) override {
+        Stop();
+        callback_ = callback;
+        context_ = context;
+        if (!connection_.Open()) {
+            return false;
+        }
+        stopFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (stopFd_ < 0) {
+            Stop();
+            return false;
+        }
+        monitorThread_ = std::thread(&X11WindowChangeMonitor::EventLoop, this);
+        return true;
+    }
+
+    void Stop() override {
+        if (monitorThread_.joinable()) {
+            uint64_t one = 1;
+            ssize_t ignored = write(stopFd_, &one, sizeof(one));
+            (void)ignored;
+            monitorThread_.join();
+        }
+        if (stopFd_ >= 0) {
+            close(stopFd_);
+            stopFd_ = -1;
+        }
+        connection_.Close();
+    }
+
+    // XCB connections are thread-safe, so the selection is made right here
+    void Watch(WindowHandle window) override {
+        if (!connection_.IsOpen()) return;
+        const uint32_t mask = XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+        xcb_change_window_attributes(connection_.Get(), static_cast<xcb_window_t>(window),
+                                     XCB_CW_EVENT_MASK, &mask);
+        xcb_flush(connection_.Get());
+    }
+
+private:
+    void EventLoop() {
+        xcb_connection_t* c = connection_.Get();
+        const X11Atoms& atoms = connection_.Atoms();
+        pollfd fds[2];
+        fds[0].fd = xcb_get_file_descriptor(c);
+        fds[0].events = POLLIN;
+        fds[1].fd = stopFd_;
+        fds[1].events = POLLIN;
+
+        while (!xcb_connection_has_error(c)) {
+            xcb_generic_event_t* event;
+            while ((event = xcb_poll_for_event(c)) != nullptr) {
+                uint8_t type = event->response_type & ~0x80;
+                if (type == XCB_DESTROY_NOTIFY) {
+                    callback_(reinterpret_cast<xcb_destroy_notify_event_t*>(event)->window, context_);
+                } else if (type == XCB_PROPERTY_NOTIFY) {
+                    xcb_property_notify_event_t* e = reinterpret_cast<xcb_property_notify_event_t*>(event);
+                    if (e->atom == atoms.netWmName || e->atom == XCB_ATOM_WM_NAME) {
+                        callback_(e->window, context_);
+                    }
+                }
+                free(event);
+            }
+
+            fds[0].revents = 0;
+            fds[1].revents = 0;
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (fds[1].revents) {
+                break;
+            }
+        }
+    }
+
+    X11Connection connection_;
+    WindowChangedFn callback_;
+    void* context_;
+    int stopFd_;
+    std::thread monitorThread_;
+};
+
+} // namespace
+
+WindowChangeMonitor* CreateWindowChangeMonitor() {
+    return new X11WindowChangeMonitor();
+}
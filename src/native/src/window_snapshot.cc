@@ -0,0 +1,59 @@
+#include "window_snapshot.h"
+
+#include <cstring>
+
+namespace {
+
+size_t AlignUp(size_t value) {
+    return (value + 7) & ~static_cast<size_t>(7);
+}
+
+void Store(uint8_t* base, size_t offset, size_t index, uint32_t value) {
+    memcpy(base + offset + index * sizeof(uint32_t), &value, sizeof(value));
+}
+
+} // namespace
+
+WindowSnapshotLayout ComputeWindowSnapshotLayout(size_t windowCount, size_t titleBytes) {
+    WindowSnapshotLayout layout;
+    layout.handles = kWindowSnapshotHeaderBytes;
+    layout.pids = AlignUp(layout.handles + windowCount * sizeof(double));
+    layout.zOrder = AlignUp(layout.pids + windowCount * sizeof(uint32_t));
+    layout.flags = AlignUp(layout.zOrder + windowCount * sizeof(uint32_t));
+    layout.titleOffsets = AlignUp(layout.flags + windowCount * sizeof(uint32_t));
+    layout.titles = AlignUp(layout.titleOffsets + (windowCount + 1) * sizeof(uint32_t));
+    layout.totalBytes = layout.titles + titleBytes;
+    return layout;
+}
+
+void PackWindowSnapshot(const std::vector<WindowInfo>& windows, std::vector<uint8_t>* out) {
+    size_t titleBytes = 0;
+    for (const WindowInfo& window : windows) {
+        titleBytes += window.title.size();
+    }
+
+    const size_t count = windows.size();
+    WindowSnapshotLayout layout = ComputeWindowSnapshotLayout(count, titleBytes);
+    out->assign(layout.totalBytes, 0);
+    uint8_t* base = out->data();
+
+    Store(base, 0, 0, kWindowSnapshotVersion);
+    Store(base, 0, 1, static_cast<uint32_t>(count));
+    Store(base, 0, 2, static_cast<uint32_t>(titleBytes));
+
+    uint32_t titleOffset = 0;
+    for (size_t i = 0; i < count; i++) {
+        const WindowInfo& window = windows[i];
+        double handle = static_cast<double>(window.handle);
+        memcpy(base + layout.handles + i * sizeof(double), &handle, sizeof(handle));
+        Store(base, layout.pids, i, window.pid);
+        Store(base, layout.zOrder, i, static_cast<uint32_t>(i));
+        Store(base, layout.flags, i, window.flags);
+        Store(base, layout.titleOffsets, i, titleOffset);
+        if (!window.title.empty()) {
+            memcpy(base + layout.titles + titleOffset, window.title.data(), window.title.size());
+        }
+        titleOffset += static_cast<uint32_t>(window.title.size());
+    }
+    Store(base, layout.titleOffsets, count, titleOffset);
+}
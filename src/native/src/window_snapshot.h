@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "window_platform.h"
+
+// Packed window snapshot handed to JS as one ArrayBuffer.
+//
+// Struct-of-arrays so JS can lay typed-array views over it without copying;
+// every array starts on an 8-byte boundary. With n windows and t title bytes:
+//
+//   offset                        type        content
+//   0                             uint32[4]   version, n, t, reserved (0)
+//   kWindowSnapshotHeaderBytes    float64[n]  handles (exact below 2^53)
+//   ...                           uint32[n]   pids (0 = unknown)
+//   ...                           uint32[n]   z-order (0 = top)
+//   ...                           uint32[n]   WindowFlags
+//   ...                           uint32[n+1] title offsets into the blob
+//   ...                           uint8[t]    UTF-8 titles, back to back
+//
+// Windows are stored top of the z-order first. lib/topmost.js decodes this
+// layout; bump kWindowSnapshotVersion when it changes.
+
+const uint32_t kWindowSnapshotVersion = 1;
+const size_t kWindowSnapshotHeaderBytes = 16;
+
+struct WindowSnapshotLayout {
+    size_t handles;
+    size_t pids;
+    size_t zOrder;
+    size_t flags;
+    size_t titleOffsets;
+    size_t titles;
+    size_t totalBytes;
+};
+
+WindowSnapshotLayout ComputeWindowSnapshotLayout(size_t windowCount, size_t titleBytes);
+
+// Serializes `windows` (top first) into `out`, replacing its contents
+void PackWindowSnapshot(const std::vector<WindowInfo>& windows, std::vector<uint8_t>* out);
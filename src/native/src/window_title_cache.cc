@@ -0,0 +1,83 @@
+#include "window_title_cache.h"
+
+#include "trace_events.h"
+
+WindowTitleCache::WindowTitleCache()
+    : monitorStarted_(false), monitorFailed_(false), hits_(0), misses_(0), invalidations_(0) {}
+
+WindowTitleCache::~WindowTitleCache() {
+    // The monitor thread calls back into us, so it must be gone first
+    if (monitor_) {
+        monitor_->Stop();
+    }
+}
+
+WindowHandle WindowTitleCache::Find(const std::string& titleSubstring) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = entries_.find(titleSubstring);
+    if (it != entries_.end()) {
+        if (IsWindowValid(it->second)) {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return it->second;
+        }
+        // Destroyed before the monitor told us
+        entries_.erase(it);
+        invalidations_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    WindowHandle window;
+    {
+        TraceSpan span("topmost", "FindWindowByTitle");
+        window = FindWindowByTitle(titleSubstring);
+        span.SetArg("found", window != 0);
+    }
+    if (!window) {
+        return 0;
+    }
+
+    if (!monitorStarted_ && !monitorFailed_) {
+        monitor_.reset(CreateWindowChangeMonitor());
+        monitorStarted_ = monitor_->Start(&WindowTitleCache::OnWindowChanged, this);
+        monitorFailed_ = !monitorStarted_;
+    }
+    if (monitorStarted_) {
+        monitor_->Watch(window);
+        entries_[titleSubstring] = window;
+    }
+    return window;
+}
+
+void WindowTitleCache::Invalidate(WindowHandle window) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->second == window) {
+            it = entries_.erase(it);
+            invalidations_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void WindowTitleCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+WindowTitleCacheStats WindowTitleCache::Stats() {
+    WindowTitleCacheStats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.invalidations = invalidations_.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.entries = entries_.size();
+    }
+    return stats;
+}
+
+void WindowTitleCache::OnWindowChanged(WindowHandle window, void* context) {
+    static_cast<WindowTitleCache*>(context)->Invalidate(window);
+}
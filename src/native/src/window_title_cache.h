@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "window_platform.h"
+
+// Title -> handle cache in front of FindWindowByTitle().
+//
+// A miss enumerates once and registers the found window with a
+// WindowChangeMonitor; when that window is destroyed or renamed every entry
+// pointing at it is dropped, so the next lookup enumerates again. A hit is
+// only checked with IsWindowValid(), which is a single call, not an
+// enumeration. Without a working monitor (e.g. no display) nothing is cached.
+
+struct WindowTitleCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t invalidations;
+    uint64_t entries;
+};
+
+class WindowTitleCache {
+public:
+    WindowTitleCache();
+    ~WindowTitleCache();
+
+    // Cached FindWindowByTitle(); 0 if no window matches
+    WindowHandle Find(const std::string& titleSubstring);
+
+    // Drops every entry pointing at this window
+    void Invalidate(WindowHandle window);
+    void Clear();
+
+    WindowTitleCacheStats Stats();
+
+private:
+    static void OnWindowChanged(WindowHandle window, void* context);
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, WindowHandle> entries_;
+    std::unique_ptr<WindowChangeMonitor> monitor_;
+    bool monitorStarted_;
+    bool monitorFailed_;
+
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+    std::atomic<uint64_t> invalidations_;
+};
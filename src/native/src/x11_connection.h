@@ -0,0 +1,94 @@
+#pragma once
+
+#include <xcb/xcb.h>
+
+#include <cstdlib>
+#include <cstring>
+
+// XCB connection plus the EWMH atoms the topmost module needs. The window
+// platform functions share one lazily opened connection; the topmost watcher
+// opens its own so its event loop never competes with request/reply traffic.
+
+struct X11Atoms {
+    xcb_atom_t netClientListStacking;
+    xcb_atom_t netClientList;
+    xcb_atom_t netActiveWindow;
+    xcb_atom_t netWmState;
+    xcb_atom_t netWmStateAbove;
+    xcb_atom_t netWmStateHidden;
+    xcb_atom_t netWmName;
+    xcb_atom_t netWmPid;
+    xcb_atom_t utf8String;
+};
+
+class X11Connection {
+public:
+    X11Connection() : connection_(nullptr), root_(XCB_NONE), atoms_() {}
+    ~X11Connection() { Close(); }
+
+    X11Connection(const X11Connection&) = delete;
+    X11Connection& operator=(const X11Connection&) = delete;
+
+    // Connects to $DISPLAY and interns every atom in one round-trip
+    bool Open() {
+        if (connection_) return true;
+
+        int screenIndex = 0;
+        connection_ = xcb_connect(nullptr, &screenIndex);
+        if (xcb_connection_has_error(connection_)) {
+            Close();
+            return false;
+        }
+
+        xcb_screen_iterator_t it = xcb_setup_roots_iterator(xcb_get_setup(connection_));
+        for (int i = 0; i < screenIndex && it.rem; i++) {
+            xcb_screen_next(&it);
+        }
+        if (!it.rem) {
+            Close();
+            return false;
+        }
+        root_ = it.data->root;
+
+        static const char* const names[] = {
+            "_NET_CLIENT_LIST_STACKING", "_NET_CLIENT_LIST", "_NET_ACTIVE_WINDOW",
+            "_NET_WM_STATE", "_NET_WM_STATE_ABOVE", "_NET_WM_STATE_HIDDEN",
+            "_NET_WM_NAME", "_NET_WM_PID", "UTF8_STRING"
+        };
+        xcb_atom_t* targets[] = {
+            &atoms_.netClientListStacking, &atoms_.netClientList, &atoms_.netActiveWindow,
+            &atoms_.netWmState, &atoms_.netWmStateAbove, &atoms_.netWmStateHidden,
+            &atoms_.netWmName, &atoms_.netWmPid, &atoms_.utf8String
+        };
+        const size_t count = sizeof(names) / sizeof(names[0]);
+
+        xcb_intern_atom_cookie_t cookies[count];
+        for (size_t i = 0; i < count; i++) {
+            cookies[i] = xcb_intern_atom(connection_, 0, static_cast<uint16_t>(strlen(names[i])), names[i]);
+        }
+        for (size_t i = 0; i < count; i++) {
+            xcb_intern_atom_reply_t* reply = xcb_intern_atom_reply(connection_, cookies[i], nullptr);
+            *targets[i] = reply ? reply->atom : static_cast<xcb_atom_t>(XCB_ATOM_NONE);
+            free(reply);
+        }
+        return true;
+    }
+
+    void Close() {
+        if (connection_) {
+            xcb_disconnect(connection_);
+            connection_ = nullptr;
+        }
+        root_ = XCB_NONE;
+    }
+
+    bool IsOpen() const { return connection_ != nullptr; }
+    xcb_connection_t* Get() const { return connection_; }
+    xcb_window_t Root() const { return root_; }
+    const X11Atoms& Atoms() const { return atoms_; }
+
+private:
+    xcb_connection_t* connection_;
+    xcb_window_t root_;
+    X11Atoms atoms_;
+};
@@ -13,6 +13,7 @@ const navigateBtn = document.getElementById('navigateBtn');
 const backBtn = document.getElementById('backBtn');
 const aboutBackBtn = document.getElementById('aboutBackBtn');
 const gpuToggle = document.getElementById('gpuToggle');
+const mouseSwallowToggle = document.getElementById('mouseSwallowToggle');
 const resetBtn = document.getElementById('resetBtn');
 const opacitySlider = document.getElementById('opacitySlider');
 const opacityValue = document.getElementById('opacityValue');
@@ -138,6 +139,11 @@ function setupEventListeners() {
   gpuToggle.addEventListener('change', () => {
     window.electron.send('set-gpu-acceleration', gpuToggle.checked);
   });
+
+  // 鼠标侧键拦截开关
+  mouseSwallowToggle.addEventListener('change', () => {
+    window.electron.send('set-mouse-swallow', mouseSwallowToggle.checked);
+  });
   
   // 作者链接
   authorLink.addEventListener('click', (e) => {
@@ -167,7 +173,7 @@ function setupEventListeners() {
     showView(`${view}View`);
   });
   
-  window.electron.receive('initial-settings', ({ shortcuts: loadedShortcuts, opacity, enableGpu }) => {
+  window.electron.receive('initial-settings', ({ shortcuts: loadedShortcuts, opacity, enableGpu, swallowMouseButtons }) => {
     shortcuts = loadedShortcuts;
     updateShortcutButtons();
     updateShortcutDisplay();
@@ -176,6 +182,7 @@ function setupEventListeners() {
     opacityValue.textContent = opacity.toFixed(1);
 
     gpuToggle.checked = enableGpu;
+    mouseSwallowToggle.checked = swallowMouseButtons;
   });
 }
 